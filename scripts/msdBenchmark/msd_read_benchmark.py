@@ -0,0 +1,52 @@
+import argparse
+import os
+import sys
+import time
+
+parser = argparse.ArgumentParser(description='Measure the sequential read throughput of the PIC32MZW1 Curiosity OOB demo MSD')
+parser.add_argument('-d','--drive', type=str, help='Drive path of device MSD')
+parser.add_argument('-s','--size', type=int, default=512, help='Size of the test file in KB')
+parser.add_argument('-c','--chunk', type=int, default=64, help='Size of a single read in KB')
+
+args = parser.parse_args()
+
+if not args.drive:
+    print("Please provide a drive path")
+    sys.exit(1)
+
+test_file = os.path.join(args.drive, "BENCH.BIN")
+size = args.size * 1024
+chunk = args.chunk * 1024
+
+if not os.path.exists(test_file) or os.path.getsize(test_file) != size:
+    print("Creating " + test_file)
+    with open(test_file, "wb") as f:
+        f.write(os.urandom(size))
+        f.flush()
+        os.fsync(f.fileno())
+
+direct = hasattr(os, "O_DIRECT")
+if direct:
+    # Bypass the host page cache, every read goes to the device
+    import mmap
+    fd = os.open(test_file, os.O_RDONLY | os.O_DIRECT)
+    buf = mmap.mmap(-1, chunk)
+else:
+    print("O_DIRECT is not available, the host may serve the file from its cache.")
+    print("Unplug and replug the board before each run to measure the device.")
+    fd = os.open(test_file, os.O_RDONLY | getattr(os, "O_BINARY", 0))
+
+total = 0
+start = time.perf_counter()
+while True:
+    if direct:
+        n = os.readv(fd, [buf])
+    else:
+        n = len(os.read(fd, chunk))
+    if n == 0:
+        break
+    total += n
+elapsed = time.perf_counter() - start
+os.close(fd)
+
+print("Read %d bytes in %.3f s: %.2f MB/s" % (total, elapsed, total / elapsed / (1024 * 1024)))
@@ -0,0 +1,244 @@
+/*******************************************************************************
+  Host benchmark of the streaming JSON parser (app_json.c) against cJSON.
+
+  Both parse the shadow delta and a cloud.json and extract the same values.
+  malloc/free/realloc are wrapped at link time (-Wl,--wrap) to count the
+  allocations, the bytes requested and the peak heap of each parser: on the
+  target every block is taken from the newlib heap shared with wolfSSL and
+  the TCP/IP stack.
+
+    bench_json [iterations]
+
+  Returns non zero if APP_JSON_Parse() allocated anything or the two parsers
+  disagree, so that it can run in ctest with a small iteration count.
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "app_json.h"
+#include "cJSON.h"
+
+// *****************************************************************************
+// Section: Heap accounting
+// *****************************************************************************
+
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+void *__real_realloc(void *ptr, size_t size);
+
+typedef struct {
+    unsigned long allocs;
+    size_t current;
+    size_t peak;
+} HEAP_STATS;
+
+static HEAP_STATS heap;
+
+/*the block size is kept in front of the block*/
+#define HEAP_HDR 16
+
+void *__wrap_malloc(size_t size) {
+    unsigned char *p = __real_malloc(size + HEAP_HDR);
+
+    if (p == NULL) {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof (size));
+    heap.allocs++;
+    heap.current += size;
+    if (heap.current > heap.peak) {
+        heap.peak = heap.current;
+    }
+    return p + HEAP_HDR;
+}
+
+void __wrap_free(void *ptr) {
+    unsigned char *p = ptr;
+    size_t size;
+
+    if (p == NULL) {
+        return;
+    }
+    p -= HEAP_HDR;
+    memcpy(&size, p, sizeof (size));
+    heap.current -= size;
+    __real_free(p);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    void *n = __wrap_malloc(size);
+    size_t old;
+
+    if ((n != NULL) && (ptr != NULL)) {
+        memcpy(&old, (unsigned char *) ptr - HEAP_HDR, sizeof (old));
+        memcpy(n, ptr, (old < size) ? old : size);
+        __wrap_free(ptr);
+    }
+    return n;
+}
+
+// *****************************************************************************
+// Section: Timing
+// *****************************************************************************
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t nowCycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// *****************************************************************************
+// Section: Parsers under test
+// *****************************************************************************
+
+static const char shadowDelta[] = "{\"version\":12,\"timestamp\":1600000000,"
+        "\"state\":{\"toggle\":1},"
+        "\"metadata\":{\"toggle\":{\"timestamp\":1600000000}},"
+        "\"clientToken\":\"0123456789abcdef\"}";
+
+static const char cloudConfig[] = "{\r\n"
+        "  \"broker\": \"a1b2c3d4e5f6g7-ats.iot.us-east-1.amazonaws.com\",\r\n"
+        "  \"clientID\": \"01233b7a4d05d4f0fe\"\r\n"
+        "}\r\n";
+
+typedef struct {
+    int32_t toggle;
+    char broker[64];
+    char clientID[32];
+} RESULT;
+
+static bool appJsonDelta(const char *json, size_t len, RESULT *r) {
+    APP_JSON_HANDLER handlers[] = {
+        {"/state/toggle", APP_JSON_GetInt, &r->toggle},
+    };
+
+    return APP_JSON_Parse(json, len, handlers, 1, NULL) == APP_JSON_OK;
+}
+
+static bool appJsonCloud(const char *json, size_t len, RESULT *r) {
+    APP_JSON_STRING_BUF brokerBuf = {r->broker, sizeof (r->broker), false};
+    APP_JSON_STRING_BUF clientIDBuf = {r->clientID, sizeof (r->clientID), false};
+    APP_JSON_HANDLER handlers[] = {
+        {"/broker", APP_JSON_GetString, &brokerBuf},
+        {"/clientID", APP_JSON_GetString, &clientIDBuf},
+    };
+
+    return (APP_JSON_Parse(json, len, handlers, 2, NULL) == APP_JSON_OK) && brokerBuf.found && clientIDBuf.found;
+}
+
+/*as the firmware did before app_json.c, on the NUL terminated message*/
+static bool cJsonDelta(const char *json, size_t len, RESULT *r) {
+    cJSON *root = cJSON_Parse(json);
+    cJSON *state;
+    cJSON *toggle;
+
+    (void) len;
+    if (root == NULL) {
+        return false;
+    }
+    state = cJSON_GetObjectItem(root, "state");
+    toggle = cJSON_GetObjectItem(state, "toggle");
+    if (cJSON_IsNumber(toggle)) {
+        r->toggle = toggle->valueint;
+    } else if (cJSON_IsBool(toggle)) {
+        r->toggle = cJSON_IsTrue(toggle);
+    }
+    cJSON_Delete(root);
+    return true;
+}
+
+static bool cJsonCloud(const char *json, size_t len, RESULT *r) {
+    cJSON *root = cJSON_Parse(json);
+    cJSON *broker;
+    cJSON *clientID;
+    bool ret = false;
+
+    (void) len;
+    if (root == NULL) {
+        return false;
+    }
+    broker = cJSON_GetObjectItem(root, "broker");
+    clientID = cJSON_GetObjectItem(root, "clientID");
+    if (cJSON_IsString(broker) && cJSON_IsString(clientID) &&
+            (strlen(broker->valuestring) < sizeof (r->broker)) &&
+            (strlen(clientID->valuestring) < sizeof (r->clientID))) {
+        strcpy(r->broker, broker->valuestring);
+        strcpy(r->clientID, clientID->valuestring);
+        ret = true;
+    }
+    cJSON_Delete(root);
+    return ret;
+}
+
+typedef bool (*PARSE_FN)(const char *json, size_t len, RESULT *r);
+
+/*Runs one parser and prints a row. Returns the allocations of one parse.*/
+static unsigned long run(const char *name, PARSE_FN fn, const char *json, RESULT *r, unsigned long iterations) {
+    size_t len = strlen(json);
+    uint64_t t0, c0, ns, cycles;
+    unsigned long perParse;
+    unsigned long i;
+
+    memset(&heap, 0, sizeof (heap));
+    memset(r, 0, sizeof (*r));
+    r->toggle = -1;
+    if (!fn(json, len, r)) {
+        printf("%s: parse failed\n", name);
+        exit(1);
+    }
+    perParse = heap.allocs;
+
+    c0 = nowCycles();
+    t0 = nowNs();
+    for (i = 0; i < iterations; i++) {
+        fn(json, len, r);
+    }
+    ns = nowNs() - t0;
+    cycles = nowCycles() - c0;
+
+    printf("%-22s %9.1f %9.1f %8lu %9zu %8zu\n", name,
+            (double) ns / iterations, (double) cycles / iterations,
+            perParse, heap.peak, heap.current);
+    return perParse;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000UL;
+    RESULT a, c;
+    bool ok = true;
+
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    printf("%lu iterations, host cycles are not PIC32 cycles\n", iterations);
+    printf("%-22s %9s %9s %8s %9s %8s\n", "", "ns/parse", "cyc/parse", "allocs", "peak B", "leak B");
+
+    ok = (run("delta   app_json", appJsonDelta, shadowDelta, &a, iterations) == 0) && ok;
+    run("delta   cJSON", cJsonDelta, shadowDelta, &c, iterations);
+    ok = (a.toggle == 1) && (a.toggle == c.toggle) && ok;
+
+    ok = (run("cloud   app_json", appJsonCloud, cloudConfig, &a, iterations) == 0) && ok;
+    run("cloud   cJSON", cJsonCloud, cloudConfig, &c, iterations);
+    ok = (strcmp(a.broker, c.broker) == 0) && (strcmp(a.clientID, c.clientID) == 0) && ok;
+
+    if (!ok) {
+        printf("bench_json: app_json allocated or the results differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*******************************************************************************
+  Host Build System Definitions Header
+
+  File Name:
+    definitions.h
+
+  Summary:
+    Host replacement of config/pic32mz_w1_curiosity/definitions.h.
+
+  Description:
+    Declares the part of the Harmony drivers, system services and FreeRTOS
+    used by the application modules built on the host. They are implemented by
+    host_sim.c on top of a RAM backed SST26 and a virtual tick clock, see
+    host_sim.h.
+ *******************************************************************************/
+
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// Section: FreeRTOS
+// *****************************************************************************
+
+typedef uint32_t TickType_t;
+
+#include "FreeRTOSConfig.h"
+
+#define portTICK_PERIOD_MS              ((TickType_t) 1000 / configTICK_RATE_HZ)
+
+/* Virtual clock: vTaskDelay() moves it on and returns at once */
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(const TickType_t xTicksToDelay);
+
+/* Single task: nothing to yield to */
+#define taskYIELD()
+
+// *****************************************************************************
+// Section: System and driver types
+// *****************************************************************************
+
+typedef uintptr_t SYS_MODULE_OBJ;
+typedef uintptr_t DRV_HANDLE;
+
+#define DRV_HANDLE_INVALID              (((DRV_HANDLE) -1))
+
+typedef enum
+{
+    SYS_STATUS_ERROR = -1,
+    SYS_STATUS_UNINITIALIZED = 0,
+    SYS_STATUS_BUSY = 1,
+    SYS_STATUS_READY = 2
+} SYS_STATUS;
+
+typedef enum
+{
+    DRV_IO_INTENT_READ = 1,
+    DRV_IO_INTENT_WRITE = 2,
+    DRV_IO_INTENT_READWRITE = 3
+} DRV_IO_INTENT;
+
+#define SYS_CONSOLE_PRINT(...)          printf(__VA_ARGS__)
+
+// *****************************************************************************
+// Section: DRV_MEMORY and DRV_SST26
+// *****************************************************************************
+
+typedef enum
+{
+    DRV_SST26_TRANSFER_BUSY,
+    DRV_SST26_TRANSFER_COMPLETED,
+    DRV_SST26_TRANSFER_ERROR_UNKNOWN
+} DRV_SST26_TRANSFER_STATUS;
+
+SYS_STATUS DRV_MEMORY_Status(SYS_MODULE_OBJ object);
+bool DRV_MEMORY_DeviceAccessLock(SYS_MODULE_OBJ object);
+void DRV_MEMORY_DeviceAccessUnlock(SYS_MODULE_OBJ object);
+
+DRV_HANDLE DRV_SST26_Open(const uint32_t drvIndex, const DRV_IO_INTENT ioIntent);
+bool DRV_SST26_Read(const DRV_HANDLE handle, void *rx_data, uint32_t rx_data_length, uint32_t address);
+bool DRV_SST26_PageWrite(const DRV_HANDLE handle, void *tx_data, uint32_t address);
+bool DRV_SST26_SectorErase(const DRV_HANDLE handle, uint32_t address);
+DRV_SST26_TRANSFER_STATUS DRV_SST26_TransferStatusGet(const DRV_HANDLE handle);
+
+typedef struct
+{
+    SYS_MODULE_OBJ drvMemory0;
+} SYSTEM_OBJECTS;
+
+extern SYSTEM_OBJECTS sysObj;
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // DEFINITIONS_H
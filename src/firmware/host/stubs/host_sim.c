@@ -0,0 +1,165 @@
+/*******************************************************************************
+  Host Simulator Source File
+
+  File Name:
+    host_sim.c
+
+  Summary:
+    Drivers, services and FreeRTOS calls declared by the host definitions.h.
+
+  Description:
+    See host_sim.h.
+ *******************************************************************************/
+
+#include <string.h>
+
+#include "host_sim.h"
+
+SYSTEM_OBJECTS sysObj;
+
+static struct
+{
+    uint8_t flash[HOST_SIM_FLASH_SIZE];
+    TickType_t tick;
+    uint32_t failNext;
+    uint32_t eraseCount;
+    uint32_t programCount;
+    DRV_SST26_TRANSFER_STATUS status;
+    bool locked;
+} hostSim;
+
+void HOST_SIM_Reset(void)
+{
+    memset(&hostSim, 0, sizeof (hostSim));
+    memset(hostSim.flash, 0xFF, sizeof (hostSim.flash));
+    hostSim.status = DRV_SST26_TRANSFER_COMPLETED;
+}
+
+void HOST_SIM_ClockAdvance(uint32_t ms)
+{
+    hostSim.tick += ms / portTICK_PERIOD_MS;
+}
+
+void HOST_SIM_FlashFailNext(uint32_t count)
+{
+    hostSim.failNext = count;
+}
+
+uint32_t HOST_SIM_FlashEraseCount(void)
+{
+    return hostSim.eraseCount;
+}
+
+uint32_t HOST_SIM_FlashProgramCount(void)
+{
+    return hostSim.programCount;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return hostSim.tick;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    hostSim.tick += xTicksToDelay;
+}
+
+SYS_STATUS DRV_MEMORY_Status(SYS_MODULE_OBJ object)
+{
+    (void)object;
+    return SYS_STATUS_READY;
+}
+
+bool DRV_MEMORY_DeviceAccessLock(SYS_MODULE_OBJ object)
+{
+    (void)object;
+    if (hostSim.locked)
+    {
+        return false;
+    }
+    hostSim.locked = true;
+    return true;
+}
+
+void DRV_MEMORY_DeviceAccessUnlock(SYS_MODULE_OBJ object)
+{
+    (void)object;
+    hostSim.locked = false;
+}
+
+DRV_HANDLE DRV_SST26_Open(const uint32_t drvIndex, const DRV_IO_INTENT ioIntent)
+{
+    (void)ioIntent;
+    return (drvIndex == DRV_SST26_INDEX) ? (DRV_HANDLE) 0 : DRV_HANDLE_INVALID;
+}
+
+/* A failed request reports the error on the next status poll */
+static bool HOST_SIM_FlashFail(void)
+{
+    if (hostSim.failNext == 0U)
+    {
+        hostSim.status = DRV_SST26_TRANSFER_COMPLETED;
+        return false;
+    }
+    hostSim.failNext--;
+    hostSim.status = DRV_SST26_TRANSFER_ERROR_UNKNOWN;
+    return true;
+}
+
+bool DRV_SST26_Read(const DRV_HANDLE handle, void *rx_data, uint32_t rx_data_length, uint32_t address)
+{
+    (void)handle;
+    if (!hostSim.locked || (address + rx_data_length > HOST_SIM_FLASH_SIZE))
+    {
+        return false;
+    }
+    memcpy(rx_data, &hostSim.flash[address], rx_data_length);
+    hostSim.status = DRV_SST26_TRANSFER_COMPLETED;
+    return true;
+}
+
+bool DRV_SST26_PageWrite(const DRV_HANDLE handle, void *tx_data, uint32_t address)
+{
+    const uint8_t *src = (const uint8_t *) tx_data;
+    uint32_t i;
+
+    (void)handle;
+    if (!hostSim.locked || ((address % DRV_SST26_PAGE_SIZE) != 0U) ||
+            (address + DRV_SST26_PAGE_SIZE > HOST_SIM_FLASH_SIZE))
+    {
+        return false;
+    }
+    if (!HOST_SIM_FlashFail())
+    {
+        /* programming only clears bits */
+        for (i = 0; i < DRV_SST26_PAGE_SIZE; i++)
+        {
+            hostSim.flash[address + i] &= src[i];
+        }
+        hostSim.programCount++;
+    }
+    return true;
+}
+
+bool DRV_SST26_SectorErase(const DRV_HANDLE handle, uint32_t address)
+{
+    (void)handle;
+    if (!hostSim.locked || ((address % DRV_SST26_ERASE_BUFFER_SIZE) != 0U) ||
+            (address + DRV_SST26_ERASE_BUFFER_SIZE > HOST_SIM_FLASH_SIZE))
+    {
+        return false;
+    }
+    if (!HOST_SIM_FlashFail())
+    {
+        memset(&hostSim.flash[address], 0xFF, DRV_SST26_ERASE_BUFFER_SIZE);
+        hostSim.eraseCount++;
+    }
+    return true;
+}
+
+DRV_SST26_TRANSFER_STATUS DRV_SST26_TransferStatusGet(const DRV_HANDLE handle)
+{
+    (void)handle;
+    return hostSim.status;
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************
+  Host Simulator Header
+
+  File Name:
+    host_sim.h
+
+  Summary:
+    Control of the simulated board for the host tests.
+
+  Description:
+    The SST26 area below DRV_SST26_START_ADDRESS is a RAM array with the
+    flash semantics: an erase sets a sector to 0xFF and a page program can
+    only clear bits. Every transfer completes at once. The FreeRTOS tick count
+    is a virtual clock which only moves on vTaskDelay() and
+    HOST_SIM_ClockAdvance(), so runs are deterministic.
+ *******************************************************************************/
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "definitions.h"
+
+/* Size of the simulated flash, the area reserved below the FAT volume */
+#define HOST_SIM_FLASH_SIZE             DRV_SST26_START_ADDRESS
+
+/* Blank chip: all erased, counters and clock back to 0 */
+void HOST_SIM_Reset(void);
+
+void HOST_SIM_ClockAdvance(uint32_t ms);
+
+/* The next 'count' program/erase requests fail, as a busy or worn chip */
+void HOST_SIM_FlashFailNext(uint32_t count);
+
+uint32_t HOST_SIM_FlashEraseCount(void);
+uint32_t HOST_SIM_FlashProgramCount(void);
+
+#endif // HOST_SIM_H
@@ -0,0 +1,5 @@
+/* Host build: no interrupt attributes. */
+#ifndef ATTRIBS_H
+#define ATTRIBS_H
+
+#endif // ATTRIBS_H
@@ -0,0 +1,9 @@
+/* Host build: no device registers. configuration.h includes the device
+   header through device.h. */
+#ifndef XC_H
+#define XC_H
+
+/* no coherent (uncached) data on the host */
+#define __COHERENT
+
+#endif // XC_H
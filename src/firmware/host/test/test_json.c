@@ -0,0 +1,127 @@
+/*******************************************************************************
+  Host test of the streaming JSON parser (app_json.c).
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_json.h"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+#define N_HANDLERS(h) (sizeof (h) / sizeof ((h)[0]))
+
+static APP_JSON_RESULT parse(const char *json, const APP_JSON_HANDLER *handlers, uint8_t nHandlers, size_t *errPos) {
+    return APP_JSON_Parse(json, strlen(json), handlers, nHandlers, errPos);
+}
+
+static void testShadowDelta(void) {
+    const char *delta = "{\"version\":12,\"timestamp\":1600000000,"
+            "\"state\":{\"toggle\":1},"
+            "\"metadata\":{\"toggle\":{\"timestamp\":1600000000}},"
+            "\"clientToken\":\"abc\"}";
+    int32_t toggle = -1;
+    int32_t version = -1;
+    APP_JSON_HANDLER handlers[] = {
+        {"/state/toggle", APP_JSON_GetInt, &toggle},
+        {"/version", APP_JSON_GetInt, &version},
+    };
+
+    CHECK(parse(delta, handlers, N_HANDLERS(handlers), NULL) == APP_JSON_OK);
+    CHECK(toggle == 1);
+    CHECK(version == 12);
+
+    /*"/metadata/toggle" is an object, not a value: no callback*/
+    toggle = -1;
+    handlers[0].pointer = "/metadata/toggle";
+    CHECK(parse(delta, handlers, 1, NULL) == APP_JSON_OK);
+    CHECK(toggle == -1);
+
+    toggle = -1;
+    CHECK(parse("{\"state\":{\"toggle\":false}}", handlers, 1, NULL) == APP_JSON_OK);
+    CHECK(toggle == -1);
+    handlers[0].pointer = "/state/toggle";
+    CHECK(parse("{\"state\":{\"toggle\":false}}", handlers, 1, NULL) == APP_JSON_OK);
+    CHECK(toggle == 0);
+}
+
+static void testCloudConfig(void) {
+    const char *cloud = "{\r\n  \"broker\": \"a1b2c3-ats.iot.us-east-1.amazonaws.com\",\r\n"
+            "  \"clientID\": \"id\\\"with\\\\escapes\\u0041\"\r\n}\r\n";
+    char broker[64];
+    char clientID[8];
+    APP_JSON_STRING_BUF brokerBuf = {broker, sizeof (broker), false};
+    APP_JSON_STRING_BUF clientIDBuf = {clientID, sizeof (clientID), false};
+    APP_JSON_HANDLER handlers[] = {
+        {"/broker", APP_JSON_GetString, &brokerBuf},
+        {"/clientID", APP_JSON_GetString, &clientIDBuf},
+    };
+    char big[32];
+
+    CHECK(parse(cloud, handlers, N_HANDLERS(handlers), NULL) == APP_JSON_OK);
+    CHECK(brokerBuf.found);
+    CHECK(strcmp(broker, "a1b2c3-ats.iot.us-east-1.amazonaws.com") == 0);
+    /*does not fit*/
+    CHECK(!clientIDBuf.found);
+
+    clientIDBuf.buf = big;
+    clientIDBuf.size = sizeof (big);
+    CHECK(parse(cloud, handlers, N_HANDLERS(handlers), NULL) == APP_JSON_OK);
+    CHECK(clientIDBuf.found);
+    CHECK(strcmp(big, "id\"with\\escapesA") == 0);
+}
+
+static void testArrays(void) {
+    int32_t v = -1;
+    APP_JSON_HANDLER handlers[] = {
+        {"/s/1/2", APP_JSON_GetInt, &v},
+    };
+
+    CHECK(parse("{\"s\":[[1,2,3],[4,5,-6.5e1],[7]]}", handlers, 1, NULL) == APP_JSON_OK);
+    CHECK(v == -6);
+}
+
+/*a value in depth nested arrays: every level is a path segment. Empty
+  containers take no segment.*/
+static void nest(char *buf, int depth) {
+    int i;
+
+    for (i = 0; i < depth; i++) {
+        buf[i] = '[';
+        buf[2 * depth - i] = ']';
+    }
+    buf[depth] = '1';
+    buf[2 * depth + 1] = 0;
+}
+
+static void testErrors(void) {
+    char deep[64];
+    size_t errPos = 0;
+
+    CHECK(parse("{\"a\":1,}", NULL, 0, &errPos) == APP_JSON_ERR_SYNTAX);
+    CHECK(errPos == 7);
+    CHECK(parse("{\"a\" 1}", NULL, 0, NULL) == APP_JSON_ERR_SYNTAX);
+    CHECK(parse("{\"a\":tru}", NULL, 0, NULL) == APP_JSON_ERR_SYNTAX);
+    CHECK(parse("{\"a\":\"open", NULL, 0, NULL) == APP_JSON_ERR_SYNTAX);
+    CHECK(parse("", NULL, 0, NULL) == APP_JSON_ERR_SYNTAX);
+
+    nest(deep, APP_JSON_MAX_DEPTH);
+    CHECK(parse(deep, NULL, 0, NULL) == APP_JSON_OK);
+    nest(deep, APP_JSON_MAX_DEPTH + 1);
+    CHECK(parse(deep, NULL, 0, NULL) == APP_JSON_ERR_DEPTH);
+}
+
+int main(void) {
+    testShadowDelta();
+    testCloudConfig();
+    testArrays();
+    testErrors();
+    printf("test_json: passed\n");
+    return 0;
+}
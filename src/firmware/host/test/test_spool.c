@@ -0,0 +1,125 @@
+/*******************************************************************************
+  Host test of the telemetry spool (app_spool.c) on the simulated SST26.
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_spool.h"
+#include "host_sim.h"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+/*restart of the board: RAM state lost, flash kept*/
+static void reboot(void) {
+    APP_SPOOL_Initialize();
+    CHECK(APP_SPOOL_Mount());
+}
+
+static void writeSamples(uint32_t n) {
+    APP_SPOOL_RECORD rec;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        memset(&rec, 0, sizeof (rec));
+        rec.temp = (int16_t) i;
+        CHECK(APP_SPOOL_Write(&rec));
+    }
+}
+
+static void testWriteDrain(void) {
+    APP_SPOOL_RECORD recs[APP_SPOOL_DRAIN_BATCH];
+    APP_SPOOL_STATS stats;
+    uint8_t i;
+
+    HOST_SIM_Reset();
+    reboot();
+    CHECK(APP_SPOOL_PendingCount() == 0);
+
+    writeSamples(20);
+    CHECK(APP_SPOOL_PendingCount() == 20);
+
+    APP_SPOOL_DrainStart();
+    CHECK(APP_SPOOL_ReadBatch(recs, APP_SPOOL_DRAIN_BATCH) == APP_SPOOL_DRAIN_BATCH);
+    for (i = 0; i < APP_SPOOL_DRAIN_BATCH; i++) {
+        CHECK(recs[i].seq == i);
+    }
+    /*not consumed until committed*/
+    CHECK(APP_SPOOL_ReadBatch(recs, APP_SPOOL_DRAIN_BATCH) == APP_SPOOL_DRAIN_BATCH);
+    CHECK(recs[0].seq == 0);
+    HOST_SIM_ClockAdvance(1000);
+    CHECK(APP_SPOOL_Commit(APP_SPOOL_DRAIN_BATCH));
+    CHECK(APP_SPOOL_PendingCount() == 20 - APP_SPOOL_DRAIN_BATCH);
+    APP_SPOOL_StatsGet(&stats);
+    CHECK(stats.drainRate == APP_SPOOL_DRAIN_BATCH);
+
+    /*an unacked batch is read again after a reset*/
+    CHECK(APP_SPOOL_ReadBatch(recs, 4) == 4);
+    reboot();
+    CHECK(APP_SPOOL_PendingCount() == 20 - APP_SPOOL_DRAIN_BATCH);
+    CHECK(APP_SPOOL_ReadBatch(recs, 1) == 1);
+    CHECK(recs[0].seq == APP_SPOOL_DRAIN_BATCH);
+    CHECK(recs[0].temp == APP_SPOOL_DRAIN_BATCH);
+
+    /*the sample numbers go on across the reset*/
+    writeSamples(1);
+    CHECK(APP_SPOOL_ReadBatch(recs, APP_SPOOL_DRAIN_BATCH) == APP_SPOOL_DRAIN_BATCH);
+    CHECK(APP_SPOOL_Commit(APP_SPOOL_DRAIN_BATCH));
+    CHECK(APP_SPOOL_ReadBatch(recs, APP_SPOOL_DRAIN_BATCH) == 5);
+    CHECK(recs[4].seq == 20);
+}
+
+static void testOverflow(void) {
+    APP_SPOOL_RECORD rec;
+    APP_SPOOL_STATS stats;
+
+    HOST_SIM_Reset();
+    reboot();
+    writeSamples(APP_SPOOL_CAPACITY + APP_SPOOL_SLOTS_PER_SECTOR);
+    APP_SPOOL_StatsGet(&stats);
+    /*the oldest sector is recycled, its records counted as dropped*/
+    CHECK(stats.dropped != 0);
+    CHECK(stats.pending + stats.dropped == APP_SPOOL_CAPACITY + APP_SPOOL_SLOTS_PER_SECTOR);
+    CHECK(stats.pending <= APP_SPOOL_CAPACITY);
+    CHECK(APP_SPOOL_ReadBatch(&rec, 1) == 1);
+    CHECK(rec.seq == stats.dropped);
+
+    reboot();
+    CHECK(APP_SPOOL_PendingCount() == stats.pending);
+    CHECK(APP_SPOOL_ReadBatch(&rec, 1) == 1);
+    CHECK(rec.seq == stats.dropped);
+}
+
+static void testFlashError(void) {
+    APP_SPOOL_RECORD rec;
+    APP_SPOOL_STATS stats;
+
+    HOST_SIM_Reset();
+    reboot();
+    writeSamples(2);
+    /*a failed program loses that sample only*/
+    memset(&rec, 0, sizeof (rec));
+    HOST_SIM_FlashFailNext(1);
+    CHECK(!APP_SPOOL_Write(&rec));
+    writeSamples(1);
+    APP_SPOOL_StatsGet(&stats);
+    CHECK(stats.flashErrors == 1);
+    CHECK(stats.pending == 3);
+
+    reboot();
+    CHECK(APP_SPOOL_PendingCount() == 3);
+}
+
+int main(void) {
+    testWriteDrain();
+    testOverflow();
+    testFlashError();
+    printf("test_spool: passed\n");
+    return 0;
+}
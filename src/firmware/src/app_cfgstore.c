@@ -0,0 +1,229 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_cfgstore.c
+
+  Summary:
+    Binary copy of the Wi-Fi and cloud config in the record store.
+
+  Description:
+    See app_cfgstore.h. The records are only loaded and saved by the MSD_APP
+    task, the encode/decode buffers are not shared with anything else. A
+    record is decoded completely before app_controlData is touched, a
+    damaged or partial record never ends up in the running config.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+
+#include "app_cfgstore.h"
+#include "app_nvrec.h"
+#include "app_control.h"
+#include "definitions.h"
+
+/*bump it when the meaning of an existing key changes*/
+#define APP_CFGSTORE_VERSION        1U
+#define APP_CFGSTORE_HDR_SIZE       (1U + sizeof (APP_CFGSTORE_SOURCE))
+#define APP_CFGSTORE_ITEM_HDR_SIZE  2U
+
+/*Item keys, never reuse a retired one*/
+typedef enum
+{
+    APP_CFGSTORE_KEY_SSID = 1,
+    APP_CFGSTORE_KEY_PASS,
+    APP_CFGSTORE_KEY_AUTH,
+    APP_CFGSTORE_KEY_BROKER,
+    APP_CFGSTORE_KEY_CLIENT_ID,
+} APP_CFGSTORE_KEY;
+
+typedef struct
+{
+    uint8_t *buf;
+    uint16_t len;
+    bool overflow;
+} APP_CFGSTORE_WRITER;
+
+static const APP_NVREC_ID cfgstoreRecId[APP_CFGSTORE_COUNT] = {
+    APP_NVREC_ID_WIFI_CONFIG,
+    APP_NVREC_ID_CLOUD_CONFIG,
+};
+
+static uint8_t cfgstoreRecBuf[APP_NVREC_MAX_LEN];
+/*copy on flash, to skip writing an unchanged record*/
+static uint8_t cfgstoreOldBuf[APP_NVREC_MAX_LEN];
+
+static bool APP_CFGSTORE_Mount(void) {
+    return APP_NVREC_IsReady() || APP_NVREC_Mount();
+}
+
+static void APP_CFGSTORE_Put(APP_CFGSTORE_WRITER *w, APP_CFGSTORE_KEY key, const void *val, size_t len) {
+    if (w->overflow || (len > 0xFFU) || (w->len + APP_CFGSTORE_ITEM_HDR_SIZE + len > APP_NVREC_MAX_LEN)) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = (uint8_t) key;
+    w->buf[w->len++] = (uint8_t) len;
+    memcpy(&w->buf[w->len], val, len);
+    w->len += len;
+}
+
+/*Strings are stored without their NUL*/
+static void APP_CFGSTORE_PutString(APP_CFGSTORE_WRITER *w, APP_CFGSTORE_KEY key, const char *s, size_t size) {
+    const char *end = memchr(s, '\0', size);
+
+    APP_CFGSTORE_Put(w, key, s, (end != NULL) ? (size_t) (end - s) : size);
+}
+
+static bool APP_CFGSTORE_GetString(char *dst, size_t size, const uint8_t *val, uint8_t len) {
+    if (len >= size) {
+        return false;
+    }
+    memcpy(dst, val, len);
+    dst[len] = '\0';
+    return true;
+}
+
+static uint16_t APP_CFGSTORE_Encode(APP_CFGSTORE_REC rec, const APP_CFGSTORE_SOURCE *src) {
+    APP_CFGSTORE_WRITER w = {cfgstoreRecBuf, 0, false};
+    uint8_t auth;
+
+    w.buf[w.len++] = APP_CFGSTORE_VERSION;
+    memcpy(&w.buf[w.len], src, sizeof (*src));
+    w.len += sizeof (*src);
+
+    if (APP_CFGSTORE_WIFI == rec) {
+        APP_CTRL_WIFI_DATA *wifi = &app_controlData.wifiCtrl;
+
+        auth = (uint8_t) wifi->authmode;
+        APP_CFGSTORE_PutString(&w, APP_CFGSTORE_KEY_SSID, wifi->SSID, sizeof (wifi->SSID));
+        if (WIFI_OPEN != wifi->authmode) {
+            APP_CFGSTORE_PutString(&w, APP_CFGSTORE_KEY_PASS, wifi->pass, sizeof (wifi->pass));
+        }
+        APP_CFGSTORE_Put(&w, APP_CFGSTORE_KEY_AUTH, &auth, sizeof (auth));
+    } else {
+        APP_CTRL_MQTT_DATA *mqtt = &app_controlData.mqttCtrl;
+
+        APP_CFGSTORE_PutString(&w, APP_CFGSTORE_KEY_BROKER, mqtt->mqttBroker, sizeof (mqtt->mqttBroker));
+        APP_CFGSTORE_PutString(&w, APP_CFGSTORE_KEY_CLIENT_ID, mqtt->clientId, sizeof (mqtt->clientId));
+    }
+    return w.overflow ? 0 : w.len;
+}
+
+bool APP_CFGSTORE_Load(APP_CFGSTORE_REC rec, APP_CFGSTORE_SOURCE *src) {
+    /*decoded into a copy, applied only once the whole record checks out*/
+    APP_CTRL_WIFI_DATA wifi;
+    APP_CTRL_MQTT_DATA mqtt;
+    uint32_t found = 0;
+    uint32_t required;
+    uint16_t len = 0;
+    uint16_t off;
+
+    if ((rec >= APP_CFGSTORE_COUNT) || !APP_CFGSTORE_Mount()) {
+        return false;
+    }
+    if (!APP_NVREC_Read(cfgstoreRecId[rec], cfgstoreRecBuf, sizeof (cfgstoreRecBuf), &len) ||
+            (len < APP_CFGSTORE_HDR_SIZE) || (APP_CFGSTORE_VERSION != cfgstoreRecBuf[0])) {
+        return false;
+    }
+
+    memset(&wifi, 0, sizeof (wifi));
+    memset(&mqtt, 0, sizeof (mqtt));
+    for (off = APP_CFGSTORE_HDR_SIZE; off + APP_CFGSTORE_ITEM_HDR_SIZE <= len;) {
+        uint8_t key = cfgstoreRecBuf[off];
+        uint8_t vlen = cfgstoreRecBuf[off + 1];
+        const uint8_t *val = &cfgstoreRecBuf[off + APP_CFGSTORE_ITEM_HDR_SIZE];
+        bool ok = true;
+
+        if (off + APP_CFGSTORE_ITEM_HDR_SIZE + vlen > len) {
+            return false;
+        }
+        switch (key) {
+            case APP_CFGSTORE_KEY_SSID:
+                ok = APP_CFGSTORE_GetString(wifi.SSID, sizeof (wifi.SSID), val, vlen);
+                break;
+            case APP_CFGSTORE_KEY_PASS:
+                ok = APP_CFGSTORE_GetString(wifi.pass, sizeof (wifi.pass), val, vlen);
+                break;
+            case APP_CFGSTORE_KEY_AUTH:
+                ok = (1U == vlen);
+                wifi.authmode = (WIFI_AUTH) val[0];
+                break;
+            case APP_CFGSTORE_KEY_BROKER:
+                ok = APP_CFGSTORE_GetString(mqtt.mqttBroker, sizeof (mqtt.mqttBroker), val, vlen);
+                break;
+            case APP_CFGSTORE_KEY_CLIENT_ID:
+                ok = APP_CFGSTORE_GetString(mqtt.clientId, sizeof (mqtt.clientId), val, vlen);
+                break;
+            default:
+                /*written by a newer firmware*/
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+        if (key < 32U) {
+            found |= 1UL << key;
+        }
+        off += APP_CFGSTORE_ITEM_HDR_SIZE + vlen;
+    }
+    if (off != len) {
+        return false;
+    }
+
+    if (APP_CFGSTORE_WIFI == rec) {
+        required = (1UL << APP_CFGSTORE_KEY_SSID) | (1UL << APP_CFGSTORE_KEY_AUTH);
+        if ((found & required) != required) {
+            return false;
+        }
+        app_controlData.wifiCtrl.wifiCtrlValid = false;
+        memcpy(app_controlData.wifiCtrl.SSID, wifi.SSID, sizeof (wifi.SSID));
+        memcpy(app_controlData.wifiCtrl.pass, wifi.pass, sizeof (wifi.pass));
+        app_controlData.wifiCtrl.authmode = wifi.authmode;
+        app_controlData.wifiCtrl.wifiCtrlValid = true;
+    } else {
+        required = (1UL << APP_CFGSTORE_KEY_BROKER) | (1UL << APP_CFGSTORE_KEY_CLIENT_ID);
+        if ((found & required) != required) {
+            return false;
+        }
+        app_controlData.mqttCtrl.mqttConfigValid = false;
+        memcpy(app_controlData.mqttCtrl.mqttBroker, mqtt.mqttBroker, sizeof (mqtt.mqttBroker));
+        memcpy(app_controlData.mqttCtrl.clientId, mqtt.clientId, sizeof (mqtt.clientId));
+        app_controlData.mqttCtrl.mqttConfigValid = true;
+    }
+    if (src != NULL) {
+        memcpy(src, &cfgstoreRecBuf[1], sizeof (*src));
+    }
+    return true;
+}
+
+bool APP_CFGSTORE_Save(APP_CFGSTORE_REC rec, const APP_CFGSTORE_SOURCE *src) {
+    uint16_t len;
+    uint16_t oldLen = 0;
+
+    if ((rec >= APP_CFGSTORE_COUNT) || !APP_CFGSTORE_Mount()) {
+        return false;
+    }
+    len = APP_CFGSTORE_Encode(rec, src);
+    if (0 == len) {
+        SYS_CONSOLE_PRINT("APP_CFGSTORE: config %d does not fit a record\r\n", (int) rec);
+        return false;
+    }
+    if (APP_NVREC_Read(cfgstoreRecId[rec], cfgstoreOldBuf, sizeof (cfgstoreOldBuf), &oldLen) &&
+            (oldLen == len) && (0 == memcmp(cfgstoreOldBuf, cfgstoreRecBuf, len))) {
+        return true;
+    }
+    return APP_NVREC_Write(cfgstoreRecId[rec], cfgstoreRecBuf, len);
+}
+
+/*******************************************************************************
+ End of File
+ */
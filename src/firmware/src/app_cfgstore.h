@@ -0,0 +1,81 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_cfgstore.h
+
+  Summary:
+    Binary copy of the Wi-Fi and cloud config in the record store.
+
+  Description:
+    The running config is kept as two APP_NVREC records, APP_NVREC_ID_WIFI_CONFIG
+    and APP_NVREC_ID_CLOUD_CONFIG. A record starts with a format version and
+    the APP_CFGSTORE_SOURCE of the MSD file it was imported from, followed by
+    key/length/value items. Unknown keys are skipped, so new keys do not need a
+    version change.
+
+    WIFI.CFG and cloud.json are only an import/export view: at boot the config
+    comes from the records, and a file is parsed only when it no longer
+    matches the source of its record. Updates are atomic, APP_NVREC keeps the
+    previous copy until the new one is complete.
+*******************************************************************************/
+
+#ifndef _APP_CFGSTORE_H
+#define _APP_CFGSTORE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+typedef enum
+{
+    APP_CFGSTORE_WIFI = 0,      /*app_controlData.wifiCtrl*/
+    APP_CFGSTORE_CLOUD,         /*app_controlData.mqttCtrl*/
+    APP_CFGSTORE_COUNT
+} APP_CFGSTORE_REC;
+
+/*MSD file a record was imported from*/
+typedef struct
+{
+    uint32_t fsize;
+    uint16_t fdate;
+    uint16_t ftime;
+    unsigned char hash[32];     /*SHA-256 of the content*/
+} APP_CFGSTORE_SOURCE;
+
+/*Applies the record to app_controlData. Returns false if there is none, it
+  has another format version or the record store cannot be mounted.*/
+bool APP_CFGSTORE_Load(APP_CFGSTORE_REC rec, APP_CFGSTORE_SOURCE *src);
+
+/*Stores the config from app_controlData along with its source file. The
+  flash is not written if the record is unchanged.*/
+bool APP_CFGSTORE_Save(APP_CFGSTORE_REC rec, const APP_CFGSTORE_SOURCE *src);
+
+#endif /* _APP_CFGSTORE_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
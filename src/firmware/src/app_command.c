@@ -47,17 +47,39 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "cryptoauthlib.h"
 #include "wdrv_pic32mzw_common.h"
 #include "wdrv_pic32mzw_assoc.h"
+#include "sys_tasks.h"
+#include "app_spool.h"
+#include "app_heapstat.h"
+#include "net_pres/pres/net_pres_enc_glue.h"
 
 #if defined(TCPIP_STACK_COMMAND_ENABLE)
 
 static void _APP_Commands_GetUnixTime(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 static void _APP_Commands_GetRSSI(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 static void _APP_Commands_GetRTCC(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_GetWakeups(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_GetSpool(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_GetTls(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+#ifdef DRV_FTL_ENABLE
+static void _APP_Commands_GetFtl(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+#endif
+#ifdef APP_HEAPSTAT_ENABLE
+static void _APP_Commands_GetHeap(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+#endif
 
 static const SYS_CMD_DESCRIPTOR appCmdTbl[] = {
     {"unixtime", _APP_Commands_GetUnixTime, ": Unix Time"},
     {"rssi", _APP_Commands_GetRSSI, ": Get current RSSI"},
     {"rtcc", _APP_Commands_GetRTCC, ": Get uptime"},
+    {"wakeups", _APP_Commands_GetWakeups, ": App task wakeup statistics"},
+    {"spool", _APP_Commands_GetSpool, ": Telemetry spool statistics"},
+    {"tls", _APP_Commands_GetTls, ": TLS session resumption statistics ('flush' drops the cached session)"},
+#ifdef DRV_FTL_ENABLE
+    {"ftl", _APP_Commands_GetFtl, ": Flash wear statistics ('blocks' lists the erase count of every sector)"},
+#endif
+#ifdef APP_HEAPSTAT_ENABLE
+    {"heap", _APP_Commands_GetHeap, ": Heap usage per subsystem ('reset' restarts the peaks and fail counts)"},
+#endif
 };
 
 bool APP_Commands_Init() {
@@ -92,6 +114,119 @@ void _APP_Commands_GetRTCC(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
     (*pCmdIO->pCmdApi->print)(cmdIoParam, "RTCC: "TERM_YELLOW" %d-%d-%d %d:%d:%d\r\n"TERM_RESET, sys_time->tm_mday, sys_time->tm_mon, sys_time->tm_year, sys_time->tm_hour, sys_time->tm_min, sys_time->tm_sec);
 }
 
+void _APP_Commands_GetWakeups(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    uint32_t uptimeMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint64_t total = 0;
+    uint32_t rate;
+    int i;
+
+    if (uptimeMs == 0) {
+        uptimeMs = 1;
+    }
+#ifdef APP_RTOS_EVENT_DRIVEN
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "Task wakeups (event driven), uptime %u ms\r\n", uptimeMs);
+#else
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "Task wakeups (polled), uptime %u ms\r\n", uptimeMs);
+#endif
+    for (i = 0; i < APP_RTOS_TASK_COUNT; i++) {
+        APP_RTOS_TASK_STATS *pStats = &appRtosTaskStats[i];
+        if (i == APP_RTOS_TASK_NET_PRES) {
+            (*pCmdIO->pCmdApi->print)(cmdIoParam, "System tasks (polled)\r\n");
+        }
+        rate = (uint32_t) (((uint64_t) pStats->wakeups * 100000) / uptimeMs);
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, "%-18s wakeups: %u notified: %u rate: %u.%02u/s\r\n",
+                pStats->name, pStats->wakeups, pStats->notified, rate / 100, rate % 100);
+        total += pStats->wakeups;
+    }
+    rate = (uint32_t) ((total * 100000) / uptimeMs);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "%-18s rate: %u.%02u/s\r\n", "Total", rate / 100, rate % 100);
+}
+
+void _APP_Commands_GetSpool(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    APP_SPOOL_STATS stats;
+
+    APP_SPOOL_StatsGet(&stats);
+    if (!stats.ready) {
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, TERM_RED "Spool: not mounted\r\n" TERM_RESET);
+        return;
+    }
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "Spool: %u/%u records (%u%%)\r\n",
+            stats.pending, stats.capacity, (stats.pending * 100) / stats.capacity);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "written: %u drained: %u dropped: %u flash errors: %u\r\n",
+            stats.written, stats.drained, stats.dropped, stats.flashErrors);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "drain rate: %u records/s, sector erases min: %u max: %u\r\n",
+            stats.drainRate, stats.eraseMin, stats.eraseMax);
+}
+
+void _APP_Commands_GetTls(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    NET_PRES_EncProviderSessionStats stats;
+
+    if ((argc >= 2) && (strcmp(argv[1], "flush") == 0)) {
+        /*the next connect does a full handshake, for comparing the two*/
+        NET_PRES_EncProviderSessionFlush0();
+    }
+    NET_PRES_EncProviderSessionStatsGet0(&stats);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "TLS handshakes: %u resumed: %u failed: %u session cached: %s\r\n",
+            stats.handshakes, stats.resumed, stats.failed, stats.sessionCached ? "yes" : "no");
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "last full handshake: %u ms, last resumed handshake: %u ms\r\n",
+            stats.fullHandshakeMs, stats.resumedHandshakeMs);
+}
+
+#ifdef DRV_FTL_ENABLE
+void _APP_Commands_GetFtl(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    DRV_FTL_STATS stats;
+    uint32_t block;
+    uint32_t count;
+
+    DRV_FTL_StatsGet(&stats);
+    if (!stats.ready) {
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, TERM_RED "FTL: not mounted\r\n" TERM_RESET);
+        return;
+    }
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "FTL: %u logical sectors on %u, %u free\r\n",
+            stats.logicalBlocks, stats.physicalBlocks, stats.freeBlocks);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "sector erases min: %u max: %u avg: %u\r\n",
+            stats.eraseMin, stats.eraseMax, stats.eraseTotal / stats.physicalBlocks);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "remaps: %u log compactions: %u flash errors: %u\r\n",
+            stats.remaps, stats.logCompactions, stats.flashErrors);
+
+    if ((argc >= 2) && (strcmp(argv[1], "blocks") == 0)) {
+        for (block = 0; DRV_FTL_EraseCountGet(block, &count); block++) {
+            (*pCmdIO->pCmdApi->print)(cmdIoParam, "%s%6u", ((block % 16) == 0) ? "\r\n" : "", count);
+        }
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, "\r\n");
+    }
+}
+#endif
+
+#ifdef APP_HEAPSTAT_ENABLE
+void _APP_Commands_GetHeap(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    APP_HEAPSTAT_STATS stats;
+    uint8_t i;
+
+    if ((argc >= 2) && (strcmp(argv[1], "reset") == 0)) {
+        APP_HEAPSTAT_Reset();
+    }
+    APP_HEAPSTAT_Get(&stats, true);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "Heap: %u bytes, largest free block: %u (lowest seen: %u)\r\n",
+            stats.heapSize, stats.largestFree, stats.largestFreeMin);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "%-8s %8s %8s %8s %6s\r\n", "", "current", "peak", "allocs", "fails");
+    for (i = 0; i < APP_HEAPSTAT_COUNT; i++) {
+        const APP_HEAPSTAT_ENTRY *e = &stats.tag[i];
+
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, "%-8s %8u %8u %8u %6u\r\n",
+                APP_HEAPSTAT_TagName((APP_HEAPSTAT_TAG) i), e->current, e->peak, e->allocs, e->fails);
+    }
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "%-8s %8u %8u\r\n", "total", stats.current, stats.peak);
+    (*pCmdIO->pCmdApi->print)(cmdIoParam, "untagged pvPortMalloc() fails: %u\r\n", stats.rtosFails);
+}
+#endif
+
 void _APP_Commands_GetUnixTime(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
     const void* cmdIoParam = pCmdIO->cmdIoParam;
     uint32_t sec = TCPIP_SNTP_UTCSecondsGet();
@@ -31,6 +31,7 @@
 #include "peripheral/rtcc/plib_rtcc.h"
 #include "peripheral/adchs/plib_adchs.h"
 #include "peripheral/tmr/plib_tmr3.h"
+#include "sys_tasks.h"
 
 APP_CONTROL_DATA app_controlData;
 
@@ -38,6 +39,7 @@ void APP_CONTROL_Initialize(void) {
     app_controlData.wifiCtrl.wifiConnected = false;
     app_controlData.wifiCtrl.wifiCtrlValid = false;
     app_controlData.wifiCtrl.wifiCtrlChanged = false;
+    app_controlData.mqttCtrl.mqttConfigChanged = false;
     app_controlData.serialNumValid=false;
     app_controlData.devSerialStr[0] = '\0'; //to indicate valid serial number when populated from msd_app
     app_controlData.rssiData.assocHandle = 0;
@@ -69,6 +71,7 @@ static volatile bool rtcc_alarm = false;
 
 void RTCC_Callback(uintptr_t context) {
     rtcc_alarm = true;
+    APP_RTOS_NotifyFromISR(xAPP_CONTROL_Tasks);
 }
 
 void softResetDevice(void) {
@@ -127,6 +130,7 @@ void ADC_ResultHandler(ADCHS_CHANNEL_NUM channel, uintptr_t context) {
     /* Read the ADC result */
     app_controlData.adcData.adcCount = ADCHS_ChannelResultGet(ADCHS_CH15);
     app_controlData.adcData.dataReady = true;
+    APP_RTOS_NotifyFromISR(xAPP_CONTROL_Tasks);
 }
 
 static void setup_rtcc(void) {
@@ -243,6 +247,11 @@ void APP_CONTROL_Tasks(void) {
             break;
         }
     }
+
+    /*Run the monitor states back to back so that one event services a full cycle*/
+    if (APP_CONTROL_STATE_MONITOR_CONNECTION != app_controlData.state) {
+        APP_RTOS_Notify(xAPP_CONTROL_Tasks);
+    }
 }
 
 
@@ -131,6 +131,8 @@ extern "C" {
 
     typedef struct {
         bool mqttConfigValid;
+        /*cloud.json was edited, reconnect with the new broker/clientID*/
+        bool mqttConfigChanged;
         char mqttBroker[APP_CTRL_MAX_BROKER_NAME_LEN];
         char clientId[APP_CTRL_MAX_CLIENT_ID_LEN];
         bool conStat;
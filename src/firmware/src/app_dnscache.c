@@ -0,0 +1,127 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dnscache.c
+
+  Summary:
+    Last known good address of the MQTT broker.
+
+  Description:
+    See app_dnscache.h. The hooks are called from SYS_NET, inside
+    SYS_MQTT_Task() of the MQTT_APP task, which also runs APP_DNSCACHE_Tasks():
+    no locking is needed around the RAM copy.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+
+#include "app_dnscache.h"
+#include "app_nvrec.h"
+
+typedef struct
+{
+    APP_DNS_CACHE_ENTRY entry;
+    bool loaded;
+    bool dirty;
+    /*expiry of the copy on flash*/
+    uint32_t savedExpiry;
+} APP_DNSCACHE_DATA;
+
+static APP_DNSCACHE_DATA app_dnscacheData;
+
+static void APP_DNSCACHE_LoadRecord(void) {
+    APP_DNSCACHE_DATA *s = &app_dnscacheData;
+    uint16_t len;
+
+    if (s->loaded || !APP_NVREC_IsReady()) {
+        return;
+    }
+    if (!APP_NVREC_Read(APP_NVREC_ID_DNS_BROKER, &s->entry, sizeof (s->entry), &len) ||
+            (len != sizeof (s->entry))) {
+        memset(&s->entry, 0, sizeof (s->entry));
+    }
+    s->entry.host[sizeof (s->entry.host) - 1] = '\0';
+    s->savedExpiry = s->entry.expiry;
+    s->loaded = true;
+}
+
+void APP_DNSCACHE_Initialize(void) {
+    memset(&app_dnscacheData, 0, sizeof (app_dnscacheData));
+}
+
+void APP_DNSCACHE_Tasks(void) {
+    APP_DNSCACHE_DATA *s = &app_dnscacheData;
+
+    if (!APP_NVREC_IsReady()) {
+        APP_NVREC_Mount();
+        APP_DNSCACHE_LoadRecord();
+        return;
+    }
+    if (s->dirty) {
+        if (APP_NVREC_Write(APP_NVREC_ID_DNS_BROKER, &s->entry, sizeof (s->entry))) {
+            s->savedExpiry = s->entry.expiry;
+        }
+        /*on failure the entry is written again with the next change*/
+        s->dirty = false;
+    }
+}
+
+bool APP_DNSCACHE_Load(const char *host, IPV4_ADDR *addr) {
+    APP_DNS_CACHE_ENTRY *e = &app_dnscacheData.entry;
+    uint32_t now = TCPIP_SNTP_UTCSecondsGet();
+
+    APP_DNSCACHE_LoadRecord();
+    if ((e->addr == 0) || (strncmp(e->host, host, sizeof (e->host)) != 0)) {
+        return false;
+    }
+    /*an address way past its TTL is more likely to fail than to save time*/
+    if ((now != 0) && (e->expiry != 0) && (now - e->expiry < 0x80000000UL) &&
+            (now - e->expiry > APP_DNSCACHE_MAX_STALE)) {
+        return false;
+    }
+    addr->Val = e->addr;
+    return true;
+}
+
+void APP_DNSCACHE_Store(const char *host, IPV4_ADDR addr, uint32_t ttl) {
+    APP_DNSCACHE_DATA *s = &app_dnscacheData;
+    APP_DNS_CACHE_ENTRY *e = &s->entry;
+    uint32_t now = TCPIP_SNTP_UTCSecondsGet();
+    uint32_t expiry = (now != 0) ? (now + ttl) : 0;
+
+    APP_DNSCACHE_LoadRecord();
+    if ((e->addr != addr.Val) || (strncmp(e->host, host, sizeof (e->host)) != 0)) {
+        strncpy(e->host, host, sizeof (e->host) - 1);
+        e->host[sizeof (e->host) - 1] = '\0';
+        e->addr = addr.Val;
+        e->expiry = expiry;
+        s->dirty = true;
+    } else if ((expiry != 0) && ((s->savedExpiry == 0) || (expiry - s->savedExpiry > APP_DNSCACHE_MAX_STALE / 2))) {
+        s->dirty = true;
+    }
+    if (expiry != 0) {
+        e->expiry = expiry;
+    }
+}
+
+void APP_DNSCACHE_Invalidate(const char *host) {
+    APP_DNSCACHE_DATA *s = &app_dnscacheData;
+
+    if ((s->entry.addr != 0) && (strncmp(s->entry.host, host, sizeof (s->entry.host)) == 0)) {
+        s->entry.addr = 0;
+        s->dirty = true;
+    }
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,76 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dnscache.h
+
+  Summary:
+    Last known good address of the MQTT broker.
+
+  Description:
+    Implements the SYS_NET_DNS_CACHE_xxx_HOOK functions. SYS_NET connects to
+    the address returned by APP_DNSCACHE_Load() without waiting for DNS, the
+    name is resolved in the background and APP_DNSCACHE_Store() refreshes the
+    entry. The entry is kept as APP_NVREC_ID_DNS_BROKER so that it survives a
+    reset; it is only written back when the address changes or its TTL was
+    refreshed by more than APP_DNSCACHE_MAX_STALE / 2.
+*******************************************************************************/
+
+#ifndef _APP_DNSCACHE_H
+#define _APP_DNSCACHE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+#include "app_control.h"
+#include "tcpip/tcpip.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+/*APP_NVREC_ID_DNS_BROKER record*/
+typedef struct
+{
+    uint32_t addr;              /*IPv4 address, 0: none*/
+    uint32_t expiry;            /*end of the DNS TTL in SNTP UTC seconds, 0: unknown*/
+    char host[APP_CTRL_MAX_BROKER_NAME_LEN];
+} APP_DNS_CACHE_ENTRY;
+
+void APP_DNSCACHE_Initialize(void);
+
+/*Mounts the record store and writes a changed entry back. Call it from the
+  task running SYS_NET, the hooks below only update the RAM copy.*/
+void APP_DNSCACHE_Tasks(void);
+
+/*SYS_NET hooks*/
+bool APP_DNSCACHE_Load(const char *host, IPV4_ADDR *addr);
+
+void APP_DNSCACHE_Store(const char *host, IPV4_ADDR addr, uint32_t ttl);
+
+void APP_DNSCACHE_Invalidate(const char *host);
+
+#endif /* _APP_DNSCACHE_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
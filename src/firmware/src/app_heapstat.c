@@ -0,0 +1,266 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_heapstat.c
+
+  Summary:
+    Heap usage per subsystem.
+
+  Description:
+    See app_heapstat.h. Every block starts with an APP_HEAPSTAT_HDR recording
+    its tag and requested size, so a free needs no lookup. malloc() and the
+    counters are updated with the scheduler suspended, as heap_3 does around
+    malloc().
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_heapstat.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "wolfssl/wolfcrypt/settings.h"
+#include "wolfssl/wolfcrypt/types.h"
+
+#ifdef APP_HEAPSTAT_ENABLE
+
+/*stops the largest free block search*/
+#define APP_HEAPSTAT_PROBE_STEP     16U
+
+typedef union
+{
+    struct
+    {
+        uint32_t size;
+        uint8_t tag;
+    };
+    uint8_t align[APP_HEAPSTAT_HDR_SIZE];
+} APP_HEAPSTAT_HDR;
+
+/*Linker symbol set with the heap-size project option, its address is the
+  value. An array so that it is not taken for a small data object.*/
+extern char _min_heap_size[];
+
+static const char *const heapstatTagName[APP_HEAPSTAT_COUNT] = {
+    "tcpip",
+    "wolfssl",
+    "wifi",
+};
+
+static APP_HEAPSTAT_ENTRY heapstatTag[APP_HEAPSTAT_COUNT];
+static uint32_t heapstatCurrent;
+static uint32_t heapstatPeak;
+static uint32_t heapstatRtosFails;
+static uint32_t heapstatLargestFreeMin = UINT32_MAX;
+
+static void APP_HEAPSTAT_Add(APP_HEAPSTAT_TAG tag, uint32_t size) {
+    APP_HEAPSTAT_ENTRY *e = &heapstatTag[tag];
+
+    e->allocs++;
+    e->current += size;
+    if (e->current > e->peak) {
+        e->peak = e->current;
+    }
+    heapstatCurrent += size;
+    if (heapstatCurrent > heapstatPeak) {
+        heapstatPeak = heapstatCurrent;
+    }
+}
+
+static void APP_HEAPSTAT_Sub(APP_HEAPSTAT_TAG tag, uint32_t size) {
+    heapstatTag[tag].current -= size;
+    heapstatCurrent -= size;
+}
+
+void *APP_HEAPSTAT_Malloc(APP_HEAPSTAT_TAG tag, size_t size) {
+    APP_HEAPSTAT_HDR *hdr = NULL;
+
+    vTaskSuspendAll();
+    if (size <= UINT32_MAX - sizeof (*hdr)) {
+        hdr = malloc(sizeof (*hdr) + size);
+    }
+    if (hdr != NULL) {
+        hdr->size = (uint32_t) size;
+        hdr->tag = (uint8_t) tag;
+        APP_HEAPSTAT_Add(tag, (uint32_t) size);
+    } else {
+        heapstatTag[tag].fails++;
+    }
+    (void) xTaskResumeAll();
+
+    return (hdr != NULL) ? (hdr + 1) : NULL;
+}
+
+void *APP_HEAPSTAT_Calloc(APP_HEAPSTAT_TAG tag, size_t nElems, size_t elemSize) {
+    void *ptr = NULL;
+
+    if ((elemSize == 0) || (nElems <= SIZE_MAX / elemSize)) {
+        ptr = APP_HEAPSTAT_Malloc(tag, nElems * elemSize);
+    }
+    if (ptr != NULL) {
+        memset(ptr, 0, nElems * elemSize);
+    }
+    return ptr;
+}
+
+void *APP_HEAPSTAT_Realloc(APP_HEAPSTAT_TAG tag, void *ptr, size_t size) {
+    APP_HEAPSTAT_HDR *hdr;
+    APP_HEAPSTAT_HDR *newHdr = NULL;
+    uint32_t oldSize;
+
+    if (ptr == NULL) {
+        return APP_HEAPSTAT_Malloc(tag, size);
+    }
+    hdr = (APP_HEAPSTAT_HDR *) ptr - 1;
+    oldSize = hdr->size;
+
+    vTaskSuspendAll();
+    if (size <= UINT32_MAX - sizeof (*hdr)) {
+        newHdr = realloc(hdr, sizeof (*hdr) + size);
+    }
+    if (newHdr != NULL) {
+        /*moves to the new tag, if another one*/
+        APP_HEAPSTAT_Sub((APP_HEAPSTAT_TAG) newHdr->tag, oldSize);
+        newHdr->size = (uint32_t) size;
+        newHdr->tag = (uint8_t) tag;
+        APP_HEAPSTAT_Add(tag, (uint32_t) size);
+    } else {
+        /*the old block is still there*/
+        heapstatTag[tag].fails++;
+    }
+    (void) xTaskResumeAll();
+
+    return (newHdr != NULL) ? (newHdr + 1) : NULL;
+}
+
+void APP_HEAPSTAT_Free(void *ptr) {
+    APP_HEAPSTAT_HDR *hdr;
+
+    if (ptr == NULL) {
+        return;
+    }
+    hdr = (APP_HEAPSTAT_HDR *) ptr - 1;
+
+    vTaskSuspendAll();
+    APP_HEAPSTAT_Sub((APP_HEAPSTAT_TAG) hdr->tag, hdr->size);
+    free(hdr);
+    (void) xTaskResumeAll();
+}
+
+void *APP_HEAPSTAT_TcpipMalloc(size_t size) {
+    return APP_HEAPSTAT_Malloc(APP_HEAPSTAT_TCPIP, size);
+}
+
+void *APP_HEAPSTAT_TcpipCalloc(size_t nElems, size_t elemSize) {
+    return APP_HEAPSTAT_Calloc(APP_HEAPSTAT_TCPIP, nElems, elemSize);
+}
+
+void APP_HEAPSTAT_TcpipFree(void *ptr) {
+    APP_HEAPSTAT_Free(ptr);
+}
+
+void *APP_HEAPSTAT_WifiMalloc(size_t size) {
+    return APP_HEAPSTAT_Malloc(APP_HEAPSTAT_WIFI, size);
+}
+
+/*wolfSSL with XMALLOC_USER*/
+void *XMALLOC(size_t n, void *heap, int type) {
+    (void) heap;
+    (void) type;
+    return APP_HEAPSTAT_Malloc(APP_HEAPSTAT_WOLFSSL, n);
+}
+
+void *XREALLOC(void *p, size_t n, void *heap, int type) {
+    (void) heap;
+    (void) type;
+    return APP_HEAPSTAT_Realloc(APP_HEAPSTAT_WOLFSSL, p, n);
+}
+
+void XFREE(void *p, void *heap, int type) {
+    (void) heap;
+    (void) type;
+    APP_HEAPSTAT_Free(p);
+}
+
+void APP_HEAPSTAT_RtosMallocFailed(void) {
+    vTaskSuspendAll();
+    heapstatRtosFails++;
+    (void) xTaskResumeAll();
+}
+
+/*Binary search between what could be allocated and what could not*/
+static uint32_t APP_HEAPSTAT_LargestFree(uint32_t heapSize) {
+    uint32_t lo = 0;
+    uint32_t hi = heapSize + 1U;
+
+    vTaskSuspendAll();
+    while (hi - lo > APP_HEAPSTAT_PROBE_STEP) {
+        uint32_t mid = lo + (hi - lo) / 2U;
+        void *p = malloc(mid);
+
+        if (p != NULL) {
+            free(p);
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    (void) xTaskResumeAll();
+
+    return lo;
+}
+
+void APP_HEAPSTAT_Get(APP_HEAPSTAT_STATS *stats, bool probe) {
+    uint32_t largestFree = 0;
+
+    stats->heapSize = (uint32_t) (uintptr_t) _min_heap_size;
+    if (probe) {
+        largestFree = APP_HEAPSTAT_LargestFree(stats->heapSize);
+    }
+
+    vTaskSuspendAll();
+    if (probe && (largestFree < heapstatLargestFreeMin)) {
+        heapstatLargestFreeMin = largestFree;
+    }
+    memcpy(stats->tag, heapstatTag, sizeof (stats->tag));
+    stats->current = heapstatCurrent;
+    stats->peak = heapstatPeak;
+    stats->rtosFails = heapstatRtosFails;
+    stats->largestFreeMin = (heapstatLargestFreeMin != UINT32_MAX) ? heapstatLargestFreeMin : 0;
+    (void) xTaskResumeAll();
+    stats->largestFree = largestFree;
+}
+
+void APP_HEAPSTAT_Reset(void) {
+    uint8_t i;
+
+    vTaskSuspendAll();
+    for (i = 0; i < APP_HEAPSTAT_COUNT; i++) {
+        heapstatTag[i].peak = heapstatTag[i].current;
+        heapstatTag[i].fails = 0;
+    }
+    heapstatPeak = heapstatCurrent;
+    heapstatRtosFails = 0;
+    heapstatLargestFreeMin = UINT32_MAX;
+    (void) xTaskResumeAll();
+}
+
+const char *APP_HEAPSTAT_TagName(APP_HEAPSTAT_TAG tag) {
+    return (tag < APP_HEAPSTAT_COUNT) ? heapstatTagName[tag] : "?";
+}
+
+#endif /* APP_HEAPSTAT_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,117 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_heapstat.h
+
+  Summary:
+    Heap usage per subsystem.
+
+  Description:
+    All the heap users allocate from the one malloc() heap, FreeRTOS uses
+    heap_3 on top of it and configTOTAL_HEAP_SIZE is not used. The main users
+    are routed through the wrappers below, which tag every block with the
+    subsystem it belongs to:
+        - TCP/IP: TCPIP_STACK_MALLOC_FUNC/CALLOC_FUNC/FREE_FUNC
+        - wolfSSL: XMALLOC/XREALLOC/XFREE, built with XMALLOC_USER
+        - Wi-Fi driver: WDRV_PIC32MZW_MEM_ALLOC_HOOK/FREE_HOOK
+    The other pvPortMalloc() users (kernel objects, OSAL) are not tagged, only
+    their failures are counted, through vApplicationMallocFailedHook().
+
+    Enabled by APP_HEAPSTAT_ENABLE in configuration.h. Every block costs
+    APP_HEAPSTAT_HDR_SIZE bytes more.
+*******************************************************************************/
+
+#ifndef _APP_HEAPSTAT_H
+#define _APP_HEAPSTAT_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+/*keeps the 8 byte alignment of malloc()*/
+#define APP_HEAPSTAT_HDR_SIZE       8U
+
+typedef enum
+{
+    APP_HEAPSTAT_TCPIP = 0,
+    APP_HEAPSTAT_WOLFSSL,
+    APP_HEAPSTAT_WIFI,
+    APP_HEAPSTAT_COUNT
+} APP_HEAPSTAT_TAG;
+
+/*Sizes are the requested ones, without the header and the malloc() overhead*/
+typedef struct
+{
+    uint32_t current;           /*bytes allocated now*/
+    uint32_t peak;
+    uint32_t allocs;            /*successful allocations*/
+    uint32_t fails;
+} APP_HEAPSTAT_ENTRY;
+
+typedef struct
+{
+    APP_HEAPSTAT_ENTRY tag[APP_HEAPSTAT_COUNT];
+    uint32_t current;           /*all the tags together*/
+    uint32_t peak;
+    uint32_t rtosFails;         /*untagged pvPortMalloc() failures*/
+    uint32_t heapSize;          /*linker heap, the heap-size project option*/
+    uint32_t largestFree;       /*0 if not probed*/
+    uint32_t largestFreeMin;    /*lowest largestFree probed so far*/
+} APP_HEAPSTAT_STATS;
+
+void *APP_HEAPSTAT_Malloc(APP_HEAPSTAT_TAG tag, size_t size);
+void *APP_HEAPSTAT_Calloc(APP_HEAPSTAT_TAG tag, size_t nElems, size_t elemSize);
+void *APP_HEAPSTAT_Realloc(APP_HEAPSTAT_TAG tag, void *ptr, size_t size);
+/*Any tag, NULL is ignored*/
+void APP_HEAPSTAT_Free(void *ptr);
+
+/*TCPIP_STACK_MALLOC_FUNC/CALLOC_FUNC/FREE_FUNC*/
+void *APP_HEAPSTAT_TcpipMalloc(size_t size);
+void *APP_HEAPSTAT_TcpipCalloc(size_t nElems, size_t elemSize);
+void APP_HEAPSTAT_TcpipFree(void *ptr);
+
+/*WDRV_PIC32MZW_MEM_ALLOC_HOOK, freed with APP_HEAPSTAT_Free()*/
+void *APP_HEAPSTAT_WifiMalloc(size_t size);
+
+/*From vApplicationMallocFailedHook()*/
+void APP_HEAPSTAT_RtosMallocFailed(void);
+
+/*With probe, the largest free block is searched for by allocating it: the
+  scheduler is suspended for some 20 malloc()/free() pairs.*/
+void APP_HEAPSTAT_Get(APP_HEAPSTAT_STATS *stats, bool probe);
+
+/*Restarts the peaks from the current usage and clears the fail counts*/
+void APP_HEAPSTAT_Reset(void);
+
+const char *APP_HEAPSTAT_TagName(APP_HEAPSTAT_TAG tag);
+
+#endif /* _APP_HEAPSTAT_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,430 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_json.c
+
+  Summary:
+    Streaming JSON parser with JSON pointer callbacks.
+
+  Description:
+    Recursive descent over the input buffer. The recursion is bounded by
+    APP_JSON_MAX_DEPTH and every level only holds the current member name or
+    array index, so the parser runs in a small, fixed amount of stack and
+    never touches the heap.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+
+#include "app_json.h"
+
+typedef struct
+{
+    const char *key;        /*NULL for an array element*/
+    uint16_t keyLen;
+    uint16_t index;
+} APP_JSON_SEGMENT;
+
+typedef struct
+{
+    const char *start;
+    const char *p;
+    const char *end;
+    const APP_JSON_HANDLER *handlers;
+    uint8_t nHandlers;
+    uint8_t depth;
+    APP_JSON_SEGMENT path[APP_JSON_MAX_DEPTH];
+} APP_JSON_PARSER;
+
+static APP_JSON_RESULT APP_JSON_ParseValue(APP_JSON_PARSER *ps);
+
+static inline bool APP_JSON_AtEnd(const APP_JSON_PARSER *ps) {
+    return (ps->p >= ps->end) || (*ps->p == '\0');
+}
+
+static void APP_JSON_SkipWs(APP_JSON_PARSER *ps) {
+    while (!APP_JSON_AtEnd(ps) &&
+            ((*ps->p == ' ') || (*ps->p == '\t') || (*ps->p == '\r') || (*ps->p == '\n'))) {
+        ps->p++;
+    }
+}
+
+static bool APP_JSON_PathMatches(const APP_JSON_PARSER *ps, const char *pointer) {
+    uint8_t i;
+
+    for (i = 0; i < ps->depth; i++) {
+        const APP_JSON_SEGMENT *seg = &ps->path[i];
+        const char *s;
+        size_t len;
+
+        if (*pointer != '/') {
+            return false;
+        }
+        s = ++pointer;
+        while ((*pointer != '/') && (*pointer != '\0')) {
+            pointer++;
+        }
+        len = pointer - s;
+
+        if (seg->key != NULL) {
+            if ((len != seg->keyLen) || (memcmp(s, seg->key, len) != 0)) {
+                return false;
+            }
+        } else {
+            uint32_t index = 0;
+
+            if (len == 0) {
+                return false;
+            }
+            while (s < pointer) {
+                if ((*s < '0') || (*s > '9')) {
+                    return false;
+                }
+                index = (index * 10) + (*s++ - '0');
+            }
+            if (index != seg->index) {
+                return false;
+            }
+        }
+    }
+    return *pointer == '\0';
+}
+
+static void APP_JSON_Dispatch(const APP_JSON_PARSER *ps, const APP_JSON_VALUE *value) {
+    uint8_t i;
+
+    for (i = 0; i < ps->nHandlers; i++) {
+        if (APP_JSON_PathMatches(ps, ps->handlers[i].pointer)) {
+            ps->handlers[i].callback(value, ps->handlers[i].cookie);
+        }
+    }
+}
+
+/*Leaves ps->p after the closing quote, str and len give the raw contents*/
+static APP_JSON_RESULT APP_JSON_ParseString(APP_JSON_PARSER *ps, const char **str, size_t *len) {
+    const char *s;
+
+    ps->p++;
+    s = ps->p;
+    while (!APP_JSON_AtEnd(ps) && (*ps->p != '"')) {
+        if ((uint8_t) *ps->p < 0x20) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        if (*ps->p == '\\') {
+            ps->p++;
+            if (APP_JSON_AtEnd(ps)) {
+                return APP_JSON_ERR_SYNTAX;
+            }
+        }
+        ps->p++;
+    }
+    if (APP_JSON_AtEnd(ps)) {
+        return APP_JSON_ERR_SYNTAX;
+    }
+    *str = s;
+    *len = ps->p - s;
+    ps->p++;
+    return APP_JSON_OK;
+}
+
+static APP_JSON_RESULT APP_JSON_ParseNumber(APP_JSON_PARSER *ps, APP_JSON_VALUE *value) {
+    const char *s = ps->p;
+    bool neg = false;
+    int32_t v = 0;
+
+    if (*ps->p == '-') {
+        neg = true;
+        ps->p++;
+    }
+    if (APP_JSON_AtEnd(ps) || (*ps->p < '0') || (*ps->p > '9')) {
+        return APP_JSON_ERR_SYNTAX;
+    }
+    while (!APP_JSON_AtEnd(ps) && (*ps->p >= '0') && (*ps->p <= '9')) {
+        /*saturate rather than overflow*/
+        if (v < (INT32_MAX / 10)) {
+            v = (v * 10) + (*ps->p - '0');
+        }
+        ps->p++;
+    }
+    if (!APP_JSON_AtEnd(ps) && (*ps->p == '.')) {
+        ps->p++;
+        if (APP_JSON_AtEnd(ps) || (*ps->p < '0') || (*ps->p > '9')) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        while (!APP_JSON_AtEnd(ps) && (*ps->p >= '0') && (*ps->p <= '9')) {
+            ps->p++;
+        }
+    }
+    if (!APP_JSON_AtEnd(ps) && ((*ps->p == 'e') || (*ps->p == 'E'))) {
+        ps->p++;
+        if (!APP_JSON_AtEnd(ps) && ((*ps->p == '+') || (*ps->p == '-'))) {
+            ps->p++;
+        }
+        if (APP_JSON_AtEnd(ps) || (*ps->p < '0') || (*ps->p > '9')) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        while (!APP_JSON_AtEnd(ps) && (*ps->p >= '0') && (*ps->p <= '9')) {
+            ps->p++;
+        }
+    }
+
+    value->type = APP_JSON_TYPE_NUMBER;
+    value->str = s;
+    value->len = ps->p - s;
+    value->intValue = neg ? -v : v;
+    return APP_JSON_OK;
+}
+
+static APP_JSON_RESULT APP_JSON_ParseLiteral(APP_JSON_PARSER *ps, const char *lit, APP_JSON_VALUE *value) {
+    size_t len = strlen(lit);
+
+    if (((size_t) (ps->end - ps->p) < len) || (memcmp(ps->p, lit, len) != 0)) {
+        return APP_JSON_ERR_SYNTAX;
+    }
+    value->str = ps->p;
+    value->len = len;
+    ps->p += len;
+    return APP_JSON_OK;
+}
+
+static APP_JSON_RESULT APP_JSON_ParseObject(APP_JSON_PARSER *ps) {
+    APP_JSON_RESULT ret;
+
+    ps->p++;
+    APP_JSON_SkipWs(ps);
+    if (!APP_JSON_AtEnd(ps) && (*ps->p == '}')) {
+        ps->p++;
+        return APP_JSON_OK;
+    }
+    if (ps->depth >= APP_JSON_MAX_DEPTH) {
+        return APP_JSON_ERR_DEPTH;
+    }
+
+    while (true) {
+        APP_JSON_SEGMENT *seg = &ps->path[ps->depth];
+        size_t keyLen;
+
+        if (APP_JSON_AtEnd(ps) || (*ps->p != '"')) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        if ((ret = APP_JSON_ParseString(ps, &seg->key, &keyLen)) != APP_JSON_OK) {
+            return ret;
+        }
+        seg->keyLen = (uint16_t) keyLen;
+        APP_JSON_SkipWs(ps);
+        if (APP_JSON_AtEnd(ps) || (*ps->p != ':')) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        ps->p++;
+
+        ps->depth++;
+        ret = APP_JSON_ParseValue(ps);
+        ps->depth--;
+        if (ret != APP_JSON_OK) {
+            return ret;
+        }
+
+        APP_JSON_SkipWs(ps);
+        if (APP_JSON_AtEnd(ps)) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        if (*ps->p == '}') {
+            ps->p++;
+            return APP_JSON_OK;
+        }
+        if (*ps->p != ',') {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        ps->p++;
+        APP_JSON_SkipWs(ps);
+    }
+}
+
+static APP_JSON_RESULT APP_JSON_ParseArray(APP_JSON_PARSER *ps) {
+    APP_JSON_RESULT ret;
+    APP_JSON_SEGMENT *seg;
+
+    ps->p++;
+    APP_JSON_SkipWs(ps);
+    if (!APP_JSON_AtEnd(ps) && (*ps->p == ']')) {
+        ps->p++;
+        return APP_JSON_OK;
+    }
+    if (ps->depth >= APP_JSON_MAX_DEPTH) {
+        return APP_JSON_ERR_DEPTH;
+    }
+
+    seg = &ps->path[ps->depth];
+    seg->key = NULL;
+    seg->index = 0;
+    while (true) {
+        ps->depth++;
+        ret = APP_JSON_ParseValue(ps);
+        ps->depth--;
+        if (ret != APP_JSON_OK) {
+            return ret;
+        }
+
+        APP_JSON_SkipWs(ps);
+        if (APP_JSON_AtEnd(ps)) {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        if (*ps->p == ']') {
+            ps->p++;
+            return APP_JSON_OK;
+        }
+        if (*ps->p != ',') {
+            return APP_JSON_ERR_SYNTAX;
+        }
+        ps->p++;
+        seg->index++;
+    }
+}
+
+static APP_JSON_RESULT APP_JSON_ParseValue(APP_JSON_PARSER *ps) {
+    APP_JSON_VALUE value;
+    APP_JSON_RESULT ret;
+
+    APP_JSON_SkipWs(ps);
+    if (APP_JSON_AtEnd(ps)) {
+        return APP_JSON_ERR_SYNTAX;
+    }
+
+    memset(&value, 0, sizeof (value));
+    switch (*ps->p) {
+        case '{':
+            return APP_JSON_ParseObject(ps);
+        case '[':
+            return APP_JSON_ParseArray(ps);
+        case '"':
+            value.type = APP_JSON_TYPE_STRING;
+            ret = APP_JSON_ParseString(ps, &value.str, &value.len);
+            break;
+        case 't':
+            value.type = APP_JSON_TYPE_BOOL;
+            value.intValue = 1;
+            ret = APP_JSON_ParseLiteral(ps, "true", &value);
+            break;
+        case 'f':
+            value.type = APP_JSON_TYPE_BOOL;
+            ret = APP_JSON_ParseLiteral(ps, "false", &value);
+            break;
+        case 'n':
+            value.type = APP_JSON_TYPE_NULL;
+            ret = APP_JSON_ParseLiteral(ps, "null", &value);
+            break;
+        default:
+            ret = APP_JSON_ParseNumber(ps, &value);
+            break;
+    }
+
+    if (ret == APP_JSON_OK) {
+        APP_JSON_Dispatch(ps, &value);
+    }
+    return ret;
+}
+
+APP_JSON_RESULT APP_JSON_Parse(const char *json, size_t len, const APP_JSON_HANDLER *handlers, uint8_t nHandlers, size_t *errPos) {
+    APP_JSON_PARSER ps;
+    APP_JSON_RESULT ret;
+
+    ps.start = json;
+    ps.p = json;
+    ps.end = json + len;
+    ps.handlers = handlers;
+    ps.nHandlers = nHandlers;
+    ps.depth = 0;
+
+    ret = APP_JSON_ParseValue(&ps);
+    if (ret == APP_JSON_OK) {
+        APP_JSON_SkipWs(&ps);
+        if (!APP_JSON_AtEnd(&ps)) {
+            ret = APP_JSON_ERR_SYNTAX;
+        }
+    }
+    if ((ret != APP_JSON_OK) && (errPos != NULL)) {
+        *errPos = ps.p - ps.start;
+    }
+    return ret;
+}
+
+bool APP_JSON_StringCopy(const APP_JSON_VALUE *value, char *buf, size_t size) {
+    const char *s = value->str;
+    const char *end = value->str + value->len;
+    size_t n = 0;
+
+    while (s < end) {
+        char c = *s++;
+
+        if ((c == '\\') && (s < end)) {
+            c = *s++;
+            switch (c) {
+                case 'b': c = '\b';
+                    break;
+                case 'f': c = '\f';
+                    break;
+                case 'n': c = '\n';
+                    break;
+                case 'r': c = '\r';
+                    break;
+                case 't': c = '\t';
+                    break;
+                case 'u':
+                {
+                    uint16_t cp = 0;
+                    int i;
+
+                    for (i = 0; (i < 4) && (s < end); i++, s++) {
+                        cp <<= 4;
+                        if ((*s >= '0') && (*s <= '9')) {
+                            cp |= *s - '0';
+                        } else if (((*s | 0x20) >= 'a') && ((*s | 0x20) <= 'f')) {
+                            cp |= (*s | 0x20) - 'a' + 10;
+                        }
+                    }
+                    /*the config strings are ASCII*/
+                    c = (cp < 0x80) ? (char) cp : '?';
+                    break;
+                }
+                default: /* " \ / */
+                    break;
+            }
+        }
+        if (n + 1 >= size) {
+            return false;
+        }
+        buf[n++] = c;
+    }
+    if (size == 0) {
+        return false;
+    }
+    buf[n] = '\0';
+    return true;
+}
+
+void APP_JSON_GetInt(const APP_JSON_VALUE *value, void *cookie) {
+    if ((value->type == APP_JSON_TYPE_NUMBER) || (value->type == APP_JSON_TYPE_BOOL)) {
+        *(int32_t *) cookie = value->intValue;
+    }
+}
+
+void APP_JSON_GetString(const APP_JSON_VALUE *value, void *cookie) {
+    APP_JSON_STRING_BUF *sb = (APP_JSON_STRING_BUF *) cookie;
+
+    if (value->type == APP_JSON_TYPE_STRING) {
+        sb->found = APP_JSON_StringCopy(value, sb->buf, sb->size);
+    }
+}
+
+/*******************************************************************************
+ End of File
+ */
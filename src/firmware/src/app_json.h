@@ -0,0 +1,111 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_json.h
+
+  Summary:
+    Streaming JSON parser with JSON pointer callbacks.
+
+  Description:
+    APP_JSON_Parse() walks a JSON text in place and calls the registered
+    handlers for the scalar values found at their JSON pointer paths
+    (e.g. "/state/toggle"). Nothing is allocated: the parser keeps the current
+    path on a fixed stack of APP_JSON_MAX_DEPTH levels and string values point
+    into the input buffer.
+
+    Pointer segments are compared with the raw member names, the "~0"/"~1"
+    escapes of RFC 6901 are not supported. Array elements are addressed by
+    their index ("/s/0/1").
+*******************************************************************************/
+
+#ifndef _APP_JSON_H
+#define _APP_JSON_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+#define APP_JSON_MAX_DEPTH 8
+
+typedef enum
+{
+    APP_JSON_OK = 0,
+    APP_JSON_ERR_SYNTAX = -1,
+    APP_JSON_ERR_DEPTH = -2,
+} APP_JSON_RESULT;
+
+typedef enum
+{
+    APP_JSON_TYPE_STRING = 0,
+    APP_JSON_TYPE_NUMBER,
+    APP_JSON_TYPE_BOOL,
+    APP_JSON_TYPE_NULL,
+} APP_JSON_TYPE;
+
+typedef struct
+{
+    APP_JSON_TYPE type;
+    const char *str;        /*raw text of the value, string quotes excluded, escapes not resolved*/
+    size_t len;
+    int32_t intValue;       /*numbers: integer part, bools: 0/1*/
+} APP_JSON_VALUE;
+
+typedef void (*APP_JSON_CALLBACK)(const APP_JSON_VALUE *value, void *cookie);
+
+typedef struct
+{
+    const char *pointer;
+    APP_JSON_CALLBACK callback;
+    void *cookie;
+} APP_JSON_HANDLER;
+
+/*cookie for APP_JSON_GetString()*/
+typedef struct
+{
+    char *buf;
+    size_t size;
+    bool found;
+} APP_JSON_STRING_BUF;
+
+/*Parses len bytes of json (parsing also stops at a NUL). On error *errPos,
+  if not NULL, gets the offset at which parsing failed.*/
+APP_JSON_RESULT APP_JSON_Parse(const char *json, size_t len, const APP_JSON_HANDLER *handlers, uint8_t nHandlers, size_t *errPos);
+
+/*Copies a string value to buf, resolving the escapes. Returns false if it does not fit.*/
+bool APP_JSON_StringCopy(const APP_JSON_VALUE *value, char *buf, size_t size);
+
+/*Ready made callbacks. GetInt takes an int32_t* cookie and accepts numbers and
+  bools, GetString takes an APP_JSON_STRING_BUF* cookie.*/
+void APP_JSON_GetInt(const APP_JSON_VALUE *value, void *cookie);
+
+void APP_JSON_GetString(const APP_JSON_VALUE *value, void *cookie);
+
+#endif /* _APP_JSON_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,473 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_nvrec.c
+
+  Summary:
+    Small non-volatile record store on the SST26 flash.
+
+  Description:
+    Two sector log of records, see app_nvrec.h. A record never crosses a page
+    so that it is programmed with a single page write, and the records of a
+    page are packed from its start: the first erased header ends the page.
+    Like the spool, every flash access is done with DRV_MEMORY reserved
+    through DRV_MEMORY_DeviceAccessLock().
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+
+#include "app_nvrec.h"
+#include "definitions.h"
+#include "semphr.h"
+
+#ifdef APP_FLASH_RESERVED_ENABLE
+
+#define APP_NVREC_SECTOR_MAGIC      0x4E565231UL /*"NVR1"*/
+#define APP_NVREC_RECORD_VALID      0xA5U
+#define APP_NVREC_LOCK_RETRIES      50
+/*the sector header is followed by the first record*/
+#define APP_NVREC_FIRST_OFFSET      16U
+#define APP_NVREC_ALIGN(x)          (((x) + 3U) & ~3U)
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t eraseCount;
+    uint32_t check;
+} APP_NVREC_SECTOR_HDR;
+
+typedef struct
+{
+    uint8_t id;             /*0xFF: free*/
+    uint8_t state;
+    uint16_t len;
+    uint16_t crc;           /*CRC-16/CCITT over id, len and the data*/
+    uint16_t reserved;
+} APP_NVREC_HDR;
+
+typedef struct
+{
+    DRV_HANDLE hSst26;
+    SemaphoreHandle_t mutex;
+    bool ready;
+    uint8_t active;
+    uint32_t seq;
+    uint32_t eraseCount[APP_NVREC_SECTORS];
+    /*next free byte of the active sector*/
+    uint16_t head;
+    /*latest copy of every record in the active sector, 0: none*/
+    uint16_t offset[APP_NVREC_ID_MAX];
+} APP_NVREC_DATA;
+
+static APP_NVREC_DATA app_nvrecData;
+
+static CACHE_ALIGN uint8_t nvrecPageBuf[DRV_SST26_PAGE_SIZE];
+/*record being moved while compacting*/
+static uint8_t nvrecRecBuf[DRV_SST26_PAGE_SIZE];
+
+static inline uint32_t APP_NVREC_SectorAddr(uint8_t sector) {
+    return APP_NVREC_FLASH_START + ((uint32_t) sector * APP_NVREC_SECTOR_SIZE);
+}
+
+static inline uint16_t APP_NVREC_PageBase(uint16_t offset) {
+    return offset & ~(DRV_SST26_PAGE_SIZE - 1U);
+}
+
+static uint16_t APP_NVREC_Crc(uint16_t crc, const uint8_t *p, size_t len) {
+    size_t i;
+    int bit;
+
+    for (i = 0; i < len; i++) {
+        crc ^= (uint16_t) p[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t APP_NVREC_RecordCrc(const APP_NVREC_HDR *hdr, const uint8_t *data) {
+    uint16_t crc = APP_NVREC_Crc(0xFFFF, &hdr->id, 1);
+
+    crc = APP_NVREC_Crc(crc, (const uint8_t *) &hdr->len, sizeof (hdr->len));
+    return APP_NVREC_Crc(crc, data, hdr->len);
+}
+
+/*Where a record of len bytes goes if the free space starts at head*/
+static uint16_t APP_NVREC_Place(uint16_t head, uint16_t len) {
+    if ((head - APP_NVREC_PageBase(head)) + APP_NVREC_HDR_SIZE + len > DRV_SST26_PAGE_SIZE) {
+        return APP_NVREC_PageBase(head) + DRV_SST26_PAGE_SIZE;
+    }
+    return head;
+}
+
+/*DRV_MEMORY only hands out the device in between two of its own requests*/
+static bool APP_NVREC_Lock(void) {
+    int i;
+    for (i = 0; i < APP_NVREC_LOCK_RETRIES; i++) {
+        if (DRV_MEMORY_DeviceAccessLock(sysObj.drvMemory0)) {
+            return true;
+        }
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+static void APP_NVREC_Unlock(void) {
+    DRV_MEMORY_DeviceAccessUnlock(sysObj.drvMemory0);
+}
+
+static bool APP_NVREC_WaitTransfer(bool sleep) {
+    DRV_SST26_TRANSFER_STATUS status;
+
+    while ((status = DRV_SST26_TransferStatusGet(app_nvrecData.hSst26)) == DRV_SST26_TRANSFER_BUSY) {
+        if (sleep) {
+            vTaskDelay(1);
+        } else {
+            taskYIELD();
+        }
+    }
+    return status == DRV_SST26_TRANSFER_COMPLETED;
+}
+
+/*Reads one page of a sector into nvrecPageBuf*/
+static bool APP_NVREC_ReadPage(uint8_t sector, uint16_t pageBase) {
+    bool ret = false;
+
+    if (!APP_NVREC_Lock()) {
+        return false;
+    }
+    if (DRV_SST26_Read(app_nvrecData.hSst26, nvrecPageBuf, DRV_SST26_PAGE_SIZE, APP_NVREC_SectorAddr(sector) + pageBase)) {
+        ret = APP_NVREC_WaitTransfer(false);
+    }
+    APP_NVREC_Unlock();
+    return ret;
+}
+
+/*Programs nvrecPageBuf. Bytes left at 0xFF do not change the flash contents.*/
+static bool APP_NVREC_ProgramPage(uint8_t sector, uint16_t pageBase) {
+    bool ret = false;
+
+    if (!APP_NVREC_Lock()) {
+        return false;
+    }
+    if (DRV_SST26_PageWrite(app_nvrecData.hSst26, nvrecPageBuf, APP_NVREC_SectorAddr(sector) + pageBase)) {
+        ret = APP_NVREC_WaitTransfer(true);
+    }
+    APP_NVREC_Unlock();
+    return ret;
+}
+
+static bool APP_NVREC_EraseSector(uint8_t sector) {
+    bool ret = false;
+
+    if (!APP_NVREC_Lock()) {
+        return false;
+    }
+    if (DRV_SST26_SectorErase(app_nvrecData.hSst26, APP_NVREC_SectorAddr(sector))) {
+        ret = APP_NVREC_WaitTransfer(true);
+    }
+    APP_NVREC_Unlock();
+    if (ret) {
+        app_nvrecData.eraseCount[sector]++;
+    }
+    return ret;
+}
+
+static bool APP_NVREC_ProgramRecord(uint8_t sector, uint16_t offset, uint8_t id, const void *data, uint16_t len) {
+    APP_NVREC_HDR hdr;
+    uint16_t pageBase = APP_NVREC_PageBase(offset);
+
+    hdr.id = id;
+    hdr.state = APP_NVREC_RECORD_VALID;
+    hdr.len = len;
+    hdr.reserved = 0xFFFF;
+    hdr.crc = APP_NVREC_RecordCrc(&hdr, data);
+
+    memset(nvrecPageBuf, 0xFF, sizeof (nvrecPageBuf));
+    memcpy(&nvrecPageBuf[offset - pageBase], &hdr, sizeof (hdr));
+    memcpy(&nvrecPageBuf[offset - pageBase + APP_NVREC_HDR_SIZE], data, len);
+    return APP_NVREC_ProgramPage(sector, pageBase);
+}
+
+static bool APP_NVREC_ReadHeader(uint8_t sector, APP_NVREC_SECTOR_HDR *hdr) {
+    if (!APP_NVREC_ReadPage(sector, 0)) {
+        return false;
+    }
+    memcpy(hdr, nvrecPageBuf, sizeof (*hdr));
+    return true;
+}
+
+static bool APP_NVREC_HeaderIsValid(const APP_NVREC_SECTOR_HDR *hdr) {
+    return (hdr->magic == APP_NVREC_SECTOR_MAGIC) &&
+            (hdr->check == ~(hdr->magic ^ hdr->seq ^ hdr->eraseCount));
+}
+
+/*The header goes in last, it is what makes a sector valid*/
+static bool APP_NVREC_WriteHeader(uint8_t sector, uint32_t seq) {
+    APP_NVREC_SECTOR_HDR hdr;
+
+    hdr.magic = APP_NVREC_SECTOR_MAGIC;
+    hdr.seq = seq;
+    hdr.eraseCount = app_nvrecData.eraseCount[sector];
+    hdr.check = ~(hdr.magic ^ hdr.seq ^ hdr.eraseCount);
+    memset(nvrecPageBuf, 0xFF, sizeof (nvrecPageBuf));
+    memcpy(nvrecPageBuf, &hdr, sizeof (hdr));
+    return APP_NVREC_ProgramPage(sector, 0);
+}
+
+/*Rebuilds the record index and the head of the active sector*/
+static bool APP_NVREC_ScanSector(uint8_t sector) {
+    APP_NVREC_DATA *s = &app_nvrecData;
+    uint16_t pageBase;
+
+    memset(s->offset, 0, sizeof (s->offset));
+    s->head = APP_NVREC_FIRST_OFFSET;
+    for (pageBase = 0; pageBase < APP_NVREC_SECTOR_SIZE; pageBase += DRV_SST26_PAGE_SIZE) {
+        uint16_t off = (pageBase == 0) ? APP_NVREC_FIRST_OFFSET : 0;
+
+        if (!APP_NVREC_ReadPage(sector, pageBase)) {
+            return false;
+        }
+        while (off + APP_NVREC_HDR_SIZE <= DRV_SST26_PAGE_SIZE) {
+            APP_NVREC_HDR hdr;
+
+            memcpy(&hdr, &nvrecPageBuf[off], sizeof (hdr));
+            if ((hdr.id == 0xFF) && (hdr.state == 0xFF) && (hdr.len == 0xFFFF)) {
+                break;
+            }
+            if ((hdr.state != APP_NVREC_RECORD_VALID) ||
+                    (off + APP_NVREC_HDR_SIZE + hdr.len > DRV_SST26_PAGE_SIZE) ||
+                    (hdr.crc != APP_NVREC_RecordCrc(&hdr, &nvrecPageBuf[off + APP_NVREC_HDR_SIZE]))) {
+                /*torn write: never program over the rest of this page*/
+                s->head = pageBase + DRV_SST26_PAGE_SIZE;
+                break;
+            }
+            if (hdr.id < APP_NVREC_ID_MAX) {
+                s->offset[hdr.id] = pageBase + off;
+            }
+            off += APP_NVREC_ALIGN(APP_NVREC_HDR_SIZE + hdr.len);
+            s->head = pageBase + off;
+        }
+    }
+    return true;
+}
+
+/*Moves the latest copy of every record but skipId to the other sector and
+  writes the new record there, then switches over*/
+static bool APP_NVREC_Compact(uint8_t skipId, const void *data, uint16_t len) {
+    APP_NVREC_DATA *s = &app_nvrecData;
+    uint8_t target = (s->active + 1) % APP_NVREC_SECTORS;
+    uint16_t newOffset[APP_NVREC_ID_MAX];
+    uint16_t head = APP_NVREC_FIRST_OFFSET;
+    uint16_t off;
+    uint8_t id;
+
+    if (!APP_NVREC_EraseSector(target)) {
+        return false;
+    }
+    memset(newOffset, 0, sizeof (newOffset));
+    for (id = 0; id < APP_NVREC_ID_MAX; id++) {
+        APP_NVREC_HDR hdr;
+        uint16_t src = s->offset[id];
+
+        if ((id == skipId) || (src == 0)) {
+            continue;
+        }
+        if (!APP_NVREC_ReadPage(s->active, APP_NVREC_PageBase(src))) {
+            return false;
+        }
+        memcpy(&hdr, &nvrecPageBuf[src - APP_NVREC_PageBase(src)], sizeof (hdr));
+        memcpy(nvrecRecBuf, &nvrecPageBuf[src - APP_NVREC_PageBase(src) + APP_NVREC_HDR_SIZE], hdr.len);
+        off = APP_NVREC_Place(head, hdr.len);
+        if (!APP_NVREC_ProgramRecord(target, off, id, nvrecRecBuf, hdr.len)) {
+            return false;
+        }
+        newOffset[id] = off;
+        head = off + APP_NVREC_ALIGN(APP_NVREC_HDR_SIZE + hdr.len);
+    }
+    off = APP_NVREC_Place(head, len);
+    if ((off + APP_NVREC_HDR_SIZE + len > APP_NVREC_SECTOR_SIZE) ||
+            !APP_NVREC_ProgramRecord(target, off, skipId, data, len)) {
+        return false;
+    }
+    newOffset[skipId] = off;
+    head = off + APP_NVREC_ALIGN(APP_NVREC_HDR_SIZE + len);
+    if (!APP_NVREC_WriteHeader(target, s->seq + 1)) {
+        return false;
+    }
+
+    s->active = target;
+    s->seq++;
+    s->head = head;
+    memcpy(s->offset, newOffset, sizeof (s->offset));
+    return true;
+}
+
+void APP_NVREC_Initialize(void) {
+    memset(&app_nvrecData, 0, sizeof (app_nvrecData));
+    app_nvrecData.hSst26 = DRV_HANDLE_INVALID;
+    app_nvrecData.mutex = xSemaphoreCreateMutex();
+}
+
+bool APP_NVREC_Mount(void) {
+    APP_NVREC_DATA *s = &app_nvrecData;
+    APP_NVREC_SECTOR_HDR hdr;
+    bool anyValid = false;
+    bool ret = false;
+    uint8_t i;
+
+    if (s->ready) {
+        return true;
+    }
+    if (DRV_MEMORY_Status(sysObj.drvMemory0) != SYS_STATUS_READY) {
+        return false;
+    }
+
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    if (s->hSst26 == DRV_HANDLE_INVALID) {
+        if (APP_NVREC_Lock()) {
+            s->hSst26 = DRV_SST26_Open(DRV_SST26_INDEX, DRV_IO_INTENT_READWRITE);
+            APP_NVREC_Unlock();
+        }
+        if (s->hSst26 == DRV_HANDLE_INVALID) {
+            goto out;
+        }
+    }
+
+    for (i = 0; i < APP_NVREC_SECTORS; i++) {
+        if (!APP_NVREC_ReadHeader(i, &hdr)) {
+            goto out;
+        }
+        if (!APP_NVREC_HeaderIsValid(&hdr)) {
+            continue;
+        }
+        s->eraseCount[i] = hdr.eraseCount;
+        if (!anyValid || (hdr.seq > s->seq)) {
+            s->active = i;
+            s->seq = hdr.seq;
+        }
+        anyValid = true;
+    }
+
+    if (!anyValid) {
+        /*blank area: start with an empty sector 0*/
+        s->active = 0;
+        s->seq = 1;
+        if (!APP_NVREC_EraseSector(0) || !APP_NVREC_WriteHeader(0, s->seq)) {
+            goto out;
+        }
+    }
+    if (!APP_NVREC_ScanSector(s->active)) {
+        goto out;
+    }
+    s->ready = true;
+    ret = true;
+
+out:
+    xSemaphoreGive(s->mutex);
+    return ret;
+}
+
+bool APP_NVREC_IsReady(void) {
+    return app_nvrecData.ready;
+}
+
+bool APP_NVREC_Read(APP_NVREC_ID id, void *buf, uint16_t size, uint16_t *len) {
+    APP_NVREC_DATA *s = &app_nvrecData;
+    APP_NVREC_HDR hdr;
+    uint16_t off;
+    bool ret = false;
+
+    if (!s->ready || (id >= APP_NVREC_ID_MAX)) {
+        return false;
+    }
+
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    off = s->offset[id];
+    if ((off != 0) && APP_NVREC_ReadPage(s->active, APP_NVREC_PageBase(off))) {
+        memcpy(&hdr, &nvrecPageBuf[off - APP_NVREC_PageBase(off)], sizeof (hdr));
+        if (len != NULL) {
+            *len = hdr.len;
+        }
+        if (hdr.len <= size) {
+            memcpy(buf, &nvrecPageBuf[off - APP_NVREC_PageBase(off) + APP_NVREC_HDR_SIZE], hdr.len);
+            ret = true;
+        }
+    }
+    xSemaphoreGive(s->mutex);
+    return ret;
+}
+
+bool APP_NVREC_Write(APP_NVREC_ID id, const void *data, uint16_t len) {
+    APP_NVREC_DATA *s = &app_nvrecData;
+    uint16_t off;
+    bool ret;
+
+    if (!s->ready || (id >= APP_NVREC_ID_MAX) || (len > APP_NVREC_MAX_LEN)) {
+        return false;
+    }
+
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    off = APP_NVREC_Place(s->head, len);
+    if (off + APP_NVREC_HDR_SIZE + len > APP_NVREC_SECTOR_SIZE) {
+        ret = APP_NVREC_Compact(id, data, len);
+    } else {
+        ret = APP_NVREC_ProgramRecord(s->active, off, id, data, len);
+        if (ret) {
+            s->offset[id] = off;
+            s->head = off + APP_NVREC_ALIGN(APP_NVREC_HDR_SIZE + len);
+        } else {
+            /*the page may hold a torn record now, do not use it again*/
+            s->head = APP_NVREC_PageBase(off) + DRV_SST26_PAGE_SIZE;
+        }
+    }
+    xSemaphoreGive(s->mutex);
+    return ret;
+}
+
+#else
+
+/*No SST26 area reserved below the FAT volume: there is no record store*/
+void APP_NVREC_Initialize(void) {
+}
+
+bool APP_NVREC_Mount(void) {
+    return false;
+}
+
+bool APP_NVREC_IsReady(void) {
+    return false;
+}
+
+bool APP_NVREC_Read(APP_NVREC_ID id, void *buf, uint16_t size, uint16_t *len) {
+    (void) id;
+    (void) buf;
+    (void) size;
+    (void) len;
+    return false;
+}
+
+bool APP_NVREC_Write(APP_NVREC_ID id, const void *data, uint16_t len) {
+    (void) id;
+    (void) data;
+    (void) len;
+    return false;
+}
+
+#endif /* APP_FLASH_RESERVED_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,89 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_nvrec.h
+
+  Summary:
+    Small non-volatile record store on the SST26 flash.
+
+  Description:
+    Keeps a handful of small binary records (up to APP_NVREC_MAX_LEN bytes,
+    identified by an APP_NVREC_ID) in two 4 KB sectors of the SST26 area
+    reserved below DRV_SST26_START_ADDRESS, next to the telemetry spool.
+    Without APP_FLASH_RESERVED_ENABLE there is no such area: the store is
+    never ready and every read and write fails.
+
+    A write appends a new copy of the record to the active sector, the last
+    valid copy of an id wins. When the active sector is full the latest copy
+    of every record is moved to the other sector, whose header is written
+    last: a reset at any point leaves either the old or the new sector valid.
+*******************************************************************************/
+
+#ifndef _APP_NVREC_H
+#define _APP_NVREC_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+#define APP_NVREC_SECTOR_SIZE       DRV_SST26_ERASE_BUFFER_SIZE
+#define APP_NVREC_SECTORS           2U
+#define APP_NVREC_HDR_SIZE          8U
+/*a record is programmed with a single page write*/
+#define APP_NVREC_MAX_LEN           (DRV_SST26_PAGE_SIZE - APP_NVREC_HDR_SIZE)
+
+/*Record ids, keep them below APP_NVREC_ID_MAX and never reuse a retired one*/
+typedef enum
+{
+    APP_NVREC_ID_DNS_BROKER = 1,    /*APP_DNS_CACHE_ENTRY of the MQTT broker*/
+    APP_NVREC_ID_WIFI_CONFIG,       /*app_cfgstore.h records*/
+    APP_NVREC_ID_CLOUD_CONFIG,
+    APP_NVREC_ID_MAX = 16,
+} APP_NVREC_ID;
+
+void APP_NVREC_Initialize(void);
+
+/*Scans the record area. Returns false while the memory driver is not
+  ready/busy, call again later.*/
+bool APP_NVREC_Mount(void);
+
+bool APP_NVREC_IsReady(void);
+
+/*Copies the record to buf. Returns false if there is none or it does not fit
+  size. *len, if not NULL, gets the record length.*/
+bool APP_NVREC_Read(APP_NVREC_ID id, void *buf, uint16_t size, uint16_t *len);
+
+/*Stores a new copy of the record. Programs the flash, may take a few ms (or a
+  sector erase when the area needs to be compacted).*/
+bool APP_NVREC_Write(APP_NVREC_ID id, const void *data, uint16_t len);
+
+#endif /* _APP_NVREC_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,598 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spool.c
+
+  Summary:
+    Store-and-forward telemetry spool on the SST26 flash.
+
+  Description:
+    Log structured ring of records on the SST26 area below
+    DRV_SST26_START_ADDRESS. See app_spool.h for the layout. Every flash access
+    is done with DRV_MEMORY reserved through DRV_MEMORY_DeviceAccessLock() so
+    that the FAT volume requests and the spool never share the SPI bus.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+
+#include "app_spool.h"
+#include "definitions.h"
+
+#ifdef APP_FLASH_RESERVED_ENABLE
+
+#define APP_SPOOL_SECTOR_MAGIC      0x53504C31UL /*"SPL1"*/
+#define APP_SPOOL_RECORD_VALID      0xA5U
+#define APP_SPOOL_LOCK_RETRIES      50
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t eraseCount;
+    uint32_t check;
+} APP_SPOOL_SECTOR_HDR;
+
+typedef struct
+{
+    uint8_t sector;
+    uint16_t slot;
+    uint32_t sectorSeq;
+} APP_SPOOL_BATCH_ENTRY;
+
+typedef struct
+{
+    DRV_HANDLE hSst26;
+    bool ready;
+    bool sectorValid[APP_SPOOL_SECTORS];
+    uint32_t sectorSeq[APP_SPOOL_SECTORS];
+    uint32_t eraseCount[APP_SPOOL_SECTORS];
+    uint16_t sectorPending[APP_SPOOL_SECTORS];
+    uint32_t lastSectorSeq;
+    /*next free slot*/
+    uint8_t headSector;
+    uint16_t headSlot;
+    /*oldest slot which may still be pending*/
+    uint8_t tailSector;
+    uint16_t tailSlot;
+    uint32_t nextSampleSeq;
+    APP_SPOOL_BATCH_ENTRY batch[APP_SPOOL_DRAIN_BATCH];
+    uint8_t batchCount;
+    uint32_t drainStartTick;
+    uint32_t drainStartCount;
+    APP_SPOOL_STATS stats;
+} APP_SPOOL_DATA;
+
+static APP_SPOOL_DATA app_spoolData;
+
+static CACHE_ALIGN uint8_t spoolPageBuf[DRV_SST26_PAGE_SIZE];
+
+static inline uint32_t APP_SPOOL_SectorAddr(uint8_t sector) {
+    return APP_SPOOL_FLASH_START + ((uint32_t) sector * APP_SPOOL_SECTOR_SIZE);
+}
+
+static inline uint32_t APP_SPOOL_SlotAddr(uint8_t sector, uint16_t slot) {
+    return APP_SPOOL_SectorAddr(sector) + ((uint32_t) slot * APP_SPOOL_RECORD_SIZE);
+}
+
+static inline uint32_t APP_SPOOL_PageAddr(uint32_t addr) {
+    return addr & ~(DRV_SST26_PAGE_SIZE - 1U);
+}
+
+/*CRC-16/CCITT over the record, except the consumed byte which is programmed later*/
+static uint16_t APP_SPOOL_RecordCrc(const APP_SPOOL_RECORD *rec) {
+    const uint8_t *p = (const uint8_t *) rec;
+    uint16_t crc = 0xFFFF;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < offsetof(APP_SPOOL_RECORD, crc); i++) {
+        if (i == offsetof(APP_SPOOL_RECORD, consumed)) {
+            continue;
+        }
+        crc ^= (uint16_t) p[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool APP_SPOOL_RecordIsErased(const uint8_t *p) {
+    int i;
+    for (i = 0; i < APP_SPOOL_RECORD_SIZE; i++) {
+        if (p[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool APP_SPOOL_RecordIsPending(const APP_SPOOL_RECORD *rec) {
+    return (rec->state == APP_SPOOL_RECORD_VALID) && (rec->consumed == 0xFF) &&
+            (rec->crc == APP_SPOOL_RecordCrc(rec));
+}
+
+/*DRV_MEMORY only hands out the device in between two of its own requests*/
+static bool APP_SPOOL_Lock(void) {
+    int i;
+    for (i = 0; i < APP_SPOOL_LOCK_RETRIES; i++) {
+        if (DRV_MEMORY_DeviceAccessLock(sysObj.drvMemory0)) {
+            return true;
+        }
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+static void APP_SPOOL_Unlock(void) {
+    DRV_MEMORY_DeviceAccessUnlock(sysObj.drvMemory0);
+}
+
+/*Reads are short, yield while they complete. Program and erase take ms.*/
+static bool APP_SPOOL_WaitTransfer(bool sleep) {
+    DRV_SST26_TRANSFER_STATUS status;
+
+    while ((status = DRV_SST26_TransferStatusGet(app_spoolData.hSst26)) == DRV_SST26_TRANSFER_BUSY) {
+        if (sleep) {
+            vTaskDelay(1);
+        } else {
+            taskYIELD();
+        }
+    }
+    if (status != DRV_SST26_TRANSFER_COMPLETED) {
+        app_spoolData.stats.flashErrors++;
+        return false;
+    }
+    return true;
+}
+
+static bool APP_SPOOL_FlashRead(void *buf, uint32_t len, uint32_t addr) {
+    if (!DRV_SST26_Read(app_spoolData.hSst26, buf, len, addr)) {
+        app_spoolData.stats.flashErrors++;
+        return false;
+    }
+    return APP_SPOOL_WaitTransfer(false);
+}
+
+/*Programs spoolPageBuf. Bytes left at 0xFF do not change the flash contents.*/
+static bool APP_SPOOL_FlashProgram(uint32_t pageAddr) {
+    if (!DRV_SST26_PageWrite(app_spoolData.hSst26, spoolPageBuf, pageAddr)) {
+        app_spoolData.stats.flashErrors++;
+        return false;
+    }
+    return APP_SPOOL_WaitTransfer(true);
+}
+
+static bool APP_SPOOL_FlashErase(uint32_t sectorAddr) {
+    if (!DRV_SST26_SectorErase(app_spoolData.hSst26, sectorAddr)) {
+        app_spoolData.stats.flashErrors++;
+        return false;
+    }
+    return APP_SPOOL_WaitTransfer(true);
+}
+
+static bool APP_SPOOL_ReadPage(uint32_t pageAddr) {
+    bool ret;
+
+    if (!APP_SPOOL_Lock()) {
+        return false;
+    }
+    ret = APP_SPOOL_FlashRead(spoolPageBuf, DRV_SST26_PAGE_SIZE, pageAddr);
+    APP_SPOOL_Unlock();
+    return ret;
+}
+
+/*Erase the sector following the head and give it the next sequence number.
+  Pending records still held there are lost.*/
+static bool APP_SPOOL_OpenSector(void) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    uint8_t next = (s->headSector + 1) % APP_SPOOL_SECTORS;
+    APP_SPOOL_SECTOR_HDR hdr;
+    bool ret = false;
+
+    if (s->sectorPending[next] != 0) {
+        s->stats.dropped += s->sectorPending[next];
+        s->stats.pending -= s->sectorPending[next];
+        s->sectorPending[next] = 0;
+        s->tailSector = (next + 1) % APP_SPOOL_SECTORS;
+        s->tailSlot = 1;
+    }
+    s->sectorValid[next] = false;
+
+    if (!APP_SPOOL_Lock()) {
+        return false;
+    }
+    if (APP_SPOOL_FlashErase(APP_SPOOL_SectorAddr(next))) {
+        s->eraseCount[next]++;
+        s->lastSectorSeq++;
+        hdr.magic = APP_SPOOL_SECTOR_MAGIC;
+        hdr.seq = s->lastSectorSeq;
+        hdr.eraseCount = s->eraseCount[next];
+        hdr.check = ~(hdr.magic ^ hdr.seq ^ hdr.eraseCount);
+        memset(spoolPageBuf, 0xFF, sizeof (spoolPageBuf));
+        memcpy(spoolPageBuf, &hdr, sizeof (hdr));
+        ret = APP_SPOOL_FlashProgram(APP_SPOOL_SectorAddr(next));
+    }
+    APP_SPOOL_Unlock();
+
+    /*the sector is used up even if the header was not written, move on*/
+    s->headSector = next;
+    s->headSlot = ret ? 1 : APP_SPOOL_SLOTS_PER_SECTOR;
+    if (ret) {
+        s->sectorValid[next] = true;
+        s->sectorSeq[next] = s->lastSectorSeq;
+        if (s->stats.pending == 0) {
+            s->tailSector = next;
+            s->tailSlot = 1;
+        }
+    }
+    return ret;
+}
+
+/*Walk the records of a valid sector and rebuild the head/tail/pending state*/
+static bool APP_SPOOL_ScanSector(uint8_t sector, bool *tailFound) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    APP_SPOOL_RECORD rec;
+    uint16_t slot;
+    uint16_t lastUsed = 0;
+
+    for (slot = 1; slot < APP_SPOOL_SLOTS_PER_SECTOR; slot++) {
+        uint32_t addr = APP_SPOOL_SlotAddr(sector, slot);
+        uint8_t *p = &spoolPageBuf[addr - APP_SPOOL_PageAddr(addr)];
+
+        if ((slot == 1) || ((addr & (DRV_SST26_PAGE_SIZE - 1U)) == 0)) {
+            if (!APP_SPOOL_ReadPage(APP_SPOOL_PageAddr(addr))) {
+                return false;
+            }
+        }
+        if (APP_SPOOL_RecordIsErased(p)) {
+            continue;
+        }
+        /*never program over a slot which may hold a torn write*/
+        lastUsed = slot;
+        memcpy(&rec, p, sizeof (rec));
+        if ((rec.state != APP_SPOOL_RECORD_VALID) || (rec.crc != APP_SPOOL_RecordCrc(&rec))) {
+            continue;
+        }
+        if (rec.seq >= s->nextSampleSeq) {
+            s->nextSampleSeq = rec.seq + 1;
+        }
+        if (rec.consumed == 0xFF) {
+            s->sectorPending[sector]++;
+            s->stats.pending++;
+            if (!*tailFound) {
+                *tailFound = true;
+                s->tailSector = sector;
+                s->tailSlot = slot;
+            }
+        }
+    }
+
+    if (sector == s->headSector) {
+        s->headSlot = lastUsed + 1;
+    }
+    return true;
+}
+
+void APP_SPOOL_Initialize(void) {
+    memset(&app_spoolData, 0, sizeof (app_spoolData));
+    app_spoolData.hSst26 = DRV_HANDLE_INVALID;
+    app_spoolData.stats.capacity = APP_SPOOL_CAPACITY;
+}
+
+bool APP_SPOOL_Mount(void) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    APP_SPOOL_SECTOR_HDR hdr;
+    bool anyValid = false;
+    bool tailFound = false;
+    uint8_t oldest = 0;
+    uint8_t i;
+
+    if (s->ready) {
+        return true;
+    }
+    if (DRV_MEMORY_Status(sysObj.drvMemory0) != SYS_STATUS_READY) {
+        return false;
+    }
+
+    if (s->hSst26 == DRV_HANDLE_INVALID) {
+        if (!APP_SPOOL_Lock()) {
+            return false;
+        }
+        s->hSst26 = DRV_SST26_Open(DRV_SST26_INDEX, DRV_IO_INTENT_READWRITE);
+        APP_SPOOL_Unlock();
+        if (s->hSst26 == DRV_HANDLE_INVALID) {
+            return false;
+        }
+    }
+
+    s->stats.pending = 0;
+    s->nextSampleSeq = 0;
+    s->lastSectorSeq = 0;
+    for (i = 0; i < APP_SPOOL_SECTORS; i++) {
+        s->sectorPending[i] = 0;
+        s->sectorValid[i] = false;
+        s->eraseCount[i] = 0;
+        if (!APP_SPOOL_ReadPage(APP_SPOOL_SectorAddr(i))) {
+            return false;
+        }
+        memcpy(&hdr, spoolPageBuf, sizeof (hdr));
+        if ((hdr.magic != APP_SPOOL_SECTOR_MAGIC) || (hdr.check != ~(hdr.magic ^ hdr.seq ^ hdr.eraseCount))) {
+            continue;
+        }
+        s->sectorValid[i] = true;
+        s->sectorSeq[i] = hdr.seq;
+        s->eraseCount[i] = hdr.eraseCount;
+        if (!anyValid || (hdr.seq > s->lastSectorSeq)) {
+            s->lastSectorSeq = hdr.seq;
+            s->headSector = i;
+        }
+        if (!anyValid || (hdr.seq < s->sectorSeq[oldest])) {
+            oldest = i;
+        }
+        anyValid = true;
+    }
+
+    if (!anyValid) {
+        /*blank spool: the first write opens sector 0*/
+        s->headSector = APP_SPOOL_SECTORS - 1;
+        s->headSlot = APP_SPOOL_SLOTS_PER_SECTOR;
+        s->tailSector = 0;
+        s->tailSlot = 1;
+    } else {
+        /*sectors are allocated in ring order, so walk from the oldest to the head*/
+        i = oldest;
+        while (true) {
+            if (s->sectorValid[i] && !APP_SPOOL_ScanSector(i, &tailFound)) {
+                return false;
+            }
+            if (i == s->headSector) {
+                break;
+            }
+            i = (i + 1) % APP_SPOOL_SECTORS;
+        }
+        if (!tailFound) {
+            s->tailSector = s->headSector;
+            s->tailSlot = s->headSlot;
+        }
+    }
+
+    s->batchCount = 0;
+    s->ready = true;
+    s->stats.ready = true;
+    SYS_CONSOLE_PRINT("APP_SPOOL: %u records pending\r\n", (unsigned) s->stats.pending);
+    return true;
+}
+
+bool APP_SPOOL_IsReady(void) {
+    return app_spoolData.ready;
+}
+
+uint32_t APP_SPOOL_PendingCount(void) {
+    return app_spoolData.stats.pending;
+}
+
+bool APP_SPOOL_Write(APP_SPOOL_RECORD *rec) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    uint32_t addr;
+    bool ret;
+
+    if (!s->ready) {
+        return false;
+    }
+    if (s->headSlot >= APP_SPOOL_SLOTS_PER_SECTOR) {
+        if (!APP_SPOOL_OpenSector()) {
+            return false;
+        }
+    }
+
+    rec->state = APP_SPOOL_RECORD_VALID;
+    rec->consumed = 0xFF;
+    rec->seq = s->nextSampleSeq;
+    rec->crc = APP_SPOOL_RecordCrc(rec);
+
+    addr = APP_SPOOL_SlotAddr(s->headSector, s->headSlot);
+    memset(spoolPageBuf, 0xFF, sizeof (spoolPageBuf));
+    memcpy(&spoolPageBuf[addr - APP_SPOOL_PageAddr(addr)], rec, sizeof (*rec));
+
+    if (!APP_SPOOL_Lock()) {
+        return false;
+    }
+    ret = APP_SPOOL_FlashProgram(APP_SPOOL_PageAddr(addr));
+    APP_SPOOL_Unlock();
+
+    /*the slot is not reused even if the program failed half way*/
+    s->headSlot++;
+    if (ret) {
+        if (s->stats.pending == 0) {
+            s->tailSector = s->headSector;
+            s->tailSlot = s->headSlot - 1;
+        }
+        s->nextSampleSeq++;
+        s->sectorPending[s->headSector]++;
+        s->stats.pending++;
+        s->stats.written++;
+    }
+    return ret;
+}
+
+uint8_t APP_SPOOL_ReadBatch(APP_SPOOL_RECORD *recs, uint8_t maxRecs) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    uint8_t sector = s->tailSector;
+    uint16_t slot = s->tailSlot;
+    uint32_t pageAddr = 0xFFFFFFFF;
+
+    s->batchCount = 0;
+    if (!s->ready || (s->stats.pending == 0)) {
+        return 0;
+    }
+    if (maxRecs > APP_SPOOL_DRAIN_BATCH) {
+        maxRecs = APP_SPOOL_DRAIN_BATCH;
+    }
+
+    while (s->batchCount < maxRecs) {
+        uint32_t addr;
+
+        if ((sector == s->headSector) && ((slot >= s->headSlot) || !s->sectorValid[sector])) {
+            break;
+        }
+        if ((slot >= APP_SPOOL_SLOTS_PER_SECTOR) || !s->sectorValid[sector]) {
+            sector = (sector + 1) % APP_SPOOL_SECTORS;
+            slot = 1;
+            continue;
+        }
+        addr = APP_SPOOL_SlotAddr(sector, slot);
+        if (APP_SPOOL_PageAddr(addr) != pageAddr) {
+            pageAddr = APP_SPOOL_PageAddr(addr);
+            if (!APP_SPOOL_ReadPage(pageAddr)) {
+                break;
+            }
+        }
+        memcpy(&recs[s->batchCount], &spoolPageBuf[addr - pageAddr], sizeof (APP_SPOOL_RECORD));
+        if (APP_SPOOL_RecordIsPending(&recs[s->batchCount])) {
+            s->batch[s->batchCount].sector = sector;
+            s->batch[s->batchCount].slot = slot;
+            s->batch[s->batchCount].sectorSeq = s->sectorSeq[sector];
+            s->batchCount++;
+        } else if (s->batchCount == 0) {
+            /*nothing pending before this slot*/
+            s->tailSector = sector;
+            s->tailSlot = slot + 1;
+        }
+        slot++;
+    }
+    return s->batchCount;
+}
+
+bool APP_SPOOL_Commit(uint8_t nRecs) {
+    APP_SPOOL_DATA *s = &app_spoolData;
+    uint32_t pageAddr = 0xFFFFFFFF;
+    uint32_t elapsed;
+    bool ret = true;
+    uint8_t i;
+
+    if (nRecs > s->batchCount) {
+        nRecs = s->batchCount;
+    }
+    if (!s->ready || (nRecs == 0)) {
+        return false;
+    }
+    if (!APP_SPOOL_Lock()) {
+        return false;
+    }
+
+    /*clear the consumed bytes, one page program per page touched*/
+    memset(spoolPageBuf, 0xFF, sizeof (spoolPageBuf));
+    for (i = 0; i < nRecs; i++) {
+        APP_SPOOL_BATCH_ENTRY *e = &s->batch[i];
+        uint32_t addr = APP_SPOOL_SlotAddr(e->sector, e->slot);
+
+        if (!s->sectorValid[e->sector] || (s->sectorSeq[e->sector] != e->sectorSeq)) {
+            continue; /*sector recycled meanwhile, already counted as dropped*/
+        }
+        if ((pageAddr != 0xFFFFFFFF) && (APP_SPOOL_PageAddr(addr) != pageAddr)) {
+            ret = APP_SPOOL_FlashProgram(pageAddr) && ret;
+            memset(spoolPageBuf, 0xFF, sizeof (spoolPageBuf));
+        }
+        pageAddr = APP_SPOOL_PageAddr(addr);
+        spoolPageBuf[addr - pageAddr + offsetof(APP_SPOOL_RECORD, consumed)] = 0x00;
+
+        s->sectorPending[e->sector]--;
+        s->stats.pending--;
+        s->stats.drained++;
+        s->tailSector = e->sector;
+        s->tailSlot = e->slot + 1;
+    }
+    if (pageAddr != 0xFFFFFFFF) {
+        ret = APP_SPOOL_FlashProgram(pageAddr) && ret;
+    }
+    APP_SPOOL_Unlock();
+
+    s->batchCount = 0;
+
+    elapsed = (xTaskGetTickCount() - s->drainStartTick) * portTICK_PERIOD_MS;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    s->stats.drainRate = (uint32_t) (((uint64_t) (s->stats.drained - s->drainStartCount) * 1000) / elapsed);
+    return ret;
+}
+
+void APP_SPOOL_DrainStart(void) {
+    app_spoolData.drainStartTick = xTaskGetTickCount();
+    app_spoolData.drainStartCount = app_spoolData.stats.drained;
+}
+
+void APP_SPOOL_StatsGet(APP_SPOOL_STATS *stats) {
+    uint8_t i;
+
+    *stats = app_spoolData.stats;
+    stats->eraseMin = 0xFFFFFFFF;
+    stats->eraseMax = 0;
+    for (i = 0; i < APP_SPOOL_SECTORS; i++) {
+        if (app_spoolData.eraseCount[i] < stats->eraseMin) {
+            stats->eraseMin = app_spoolData.eraseCount[i];
+        }
+        if (app_spoolData.eraseCount[i] > stats->eraseMax) {
+            stats->eraseMax = app_spoolData.eraseCount[i];
+        }
+    }
+}
+
+#else
+
+/*No SST26 area reserved below the FAT volume: nothing is spooled and the
+  samples taken while MQTT is down are not kept*/
+void APP_SPOOL_Initialize(void) {
+}
+
+bool APP_SPOOL_Mount(void) {
+    return false;
+}
+
+bool APP_SPOOL_IsReady(void) {
+    return false;
+}
+
+uint32_t APP_SPOOL_PendingCount(void) {
+    return 0;
+}
+
+bool APP_SPOOL_Write(APP_SPOOL_RECORD *rec) {
+    (void) rec;
+    return false;
+}
+
+uint8_t APP_SPOOL_ReadBatch(APP_SPOOL_RECORD *recs, uint8_t maxRecs) {
+    (void) recs;
+    (void) maxRecs;
+    return 0;
+}
+
+bool APP_SPOOL_Commit(uint8_t nRecs) {
+    (void) nRecs;
+    return false;
+}
+
+void APP_SPOOL_DrainStart(void) {
+}
+
+void APP_SPOOL_StatsGet(APP_SPOOL_STATS *stats) {
+    memset(stats, 0, sizeof (*stats));
+}
+
+#endif /* APP_FLASH_RESERVED_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,125 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spool.h
+
+  Summary:
+    Store-and-forward telemetry spool on the SST26 flash.
+
+  Description:
+    Telemetry samples which cannot be published while the MQTT connection is
+    down are appended to a log on the SST26 area reserved below
+    DRV_SST26_START_ADDRESS with APP_FLASH_RESERVED_ENABLE. Without it the
+    spool is never ready and nothing is stored. The FAT volume starts above that area, so the
+    spool is accessed through DRV_SST26 directly while DRV_MEMORY is idle.
+
+    The area is used as a ring of 4 KB sectors. Each sector starts with a
+    header slot holding a sequence number and the erase count of the sector,
+    followed by fixed size records. A record is programmed once when written
+    and its "consumed" byte is cleared once the cloud has acknowledged it, so
+    a reset at any point re-sends at most the batch which was in flight.
+    When the ring is full the oldest sector is recycled and its pending
+    records are counted as dropped.
+*******************************************************************************/
+
+#ifndef _APP_SPOOL_H
+#define _APP_SPOOL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+#define APP_SPOOL_SECTOR_SIZE       DRV_SST26_ERASE_BUFFER_SIZE
+#ifdef APP_FLASH_RESERVED_ENABLE
+#define APP_SPOOL_SECTORS           (APP_SPOOL_FLASH_SIZE / APP_SPOOL_SECTOR_SIZE)
+#endif
+#define APP_SPOOL_RECORD_SIZE       16U
+#define APP_SPOOL_RECORDS_PER_PAGE  (DRV_SST26_PAGE_SIZE / APP_SPOOL_RECORD_SIZE)
+#define APP_SPOOL_SLOTS_PER_SECTOR  (APP_SPOOL_SECTOR_SIZE / APP_SPOOL_RECORD_SIZE)
+/*slot 0 of every sector holds the sector header*/
+#ifdef APP_FLASH_RESERVED_ENABLE
+#define APP_SPOOL_CAPACITY          (APP_SPOOL_SECTORS * (APP_SPOOL_SLOTS_PER_SECTOR - 1U))
+#endif
+
+/*One telemetry sample as stored on flash. Keep it APP_SPOOL_RECORD_SIZE bytes.*/
+typedef struct
+{
+    uint8_t state;          /*0xFF: free slot*/
+    uint8_t consumed;       /*0xFF: pending, cleared once acknowledged*/
+    int16_t temp;
+    uint32_t timestamp;     /*SNTP UTC seconds, 0 if time was not known*/
+    uint32_t seq;           /*sample number, lets the cloud drop duplicates*/
+    uint8_t switchStatus;
+    int8_t rssi;            /*dBm, 0 if not known*/
+    uint16_t crc;
+} APP_SPOOL_RECORD;
+
+typedef struct
+{
+    uint32_t pending;       /*records waiting to be drained*/
+    uint32_t capacity;
+    uint32_t written;
+    uint32_t drained;
+    uint32_t dropped;       /*pending records lost to sector recycling*/
+    uint32_t flashErrors;
+    uint32_t drainRate;     /*records/s over the current/last drain run*/
+    uint32_t eraseMin;
+    uint32_t eraseMax;
+    bool ready;
+} APP_SPOOL_STATS;
+
+void APP_SPOOL_Initialize(void);
+
+/*Scans the spool area and rebuilds the ring state. Returns false while the
+  memory driver is not ready/busy, call again later.*/
+bool APP_SPOOL_Mount(void);
+
+bool APP_SPOOL_IsReady(void);
+
+uint32_t APP_SPOOL_PendingCount(void);
+
+/*Appends a sample. state, consumed, seq and crc are filled in by the spool.*/
+bool APP_SPOOL_Write(APP_SPOOL_RECORD *rec);
+
+/*Reads up to maxRecs of the oldest pending records without consuming them.
+  Returns the number of records read. A new read discards the previous one.*/
+uint8_t APP_SPOOL_ReadBatch(APP_SPOOL_RECORD *recs, uint8_t maxRecs);
+
+/*Marks the first nRecs records of the last APP_SPOOL_ReadBatch as consumed.*/
+bool APP_SPOOL_Commit(uint8_t nRecs);
+
+/*Called on (re)connect so that the drain rate covers the current run only.*/
+void APP_SPOOL_DrainStart(void);
+
+void APP_SPOOL_StatsGet(APP_SPOOL_STATS *stats);
+
+#endif /* _APP_SPOOL_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
@@ -31,6 +31,7 @@
 #include <string.h>
 #include "app_wifi.h"
 #include "app_control.h"
+#include "sys_tasks.h"
 
 typedef struct {
     APP_WIFI_STATES state;
@@ -60,6 +61,8 @@ void WiFiServCallback(uint32_t event, void * data, void *cookie)
             break;
         }
     }
+    APP_RTOS_Notify(xAPP_WIFI_Tasks);
+    APP_RTOS_Notify(xAPP_CONTROL_Tasks);
 }
 
 void APP_WIFI_Initialize(void) {
@@ -81,9 +84,11 @@ void APP_WIFI_Tasks(void) {
                 SYS_CONSOLE_MESSAGE("APP_WIFI: " TERM_RED "Failed registering Wi-Fi control message\r\n" TERM_RESET);
             }
             app_wifiData.state=APP_WIFI_CONFIG;
+            APP_RTOS_PollRequest(APP_RTOS_TASK_APP_WIFI);
         break;
      case APP_WIFI_CONFIG:
             if (true == app_controlData.wifiCtrl.wifiCtrlValid) {
+                app_controlData.wifiCtrl.wifiCtrlChanged = false;
                 wifiConfig.mode=SYS_WIFI_STA;
                 wifiConfig.saveConfig=0;
                 strncpy((char*)&wifiConfig.countryCode,WIFI_DEFAULT_REG_DOMAIN,strlen(WIFI_DEFAULT_REG_DOMAIN)+1);
@@ -104,12 +109,17 @@ void APP_WIFI_Tasks(void) {
             }
          break;
      case APP_WIFI_CONNECT:
-         if (true==app_wifiData.isConnected){
+     case APP_WIFI_IDLE:
+         /*WIFI.CFG edited over USB: SYS_WIFI reconnects with the new config*/
+         if (true==app_controlData.wifiCtrl.wifiCtrlChanged){
+             SYS_CONSOLE_MESSAGE("APP_WIFI: Applying the new Wi-Fi config\r\n");
+             app_wifiData.isConnected=false;
+             app_wifiData.state=APP_WIFI_CONFIG;
+             APP_RTOS_PollRequest(APP_RTOS_TASK_APP_WIFI);
+         } else if ((APP_WIFI_CONNECT==app_wifiData.state) && (true==app_wifiData.isConnected)){
              app_wifiData.state=APP_WIFI_IDLE;
          }
          break;
-     case APP_WIFI_IDLE:
-         break;
      case APP_WIFI_ERROR:
          break;
             
@@ -81,7 +81,7 @@ extern "C" {
 // *****************************************************************************
 /* TIME System Service Configuration Options */
 #define SYS_TIME_INDEX_0                            (0)
-#define SYS_TIME_MAX_TIMERS                         (5)
+#define SYS_TIME_MAX_TIMERS                         (6)
 #define SYS_TIME_HW_COUNTER_WIDTH                   (32)
 #define SYS_TIME_HW_COUNTER_PERIOD                  (4294967295U)
 #define SYS_TIME_HW_COUNTER_HALF_PERIOD             (SYS_TIME_HW_COUNTER_PERIOD>>1)
@@ -117,6 +117,11 @@ extern "C" {
 #define SYS_FS_FAT_CODE_PAGE              437
 #define SYS_FS_FAT_MAX_SS                 SYS_FS_MEDIA_MAX_BLOCK_SIZE
 #define SYS_FS_FAT_ALIGNED_BUFFER_LEN     512
+/* Most recently used FAT/directory sectors kept in RAM (512 bytes each) */
+#define SYS_FS_FAT_SECTOR_CACHE_ENTRIES   8
+/* Entries and longest path of the SYS_FS_FileStat() result index */
+#define SYS_FS_FAT_STAT_CACHE_ENTRIES     16
+#define SYS_FS_FAT_STAT_CACHE_PATH_LEN    32
 
 
 
@@ -163,6 +168,11 @@ extern "C" {
 
 #define SYS_MQTT_CLICMD_ENABLED
 
+/* Publish queue and QoS1 in-flight window of the Paho glue */
+#define SYS_MQTT_PAHO_PUB_QUEUE_LEN                     8
+#define SYS_MQTT_PAHO_PUB_INFLIGHT_MAX                  4
+#define SYS_MQTT_PAHO_PUB_MSG_MAX_LEN                   256
+
 
 
 
@@ -204,19 +214,60 @@ extern "C" {
 /* Memory Driver Instance 0 Configuration */
 #define DRV_MEMORY_INDEX_0                   0
 #define DRV_MEMORY_CLIENTS_NUMBER_IDX0       2
-#define DRV_MEMORY_BUF_Q_SIZE_IDX0    1
+/* Requests of the USB MSD and SYS_FS clients are queued together, served
+ * round-robin between the clients; adjacent reads are done as one transfer */
+#define DRV_MEMORY_BUF_Q_SIZE_IDX0    8
+/* Erase write requests to one sector are merged into a single sector erase
+ * and program; the sector is written back after this idle time (ms), on a
+ * file sync or a SCSI SYNCHRONIZE CACHE. 0 disables the cache. */
+#define DRV_MEMORY_CACHE_IDLE_TIMEOUT_IDX0       500U
 /* Memory Driver Instance 0 RTOS Configurations*/
 #define DRV_MEMORY_STACK_SIZE_IDX0               1024
 #define DRV_MEMORY_PRIORITY_IDX0                 1
 #define DRV_MEMORY_RTOS_DELAY_IDX0               10U
+/* Called after client requests completed, the MSD function driver is only
+ * serviced by the USB device task */
+#define DRV_MEMORY_TRANSFER_COMPLETE_HOOK        APP_RTOS_UsbDeviceWake
+
+/* SST26 area below the FAT volume for the telemetry spool (app_spool.h) and
+ * the non-volatile records (app_nvrec.h: broker address cache, Wi-Fi and
+ * cloud config records). Off by default, the volume then starts at 0 as on
+ * the boards in the field and those features are not available.
+ * Enabling it moves the start of the volume: existing boards no longer find
+ * it and format the MSD drive on the next boot. Copy the files off the drive
+ * first (certificates, WIFI.CFG, cloud.json) and back after the format. */
+//#define APP_FLASH_RESERVED_ENABLE
 
 /* SST26 Driver Instance Configuration */
 #define DRV_SST26_INDEX                 (0U)
-#define DRV_SST26_CLIENTS_NUMBER        (1U)
+#define DRV_SST26_CLIENTS_NUMBER        (3U)
+#ifdef APP_FLASH_RESERVED_ENABLE
+#define DRV_SST26_START_ADDRESS         (0x10000U)
+#else
 #define DRV_SST26_START_ADDRESS         (0x0U)
+#endif
 #define DRV_SST26_PAGE_SIZE             (256U)
 #define DRV_SST26_ERASE_BUFFER_SIZE     (4096U)
 #define DRV_SST26_CHIP_SELECT_PIN       SYS_PORT_PIN_RA1
+#define DRV_SST26_WRITE_POLL_PERIOD_US  (250U)
+#define DRV_SST26_ERASE_POLL_PERIOD_US  (2000U)
+
+/* Flash translation layer between the Memory driver and the SST26 driver
+ * (driver/ftl/drv_ftl.h). Every erase of a FAT volume sector moves it to the
+ * least worn free SST26 sector. The first DRV_FTL_LOG_SECTORS sectors of the
+ * volume area hold the mapping log and DRV_FTL_SPARE_SECTORS are always
+ * free. RAM use is 10 bytes per sector up to DRV_FTL_BLOCKS_MAX.
+ *
+ * Off by default. Enabling or disabling it changes the volume layout: on the
+ * first boot the FTL finds no mapping log, formats the volume and everything
+ * on the MSD drive is lost (the Wi-Fi and cloud config are kept in
+ * app_cfgstore records). To migrate a board, copy the files off the drive
+ * (certificates, WIFI.CFG, cloud.json), flash the firmware with the define
+ * enabled, let it format the drive, then copy the files back. */
+//#define DRV_FTL_ENABLE
+#define DRV_FTL_LOG_SECTORS             (16U)
+#define DRV_FTL_SPARE_SECTORS           (16U)
+#define DRV_FTL_BLOCKS_MAX              (2048U)
 
 
 /*** WiFi PIC32MZW1 Driver Configuration ***/
@@ -273,6 +324,9 @@ extern "C" {
 #define HAVE_SUPPORTED_CURVES
 #define HAVE_SNI
 #define HAVE_ALPN
+/* Client side TLS session resumption, see net_pres_enc_glue.c. One peer only, keep the cache small */
+#define HAVE_SESSION_TICKET
+#define SMALL_SESSION_CACHE
 #define USE_WOLF_STRTOK
 #define NO_OLD_TLS
 #define USE_FAST_MATH
@@ -465,20 +519,48 @@ extern "C" {
 #define USB_ALIGN  CACHE_ALIGN
 
 
+/* Heap usage per subsystem (app_heapstat.h), shown by the "heap" command.
+   TCP/IP, wolfSSL and the Wi-Fi driver allocate through tagged wrappers,
+   8 bytes more per block. Comment out to use malloc() directly. */
+#define APP_HEAPSTAT_ENABLE
+
 /*** TCPIP Heap Configuration ***/
 #define TCPIP_STACK_USE_EXTERNAL_HEAP
 
+#ifdef APP_HEAPSTAT_ENABLE
+#define TCPIP_STACK_MALLOC_FUNC                     APP_HEAPSTAT_TcpipMalloc
+
+#define TCPIP_STACK_CALLOC_FUNC                     APP_HEAPSTAT_TcpipCalloc
+
+#define TCPIP_STACK_FREE_FUNC                       APP_HEAPSTAT_TcpipFree
+#else
 #define TCPIP_STACK_MALLOC_FUNC                     malloc
 
 #define TCPIP_STACK_CALLOC_FUNC                     calloc
 
 #define TCPIP_STACK_FREE_FUNC                       free
+#endif
+
+#ifdef APP_HEAPSTAT_ENABLE
+#define WDRV_PIC32MZW_MEM_ALLOC_HOOK                APP_HEAPSTAT_WifiMalloc
+#define WDRV_PIC32MZW_MEM_FREE_HOOK                 APP_HEAPSTAT_Free
+#endif
 
 
 
 #define TCPIP_STACK_HEAP_USE_FLAGS                   TCPIP_STACK_HEAP_FLAG_ALLOC_UNCACHED
 
-#define TCPIP_STACK_HEAP_USAGE_CONFIG                TCPIP_STACK_HEAP_USE_DEFAULT
+#define TCPIP_STACK_HEAP_USAGE_CONFIG                (TCPIP_STACK_HEAP_USE_DEFAULT | TCPIP_STACK_HEAP_USE_PACKET)
+
+/* Packet pools, used with TCPIP_STACK_HEAP_USE_PACKET.
+   Small: TCP socket and control packets, ACKs. Medium: UDP socket packets.
+   Large: full size RX frames. */
+#define TCPIP_PKT_POOL_BLOCKS_SMALL                  16
+#define TCPIP_PKT_POOL_SIZE_SMALL                    384
+#define TCPIP_PKT_POOL_BLOCKS_MEDIUM                 4
+#define TCPIP_PKT_POOL_SIZE_MEDIUM                   896
+#define TCPIP_PKT_POOL_BLOCKS_LARGE                  6
+#define TCPIP_PKT_POOL_SIZE_LARGE                    1728
 
 #define TCPIP_STACK_SUPPORTED_HEAPS                  1
 
@@ -597,6 +679,10 @@ extern "C" {
 #define NO_SIG_WRAPPER
 #define NO_ERROR_STRINGS
 #define NO_WOLFSSL_MEMORY
+#ifdef APP_HEAPSTAT_ENABLE
+/*XMALLOC/XREALLOC/XFREE are in app_heapstat.c*/
+#define XMALLOC_USER
+#endif
 /*Enabling TNGTLS certificate loading*/
 #define HAVE_SUPPORTED_CURVES
 #define WOLFSSL_ATECC608A
@@ -609,12 +695,23 @@ extern "C" {
 /* Maximum instances of MSD function driver */
 #define USB_DEVICE_MSD_INSTANCES_NUMBER     1 
 
-#define USB_DEVICE_MSD_NUM_SECTOR_BUFFERS 1
+/* One SST26 erase sector, READ(10)/WRITE(10) are passed to the media in 4 KB
+   chunks instead of one request per 512-byte sector */
+#define USB_DEVICE_MSD_NUM_SECTOR_BUFFERS 8
 
 
 /* Number of Logical Units */
 #define USB_DEVICE_MSD_LUNS_NUMBER      1
 
+/* Called when the host writes the media, to drop the file system caches */
+#define USB_DEVICE_MSD_MEDIA_WRITE_HOOK disk_media_written
+
+/* Called when the host ejects the drive, the device may use the volume again */
+#define USB_DEVICE_MSD_MEDIA_EJECT_HOOK MSD_APP_MediaEjected
+
+/* Counter of the writes to the media, enables the read ahead across READ(10)s */
+#define USB_DEVICE_MSD_MEDIA_WRITE_COUNT disk_write_count
+
 
 
 /* WIFI System Service Configuration Options */
@@ -658,6 +755,64 @@ extern "C" {
 // *****************************************************************************
 // *****************************************************************************
 
+/* Application RTOS task periods (ms). tasks.c uses these for every polled
+   application task so that the cadence can be retuned for a different tick
+   source without editing the task bodies. */
+#define APP_RTOS_DELAY                      100U
+#define APP_WIFI_RTOS_DELAY                 50U
+#define MSD_APP_RTOS_DELAY                  50U
+#define APP_CONTROL_RTOS_DELAY              100U
+#define MQTT_APP_RTOS_DELAY                 50U
+
+/* Uncomment to have the application tasks block on task notifications (ADC,
+   RTCC, SYS_TIME, SYS_MQTT, SYS_WIFI and socket RX events) instead of waking
+   on the fixed periods above. A task that is idle and receives no event is
+   still serviced every APP_RTOS_EVENT_TIMEOUT ms. The system tasks stay
+   polled: NET_PRES every 1 ms, TCPIP and SYS_WIFI every 4 ms. The console
+   command "app wakeups" reports the wakeups per second of every task. */
+//#define APP_RTOS_EVENT_DRIVEN
+#define APP_RTOS_EVENT_TIMEOUT              1000U
+#ifdef APP_RTOS_EVENT_DRIVEN
+#define SYS_NET_RX_SIGNAL_HOOK              APP_RTOS_NetRxSignal
+#endif
+
+/* Telemetry spool. Samples taken while MQTT is down are logged to the SST26
+   area below DRV_SST26_START_ADDRESS (outside the FAT volume) and drained in
+   batches of APP_SPOOL_DRAIN_BATCH, one batch payload every
+   APP_SPOOL_DRAIN_PERIOD ms at most, once the broker is reachable again.
+   Needs APP_FLASH_RESERVED_ENABLE. */
+#ifdef APP_FLASH_RESERVED_ENABLE
+#define APP_SPOOL_FLASH_START               (0x0U)
+#define APP_SPOOL_FLASH_SIZE                APP_NVREC_FLASH_START
+
+/* Non-volatile records (app_nvrec.h), the last two sectors below the FAT
+   volume. */
+#define APP_NVREC_FLASH_START               (DRV_SST26_START_ADDRESS - (2U * DRV_SST26_ERASE_BUFFER_SIZE))
+#endif
+
+/* Last known good broker address. SYS_NET connects to it while the broker
+   name is resolved in the background and falls back to DNS if it fails. An
+   address more than APP_DNSCACHE_MAX_STALE seconds past its TTL is not used.
+   Comment out the hooks to resolve the name before every connection. */
+#define SYS_NET_DNS_CACHE_LOAD_HOOK         APP_DNSCACHE_Load
+#define SYS_NET_DNS_CACHE_STORE_HOOK        APP_DNSCACHE_Store
+#define SYS_NET_DNS_CACHE_INVALIDATE_HOOK   APP_DNSCACHE_Invalidate
+#define APP_DNSCACHE_MAX_STALE              (7UL * 24UL * 3600UL)
+#define APP_SPOOL_DRAIN_BATCH               8U
+#define APP_SPOOL_DRAIN_PERIOD              250U
+
+/* Telemetry batching. Samples are packed into one compact JSON payload which
+   is published once MQTT_APP_TELEMETRY_BATCH samples are collected, the
+   oldest is MQTT_APP_TELEMETRY_BATCH_AGE ms old or the payload would exceed
+   SYS_MQTT_PAHO_PUB_MSG_MAX_LEN. 1 publishes one JSON object per sample. */
+#define MQTT_APP_TELEMETRY_BATCH            1U
+#define MQTT_APP_TELEMETRY_BATCH_AGE        10000U
+
+/* Heap diagnostics. With APP_HEAPSTAT_ENABLE, the "heap" command output is
+   also published to <clientId>/diag/heap every MQTT_APP_HEAPSTAT_PERIOD ms.
+   Every publish probes the largest free block, see APP_HEAPSTAT_Get(). */
+//#define MQTT_APP_HEAPSTAT_PERIOD            60000U
+
 
 //DOM-IGNORE-BEGIN
 #ifdef __cplusplus
@@ -95,6 +95,7 @@
 #include "peripheral/evic/plib_evic.h"
 #include "peripheral/wdt/plib_wdt.h"
 #include "driver/sst26/drv_sst26.h"
+#include "driver/ftl/drv_ftl.h"
 #include "wolfssl/wolfcrypt/port/pic32/crypt_wolfcryptcb.h"
 #include "driver/wifi/pic32mzw1/include/wdrv_pic32mzw_api.h"
 #include "system/wifi/sys_wifi.h"
@@ -108,6 +109,7 @@
 #include "msd_app.h"
 #include "app_control.h"
 #include "mqtt_app.h"
+#include "app_heapstat.h"
 
 
 
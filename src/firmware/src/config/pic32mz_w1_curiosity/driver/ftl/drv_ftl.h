@@ -0,0 +1,310 @@
+/*******************************************************************************
+  Flash Translation Layer Driver Interface Definition
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    drv_ftl.h
+
+  Summary:
+    Flash translation layer between the Memory driver and the SST26 driver.
+
+  Description:
+    The FTL is attached to the Memory driver in place of the SST26 driver
+    (DRV_MEMORY_DEVICE_INTERFACE). It exposes a logical erase sector address
+    space and maps every logical sector to a physical SST26 sector.
+
+    Each erase of a logical sector moves it to the free physical sector with
+    the lowest erase count, the sector it leaves becomes free (dynamic wear
+    leveling). The mapping is kept in a log of records at the start of the
+    SST26 volume area. A remap is recorded once the new sector has been
+    programmed, until then the previous sector, left untouched, is the one
+    found after a reset: a power loss never leaves a logical sector half
+    written. The log is compacted sector by sector, the live records of the
+    oldest log sector are copied to the head before it is reused.
+*******************************************************************************/
+
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2021 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+//DOM-IGNORE-END
+
+#ifndef DRV_FTL_H
+#define DRV_FTL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: File includes
+// *****************************************************************************
+// *****************************************************************************
+
+#include "configuration.h"
+#include "driver/memory/drv_memory_definitions.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+    extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+/*
+ Summary:
+    FTL wear statistics.
+
+ Description:
+    Returned by DRV_FTL_StatsGet. The erase counts are those of the physical
+    sectors holding the FAT volume, the log sectors are not included.
+
+ Remarks:
+    None.
+*/
+typedef struct
+{
+    /* The log was mounted */
+    bool ready;
+
+    /* Sectors exposed to the Memory driver */
+    uint32_t logicalBlocks;
+
+    /* Sectors the logical ones are mapped to */
+    uint32_t physicalBlocks;
+
+    /* Physical sectors not mapped */
+    uint32_t freeBlocks;
+
+    /* Erase counts of the physical sectors */
+    uint32_t eraseMin;
+    uint32_t eraseMax;
+    uint32_t eraseTotal;
+
+    /* Logical sectors moved to another physical sector */
+    uint32_t remaps;
+
+    /* Log sectors reclaimed */
+    uint32_t logCompactions;
+
+    /* Failed SST26 transfers */
+    uint32_t flashErrors;
+} DRV_FTL_STATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: FTL Driver Module Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Function:
+    DRV_HANDLE DRV_FTL_Open( const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT ioIntent )
+
+  Summary:
+    Opens the SST26 driver instance and mounts the FTL log.
+
+  Description:
+    drvIndex is the SST26 driver index. The first call reads the log and
+    builds the mapping, a blank or foreign volume area gets a new empty log:
+    all the logical sectors read as erased.
+
+  Remarks:
+    Blocks while the log is read. Called by the Memory driver.
+*/
+
+DRV_HANDLE DRV_FTL_Open( const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT ioIntent );
+
+// *****************************************************************************
+/* Function:
+    void DRV_FTL_Close( const DRV_HANDLE handle )
+
+  Summary:
+    Closes the FTL.
+
+  Description:
+    Records a remap still pending and closes the SST26 driver instance.
+
+  Remarks:
+    None.
+*/
+
+void DRV_FTL_Close( const DRV_HANDLE handle );
+
+// *****************************************************************************
+/* Function:
+    SYS_STATUS DRV_FTL_Status( const SYS_MODULE_INDEX drvIndex )
+
+  Summary:
+    Returns the status of the SST26 driver instance.
+
+  Remarks:
+    None.
+*/
+
+SYS_STATUS DRV_FTL_Status( const SYS_MODULE_INDEX drvIndex );
+
+// *****************************************************************************
+/* Function:
+    bool DRV_FTL_SectorErase( const DRV_HANDLE handle, uint32_t address )
+
+  Summary:
+    Erases a logical sector.
+
+  Description:
+    Maps the logical sector at address to the least worn free physical sector
+    and starts erasing it. The sector previously mapped is freed once the
+    new one is recorded in the log.
+
+  Remarks:
+    May program the log before returning.
+*/
+
+bool DRV_FTL_SectorErase( const DRV_HANDLE handle, uint32_t address );
+
+// *****************************************************************************
+/* Function:
+    bool DRV_FTL_Read( const DRV_HANDLE handle, void *rx_data, uint32_t rx_data_length, uint32_t address )
+
+  Summary:
+    Reads from the logical address space.
+
+  Description:
+    Logical sectors never written read as erased (0xFF). A read spanning
+    several logical sectors is split, only the last part completes
+    asynchronously.
+
+  Remarks:
+    None.
+*/
+
+bool DRV_FTL_Read( const DRV_HANDLE handle, void *rx_data, uint32_t rx_data_length, uint32_t address );
+
+// *****************************************************************************
+/* Function:
+    bool DRV_FTL_PageWrite( const DRV_HANDLE handle, void *tx_data, uint32_t address )
+
+  Summary:
+    Programs a page of a logical sector.
+
+  Description:
+    Programs the page in the physical sector the logical sector is mapped
+    to. Programming the last page of a sector just erased records its remap.
+
+  Remarks:
+    None.
+*/
+
+bool DRV_FTL_PageWrite( const DRV_HANDLE handle, void *tx_data, uint32_t address );
+
+// *****************************************************************************
+/* Function:
+    void DRV_FTL_EventHandlerSet( const DRV_HANDLE handle, DRV_MEMORY_EVENT_HANDLER eventHandler, uintptr_t context )
+
+  Summary:
+    Sets the handler called at the end of a transfer.
+
+  Description:
+    Only the end of the transfers started for the Memory driver is signaled,
+    not the log accesses done by the FTL itself.
+
+  Remarks:
+    None.
+*/
+
+void DRV_FTL_EventHandlerSet( const DRV_HANDLE handle, DRV_MEMORY_EVENT_HANDLER eventHandler, uintptr_t context );
+
+// *****************************************************************************
+/* Function:
+    bool DRV_FTL_GeometryGet( const DRV_HANDLE handle, MEMORY_DEVICE_GEOMETRY *geometry )
+
+  Summary:
+    Returns the geometry of the logical address space.
+
+  Description:
+    The SST26 geometry less the log sectors and DRV_FTL_SPARE_SECTORS, the
+    logical address space starts at 0.
+
+  Remarks:
+    None.
+*/
+
+bool DRV_FTL_GeometryGet( const DRV_HANDLE handle, MEMORY_DEVICE_GEOMETRY *geometry );
+
+// *****************************************************************************
+/* Function:
+    uint32_t DRV_FTL_TransferStatusGet( const DRV_HANDLE handle )
+
+  Summary:
+    Returns the status of the last transfer (MEMORY_DEVICE_TRANSFER_STATUS).
+
+  Remarks:
+    May program the log before returning.
+*/
+
+uint32_t DRV_FTL_TransferStatusGet( const DRV_HANDLE handle );
+
+// *****************************************************************************
+/* Function:
+    bool DRV_FTL_EraseCountGet( uint32_t block, uint32_t *eraseCount )
+
+  Summary:
+    Returns the erase count of a physical sector.
+
+  Description:
+    block is in 0..physicalBlocks-1 (DRV_FTL_StatsGet). Returns false if it
+    is out of range or the FTL is not mounted.
+
+  Remarks:
+    Counts are only known from the records of the log, a sector never
+    mapped since the log was created reads 0.
+*/
+
+bool DRV_FTL_EraseCountGet( uint32_t block, uint32_t *eraseCount );
+
+// *****************************************************************************
+/* Function:
+    void DRV_FTL_StatsGet( DRV_FTL_STATS *stats )
+
+  Summary:
+    Returns the wear statistics.
+
+  Remarks:
+    None.
+*/
+
+void DRV_FTL_StatsGet( DRV_FTL_STATS *stats );
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+// DOM-IGNORE-END
+
+#endif // #ifndef DRV_FTL_H
+/*******************************************************************************
+ End of File
+*/
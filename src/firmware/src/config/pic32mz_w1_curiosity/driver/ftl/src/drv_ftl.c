@@ -0,0 +1,1053 @@
+/*******************************************************************************
+  Flash Translation Layer Driver Implementation.
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    drv_ftl.c
+
+  Summary:
+    Flash translation layer between the Memory driver and the SST26 driver.
+
+  Description:
+    See drv_ftl.h. The FTL functions are called by the Memory driver task,
+    with the device reserved (transferMutex). The log accesses are done
+    synchronously within these calls, only the transfers of the Memory
+    driver requests complete asynchronously and are signaled to it.
+*******************************************************************************/
+
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2021 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+//DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Include Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include <stddef.h>
+
+#include "driver/ftl/src/drv_ftl_local.h"
+
+#ifdef DRV_FTL_ENABLE
+
+/* Every physical sector may need a live record, they must fit the log less
+ * the head and the sector after it */
+#if ((DRV_FTL_LOG_SECTORS - 2U) * ((DRV_SST26_ERASE_BUFFER_SIZE / 16U) - 1U)) < DRV_FTL_BLOCKS_MAX
+#error "DRV_FTL_LOG_SECTORS is too small for DRV_FTL_BLOCKS_MAX"
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global objects
+// *****************************************************************************
+// *****************************************************************************
+
+static DRV_FTL_OBJECT gDrvFtlObj;
+static DRV_FTL_OBJECT *dObj = &gDrvFtlObj;
+
+/* Log page programmed, or record read */
+static CACHE_ALIGN uint8_t gDrvFtlPageBuffer[DRV_FTL_PAGE_SIZE];
+
+/* Log page scanned */
+static CACHE_ALIGN uint8_t gDrvFtlScanBuffer[DRV_FTL_PAGE_SIZE];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: FTL Driver Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void DRV_FTL_EventHandler( DRV_SST26_TRANSFER_STATUS status, uintptr_t context )
+{
+    if (dObj->deviceTransfer == true)
+    {
+        if (dObj->eventHandler != NULL)
+        {
+            dObj->eventHandler((MEMORY_DEVICE_TRANSFER_STATUS)status, dObj->context);
+        }
+    }
+    else
+    {
+        /* Log access, or another SST26 client */
+        (void) OSAL_SEM_PostISR(&dObj->eventSemaphore);
+    }
+}
+
+static inline uint32_t DRV_FTL_LogAddress( uint8_t sector )
+{
+    return dObj->deviceStart + ((uint32_t)sector * DRV_FTL_SECTOR_SIZE);
+}
+
+static inline uint32_t DRV_FTL_PhysicalAddress( uint16_t physical )
+{
+    return dObj->deviceStart + (((uint32_t)DRV_FTL_LOG_SECTORS + physical) * DRV_FTL_SECTOR_SIZE);
+}
+
+static uint16_t DRV_FTL_RecordCrc( const DRV_FTL_RECORD *record )
+{
+    const uint8_t *data = (const uint8_t *)record;
+    uint16_t crc = 0xFFFFU;
+    uint32_t i;
+    uint8_t bit;
+
+    for (i = 0; i < offsetof(DRV_FTL_RECORD, check); i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (bit = 0; bit < 8U; bit++)
+        {
+            crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static bool DRV_FTL_RecordIsValid( const DRV_FTL_RECORD *record )
+{
+    return ((record->state == DRV_FTL_RECORD_VALID) &&
+            (record->check == DRV_FTL_RecordCrc(record)) &&
+            (record->physical < dObj->numPhysical) &&
+            ((record->logical < dObj->numLogical) || (record->logical == DRV_FTL_UNMAPPED)));
+}
+
+static bool DRV_FTL_SlotIsErased( const uint8_t *slot )
+{
+    uint32_t i;
+
+    for (i = 0; i < DRV_FTL_SLOT_SIZE; i++)
+    {
+        if (slot[i] != 0xFFU)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Waits for the end of a log access */
+static bool DRV_FTL_Wait( void )
+{
+    DRV_SST26_TRANSFER_STATUS status;
+
+    while ((status = DRV_SST26_TransferStatusGet(dObj->sst26Handle)) == DRV_SST26_TRANSFER_BUSY)
+    {
+        (void) OSAL_SEM_Pend(&dObj->eventSemaphore, DRV_FTL_WAIT_TIMEOUT_MS);
+    }
+
+    if (status != DRV_SST26_TRANSFER_COMPLETED)
+    {
+        dObj->flashErrors++;
+        return false;
+    }
+
+    return true;
+}
+
+static bool DRV_FTL_DeviceRead( void *data, uint32_t length, uint32_t address )
+{
+    if (DRV_SST26_Read(dObj->sst26Handle, data, length, address) == false)
+    {
+        dObj->flashErrors++;
+        return false;
+    }
+
+    return DRV_FTL_Wait();
+}
+
+static bool DRV_FTL_DeviceWrite( void *data, uint32_t address )
+{
+    if (DRV_SST26_PageWrite(dObj->sst26Handle, data, address) == false)
+    {
+        dObj->flashErrors++;
+        return false;
+    }
+
+    return DRV_FTL_Wait();
+}
+
+static bool DRV_FTL_DeviceErase( uint32_t address )
+{
+    if (DRV_SST26_SectorErase(dObj->sst26Handle, address) == false)
+    {
+        dObj->flashErrors++;
+        return false;
+    }
+
+    return DRV_FTL_Wait();
+}
+
+static bool DRV_FTL_HeaderRead( uint8_t sector, uint32_t *seq )
+{
+    DRV_FTL_LOG_HEADER header;
+
+    if (DRV_FTL_DeviceRead(gDrvFtlPageBuffer, sizeof(header), DRV_FTL_LogAddress(sector)) == false)
+    {
+        return false;
+    }
+
+    (void) memcpy(&header, gDrvFtlPageBuffer, sizeof(header));
+
+    if ((header.magic != DRV_FTL_LOG_MAGIC) || (header.check != ~header.seq))
+    {
+        return false;
+    }
+
+    *seq = header.seq;
+    return true;
+}
+
+static bool DRV_FTL_HeaderWrite( uint8_t sector, uint32_t seq )
+{
+    DRV_FTL_LOG_HEADER header;
+
+    header.magic = DRV_FTL_LOG_MAGIC;
+    header.seq = seq;
+    header.check = ~seq;
+    header.reserved = 0xFFFFFFFFU;
+
+    (void) memset(gDrvFtlPageBuffer, 0xFF, sizeof(gDrvFtlPageBuffer));
+    (void) memcpy(gDrvFtlPageBuffer, &header, sizeof(header));
+
+    return DRV_FTL_DeviceWrite(gDrvFtlPageBuffer, DRV_FTL_LogAddress(sector));
+}
+
+static bool DRV_FTL_RecordRead( uint16_t pos, DRV_FTL_RECORD *record )
+{
+    uint32_t address = DRV_FTL_LogAddress((uint8_t)(pos / DRV_FTL_LOG_SLOTS)) + ((uint32_t)(pos % DRV_FTL_LOG_SLOTS) * DRV_FTL_SLOT_SIZE);
+
+    if (DRV_FTL_DeviceRead(gDrvFtlPageBuffer, DRV_FTL_SLOT_SIZE, address) == false)
+    {
+        return false;
+    }
+
+    (void) memcpy(record, gDrvFtlPageBuffer, sizeof(*record));
+    return true;
+}
+
+/* Programs a record in the next slot of the head, which must not be full */
+static bool DRV_FTL_RecordWrite( DRV_FTL_RECORD *record )
+{
+    uint16_t pageSlot = dObj->logSlot % DRV_FTL_SLOTS_PER_PAGE;
+    uint16_t pos = (uint16_t)(((uint32_t)dObj->logSector * DRV_FTL_LOG_SLOTS) + dObj->logSlot);
+    uint32_t address = DRV_FTL_LogAddress(dObj->logSector) + ((uint32_t)(dObj->logSlot - pageSlot) * DRV_FTL_SLOT_SIZE);
+
+    record->state = DRV_FTL_RECORD_VALID;
+    record->check = DRV_FTL_RecordCrc(record);
+
+    /* Bytes left at 0xFF do not change the flash contents */
+    (void) memset(gDrvFtlPageBuffer, 0xFF, sizeof(gDrvFtlPageBuffer));
+    (void) memcpy(&gDrvFtlPageBuffer[pageSlot * DRV_FTL_SLOT_SIZE], record, sizeof(*record));
+
+    /* A slot that failed to program is not used again */
+    dObj->logSlot++;
+
+    if (DRV_FTL_DeviceWrite(gDrvFtlPageBuffer, address) == false)
+    {
+        return false;
+    }
+
+    dObj->logPos[record->physical] = pos;
+    return true;
+}
+
+static bool DRV_FTL_LogSectorIsLive( uint8_t sector )
+{
+    uint16_t physical;
+
+    for (physical = 0; physical < dObj->numPhysical; physical++)
+    {
+        if ((dObj->logPos[physical] != DRV_FTL_NO_POS) && ((dObj->logPos[physical] / DRV_FTL_LOG_SLOTS) == sector))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Copies the records of a log sector which are still the latest of their
+ * physical sector to the head. They keep their seq. */
+static bool DRV_FTL_LogEvacuate( uint8_t sector )
+{
+    DRV_FTL_RECORD record;
+    uint16_t slot;
+    uint16_t pageSlot;
+    uint16_t pos;
+
+    for (slot = 1; slot < DRV_FTL_LOG_SLOTS; slot++)
+    {
+        pageSlot = slot % DRV_FTL_SLOTS_PER_PAGE;
+
+        if ((slot == 1U) || (pageSlot == 0U))
+        {
+            if (DRV_FTL_DeviceRead(gDrvFtlScanBuffer, DRV_FTL_PAGE_SIZE, DRV_FTL_LogAddress(sector) + ((uint32_t)(slot - pageSlot) * DRV_FTL_SLOT_SIZE)) == false)
+            {
+                return false;
+            }
+        }
+
+        (void) memcpy(&record, &gDrvFtlScanBuffer[pageSlot * DRV_FTL_SLOT_SIZE], sizeof(record));
+        pos = (uint16_t)(((uint32_t)sector * DRV_FTL_LOG_SLOTS) + slot);
+
+        if ((DRV_FTL_RecordIsValid(&record) == false) || (dObj->logPos[record.physical] != pos))
+        {
+            continue;
+        }
+
+        if ((dObj->logSlot >= DRV_FTL_LOG_SLOTS) || (DRV_FTL_RecordWrite(&record) == false))
+        {
+            return false;
+        }
+    }
+
+    dObj->logCompactions++;
+    return true;
+}
+
+/* Moves the head to the next log sector. The sector after the head never
+ * holds a live record: it is erased, and the live records of the one after
+ * it are copied to the new head, before it is erased in turn. */
+static bool DRV_FTL_LogAdvance( void )
+{
+    uint8_t next = (uint8_t)((dObj->logSector + 1U) % DRV_FTL_LOG_SECTORS);
+
+    /* Only after a failed evacuation, the head is full: give up rather
+     * than lose the records */
+    if (DRV_FTL_LogSectorIsLive(next) == true)
+    {
+        return false;
+    }
+
+    if ((DRV_FTL_DeviceErase(DRV_FTL_LogAddress(next)) == false) ||
+        (DRV_FTL_HeaderWrite(next, dObj->logSeq + 1U) == false))
+    {
+        return false;
+    }
+
+    dObj->logSeq++;
+    dObj->logSector = next;
+    dObj->logSlot = 1;
+
+    next = (uint8_t)((next + 1U) % DRV_FTL_LOG_SECTORS);
+
+    if (DRV_FTL_LogSectorIsLive(next) == false)
+    {
+        return true;
+    }
+
+    return DRV_FTL_LogEvacuate(next);
+}
+
+static bool DRV_FTL_LogAppend( DRV_FTL_RECORD *record )
+{
+    uint8_t advances = 0;
+
+    while (dObj->logSlot >= DRV_FTL_LOG_SLOTS)
+    {
+        /* An evacuation may fill the new head, not all the log sectors */
+        if ((advances == DRV_FTL_LOG_SECTORS) || (DRV_FTL_LogAdvance() == false))
+        {
+            return false;
+        }
+        advances++;
+    }
+
+    return DRV_FTL_RecordWrite(record);
+}
+
+/* Records the remap in progress. Until then the physical sector it leaves is
+ * not allocated again, a failed commit is retried before the next remap. */
+static bool DRV_FTL_Commit( void )
+{
+    DRV_FTL_RECORD record;
+
+    if (dObj->commitPending == false)
+    {
+        return true;
+    }
+
+    dObj->commitOnComplete = false;
+
+    record.logical = dObj->pendingLogical;
+    record.physical = dObj->pendingPhysical;
+    record.seq = dObj->recordSeq + 1U;
+    record.eraseCount = dObj->eraseCount[dObj->pendingPhysical];
+
+    if (DRV_FTL_LogAppend(&record) == false)
+    {
+        return false;
+    }
+
+    dObj->recordSeq++;
+    dObj->commitPending = false;
+    return true;
+}
+
+static void DRV_FTL_RemapUndo( void )
+{
+    dObj->owner[dObj->pendingPhysical] = DRV_FTL_UNMAPPED;
+    dObj->map[dObj->pendingLogical] = dObj->pendingOld;
+
+    if (dObj->pendingOld != DRV_FTL_UNMAPPED)
+    {
+        dObj->owner[dObj->pendingOld] = dObj->pendingLogical;
+    }
+
+    dObj->commitPending = false;
+    dObj->commitOnComplete = false;
+    dObj->eraseInProgress = false;
+}
+
+/* Free physical sector with the lowest erase count */
+static uint16_t DRV_FTL_Allocate( void )
+{
+    uint16_t best = DRV_FTL_UNMAPPED;
+    uint16_t physical;
+    uint16_t i;
+
+    for (i = 0; i < dObj->numPhysical; i++)
+    {
+        physical = (uint16_t)((dObj->allocNext + i) % dObj->numPhysical);
+
+        if ((dObj->owner[physical] == DRV_FTL_UNMAPPED) &&
+            ((best == DRV_FTL_UNMAPPED) || (dObj->eraseCount[physical] < dObj->eraseCount[best])))
+        {
+            best = physical;
+        }
+    }
+
+    if (best != DRV_FTL_UNMAPPED)
+    {
+        dObj->allocNext = (uint16_t)((best + 1U) % dObj->numPhysical);
+    }
+
+    return best;
+}
+
+/* Moves a logical sector to a free physical sector and erases it. The erase
+ * is done synchronously if wait is set, otherwise it completes as a Memory
+ * driver transfer. */
+static bool DRV_FTL_Remap( uint16_t logical, bool wait )
+{
+    uint16_t physical;
+    bool status;
+
+    if (DRV_FTL_Commit() == false)
+    {
+        return false;
+    }
+
+    physical = DRV_FTL_Allocate();
+
+    if (physical == DRV_FTL_UNMAPPED)
+    {
+        return false;
+    }
+
+    dObj->pendingLogical = logical;
+    dObj->pendingPhysical = physical;
+    dObj->pendingOld = dObj->map[logical];
+
+    dObj->map[logical] = physical;
+    dObj->owner[physical] = logical;
+
+    if (dObj->pendingOld != DRV_FTL_UNMAPPED)
+    {
+        dObj->owner[dObj->pendingOld] = DRV_FTL_UNMAPPED;
+    }
+
+    dObj->eraseCount[physical]++;
+    dObj->remaps++;
+    dObj->commitPending = true;
+
+    if (wait == true)
+    {
+        status = DRV_FTL_DeviceErase(DRV_FTL_PhysicalAddress(physical));
+    }
+    else
+    {
+        dObj->eraseInProgress = true;
+        dObj->deviceTransfer = true;
+
+        status = DRV_SST26_SectorErase(dObj->sst26Handle, DRV_FTL_PhysicalAddress(physical));
+
+        if (status == false)
+        {
+            dObj->deviceTransfer = false;
+            dObj->flashErrors++;
+        }
+    }
+
+    if (status == false)
+    {
+        DRV_FTL_RemapUndo();
+    }
+
+    return status;
+}
+
+/* Reads the records of a log sector, oldest sector first: the last record
+ * of a physical sector found is its latest. */
+static bool DRV_FTL_LogScan( uint8_t sector, uint16_t *nextSlot )
+{
+    DRV_FTL_RECORD record;
+    uint16_t slot;
+    uint16_t pageSlot;
+
+    *nextSlot = 1;
+
+    for (slot = 1; slot < DRV_FTL_LOG_SLOTS; slot++)
+    {
+        pageSlot = slot % DRV_FTL_SLOTS_PER_PAGE;
+
+        if ((slot == 1U) || (pageSlot == 0U))
+        {
+            if (DRV_FTL_DeviceRead(gDrvFtlScanBuffer, DRV_FTL_PAGE_SIZE, DRV_FTL_LogAddress(sector) + ((uint32_t)(slot - pageSlot) * DRV_FTL_SLOT_SIZE)) == false)
+            {
+                return false;
+            }
+        }
+
+        if (DRV_FTL_SlotIsErased(&gDrvFtlScanBuffer[pageSlot * DRV_FTL_SLOT_SIZE]) == true)
+        {
+            continue;
+        }
+
+        /* Torn records are skipped, their slot is used */
+        *nextSlot = slot + 1U;
+
+        (void) memcpy(&record, &gDrvFtlScanBuffer[pageSlot * DRV_FTL_SLOT_SIZE], sizeof(record));
+
+        if (DRV_FTL_RecordIsValid(&record) == false)
+        {
+            continue;
+        }
+
+        dObj->owner[record.physical] = record.logical;
+        dObj->eraseCount[record.physical] = record.eraseCount;
+        dObj->logPos[record.physical] = (uint16_t)(((uint32_t)sector * DRV_FTL_LOG_SLOTS) + slot);
+
+        if (record.seq > dObj->recordSeq)
+        {
+            dObj->recordSeq = record.seq;
+        }
+    }
+
+    return true;
+}
+
+/* Builds the logical to physical map from the latest record of every
+ * physical sector */
+static bool DRV_FTL_MapBuild( void )
+{
+    DRV_FTL_RECORD claim;
+    DRV_FTL_RECORD current;
+    uint16_t physical;
+    uint16_t logical;
+
+    for (physical = 0; physical < dObj->numPhysical; physical++)
+    {
+        logical = dObj->owner[physical];
+
+        if (logical == DRV_FTL_UNMAPPED)
+        {
+            continue;
+        }
+
+        if (dObj->map[logical] == DRV_FTL_UNMAPPED)
+        {
+            dObj->map[logical] = physical;
+            continue;
+        }
+
+        /* The sector left by a remap still claims the logical sector */
+        if ((DRV_FTL_RecordRead(dObj->logPos[physical], &claim) == false) ||
+            (DRV_FTL_RecordRead(dObj->logPos[dObj->map[logical]], &current) == false))
+        {
+            return false;
+        }
+
+        if (claim.seq > current.seq)
+        {
+            dObj->owner[dObj->map[logical]] = DRV_FTL_UNMAPPED;
+            dObj->map[logical] = physical;
+        }
+        else
+        {
+            dObj->owner[physical] = DRV_FTL_UNMAPPED;
+        }
+    }
+
+    return true;
+}
+
+static bool DRV_FTL_Mount( void )
+{
+    DRV_SST26_GEOMETRY sst26Geometry;
+    uint32_t seq[DRV_FTL_LOG_SECTORS];
+    bool valid[DRV_FTL_LOG_SECTORS];
+    uint32_t lastSeq = 0;
+    uint16_t nextSlot = 1;
+    uint8_t sector;
+    uint8_t oldest;
+    uint8_t nValid = 0;
+    uint8_t n;
+
+    if (DRV_SST26_GeometryGet(dObj->sst26Handle, &sst26Geometry) == false)
+    {
+        return false;
+    }
+
+    if (sst26Geometry.erase_numBlocks <= (DRV_FTL_LOG_SECTORS + DRV_FTL_SPARE_SECTORS))
+    {
+        return false;
+    }
+
+    dObj->deviceStart = sst26Geometry.blockStartAddress;
+    dObj->numPhysical = (uint16_t)((sst26Geometry.erase_numBlocks - DRV_FTL_LOG_SECTORS < DRV_FTL_BLOCKS_MAX) ?
+                                   (sst26Geometry.erase_numBlocks - DRV_FTL_LOG_SECTORS) : DRV_FTL_BLOCKS_MAX);
+    dObj->numLogical = (uint16_t)(dObj->numPhysical - DRV_FTL_SPARE_SECTORS);
+
+    (void) memset(dObj->map, 0xFF, sizeof(dObj->map));
+    (void) memset(dObj->owner, 0xFF, sizeof(dObj->owner));
+    (void) memset(dObj->logPos, 0xFF, sizeof(dObj->logPos));
+    (void) memset(dObj->eraseCount, 0, sizeof(dObj->eraseCount));
+    dObj->recordSeq = 0;
+    dObj->logSeq = 0;
+    dObj->commitPending = false;
+    dObj->commitOnComplete = false;
+    dObj->eraseInProgress = false;
+    dObj->deviceTransfer = false;
+    dObj->allocNext = 0;
+
+    for (sector = 0; sector < DRV_FTL_LOG_SECTORS; sector++)
+    {
+        valid[sector] = DRV_FTL_HeaderRead(sector, &seq[sector]);
+
+        if (valid[sector] == true)
+        {
+            nValid++;
+        }
+    }
+
+    if (nValid == 0U)
+    {
+        /* New log: every logical sector reads erased, the drive is
+         * formatted by its first user */
+        dObj->logSector = 0;
+        dObj->logSlot = 1;
+        dObj->logSeq = 1;
+
+        return ((DRV_FTL_DeviceErase(DRV_FTL_LogAddress(0)) == true) &&
+                (DRV_FTL_HeaderWrite(0, dObj->logSeq) == true));
+    }
+
+    /* Scan the log sectors from the oldest to the head */
+    for (n = 0; n < nValid; n++)
+    {
+        oldest = DRV_FTL_LOG_SECTORS;
+
+        for (sector = 0; sector < DRV_FTL_LOG_SECTORS; sector++)
+        {
+            if ((valid[sector] == true) && ((n == 0U) || (seq[sector] > lastSeq)) &&
+                ((oldest == DRV_FTL_LOG_SECTORS) || (seq[sector] < seq[oldest])))
+            {
+                oldest = sector;
+            }
+        }
+
+        if (DRV_FTL_LogScan(oldest, &nextSlot) == false)
+        {
+            return false;
+        }
+
+        lastSeq = seq[oldest];
+        dObj->logSector = oldest;
+    }
+
+    dObj->logSlot = nextSlot;
+    dObj->logSeq = lastSeq;
+
+    if (DRV_FTL_MapBuild() == false)
+    {
+        return false;
+    }
+
+    /* Finish an evacuation cut by a reset, it fits the head. If it fails
+     * the log does not advance any more but the volume is still readable. */
+    sector = (uint8_t)((dObj->logSector + 1U) % DRV_FTL_LOG_SECTORS);
+
+    if (DRV_FTL_LogSectorIsLive(sector) == true)
+    {
+        (void) DRV_FTL_LogEvacuate(sector);
+    }
+
+    return true;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: FTL Driver Global Functions
+// *****************************************************************************
+// *****************************************************************************
+
+DRV_HANDLE DRV_FTL_Open( const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT ioIntent )
+{
+    if (dObj->status == SYS_STATUS_READY)
+    {
+        return dObj->sst26Handle;
+    }
+
+    if (dObj->status == SYS_STATUS_UNINITIALIZED)
+    {
+        if (OSAL_SEM_Create(&dObj->eventSemaphore, OSAL_SEM_TYPE_BINARY, 1, 0) == OSAL_RESULT_FAIL)
+        {
+            return DRV_HANDLE_INVALID;
+        }
+
+        /* The log area is shared with the other SST26 clients */
+        dObj->sst26Handle = DRV_SST26_Open(drvIndex, DRV_IO_INTENT_READWRITE);
+
+        if (dObj->sst26Handle == DRV_HANDLE_INVALID)
+        {
+            (void) OSAL_SEM_Delete(&dObj->eventSemaphore);
+            return DRV_HANDLE_INVALID;
+        }
+
+        DRV_SST26_EventHandlerSet(dObj->sst26Handle, DRV_FTL_EventHandler, 0);
+        dObj->status = SYS_STATUS_BUSY;
+    }
+
+    if (DRV_FTL_Mount() == false)
+    {
+        return DRV_HANDLE_INVALID;
+    }
+
+    dObj->transferStatus = MEMORY_DEVICE_TRANSFER_COMPLETED;
+    dObj->status = SYS_STATUS_READY;
+
+    return dObj->sst26Handle;
+}
+
+void DRV_FTL_Close( const DRV_HANDLE handle )
+{
+    if ((handle == DRV_HANDLE_INVALID) || (dObj->status == SYS_STATUS_UNINITIALIZED))
+    {
+        return;
+    }
+
+    if (dObj->status == SYS_STATUS_READY)
+    {
+        (void) DRV_FTL_Commit();
+    }
+
+    DRV_SST26_Close(dObj->sst26Handle);
+    (void) OSAL_SEM_Delete(&dObj->eventSemaphore);
+    dObj->status = SYS_STATUS_UNINITIALIZED;
+}
+
+SYS_STATUS DRV_FTL_Status( const SYS_MODULE_INDEX drvIndex )
+{
+    return DRV_SST26_Status(drvIndex);
+}
+
+bool DRV_FTL_SectorErase( const DRV_HANDLE handle, uint32_t address )
+{
+    uint16_t logical = (uint16_t)(address / DRV_FTL_SECTOR_SIZE);
+
+    if ((handle == DRV_HANDLE_INVALID) || (dObj->status != SYS_STATUS_READY) ||
+        (logical >= dObj->numLogical) || (dObj->deviceTransfer == true))
+    {
+        return false;
+    }
+
+    return DRV_FTL_Remap(logical, false);
+}
+
+bool DRV_FTL_Read( const DRV_HANDLE handle, void *rx_data, uint32_t rx_data_length, uint32_t address )
+{
+    uint8_t *data = (uint8_t *)rx_data;
+    uint32_t length;
+    uint32_t offset;
+    uint16_t logical;
+    uint16_t physical;
+    uint16_t next;
+
+    if ((handle == DRV_HANDLE_INVALID) || (dObj->status != SYS_STATUS_READY) ||
+        (rx_data == NULL) || (rx_data_length == 0U) || (dObj->deviceTransfer == true) ||
+        (address >= ((uint32_t)dObj->numLogical * DRV_FTL_SECTOR_SIZE)) ||
+        (rx_data_length > (((uint32_t)dObj->numLogical * DRV_FTL_SECTOR_SIZE) - address)))
+    {
+        return false;
+    }
+
+    dObj->transferStatus = MEMORY_DEVICE_TRANSFER_COMPLETED;
+
+    while (rx_data_length != 0U)
+    {
+        logical = (uint16_t)(address / DRV_FTL_SECTOR_SIZE);
+        offset = address % DRV_FTL_SECTOR_SIZE;
+        physical = dObj->map[logical];
+
+        /* Logical sectors mapped to consecutive physical sectors, or not
+         * mapped, are read at once */
+        length = DRV_FTL_SECTOR_SIZE - offset;
+        next = logical + 1U;
+
+        while ((length < rx_data_length) &&
+               (dObj->map[next] == ((physical == DRV_FTL_UNMAPPED) ? DRV_FTL_UNMAPPED : (uint16_t)(physical + (next - logical)))))
+        {
+            length += DRV_FTL_SECTOR_SIZE;
+            next++;
+        }
+
+        if (length > rx_data_length)
+        {
+            length = rx_data_length;
+        }
+
+        if (physical == DRV_FTL_UNMAPPED)
+        {
+            (void) memset(data, 0xFF, length);
+        }
+        else if (length == rx_data_length)
+        {
+            /* The last part completes as a Memory driver transfer */
+            dObj->deviceTransfer = true;
+
+            if (DRV_SST26_Read(dObj->sst26Handle, data, length, DRV_FTL_PhysicalAddress(physical) + offset) == false)
+            {
+                dObj->deviceTransfer = false;
+                dObj->flashErrors++;
+                return false;
+            }
+        }
+        else if (DRV_FTL_DeviceRead(data, length, DRV_FTL_PhysicalAddress(physical) + offset) == false)
+        {
+            return false;
+        }
+        else
+        {
+            /* Nothing to do */
+        }
+
+        data += length;
+        address += length;
+        rx_data_length -= length;
+    }
+
+    return true;
+}
+
+bool DRV_FTL_PageWrite( const DRV_HANDLE handle, void *tx_data, uint32_t address )
+{
+    uint16_t logical = (uint16_t)(address / DRV_FTL_SECTOR_SIZE);
+    uint32_t offset = address % DRV_FTL_SECTOR_SIZE;
+
+    if ((handle == DRV_HANDLE_INVALID) || (dObj->status != SYS_STATUS_READY) ||
+        (tx_data == NULL) || (logical >= dObj->numLogical) || (dObj->deviceTransfer == true))
+    {
+        return false;
+    }
+
+    if ((dObj->commitPending == true) && (dObj->pendingLogical != logical))
+    {
+        if (DRV_FTL_Commit() == false)
+        {
+            return false;
+        }
+    }
+
+    /* A logical sector never written reads erased, it gets an erased
+     * physical sector first */
+    if (dObj->map[logical] == DRV_FTL_UNMAPPED)
+    {
+        if (DRV_FTL_Remap(logical, true) == false)
+        {
+            return false;
+        }
+    }
+
+    dObj->commitOnComplete = ((dObj->commitPending == true) && (dObj->pendingLogical == logical) &&
+                              (offset == (DRV_FTL_SECTOR_SIZE - DRV_FTL_PAGE_SIZE)));
+    dObj->deviceTransfer = true;
+
+    if (DRV_SST26_PageWrite(dObj->sst26Handle, tx_data, DRV_FTL_PhysicalAddress(dObj->map[logical]) + offset) == false)
+    {
+        dObj->deviceTransfer = false;
+        dObj->commitOnComplete = false;
+        dObj->flashErrors++;
+        return false;
+    }
+
+    return true;
+}
+
+void DRV_FTL_EventHandlerSet( const DRV_HANDLE handle, DRV_MEMORY_EVENT_HANDLER eventHandler, uintptr_t context )
+{
+    if (handle != DRV_HANDLE_INVALID)
+    {
+        dObj->eventHandler = eventHandler;
+        dObj->context = context;
+    }
+}
+
+bool DRV_FTL_GeometryGet( const DRV_HANDLE handle, MEMORY_DEVICE_GEOMETRY *geometry )
+{
+    uint32_t size = (uint32_t)dObj->numLogical * DRV_FTL_SECTOR_SIZE;
+
+    if ((handle == DRV_HANDLE_INVALID) || (dObj->status != SYS_STATUS_READY))
+    {
+        return false;
+    }
+
+    geometry->read_blockSize = 1;
+    geometry->read_numBlocks = size;
+
+    geometry->write_blockSize = DRV_FTL_PAGE_SIZE;
+    geometry->write_numBlocks = size / DRV_FTL_PAGE_SIZE;
+
+    geometry->erase_blockSize = DRV_FTL_SECTOR_SIZE;
+    geometry->erase_numBlocks = dObj->numLogical;
+
+    geometry->numReadRegions = 1;
+    geometry->numWriteRegions = 1;
+    geometry->numEraseRegions = 1;
+
+    geometry->blockStartAddress = 0;
+
+    return true;
+}
+
+uint32_t DRV_FTL_TransferStatusGet( const DRV_HANDLE handle )
+{
+    MEMORY_DEVICE_TRANSFER_STATUS status;
+
+    if (handle == DRV_HANDLE_INVALID)
+    {
+        return (uint32_t)MEMORY_DEVICE_TRANSFER_ERROR_UNKNOWN;
+    }
+
+    if (dObj->deviceTransfer == false)
+    {
+        return (uint32_t)dObj->transferStatus;
+    }
+
+    status = (MEMORY_DEVICE_TRANSFER_STATUS)DRV_SST26_TransferStatusGet(dObj->sst26Handle);
+
+    if (status == MEMORY_DEVICE_TRANSFER_BUSY)
+    {
+        return (uint32_t)status;
+    }
+
+    dObj->deviceTransfer = false;
+
+    if (status != MEMORY_DEVICE_TRANSFER_COMPLETED)
+    {
+        dObj->flashErrors++;
+
+        if (dObj->eraseInProgress == true)
+        {
+            DRV_FTL_RemapUndo();
+        }
+
+        dObj->commitOnComplete = false;
+    }
+    else
+    {
+        dObj->eraseInProgress = false;
+
+        /* The sector is completely programmed, record its new place */
+        if ((dObj->commitOnComplete == true) && (DRV_FTL_Commit() == false))
+        {
+            status = MEMORY_DEVICE_TRANSFER_ERROR_UNKNOWN;
+        }
+    }
+
+    dObj->transferStatus = status;
+
+    return (uint32_t)status;
+}
+
+bool DRV_FTL_EraseCountGet( uint32_t block, uint32_t *eraseCount )
+{
+    if ((dObj->status != SYS_STATUS_READY) || (block >= dObj->numPhysical))
+    {
+        return false;
+    }
+
+    *eraseCount = dObj->eraseCount[block];
+    return true;
+}
+
+void DRV_FTL_StatsGet( DRV_FTL_STATS *stats )
+{
+    uint16_t physical;
+    uint32_t count;
+
+    (void) memset(stats, 0, sizeof(*stats));
+
+    if (dObj->status != SYS_STATUS_READY)
+    {
+        return;
+    }
+
+    stats->ready = true;
+    stats->logicalBlocks = dObj->numLogical;
+    stats->physicalBlocks = dObj->numPhysical;
+    stats->eraseMin = 0xFFFFFFFFU;
+
+    for (physical = 0; physical < dObj->numPhysical; physical++)
+    {
+        count = dObj->eraseCount[physical];
+
+        if (dObj->owner[physical] == DRV_FTL_UNMAPPED)
+        {
+            stats->freeBlocks++;
+        }
+
+        if (count < stats->eraseMin)
+        {
+            stats->eraseMin = count;
+        }
+
+        if (count > stats->eraseMax)
+        {
+            stats->eraseMax = count;
+        }
+
+        stats->eraseTotal += count;
+    }
+
+    stats->remaps = dObj->remaps;
+    stats->logCompactions = dObj->logCompactions;
+    stats->flashErrors = dObj->flashErrors;
+}
+
+#endif // DRV_FTL_ENABLE
@@ -0,0 +1,194 @@
+/*******************************************************************************
+  FTL Driver Local Data Structures
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    drv_ftl_local.h
+
+  Summary:
+    FTL driver local declarations and definitions
+
+  Description:
+    This file contains the FTL driver's local declarations and definitions.
+*******************************************************************************/
+
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2021 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+//DOM-IGNORE-END
+
+#ifndef DRV_FTL_LOCAL_H
+#define DRV_FTL_LOCAL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: File includes
+// *****************************************************************************
+// *****************************************************************************
+
+#include "configuration.h"
+#include "driver/ftl/drv_ftl.h"
+#include "driver/sst26/drv_sst26.h"
+
+#include "osal/osal.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Data Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+#define DRV_FTL_SECTOR_SIZE         DRV_SST26_ERASE_BUFFER_SIZE
+#define DRV_FTL_PAGE_SIZE           DRV_SST26_PAGE_SIZE
+
+/* Log sector layout: a header in slot 0 followed by records */
+#define DRV_FTL_SLOT_SIZE           16U
+#define DRV_FTL_LOG_SLOTS           (DRV_FTL_SECTOR_SIZE / DRV_FTL_SLOT_SIZE)
+#define DRV_FTL_SLOTS_PER_PAGE      (DRV_FTL_PAGE_SIZE / DRV_FTL_SLOT_SIZE)
+
+#define DRV_FTL_LOG_MAGIC           0x46544C31UL /* "FTL1" */
+#define DRV_FTL_RECORD_VALID        0xA55AU
+
+/* Logical sector of a free physical sector, physical sector of a logical
+ * sector never written */
+#define DRV_FTL_UNMAPPED            0xFFFFU
+
+/* Log position (sector * DRV_FTL_LOG_SLOTS + slot) of no record */
+#define DRV_FTL_NO_POS              0xFFFFU
+
+/* Guards the wait for the end of an SST26 transfer against a lost event */
+#define DRV_FTL_WAIT_TIMEOUT_MS     100U
+
+typedef struct
+{
+    uint32_t magic;
+
+    /* Incremented every time a log sector becomes the head */
+    uint32_t seq;
+
+    /* ~seq, a torn header is not valid */
+    uint32_t check;
+
+    uint32_t reserved;
+} DRV_FTL_LOG_HEADER;
+
+/* The latest record of a physical sector states the logical sector it holds
+ * and its erase count. Two physical sectors may claim the same logical one
+ * (the previous one was freed), the record with the highest seq wins. */
+typedef struct
+{
+    uint16_t logical;
+
+    uint16_t physical;
+
+    uint32_t seq;
+
+    uint32_t eraseCount;
+
+    uint16_t state;
+
+    /* CRC-16/CCITT of the fields above */
+    uint16_t check;
+} DRV_FTL_RECORD;
+
+typedef struct
+{
+    /* SYS_STATUS_READY once the log is mounted */
+    SYS_STATUS status;
+
+    DRV_HANDLE sst26Handle;
+
+    /* Memory driver handler, called at the end of the transfers started
+     * for it */
+    DRV_MEMORY_EVENT_HANDLER eventHandler;
+
+    uintptr_t context;
+
+    /* An SST26 transfer started for the Memory driver is in progress, its
+     * end is signaled to eventHandler */
+    volatile bool deviceTransfer;
+
+    /* Signaled at the end of any SST26 transfer */
+    OSAL_SEM_DECLARE(eventSemaphore);
+
+    /* Status of a transfer completed without an SST26 transfer in
+     * progress */
+    MEMORY_DEVICE_TRANSFER_STATUS transferStatus;
+
+    /* SST26 address of the first log sector */
+    uint32_t deviceStart;
+
+    uint16_t numLogical;
+
+    uint16_t numPhysical;
+
+    /* Head of the log */
+    uint8_t logSector;
+
+    uint16_t logSlot;
+
+    uint32_t logSeq;
+
+    uint32_t recordSeq;
+
+    /* A logical sector was moved to pendingPhysical and is not recorded
+     * yet. pendingOld is the physical sector it leaves. */
+    bool commitPending;
+
+    /* The erase started for the remap is in progress */
+    bool eraseInProgress;
+
+    /* The page in progress is the last one of the pending sector */
+    bool commitOnComplete;
+
+    uint16_t pendingLogical;
+
+    uint16_t pendingPhysical;
+
+    uint16_t pendingOld;
+
+    /* The free sector search starts here, sectors with the same erase
+     * count are used in turn */
+    uint16_t allocNext;
+
+    uint32_t remaps;
+
+    uint32_t logCompactions;
+
+    uint32_t flashErrors;
+
+    /* Logical to physical sector */
+    uint16_t map[DRV_FTL_BLOCKS_MAX];
+
+    /* Physical to logical sector, DRV_FTL_UNMAPPED: free */
+    uint16_t owner[DRV_FTL_BLOCKS_MAX];
+
+    /* Log position of the latest record of each physical sector */
+    uint16_t logPos[DRV_FTL_BLOCKS_MAX];
+
+    uint32_t eraseCount[DRV_FTL_BLOCKS_MAX];
+} DRV_FTL_OBJECT;
+
+#endif //#ifndef DRV_FTL_LOCAL_H
@@ -433,6 +433,112 @@ SYS_STATUS DRV_MEMORY_Status( SYS_MODULE_OBJ object );
 
 void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object );
 
+// ****************************************************************************
+/* Function:
+    void DRV_MEMORY_TasksWait( SYS_MODULE_OBJ object, uint16_t timeoutMs );
+
+  Summary:
+    Blocks the Memory driver thread until DRV_MEMORY_Tasks has work to do.
+
+  Description:
+    The driver is woken up when a request is queued, when the memory device
+    signals the end of a transfer, or when the erase write cache is due to be
+    programmed. It returns immediately if the next step of the current request
+    can be started, and waits timeoutMs at most while a device transfer is in
+    progress. Without the device interrupt, or before the driver is ready, it
+    waits timeoutMs.
+
+  Preconditions:
+    The DRV_MEMORY_Initialize routine must have been called for the specified
+    Memory driver instance.
+
+  Parameters:
+    object    - Driver object handle, returned from the DRV_MEMORY_Initialize
+                routine
+
+    timeoutMs - Polling period
+
+  Returns:
+    None.
+
+  Example:
+    <code>
+    while(true)
+    {
+        DRV_MEMORY_Tasks(object);
+        DRV_MEMORY_TasksWait(object, DRV_MEMORY_RTOS_DELAY_IDX0);
+    }
+    </code>
+
+  Remarks:
+    For RTOS only, replaces the fixed delay of the driver thread.
+*/
+
+void DRV_MEMORY_TasksWait( SYS_MODULE_OBJ object, uint16_t timeoutMs );
+
+// ****************************************************************************
+/* Function:
+    bool DRV_MEMORY_DeviceAccessLock( SYS_MODULE_OBJ object );
+
+  Summary:
+    Reserves the attached memory device for direct access.
+
+  Description:
+    This routine takes the instance transfer lock when no transfer is in
+    progress. While the lock is held DRV_MEMORY_Tasks will not start the
+    queued requests, so the caller can use the memory device routines
+    directly on a region which is not exposed through the media geometry
+    (for example the area below DRV_SST26_START_ADDRESS).
+
+  Preconditions:
+    The DRV_MEMORY_Status routine must have returned SYS_STATUS_READY.
+
+  Parameters:
+    object -  Driver object handle, returned from the DRV_MEMORY_Initialize
+              routine
+
+  Returns:
+    true  - The device is reserved. DRV_MEMORY_DeviceAccessUnlock must be
+            called once the direct access is complete.
+    false - A transfer is in progress or the driver is not ready. Retry later.
+
+  Example:
+    <code>
+    if (DRV_MEMORY_DeviceAccessLock(sysObj.drvMemory0) == true)
+    {
+        // Access the memory device directly
+
+        DRV_MEMORY_DeviceAccessUnlock(sysObj.drvMemory0);
+    }
+    </code>
+
+  Remarks:
+    The device transfer must be complete before the lock is released. Keep
+    the access short, the file system requests are held off meanwhile.
+*/
+
+bool DRV_MEMORY_DeviceAccessLock( SYS_MODULE_OBJ object );
+
+// ****************************************************************************
+/* Function:
+    void DRV_MEMORY_DeviceAccessUnlock( SYS_MODULE_OBJ object );
+
+  Summary:
+    Releases the memory device reserved by DRV_MEMORY_DeviceAccessLock.
+
+  Precondition:
+    DRV_MEMORY_DeviceAccessLock must have returned true.
+
+  Parameters:
+    object -  Driver object handle, returned from the DRV_MEMORY_Initialize
+              routine
+
+  Returns:
+    None.
+*/
+
+void DRV_MEMORY_DeviceAccessUnlock( SYS_MODULE_OBJ object );
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Memory Driver Client Routines
@@ -949,6 +1055,68 @@ bool DRV_MEMORY_SyncEraseWrite
     uint32_t nBlock
 );
 
+// *****************************************************************************
+/* Function:
+    void DRV_MEMORY_AsyncCacheFlush
+    (
+        const DRV_HANDLE handle,
+        DRV_MEMORY_COMMAND_HANDLE *commandHandle
+    );
+
+  Summary:
+    Programs the sector held in the erase write cache.
+
+  Description:
+    When DRV_MEMORY_INIT::cacheIdleTimeoutMs is not zero, erase write requests
+    to the same sector are collected in the erase buffer and the sector is
+    erased and programmed once: when a request targets another sector, when
+    no request was queued for cacheIdleTimeoutMs, or on a flush.
+
+    This function queues a flush request behind the pending requests. The
+    request completes once the cached sector is on the flash, or immediately
+    if the cache is clean.
+
+  Precondition:
+    The DRV_MEMORY_Open() must have been called with DRV_IO_INTENT_WRITE or
+    DRV_IO_INTENT_READWRITE as a parameter to obtain a valid opened device
+    handle.
+
+  Parameters:
+    handle        - A valid open-instance handle, returned from the driver's
+                    open function
+
+    commandHandle - Pointer to an argument that will contain the return buffer
+                    handle
+
+  Returns:
+    The buffer handle is returned in the commandHandle argument. It will be
+    DRV_MEMORY_COMMAND_HANDLE_INVALID if the request was not queued.
+
+  Example:
+    <code>
+
+    DRV_MEMORY_COMMAND_HANDLE commandHandle;
+
+    DRV_MEMORY_AsyncCacheFlush(memoryHandle, &commandHandle);
+
+    if(DRV_MEMORY_COMMAND_HANDLE_INVALID == commandHandle)
+    {
+        // Error handling here
+    }
+
+    </code>
+
+  Remarks:
+    Used as the cacheFlush entry of the file system and USB MSD media
+    functions.
+*/
+
+void DRV_MEMORY_AsyncCacheFlush
+(
+    const DRV_HANDLE handle,
+    DRV_MEMORY_COMMAND_HANDLE *commandHandle
+);
+
 // *****************************************************************************
 /* Function:
     void DRV_MEMORY_AsyncWrite
@@ -223,6 +223,13 @@ typedef struct
     /* Erase Write Buffer pointer */
     uint8_t *ewBuffer;
 
+    /* Write-back cache idle timeout. When not 0, ewBuffer keeps the last
+     * erase sector written and consecutive writes to that sector are merged
+     * into one erase and program. The sector is programmed when another
+     * sector is written, on a cache flush request or after this many
+     * milliseconds without writes. */
+    uint32_t cacheIdleTimeoutMs;
+
     /* Memory pool for Client Objects */
     uintptr_t  clientObjPool;
 
@@ -50,6 +50,7 @@
 #include "driver/memory/src/drv_memory_local.h"
 #include "system/debug/sys_debug.h"
 #include "driver/memory/src/drv_memory_file_system.h"
+#include "system/time/sys_time.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -63,6 +64,13 @@
 
 static DRV_MEMORY_OBJECT gDrvMemoryObj[DRV_MEMORY_INSTANCES_NUMBER];
 
+#ifdef DRV_MEMORY_TRANSFER_COMPLETE_HOOK
+/* Configuration supplied hook, invoked from DRV_MEMORY_Tasks() after the
+ * client event handlers of completed requests were called, so that a client
+ * which polls for completion can be woken up */
+extern void DRV_MEMORY_TRANSFER_COMPLETE_HOOK(void);
+#endif
+
 
 /************************************************
  * This token is incremented for every request added to the queue and is used
@@ -101,12 +109,21 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
     uint32_t nBlocks
 );
 
-static const DRV_MEMORY_TransferOperation gMemoryXferFuncPtr[4] =
+static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleCacheFlush
+(
+    DRV_MEMORY_OBJECT *dObj,
+    uint8_t *data,
+    uint32_t blockStart,
+    uint32_t nBlocks
+);
+
+static const DRV_MEMORY_TransferOperation gMemoryXferFuncPtr[5] =
 {
     DRV_MEMORY_HandleRead,
     DRV_MEMORY_HandleWrite,
     DRV_MEMORY_HandleErase,
     DRV_MEMORY_HandleEraseWrite,
+    DRV_MEMORY_HandleCacheFlush,
 };
 
 // *****************************************************************************
@@ -119,6 +136,9 @@ static void DRV_MEMORY_EventHandler( MEMORY_DEVICE_TRANSFER_STATUS status, uintp
 {
     DRV_MEMORY_OBJECT *dObj = (DRV_MEMORY_OBJECT *)context;
     dObj->isTransferDone = true;
+
+    /* Wake up the driver task to start the next step */
+    (void) OSAL_SEM_PostISR(&dObj->eventSemaphore);
 }
 
 static inline uint16_t DRV_MEMORY_UPDATE_TOKEN(uint16_t token)
@@ -208,6 +228,8 @@ static void DRV_MEMORY_AllocateBufferObject
         dObj->queueTail->next = bufferObj;
         dObj->queueTail = bufferObj;
     }
+
+    (void) OSAL_SEM_Post(&dObj->eventSemaphore);
 }
 
 /* This function validates the driver handle and returns the client object
@@ -285,7 +307,6 @@ static void DRV_MEMORY_RemoveClientBufferObjects
             if(previous == NULL)
             {
                 dObj->queueHead = current->next;
-                previous = current;
             }
             else
             {
@@ -305,14 +326,99 @@ static void DRV_MEMORY_RemoveClientBufferObjects
         }
     }
 
-    if(dObj->queueHead != (DRV_MEMORY_BUFFER_OBJECT *)NULL)
+    /* The last object left in the queue, if any, is the new tail */
+    dObj->queueTail = previous;
+}
+
+/* Picks the next request to be processed. Requests are served in the order
+ * they were queued, except that the client served last yields to the oldest
+ * request of any other client: a client streaming requests cannot hold off
+ * the others for more than one request. */
+static DRV_MEMORY_BUFFER_OBJECT *DRV_MEMORY_QueueSelect( DRV_MEMORY_OBJECT *dObj )
+{
+    DRV_MEMORY_BUFFER_OBJECT *bufferObj = dObj->queueHead;
+    DRV_MEMORY_BUFFER_OBJECT *other = NULL;
+
+    if ((bufferObj == NULL) || (bufferObj->hClient != dObj->lastClient))
+    {
+        return bufferObj;
+    }
+
+    for (other = bufferObj->next; other != NULL; other = other->next)
+    {
+        if (other->hClient != dObj->lastClient)
+        {
+            return other;
+        }
+    }
+
+    return bufferObj;
+}
+
+/* Appends the reads queued right behind bufferObj by the same client to it
+ * when they continue both the memory range and the destination buffer, so
+ * that they are done as one device read. Returns the last merged request. */
+static DRV_MEMORY_BUFFER_OBJECT *DRV_MEMORY_QueueMergeReads
+(
+    DRV_MEMORY_OBJECT *dObj,
+    DRV_MEMORY_BUFFER_OBJECT *bufferObj
+)
+{
+    DRV_MEMORY_BUFFER_OBJECT *last = bufferObj;
+    DRV_MEMORY_BUFFER_OBJECT *next = bufferObj->next;
+    uint32_t blockSize = dObj->mediaGeometryTable[SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY].blockSize;
+
+    if (bufferObj->opType != DRV_MEM_OP_TYPE_READ)
+    {
+        return last;
+    }
+
+    while ((next != NULL) &&
+           (next->hClient == bufferObj->hClient) &&
+           (next->opType == DRV_MEM_OP_TYPE_READ) &&
+           (next->blockStart == (bufferObj->blockStart + bufferObj->nBlocks)) &&
+           (next->buffer == &bufferObj->buffer[bufferObj->nBlocks * blockSize]))
+    {
+        bufferObj->nBlocks += next->nBlocks;
+        next->status = DRV_MEMORY_COMMAND_IN_PROGRESS;
+
+        last = next;
+        next = next->next;
+    }
+
+    return last;
+}
+
+/* Unlinks the consecutive requests first..last from the queue. */
+static void DRV_MEMORY_QueueRemove
+(
+    DRV_MEMORY_OBJECT *dObj,
+    DRV_MEMORY_BUFFER_OBJECT *first,
+    DRV_MEMORY_BUFFER_OBJECT *last
+)
+{
+    DRV_MEMORY_BUFFER_OBJECT *previous = NULL;
+
+    if (dObj->queueHead == first)
     {
-        dObj->queueTail = (DRV_MEMORY_BUFFER_OBJECT *)NULL;
+        dObj->queueHead = last->next;
     }
     else
+    {
+        for (previous = dObj->queueHead; previous->next != first; previous = previous->next)
+        {
+            /* Find the request in front of first */
+        }
+
+        previous->next = last->next;
+    }
+
+    if (dObj->queueTail == last)
     {
         dObj->queueTail = previous;
     }
+
+    last->next = NULL;
 }
 
 /* This function updates the driver object's geometry information for the memory
@@ -353,6 +459,88 @@ static bool DRV_MEMORY_UpdateGeometry( DRV_MEMORY_OBJECT *dObj )
 
     return true;
 }
+
+/* Copies the part of the cached sector which overlaps a read from the flash,
+ * the cache holds newer data than the flash while it is dirty. */
+static void DRV_MEMORY_CacheOverlay
+(
+    DRV_MEMORY_OBJECT *dObj,
+    uint8_t *data,
+    uint32_t address,
+    uint32_t length
+)
+{
+    uint32_t cacheStart;
+    uint32_t start;
+    uint32_t end;
+
+    if ((dObj->cacheDirty == false) || (data == dObj->ewBuffer))
+    {
+        return;
+    }
+
+    cacheStart = (dObj->cacheSector * dObj->eraseBlockSize) + dObj->blockStartAddress;
+    start = (address > cacheStart) ? address : cacheStart;
+    end = ((address + length) < (cacheStart + dObj->eraseBlockSize)) ? (address + length) : (cacheStart + dObj->eraseBlockSize);
+
+    if (start < end)
+    {
+        (void) memcpy ((void *)&data[start - address], (const void *)&dObj->ewBuffer[start - cacheStart], end - start);
+    }
+}
+
+/* Returns true if a write or erase request covers the cached sector. Such
+ * requests bypass the cache, which must be programmed or dropped first. */
+static bool DRV_MEMORY_CacheOverlaps
+(
+    DRV_MEMORY_OBJECT *dObj,
+    DRV_MEMORY_BUFFER_OBJECT *bufferObj
+)
+{
+    uint32_t start;
+    uint32_t end;
+
+    if (dObj->cacheSector == DRV_MEMORY_CACHE_INVALID)
+    {
+        return false;
+    }
+
+    if (bufferObj->opType == DRV_MEM_OP_TYPE_ERASE)
+    {
+        return ((dObj->cacheSector >= bufferObj->blockStart) && (dObj->cacheSector < (bufferObj->blockStart + bufferObj->nBlocks)));
+    }
+
+    if (bufferObj->opType == DRV_MEM_OP_TYPE_WRITE)
+    {
+        start = bufferObj->blockStart * dObj->writeBlockSize;
+        end = start + (bufferObj->nBlocks * dObj->writeBlockSize);
+
+        return ((start < ((dObj->cacheSector + 1U) * dObj->eraseBlockSize)) && (end > (dObj->cacheSector * dObj->eraseBlockSize)));
+    }
+
+    return false;
+}
+
+/* Decides, in between two requests, whether the cache has to be programmed
+ * now. */
+static bool DRV_MEMORY_CacheFlushNeeded
+(
+    DRV_MEMORY_OBJECT *dObj,
+    DRV_MEMORY_BUFFER_OBJECT *bufferObj
+)
+{
+    if (dObj->cacheDirty == false)
+    {
+        return false;
+    }
+
+    if (bufferObj == NULL)
+    {
+        return (SYS_TIME_CountToMS(SYS_TIME_CounterGet() - dObj->cacheWriteTime) >= dObj->cacheIdleTimeoutMs);
+    }
+
+    return DRV_MEMORY_CacheOverlaps(dObj, bufferObj);
+}
 /* MISRA C-2012 Rule 16.1, 16.3, 16.5, 16.6 deviated below.Deviation record ID -
   H3_MISRAC_2012_R_16_1_DR_1, H3_MISRAC_2012_R_16_3_DR_1, H3_MISRAC_2012_R_16_5_DR_1 & H3_MISRAC_2012_R_16_6_DR_1*/
 
@@ -365,14 +553,13 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleRead
 )
 {
     MEMORY_DEVICE_TRANSFER_STATUS transferStatus;
-    uint32_t address = 0;
+    uint32_t address = (blockStart * dObj->mediaGeometryTable[0].blockSize) + dObj->blockStartAddress;
 
     switch (dObj->readState)
     {
         case DRV_MEMORY_READ_INIT:
         default:
         {
-            address = (blockStart * dObj->mediaGeometryTable[0].blockSize) + dObj->blockStartAddress;
             dObj->readState = DRV_MEMORY_READ_MEM;
             /* Fall through */
         }
@@ -395,6 +582,11 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleRead
         case DRV_MEMORY_READ_MEM_STATUS:
         {
             transferStatus = (MEMORY_DEVICE_TRANSFER_STATUS)(uint32_t)(dObj->memoryDevice->TransferStatusGet(dObj->memDevHandle));
+
+            if (transferStatus == MEMORY_DEVICE_TRANSFER_COMPLETED)
+            {
+                DRV_MEMORY_CacheOverlay(dObj, data, address, nBlocks * dObj->mediaGeometryTable[0].blockSize);
+            }
             break;
         }
     }
@@ -531,6 +723,86 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleErase
     return transferStatus;
 }
 
+/* Programs the cached sector, if dirty, from ewBuffer. */
+static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_CacheProgram( DRV_MEMORY_OBJECT *dObj )
+{
+    uint32_t pagesPerSector = (dObj->eraseBlockSize / dObj->writeBlockSize);
+    MEMORY_DEVICE_TRANSFER_STATUS transferStatus = MEMORY_DEVICE_TRANSFER_COMPLETED;
+
+    if (dObj->cacheDirty == false)
+    {
+        return transferStatus;
+    }
+
+    switch (dObj->flushState)
+    {
+        case DRV_MEMORY_FLUSH_INIT:
+        default:
+        {
+            dObj->eraseState = DRV_MEMORY_ERASE_INIT;
+            dObj->writeState = DRV_MEMORY_WRITE_INIT;
+            dObj->flushState = DRV_MEMORY_FLUSH_ERASE;
+            /* Fall through */
+        }
+
+        case DRV_MEMORY_FLUSH_ERASE:
+        {
+            transferStatus = DRV_MEMORY_HandleErase(dObj, NULL, dObj->cacheSector, 1);
+            if (transferStatus == MEMORY_DEVICE_TRANSFER_COMPLETED)
+            {
+                dObj->flushState = DRV_MEMORY_FLUSH_WRITE;
+
+                transferStatus = MEMORY_DEVICE_TRANSFER_BUSY;
+            }
+            break;
+        }
+
+        case DRV_MEMORY_FLUSH_WRITE:
+        {
+            transferStatus = DRV_MEMORY_HandleWrite(dObj, dObj->ewBuffer, dObj->cacheSector * pagesPerSector, pagesPerSector);
+            if (transferStatus == MEMORY_DEVICE_TRANSFER_COMPLETED)
+            {
+                dObj->cacheDirty = false;
+                dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+            }
+            break;
+        }
+    }
+
+    if (transferStatus >= MEMORY_DEVICE_TRANSFER_ERROR_UNKNOWN)
+    {
+        /* The sector contents are lost either way, do not retry forever */
+        dObj->cacheDirty = false;
+        dObj->cacheSector = DRV_MEMORY_CACHE_INVALID;
+        dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+    }
+
+    return transferStatus;
+}
+
+/* Moves an erase write request to its next sector. */
+static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_EraseWriteNext
+(
+    DRV_MEMORY_OBJECT *dObj,
+    DRV_MEMORY_BUFFER_OBJECT *bufferObj
+)
+{
+    if ((bufferObj->nBlocks - dObj->nBlocksToWrite) == 0U)
+    {
+        /* This is the last write operation. */
+        return MEMORY_DEVICE_TRANSFER_COMPLETED;
+    }
+
+    /* Update the number of block still to be written, sector address
+     * and the buffer pointer */
+    bufferObj->nBlocks -= dObj->nBlocksToWrite;
+    bufferObj->blockStart += dObj->nBlocksToWrite;
+    bufferObj->buffer += (dObj->nBlocksToWrite * dObj->writeBlockSize);
+    dObj->ewState = DRV_MEMORY_EW_INIT;
+
+    return MEMORY_DEVICE_TRANSFER_BUSY;
+}
+
 static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
 (
     DRV_MEMORY_OBJECT *dObj,
@@ -566,8 +838,36 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
                 dObj->nBlocksToWrite = bufferObj->nBlocks;
             }
 
+            if (dObj->cacheIdleTimeoutMs != 0U)
+            {
+                if (dObj->cacheSector == dObj->sectorNumber)
+                {
+                    /* The sector is cached, only update it */
+                    (void) memcpy ((void *)&dObj->ewBuffer[dObj->blockOffsetInSector * dObj->writeBlockSize], (const void *)bufferObj->buffer, dObj->nBlocksToWrite * dObj->writeBlockSize);
+
+                    dObj->cacheDirty = true;
+                    dObj->cacheWriteTime = SYS_TIME_CounterGet();
+
+                    transferStatus = DRV_MEMORY_EraseWriteNext(dObj, bufferObj);
+
+                    break;
+                }
+
+                if (dObj->cacheDirty == true)
+                {
+                    /* ewBuffer is needed for another sector */
+                    dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+                    dObj->ewState = DRV_MEMORY_EW_FLUSH_CACHE;
+
+                    transferStatus = MEMORY_DEVICE_TRANSFER_BUSY;
+
+                    break;
+                }
+            }
+
             if (dObj->nBlocksToWrite != pagesPerSector)
             {
+                dObj->cacheSector = DRV_MEMORY_CACHE_INVALID;
                 dObj->writePtr = dObj->ewBuffer;
                 dObj->ewState = DRV_MEMORY_EW_READ_SECTOR;
             }
@@ -597,6 +897,19 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
 
                 (void) memcpy ((void *)&dObj->ewBuffer[dObj->blockOffsetInSector], (const void *)bufferObj->buffer, dObj->nBlocksToWrite * dObj->writeBlockSize);
 
+                if (dObj->cacheIdleTimeoutMs != 0U)
+                {
+                    /* Keep the sector in ewBuffer, the following writes
+                     * usually go to the same sector */
+                    dObj->cacheSector = dObj->sectorNumber;
+                    dObj->cacheDirty = true;
+                    dObj->cacheWriteTime = SYS_TIME_CounterGet();
+
+                    transferStatus = DRV_MEMORY_EraseWriteNext(dObj, bufferObj);
+
+                    break;
+                }
+
                 dObj->ewState = DRV_MEMORY_EW_ERASE_SECTOR;
 
                 /* Fall through for Erase operation. */
@@ -625,22 +938,21 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
 
             if (transferStatus == MEMORY_DEVICE_TRANSFER_COMPLETED)
             {
-                if ((bufferObj->nBlocks - dObj->nBlocksToWrite) == 0U)
-                {
-                    /* This is the last write operation. */
-                    break;
-                }
+                transferStatus = DRV_MEMORY_EraseWriteNext(dObj, bufferObj);
+            }
+
+            break;
+        }
 
-                /* Update the number of block still to be written, sector address
-                 * and the buffer pointer */
-                bufferObj->nBlocks -= dObj->nBlocksToWrite;
-                bufferObj->blockStart += dObj->nBlocksToWrite;
-                bufferObj->buffer += (dObj->nBlocksToWrite * dObj->writeBlockSize);
+        case DRV_MEMORY_EW_FLUSH_CACHE:
+        {
+            transferStatus = DRV_MEMORY_CacheProgram(dObj);
+            if (transferStatus == MEMORY_DEVICE_TRANSFER_COMPLETED)
+            {
                 dObj->ewState = DRV_MEMORY_EW_INIT;
 
                 transferStatus = MEMORY_DEVICE_TRANSFER_BUSY;
             }
-
             break;
         }
     }
@@ -648,6 +960,17 @@ static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleEraseWrite
     return transferStatus;
 }
 
+static MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_HandleCacheFlush
+(
+    DRV_MEMORY_OBJECT *dObj,
+    uint8_t *data,
+    uint32_t blockStart,
+    uint32_t nBlocks
+)
+{
+    return DRV_MEMORY_CacheProgram(dObj);
+}
+
 static void DRV_MEMORY_SetupXfer
 (
     const DRV_HANDLE handle,
@@ -774,6 +1097,7 @@ SYS_MODULE_OBJ DRV_MEMORY_Initialize
     dObj->buffObjFree         = (DRV_MEMORY_BUFFER_OBJECT *)NULL;
     dObj->queueHead           = (DRV_MEMORY_BUFFER_OBJECT *)NULL;
     dObj->queueTail           = (DRV_MEMORY_BUFFER_OBJECT *)NULL;
+    dObj->lastClient          = (DRV_MEMORY_CLIENT_OBJECT *)NULL;
     dObj->bufferToken         = 1;
     dObj->clientToken         = 1;
 
@@ -791,6 +1115,11 @@ SYS_MODULE_OBJ DRV_MEMORY_Initialize
     /* Set the erase buffer */
     dObj->ewBuffer = memoryInit->ewBuffer;
 
+    dObj->cacheSector = DRV_MEMORY_CACHE_INVALID;
+    dObj->cacheDirty = false;
+    dObj->cacheIdleTimeoutMs = memoryInit->cacheIdleTimeoutMs;
+    dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+
     dObj->state = DRV_MEMORY_PROCESS_QUEUE;
 
     if (OSAL_MUTEX_Create(&dObj->clientMutex) == OSAL_RESULT_FAIL)
@@ -805,6 +1134,12 @@ SYS_MODULE_OBJ DRV_MEMORY_Initialize
         return SYS_MODULE_OBJ_INVALID;
     }
 
+    if (OSAL_SEM_Create(&dObj->eventSemaphore, OSAL_SEM_TYPE_BINARY, 1, 0) == OSAL_RESULT_FAIL)
+    {
+        /* There was insufficient memory available for the semaphore to be created */
+        return SYS_MODULE_OBJ_INVALID;
+    }
+
     if (memoryInit->isFsEnabled == true)
     {
         DRV_MEMORY_RegisterWithSysFs(drvIndex, memoryInit->deviceMediaType);
@@ -1064,6 +1399,45 @@ void DRV_MEMORY_AsyncEraseWrite
             DRV_IO_INTENT_WRITE);
 }
 
+void DRV_MEMORY_AsyncCacheFlush
+(
+    const DRV_HANDLE handle,
+    DRV_MEMORY_COMMAND_HANDLE *commandHandle
+)
+{
+    DRV_MEMORY_CLIENT_OBJECT *clientObj = NULL;
+    DRV_MEMORY_OBJECT *dObj = NULL;
+
+    if (commandHandle != NULL)
+    {
+        *commandHandle = DRV_MEMORY_COMMAND_HANDLE_INVALID;
+    }
+
+    /* Validate the driver handle */
+    clientObj = DRV_MEMORY_DriverHandleValidate(handle);
+
+    if (clientObj == NULL)
+    {
+        SYS_DEBUG_MESSAGE(SYS_ERROR_INFO, "Invalid Memory driver handle.\n");
+        return;
+    }
+
+    if (((uint32_t)clientObj->intent & (uint32_t)DRV_IO_INTENT_WRITE) == 0U)
+    {
+        SYS_DEBUG_MESSAGE(SYS_ERROR_INFO, "Memory Driver Opened with invalid intent.\n");
+        return;
+    }
+
+    dObj = &gDrvMemoryObj[clientObj->drvIndex];
+
+    if (OSAL_MUTEX_Lock(&dObj->transferMutex, OSAL_WAIT_FOREVER ) == OSAL_RESULT_SUCCESS)
+    {
+        DRV_MEMORY_AllocateBufferObject (clientObj, commandHandle, NULL, 0, 0, DRV_MEM_OP_TYPE_CACHE_FLUSH);
+
+        (void) OSAL_MUTEX_Unlock(&dObj->transferMutex);
+    }
+}
+
 MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_TransferStatusGet
 (
     const DRV_HANDLE handle
@@ -1140,6 +1514,7 @@ void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object )
     DRV_MEMORY_OBJECT *dObj = NULL;
     DRV_MEMORY_CLIENT_OBJECT *clientObj = NULL;
     DRV_MEMORY_BUFFER_OBJECT *bufferObj = NULL;
+    DRV_MEMORY_BUFFER_OBJECT *nextObj = NULL;
     DRV_MEMORY_EVENT event = DRV_MEMORY_EVENT_COMMAND_ERROR;
     bool isDone = false;
     MEMORY_DEVICE_TRANSFER_STATUS transferStatus = MEMORY_DEVICE_TRANSFER_ERROR_UNKNOWN;
@@ -1173,7 +1548,14 @@ void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object )
         case DRV_MEMORY_PROCESS_QUEUE:
         {
             /* Process the queued requests. */
-            dObj->currentBufObj = dObj->queueHead;
+            dObj->currentBufObj = DRV_MEMORY_QueueSelect(dObj);
+
+            if (DRV_MEMORY_CacheFlushNeeded(dObj, dObj->currentBufObj) == true)
+            {
+                dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+                dObj->state = DRV_MEMORY_CACHE_FLUSH;
+                break;
+            }
 
             if (dObj->currentBufObj == NULL)
             {
@@ -1188,10 +1570,20 @@ void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object )
                 dObj->writeState = DRV_MEMORY_WRITE_INIT;
                 dObj->eraseState = DRV_MEMORY_ERASE_INIT;
                 dObj->ewState    = DRV_MEMORY_EW_INIT;
+                dObj->flushState = DRV_MEMORY_FLUSH_INIT;
+
+                /* Writes and erases of the cached sector bypass the cache,
+                 * which is clean at this point. */
+                if (DRV_MEMORY_CacheOverlaps(dObj, dObj->currentBufObj) == true)
+                {
+                    dObj->cacheSector = DRV_MEMORY_CACHE_INVALID;
+                }
 
                 dObj->state = DRV_MEMORY_TRANSFER;
 
                 dObj->currentBufObj->status = DRV_MEMORY_COMMAND_IN_PROGRESS;
+
+                dObj->mergeTail = DRV_MEMORY_QueueMergeReads(dObj, dObj->currentBufObj);
             }
         }
 
@@ -1224,22 +1616,45 @@ void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object )
                 clientObj = (DRV_MEMORY_CLIENT_OBJECT *)bufferObj->hClient;
 
                 dObj->isTransferDone = true;
+                dObj->lastClient = clientObj;
 
                 /* Go back waiting for the next request */
                 dObj->state = DRV_MEMORY_PROCESS_QUEUE;
 
-                /* Get the next buffer in the queue */
-                dObj->queueHead = dObj->queueHead->next;
+                /* Take the processed buffer, and the reads merged into it,
+                 * out of the queue */
+                DRV_MEMORY_QueueRemove(dObj, bufferObj, dObj->mergeTail);
 
-                /* Return the processed buffer to free list */
-                bufferObj->next = dObj->buffObjFree;
-                dObj->buffObjFree = bufferObj;
-
-                if(clientObj->transferHandler != NULL)
+                while (bufferObj != NULL)
                 {
-                    /* Call the event handler */
-                    clientObj->transferHandler((SYS_MEDIA_BLOCK_EVENT)event, (DRV_MEMORY_COMMAND_HANDLE)bufferObj->commandHandle, clientObj->context);
+                    nextObj = bufferObj->next;
+                    bufferObj->status = dObj->currentBufObj->status;
+
+                    /* Return the processed buffer to free list */
+                    bufferObj->next = dObj->buffObjFree;
+                    dObj->buffObjFree = bufferObj;
+
+                    if(clientObj->transferHandler != NULL)
+                    {
+                        /* Call the event handler */
+                        clientObj->transferHandler((SYS_MEDIA_BLOCK_EVENT)event, (DRV_MEMORY_COMMAND_HANDLE)bufferObj->commandHandle, clientObj->context);
+                    }
+
+                    bufferObj = nextObj;
                 }
+
+#ifdef DRV_MEMORY_TRANSFER_COMPLETE_HOOK
+                DRV_MEMORY_TRANSFER_COMPLETE_HOOK();
+#endif
+            }
+            break;
+        }
+
+        case DRV_MEMORY_CACHE_FLUSH:
+        {
+            if (DRV_MEMORY_CacheProgram(dObj) != MEMORY_DEVICE_TRANSFER_BUSY)
+            {
+                dObj->state = DRV_MEMORY_PROCESS_QUEUE;
             }
             break;
         }
@@ -1260,6 +1675,98 @@ void DRV_MEMORY_Tasks( SYS_MODULE_OBJ object )
     (void) OSAL_MUTEX_Unlock(&dObj->transferMutex);
 }
 
+void DRV_MEMORY_TasksWait( SYS_MODULE_OBJ object, uint16_t timeoutMs )
+{
+    DRV_MEMORY_OBJECT *dObj = NULL;
+    uint16_t waitMs = timeoutMs;
+    uint32_t elapsedMs = 0;
+
+    if(object == SYS_MODULE_OBJ_INVALID)
+    {
+        return;
+    }
+
+    dObj = &gDrvMemoryObj[object];
+
+    /* Without the device interrupt the transfer status has to be polled */
+    if ((dObj->status == SYS_STATUS_READY) && (dObj->isMemDevInterruptEnabled == true))
+    {
+        if ((dObj->state == DRV_MEMORY_PROCESS_QUEUE) && (dObj->queueHead == NULL))
+        {
+            /* Idle: sleep until a request is queued or the cache is due */
+            waitMs = OSAL_WAIT_FOREVER;
+
+            if (dObj->cacheDirty == true)
+            {
+                elapsedMs = SYS_TIME_CountToMS(SYS_TIME_CounterGet() - dObj->cacheWriteTime);
+                waitMs = (elapsedMs < dObj->cacheIdleTimeoutMs) ? (uint16_t)(dObj->cacheIdleTimeoutMs - elapsedMs) : 0U;
+            }
+        }
+        else if (dObj->isTransferDone == true)
+        {
+            /* The next step can be started right away */
+            waitMs = 0;
+        }
+        else
+        {
+            /* The device event handler signals the end of the transfer,
+             * timeoutMs only guards against a lost event */
+        }
+    }
+
+    if (waitMs != 0U)
+    {
+        (void) OSAL_SEM_Pend(&dObj->eventSemaphore, waitMs);
+    }
+}
+
+bool DRV_MEMORY_DeviceAccessLock( SYS_MODULE_OBJ object )
+{
+    DRV_MEMORY_OBJECT *dObj = NULL;
+
+    if(object == SYS_MODULE_OBJ_INVALID)
+    {
+        return false;
+    }
+
+    dObj = &gDrvMemoryObj[object];
+
+    if (dObj->status != SYS_STATUS_READY)
+    {
+        return false;
+    }
+
+    if (OSAL_MUTEX_Lock(&dObj->transferMutex , OSAL_WAIT_FOREVER) != OSAL_RESULT_SUCCESS)
+    {
+        return false;
+    }
+
+    /* A transfer spans several DRV_MEMORY_Tasks calls. Only hand out the
+     * device in between two requests. */
+    if ((dObj->state == DRV_MEMORY_TRANSFER) || (dObj->state == DRV_MEMORY_CACHE_FLUSH) ||
+        ((dObj->isMemDevInterruptEnabled == true) && (dObj->isTransferDone == false)))
+    {
+        (void) OSAL_MUTEX_Unlock(&dObj->transferMutex);
+        return false;
+    }
+
+    return true;
+}
+
+void DRV_MEMORY_DeviceAccessUnlock( SYS_MODULE_OBJ object )
+{
+    DRV_MEMORY_OBJECT *dObj = NULL;
+
+    if(object == SYS_MODULE_OBJ_INVALID)
+    {
+        return;
+    }
+
+    dObj = &gDrvMemoryObj[object];
+
+    (void) OSAL_MUTEX_Unlock(&dObj->transferMutex);
+}
+
 
 void DRV_MEMORY_TransferHandlerSet
 (
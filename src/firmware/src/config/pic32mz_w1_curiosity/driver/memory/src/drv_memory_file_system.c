@@ -71,6 +71,7 @@ static const SYS_FS_MEDIA_FUNCTIONS memoryMediaFunctions =
     .open               = DRV_MEMORY_Open,
     .close              = DRV_MEMORY_Close,
     .tasks              = DRV_MEMORY_Tasks,
+    .cacheFlush         = DRV_MEMORY_AsyncCacheFlush,
 };
 
 /* MISRAC 2012 deviation block end */
@@ -93,10 +93,16 @@ typedef enum
     DRV_MEM_OP_TYPE_ERASE,
 
     /* Request is erase write operation. */
-    DRV_MEM_OP_TYPE_ERASE_WRITE
+    DRV_MEM_OP_TYPE_ERASE_WRITE,
+
+    /* Request is to program the write-back sector cache. */
+    DRV_MEM_OP_TYPE_CACHE_FLUSH
 
 } DRV_MEM_OP_TYPE;
 
+/* ewBuffer does not hold any sector */
+#define DRV_MEMORY_CACHE_INVALID                        (0xFFFFFFFFU)
+
 /* MEMORY Driver write states. */
 typedef enum
 {
@@ -152,10 +158,27 @@ typedef enum
     DRV_MEMORY_EW_ERASE_SECTOR,
 
     /* Erase write write state */
-    DRV_MEMORY_EW_WRITE_SECTOR
+    DRV_MEMORY_EW_WRITE_SECTOR,
+
+    /* Erase write state programming the cached sector before reusing ewBuffer */
+    DRV_MEMORY_EW_FLUSH_CACHE
 
 } DRV_MEMORY_EW_STATE;
 
+/* MEMORY Driver write-back cache flush states. */
+typedef enum
+{
+    /* Flush init state */
+    DRV_MEMORY_FLUSH_INIT = 0,
+
+    /* Flush erase state */
+    DRV_MEMORY_FLUSH_ERASE,
+
+    /* Flush write state */
+    DRV_MEMORY_FLUSH_WRITE
+
+} DRV_MEMORY_FLUSH_STATE;
+
 typedef enum
 {
     /* Process the operations queued. */
@@ -164,6 +187,9 @@ typedef enum
     /* Perform the required transfer */
     DRV_MEMORY_TRANSFER,
 
+    /* Program the write-back sector cache outside of a request */
+    DRV_MEMORY_CACHE_FLUSH,
+
     /* Idle state of the driver. */
     DRV_MEMORY_IDLE,
 
@@ -252,6 +278,9 @@ typedef struct
     /* Erase write state */
     DRV_MEMORY_EW_STATE ewState;
 
+    /* Write-back cache flush state */
+    DRV_MEMORY_FLUSH_STATE flushState;
+
     /* MEMORY main task routine's states */
     DRV_MEMORY_STATE state;
 
@@ -264,6 +293,19 @@ typedef struct
     /* Pointer to the Erase Write buffer */
     uint8_t *ewBuffer;
 
+    /* Erase sector held by ewBuffer when used as write-back cache, or
+     * DRV_MEMORY_CACHE_INVALID */
+    uint32_t cacheSector;
+
+    /* ewBuffer holds data not programmed yet */
+    bool cacheDirty;
+
+    /* Time the cache is kept dirty without writes, 0: write-through */
+    uint32_t cacheIdleTimeoutMs;
+
+    /* SYS_TIME counter at the last write to the cache */
+    uint32_t cacheWriteTime;
+
     /* This instances flash start address */
     uint32_t blockStartAddress;
 
@@ -331,6 +373,12 @@ typedef struct
     /* Pointer to the current buffer object */
     DRV_MEMORY_BUFFER_OBJECT *currentBufObj;
 
+    /* Last of the queued reads merged into currentBufObj */
+    DRV_MEMORY_BUFFER_OBJECT *mergeTail;
+
+    /* Client of the last completed request */
+    DRV_MEMORY_CLIENT_OBJECT *lastClient;
+
     /* Memory pool for Client Objects */
     DRV_MEMORY_CLIENT_OBJECT *clientObjPool;
 
@@ -354,6 +402,9 @@ typedef struct
 
     /* Mutex to protect the client object pool */
     OSAL_MUTEX_DECLARE(clientMutex);
+
+    /* Signals DRV_MEMORY_TasksWait() that there is work to do */
+    OSAL_SEM_DECLARE(eventSemaphore);
 } DRV_MEMORY_OBJECT;
 
 typedef MEMORY_DEVICE_TRANSFER_STATUS (*DRV_MEMORY_TransferOperation)(
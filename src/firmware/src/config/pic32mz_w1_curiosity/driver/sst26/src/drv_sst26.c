@@ -173,6 +173,98 @@ static bool lDRV_SST26_ReadStatus( void )
     return true;
 }
 
+/* Called from the SPI interrupt once the erase/write command is out or a
+ * status read found the FLASH still busy.
+ */
+static bool lDRV_SST26_PollStatus( void )
+{
+    bool status = true;
+    bool interruptState;
+
+    /* The timer chain may give up on deferred polling at any point */
+    interruptState = SYS_INT_Disable();
+
+    if (dObj->pollDeferred == true)
+    {
+        /* The next status read is issued by lDRV_SST26_PollTimerCallback */
+        dObj->state = DRV_SST26_STATE_WAIT_ERASE_WRITE_POLL;
+    }
+    else
+    {
+        dObj->state = DRV_SST26_STATE_WAIT_ERASE_WRITE_COMPLETE;
+        status = lDRV_SST26_ReadStatus();
+    }
+
+    SYS_INT_Restore(interruptState);
+
+    return status;
+}
+
+static void lDRV_SST26_PollTimerCallback( uintptr_t context )
+{
+    SYS_TIME_HANDLE handle = SYS_TIME_HANDLE_INVALID;
+    bool interruptState;
+
+    (void)context;
+
+    /* Re-arm while a transfer is in progress. A new erase/write may be queued
+     * right after the current one completes and will reuse this chain.
+     */
+    if (dObj->transferStatus == DRV_SST26_TRANSFER_BUSY)
+    {
+        handle = SYS_TIME_CallbackRegisterUS(lDRV_SST26_PollTimerCallback, 0,
+                                             dObj->pollPeriodUs, SYS_TIME_SINGLE);
+    }
+
+    interruptState = SYS_INT_Disable();
+
+    if (handle == SYS_TIME_HANDLE_INVALID)
+    {
+        /* Idle, or out of timers. In the latter case the status is polled
+         * from the SPI interrupt until the chain is restarted. */
+        dObj->pollChain = false;
+        dObj->pollDeferred = false;
+    }
+
+    if (dObj->state == DRV_SST26_STATE_WAIT_ERASE_WRITE_POLL)
+    {
+        dObj->state = DRV_SST26_STATE_WAIT_ERASE_WRITE_COMPLETE;
+
+        if (lDRV_SST26_ReadStatus() == false)
+        {
+            dObj->transferStatus = DRV_SST26_TRANSFER_ERROR_UNKNOWN;
+        }
+    }
+
+    SYS_INT_Restore(interruptState);
+}
+
+/* Called from the task context with the transfer already marked busy */
+static void lDRV_SST26_PollStart( uint32_t periodUs )
+{
+    bool interruptState;
+    bool startChain;
+
+    interruptState = SYS_INT_Disable();
+
+    dObj->pollPeriodUs = periodUs;
+    startChain = !dObj->pollChain;
+    dObj->pollChain = true;
+    dObj->pollDeferred = true;
+
+    SYS_INT_Restore(interruptState);
+
+    if (startChain == true)
+    {
+        if (SYS_TIME_CallbackRegisterUS(lDRV_SST26_PollTimerCallback, 0,
+                                        periodUs, SYS_TIME_SINGLE) == SYS_TIME_HANDLE_INVALID)
+        {
+            dObj->pollChain = false;
+            dObj->pollDeferred = false;
+        }
+    }
+}
+
 static bool DRV_SST26_WriteCommandAddress( uint8_t command, uint32_t address )
 {
     uint8_t nBytes = 0;
@@ -240,6 +332,8 @@ static bool DRV_SST26_Erase( uint8_t command, uint32_t address )
 
     dObj->state             = DRV_SST26_STATE_ERASE;
 
+    lDRV_SST26_PollStart(DRV_SST26_ERASE_POLL_PERIOD_US);
+
     /* Start the transfer by submitting a Write Enable request. Further commands
      * will be issued from the interrupt context.
     */
@@ -318,11 +412,7 @@ void DRV_SST26_Handler( void )
             SYS_PORT_PinSet(dObj->chipSelectPin);
 
             /* Read the status of FLASH internal write cycle */
-            if (lDRV_SST26_ReadStatus() == true)
-            {
-                dObj->state = DRV_SST26_STATE_WAIT_ERASE_WRITE_COMPLETE;
-            }
-            else
+            if (lDRV_SST26_PollStatus() == false)
             {
                 dObj->transferStatus = DRV_SST26_TRANSFER_ERROR_UNKNOWN;
             }
@@ -338,7 +428,7 @@ void DRV_SST26_Handler( void )
             if ((sst26Response[1] & (1UL << 0)) != 0U)
             {
                 /* Keep reading the status of FLASH internal write cycle */
-                if (lDRV_SST26_ReadStatus() == false)
+                if (lDRV_SST26_PollStatus() == false)
                 {
                     dObj->transferStatus = DRV_SST26_TRANSFER_ERROR_UNKNOWN;
                 }
@@ -350,6 +440,12 @@ void DRV_SST26_Handler( void )
             break;
         }
 
+        case DRV_SST26_STATE_WAIT_ERASE_WRITE_POLL:
+        {
+            /* No transfer is in progress while waiting for the poll timer */
+            break;
+        }
+
         case DRV_SST26_STATE_ERASE:
         {
             /* De-assert the chip select */
@@ -542,6 +638,8 @@ bool DRV_SST26_PageWrite( const DRV_HANDLE handle, void *tx_data, uint32_t addre
 
     dObj->state             = DRV_SST26_STATE_WRITE_CMD_ADDR;
 
+    lDRV_SST26_PollStart(DRV_SST26_WRITE_POLL_PERIOD_US);
+
     status = DRV_SST26_WriteEnable();
 
     if (status == false)
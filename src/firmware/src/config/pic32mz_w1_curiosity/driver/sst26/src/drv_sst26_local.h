@@ -50,6 +50,8 @@
 #include <string.h>
 #include "configuration.h"
 #include "driver/sst26/drv_sst26.h"
+#include "system/int/sys_int.h"
+#include "system/time/sys_time.h"
 // *****************************************************************************
 // *****************************************************************************
 // Section: Local Data Type Definitions
@@ -124,6 +126,7 @@ typedef enum
     DRV_SST26_STATE_WRITE_DATA,
     DRV_SST26_STATE_CHECK_ERASE_WRITE_STATUS,
     DRV_SST26_STATE_WAIT_ERASE_WRITE_COMPLETE,
+    DRV_SST26_STATE_WAIT_ERASE_WRITE_POLL,
     DRV_SST26_STATE_ERASE,
     DRV_SST26_STATE_UNLOCK_FLASH,
     DRV_SST26_STATE_WAIT_UNLOCK_FLASH_COMPLETE,
@@ -196,6 +199,16 @@ typedef struct
 
     DRV_SST26_TRANSFER_OBJ          transferDataObj;
 
+    /* A SYS_TIME single shot timer chain is pacing the status polls */
+    volatile bool pollChain;
+
+    /* The current erase/write waits for the timer chain between status
+     * polls instead of re-reading the status from the SPI interrupt */
+    volatile bool pollDeferred;
+
+    /* Interval between status polls of the current erase/write */
+    uint32_t pollPeriodUs;
+
 } DRV_SST26_OBJECT;
 
 
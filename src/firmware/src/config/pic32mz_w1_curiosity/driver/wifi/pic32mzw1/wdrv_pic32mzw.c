@@ -60,6 +60,18 @@ extern pktmem_priority_t g_pktmem_pri[NUM_MEM_PRI_LEVELS];
 bool DRV_PIC32MZW_StoreBSSScanResult(const DRV_PIC32MZW_SCAN_RESULTS *const pScanResult);
 bool DRV_PIC32MZW_Crypto_Random_Init(CRYPT_RNG_CTX *pRngCtx);
 
+/* The driver memory comes from OSAL_Malloc() unless the configuration
+   provides another allocator, e.g. to account for it. */
+#if defined(WDRV_PIC32MZW_MEM_ALLOC_HOOK) && defined(WDRV_PIC32MZW_MEM_FREE_HOOK)
+void* WDRV_PIC32MZW_MEM_ALLOC_HOOK(size_t size);
+void WDRV_PIC32MZW_MEM_FREE_HOOK(void *pData);
+#define _DRV_PIC32MZW_HeapAlloc(size)   WDRV_PIC32MZW_MEM_ALLOC_HOOK(size)
+#define _DRV_PIC32MZW_HeapFree(pData)   WDRV_PIC32MZW_MEM_FREE_HOOK(pData)
+#else
+#define _DRV_PIC32MZW_HeapAlloc(size)   OSAL_Malloc(size)
+#define _DRV_PIC32MZW_HeapFree(pData)   OSAL_Free(pData)
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: PIC32MZW Driver Defines
@@ -3768,7 +3780,7 @@ void* DRV_PIC32MZW_MemAlloc(DRV_PIC32MZW_ALLOC_OPT_ARGS uint16_t size)
 
     alignedSize = (((size + sizeof(DRV_PIC32MZW_MEM_ALLOC_HDR)) + ((2*PIC32MZW_CACHE_LINE_SIZE)-1)) / PIC32MZW_CACHE_LINE_SIZE) * PIC32MZW_CACHE_LINE_SIZE;
 
-    pUnalignedPtr = OSAL_Malloc(alignedSize);
+    pUnalignedPtr = _DRV_PIC32MZW_HeapAlloc(alignedSize);
 
     if (NULL == pUnalignedPtr)
     {
@@ -3922,7 +3934,7 @@ int8_t DRV_PIC32MZW_MemFree(DRV_PIC32MZW_ALLOC_OPT_ARGS void *pBufferAddr)
     _DRV_PIC32MZW_MemTrackerRemove(pBufferAddr);
 #endif
 
-    OSAL_Free(pAllocHdr->pUnalignedPtr);
+    _DRV_PIC32MZW_HeapFree(pAllocHdr->pUnalignedPtr);
 
     OSAL_MUTEX_Unlock(&pic32mzwMemMutex);
 
@@ -38,6 +38,10 @@
 // DOM-IGNORE-END
 #include "FreeRTOS.h"
 #include "task.h"
+#include "configuration.h"
+#ifdef APP_HEAPSTAT_ENABLE
+#include "app_heapstat.h"
+#endif
 
 void vApplicationIdleHook( void );
 void vApplicationTickHook( void );
@@ -114,11 +118,11 @@ void vApplicationMallocFailedHook( void )
       to query the size of free heap space that remains (although it does not
       provide information on how the remaining heap might be fragmented). */
 
-   taskDISABLE_INTERRUPTS();
-   for( ;; )
-   {
-       /* Do Nothing */
-   }
+   /* heap_3: the caller gets NULL, as without the hook, and handles it. The
+      hook is only there to count the failures for the "heap" command. */
+#ifdef APP_HEAPSTAT_ENABLE
+   APP_HEAPSTAT_RtosMallocFailed();
+#endif
 }
 /*-----------------------------------------------------------*/
 
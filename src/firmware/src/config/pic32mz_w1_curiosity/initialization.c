@@ -155,6 +155,20 @@ static DRV_MEMORY_CLIENT_OBJECT gDrvMemory0ClientObject[DRV_MEMORY_CLIENTS_NUMBE
 
 static DRV_MEMORY_BUFFER_OBJECT gDrvMemory0BufferObject[DRV_MEMORY_BUF_Q_SIZE_IDX0];
 
+#ifdef DRV_FTL_ENABLE
+/* The FTL sits between the Memory driver and the SST26 driver */
+static const DRV_MEMORY_DEVICE_INTERFACE drvMemory0DeviceAPI = {
+    .Open               = DRV_FTL_Open,
+    .Close              = DRV_FTL_Close,
+    .Status             = DRV_FTL_Status,
+    .SectorErase        = DRV_FTL_SectorErase,
+    .Read               = DRV_FTL_Read,
+    .PageWrite          = DRV_FTL_PageWrite,
+    .EventHandlerSet    = DRV_FTL_EventHandlerSet,
+    .GeometryGet        = DRV_FTL_GeometryGet,
+    .TransferStatusGet  = DRV_FTL_TransferStatusGet
+};
+#else
 static const DRV_MEMORY_DEVICE_INTERFACE drvMemory0DeviceAPI = {
     .Open               = DRV_SST26_Open,
     .Close              = DRV_SST26_Close,
@@ -166,6 +180,7 @@ static const DRV_MEMORY_DEVICE_INTERFACE drvMemory0DeviceAPI = {
     .GeometryGet        = (DRV_MEMORY_DEVICE_GEOMETRY_GET)DRV_SST26_GeometryGet,
     .TransferStatusGet  = (DRV_MEMORY_DEVICE_TRANSFER_STATUS_GET)DRV_SST26_TransferStatusGet
 };
+#endif
 static const DRV_MEMORY_INIT drvMemory0InitData =
 {
     .memDevIndex                = DRV_SST26_INDEX,
@@ -174,6 +189,7 @@ static const DRV_MEMORY_INIT drvMemory0InitData =
     .isFsEnabled                = true,
     .deviceMediaType            = (uint8_t)SYS_FS_MEDIA_TYPE_SPIFLASH,
     .ewBuffer                   = &gDrvMemory0EraseBuffer[0],
+    .cacheIdleTimeoutMs         = DRV_MEMORY_CACHE_IDLE_TIMEOUT_IDX0,
     .clientObjPool              = (uintptr_t)&gDrvMemory0ClientObject[0],
     .bufferObj                  = (uintptr_t)&gDrvMemory0BufferObject[0],
     .queueSize                  = DRV_MEMORY_BUF_Q_SIZE_IDX0,
@@ -113,6 +113,12 @@ static int        tcpInitCount = 0;                 // initialization counter
 static const void*  tcpHeapH = 0;                    // memory allocation handle
 static unsigned int TcpSockets;                      // number of sockets in the current TCP configuration
 
+// RX demux index: sockets are linked in buckets by their remoteHash
+// a connected socket by the hash of its remote address and ports, a listening one by its local port
+static TCB_STUB**   tcpConnBkts = 0;                // buckets of connected sockets
+static TCB_STUB**   tcpListenBkts = 0;              // buckets of listening sockets
+static uint16_t     tcpHashMask;                    // number of buckets - 1; power of 2
+
 static tcpipSignalHandle    tcpSignalHandle = 0;
 
 static uint16_t             tcpDefTxSize;               // default size of the TX buffer
@@ -144,6 +150,7 @@ static void _TcpSwapHeader(TCP_HEADER* header);
 static void _TcpCloseSocket(TCB_STUB* pSkt, TCPIP_TCP_SIGNAL_TYPE tcpEvent);
 static void _TcpSocketInitialize(TCB_STUB* pSkt, TCP_SOCKET hTCP, uint8_t* txBuff, uint16_t txBuffSize, uint8_t* rxBuff, uint16_t rxBuffSize);
 static void _TcpSocketSetIdleState(TCB_STUB* pSkt);
+static void _TcpSocketHashSet(TCB_STUB* pSkt);
 
 #if (TCPIP_STACK_DOWN_OPERATION != 0)
 static void _TcpCleanup(void);
@@ -368,6 +375,7 @@ static void _TcpSocketSetState(TCB_STUB* pSkt, TCPIP_TCP_STATE newState)
         } 
     }
     pSkt->smState = newState;
+    _TcpSocketHashSet(pSkt);
 }
 
 static uint32_t    _tcpTraceMask = 0;      // currently only first 32 sockets could be traced from the creation moment
@@ -400,6 +408,7 @@ bool TCPIP_TCP_SocketTraceSet(TCP_SOCKET sktNo, bool enable)
 static __inline__ void __attribute__((always_inline)) _TcpSocketSetState(TCB_STUB* pSkt, TCPIP_TCP_STATE newState)
 {
     pSkt->smState = newState;
+    _TcpSocketHashSet(pSkt);
 }
 bool TCPIP_TCP_SocketTraceSet(TCP_SOCKET sktNo, bool enable)
 {
@@ -461,6 +470,179 @@ static bool TCPIP_TCP_CheckRxPkt(TCP_HEADER* pHdr)
     TCPIP_HEAP_Free(tcpHeapH, pSkt);
 }
 
+static __inline__ uint16_t __attribute__((always_inline)) _TcpHashBkt(uint16_t remoteHash)
+{
+    return (remoteHash ^ (remoteHash >> 8)) & tcpHashMask;
+}
+
+// links the socket in the demux bucket matching its current state and remoteHash
+// has to be called whenever either of them changes
+// buckets are kept sorted by socket index,
+// so the lookup selects the same socket as a search through all TCBStubs would
+static void _TcpSocketHashSet(TCB_STUB* pSkt)
+{
+    TCB_STUB** pBkt = 0;
+    TCB_STUB** ppSkt;
+
+    if(tcpConnBkts != 0 && pSkt->smState != TCPIP_TCP_STATE_CLIENT_WAIT_CONNECT && pSkt->smState != TCPIP_TCP_STATE_KILLED)
+    {
+        pBkt = (pSkt->smState == TCPIP_TCP_STATE_LISTEN ? tcpListenBkts : tcpConnBkts) + _TcpHashBkt(pSkt->remoteHash);
+    }
+
+    if(pBkt == pSkt->pHashBkt)
+    {   // no change
+        return;
+    }
+
+    OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    if((ppSkt = pSkt->pHashBkt) != 0)
+    {   // unlink
+        while(*ppSkt != 0 && *ppSkt != pSkt)
+        {
+            ppSkt = &(*ppSkt)->pHashNext;
+        }
+        if(*ppSkt == pSkt)
+        {
+            *ppSkt = pSkt->pHashNext;
+        }
+    }
+
+    pSkt->pHashNext = 0;
+    pSkt->pHashBkt = pBkt;
+    if((ppSkt = pBkt) != 0)
+    {   // link
+        while(*ppSkt != 0 && (*ppSkt)->sktIx < pSkt->sktIx)
+        {
+            ppSkt = &(*ppSkt)->pHashNext;
+        }
+        pSkt->pHashNext = *ppSkt;
+        *ppSkt = pSkt;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+}
+
+#if (TCPIP_TCP_TX_CHKSUM_BLOCK != 0)
+// the TX buffer is followed by a table of uint16_t partial checksums,
+// one for each TCPIP_TCP_TX_CHKSUM_BLOCK bytes of the buffer
+// the user writes the TX buffer sequentially, so writing the first byte of a block restarts its checksum
+// and a block that is entirely part of a transmitted segment has its checksum ready 
+#define _TCP_TX_CHKSUM_BLOCKS(buffSize)     (((buffSize) + TCPIP_TCP_TX_CHKSUM_BLOCK - 1) / TCPIP_TCP_TX_CHKSUM_BLOCK)
+#define _TCP_TX_BUFF_ALLOC_SIZE(txBuffSize) ((((txBuffSize) + 2) & ~1) + _TCP_TX_CHKSUM_BLOCKS((txBuffSize) + 1) * sizeof(uint16_t))
+
+static __inline__ uint16_t* __attribute__((always_inline)) _TcpTxChkBlocks(TCB_STUB* pSkt)
+{
+    return (uint16_t*)(((uintptr_t)pSkt->txEnd + 1) & ~(uintptr_t)1);
+}
+
+// copies data to the TX buffer, no wrap around, and updates the block checksums
+// if src == 0, the data is already in the buffer and it's just checksummed
+static void _TcpTxPut(TCB_STUB* pSkt, uint8_t* dst, const uint8_t* src, uint16_t len)
+{
+    uint16_t* pBlk = _TcpTxChkBlocks(pSkt);
+    uint32_t  buffOffs = dst - pSkt->txStart;
+    uint16_t  blkOffs, chunk, chkSum;
+    uint32_t  blkSum;
+
+    while(len != 0)
+    {
+        blkOffs = buffOffs & (TCPIP_TCP_TX_CHKSUM_BLOCK - 1);
+        chunk = TCPIP_TCP_TX_CHKSUM_BLOCK - blkOffs;
+        if(chunk > len)
+        {
+            chunk = len;
+        }
+
+        if(src != 0)
+        {
+            chkSum = TCPIP_Helper_MemcpyChecksum(dst, src, chunk);
+            src += chunk;
+        }
+        else
+        {
+            chkSum = ~TCPIP_Helper_CalcIPChecksum(dst, chunk, 0);
+        }
+
+        if(blkOffs == 0)
+        {   // new block data
+            pBlk[buffOffs / TCPIP_TCP_TX_CHKSUM_BLOCK] = chkSum;
+        }
+        else
+        {   // append to the block
+            if((blkOffs & 0x1) != 0)
+            {
+                chkSum = TCPIP_Helper_htons(chkSum);
+            }
+            blkSum = (uint32_t)pBlk[buffOffs / TCPIP_TCP_TX_CHKSUM_BLOCK] + chkSum;
+            pBlk[buffOffs / TCPIP_TCP_TX_CHKSUM_BLOCK] = TCPIP_Helper_ChecksumFold(blkSum);
+        }
+
+        dst += chunk;
+        buffOffs += chunk;
+        len -= chunk;
+    }
+}
+
+// adds the checksum of len bytes of TX buffer data, no wrap around, to rawChksum
+// dataOffs is the position of the data within the segment payload
+// the complete blocks are taken from the block table, only the partial ones at the ends are read
+static uint32_t _TcpTxChecksum(TCB_STUB* pSkt, const uint8_t* pData, uint16_t len, uint32_t rawChksum, uint32_t dataOffs)
+{
+    const uint16_t* pBlk = _TcpTxChkBlocks(pSkt);
+    uint32_t  buffOffs = pData - pSkt->txStart;
+    uint32_t  buffSize = pSkt->txEnd - pSkt->txStart;
+    uint32_t  chunk;
+    uint16_t  chkSum;
+
+    while(len != 0)
+    {
+        chunk = TCPIP_TCP_TX_CHKSUM_BLOCK - (buffOffs & (TCPIP_TCP_TX_CHKSUM_BLOCK - 1));
+        if(chunk > buffSize - buffOffs)
+        {   // last block of the buffer can be shorter
+            chunk = buffSize - buffOffs;
+        }
+
+        if((buffOffs & (TCPIP_TCP_TX_CHKSUM_BLOCK - 1)) == 0 && chunk <= len)
+        {   // complete block
+            chkSum = pBlk[buffOffs / TCPIP_TCP_TX_CHKSUM_BLOCK];
+            if((dataOffs & 0x1) != 0)
+            {
+                chkSum = TCPIP_Helper_htons(chkSum);
+            }
+            rawChksum += chkSum;
+            if(rawChksum < chkSum)
+            {   // end-around carry
+                rawChksum++;
+            }
+        }
+        else
+        {
+            if(chunk > len)
+            {
+                chunk = len;
+            }
+            rawChksum = TCPIP_Helper_ChecksumAdd(rawChksum, pData, chunk, dataOffs);
+        }
+
+        pData += chunk;
+        buffOffs += chunk;
+        dataOffs += chunk;
+        len -= chunk;
+    }
+
+    return rawChksum;
+}
+#else
+#define _TCP_TX_BUFF_ALLOC_SIZE(txBuffSize) ((txBuffSize) + 1)
+
+static __inline__ void __attribute__((always_inline)) _TcpTxPut(TCB_STUB* pSkt, uint8_t* dst, const uint8_t* src, uint16_t len)
+{
+    if(src != 0)
+    {
+        TCPIP_Helper_Memcpy(dst, src, len);
+    }
+}
+#endif  // (TCPIP_TCP_TX_CHKSUM_BLOCK != 0)
+
 // returns:  0 if a SYN could be sent
 //           > 0 if the operation failed but can be retried
 //           < 0 if there is no valid destination or some other error
@@ -495,6 +677,7 @@ static int _TcpClientSocketConnect(TCB_STUB* pSkt)
         default:
             return -1;  // IP_ADDRESS_TYPE_ANY
     }
+    _TcpSocketHashSet(pSkt);
 
 
     // try to send SYN
@@ -631,6 +814,7 @@ static void _TCP_LoadRetxTmo(TCB_STUB* pSkt, bool reload)
 bool TCPIP_TCP_Initialize(const TCPIP_STACK_MODULE_CTRL* const stackInit, const TCPIP_TCP_MODULE_CONFIG* pTcpInit)
 {
     int     nSockets;
+    int     nBkts;
     bool    tcpSemaphoreEnabled;
     bool    initRes = false;
     bool    doInit = false;
@@ -697,12 +881,25 @@ bool TCPIP_TCP_Initialize(const TCPIP_STACK_MODULE_CTRL* const stackInit, const
     tcpDefRxSize = pTcpInit->sktRxBuffSize;
 
     TCBStubs = (TCB_STUB**)TCPIP_HEAP_Calloc(tcpHeapH, nSockets, sizeof(*TCBStubs));
-    if(TCBStubs == 0)
+    // one bucket per socket, rounded up to a power of 2, in each demux table
+    nBkts = 1;
+    while(nBkts < nSockets)
     {
+        nBkts <<= 1;
+    }
+    tcpConnBkts = (TCB_STUB**)TCPIP_HEAP_Calloc(tcpHeapH, 2 * nBkts, sizeof(*tcpConnBkts));
+    if(TCBStubs == 0 || tcpConnBkts == 0)
+    {
+        TCPIP_HEAP_Free(tcpHeapH, tcpConnBkts);
+        TCPIP_HEAP_Free(tcpHeapH, TCBStubs);
+        tcpConnBkts = 0;
+        TCBStubs = 0;
         SYS_ERROR(SYS_ERROR_ERROR, " TCP Dynamic allocation failed");
         tcpLockCount = 0; // leave it uninitialized
         return false;
     }
+    tcpListenBkts = tcpConnBkts + nBkts;
+    tcpHashMask = (uint16_t)(nBkts - 1);
 
 
     TcpSockets = nSockets;
@@ -837,6 +1034,9 @@ static void _TcpCleanup(void)
 
     TCPIP_HEAP_Free(tcpHeapH, TCBStubs);
     TCBStubs = 0;
+    TCPIP_HEAP_Free(tcpHeapH, tcpConnBkts);
+    tcpConnBkts = 0;
+    tcpListenBkts = 0;
 
     TcpSockets = 0;
 
@@ -1149,7 +1349,7 @@ static TCP_SOCKET _TCP_Open(IP_ADDRESS_TYPE addType, TCP_OPEN_TYPE opType, TCP_P
     }
 
     pSkt = (TCB_STUB*)TCPIP_HEAP_Calloc(tcpHeapH, 1, sizeof(*pSkt));
-    txBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, tcpDefTxSize + 1);
+    txBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, _TCP_TX_BUFF_ALLOC_SIZE(tcpDefTxSize));
     rxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, tcpDefRxSize + 1);
 
     if(pSkt == 0 || txBuff == 0 || rxBuff == 0)
@@ -1206,8 +1406,8 @@ static TCP_SOCKET _TCP_Open(IP_ADDRESS_TYPE addType, TCP_OPEN_TYPE opType, TCP_P
     {
         pSkt->localPort = localPort;
         pSkt->Flags.bServer = true;
-        _TcpSocketSetState(pSkt, TCPIP_TCP_STATE_LISTEN);
         pSkt->remoteHash = localPort;
+        _TcpSocketSetState(pSkt, TCPIP_TCP_STATE_LISTEN);
     }
     // Handle all the client mode socket types
     else
@@ -1622,7 +1822,20 @@ static bool _TCPv4Flush(TCB_STUB * pSkt, IPV4_PACKET* pv4Pkt, uint16_t hdrLen, u
         if(loadLen)
         {   // add the data segments
             pv4Pkt->macPkt.pDSeg->segFlags |= TCPIP_MAC_SEG_FLAG_USER_PAYLOAD;
+#if (TCPIP_TCP_TX_CHKSUM_BLOCK != 0)
+            // the payload is always in the socket TX buffer
+            TCPIP_MAC_DATA_SEGMENT* pSeg;
+            uint32_t rawChksum = checksum;
+            uint32_t dataOffs = 0;
+            for(pSeg = ((TCP_V4_PACKET*)pv4Pkt)->tcpSeg; pSeg != 0; pSeg = pSeg->next)
+            {
+                rawChksum = _TcpTxChecksum(pSkt, pSeg->segLoad, pSeg->segLen, rawChksum, dataOffs);
+                dataOffs += pSeg->segLen;
+            }
+            checksum = TCPIP_Helper_ChecksumFold(rawChksum);
+#else
             checksum = ~TCPIP_Helper_PacketChecksum(&pv4Pkt->macPkt, ((TCP_V4_PACKET*)pv4Pkt)->tcpSeg[0].segLoad, loadLen, checksum);
+#endif  // (TCPIP_TCP_TX_CHKSUM_BLOCK != 0)
         }
         else
         {   // packet not carying user payload
@@ -2670,13 +2883,13 @@ uint16_t TCPIP_TCP_ArrayPut(TCP_SOCKET hTCP, const uint8_t* data, uint16_t len)
     if(pSkt->txHead + wActualLen >= pSkt->txEnd)
     {
         wRightLen = pSkt->txEnd-pSkt->txHead;
-        TCPIP_Helper_Memcpy((uint8_t*)pSkt->txHead, data, (uint32_t)wRightLen);
+        _TcpTxPut(pSkt, pSkt->txHead, data, wRightLen);
         data += wRightLen;
         wActualLen -= wRightLen;
         pSkt->txHead = pSkt->txStart;
     }
 
-    TCPIP_Helper_Memcpy((uint8_t*)pSkt->txHead, data, (uint32_t)wActualLen);
+    _TcpTxPut(pSkt, pSkt->txHead, data, wActualLen);
     pSkt->txHead += wActualLen;
 
     bool    toFlush = false;
@@ -4299,8 +4512,8 @@ static _TCP_SEND_RES _TcpSend(TCB_STUB* pSkt, uint8_t vTCPFlags, uint8_t vSendFl
     Finds a suitable socket for a TCP segment.
 
   Description:
-    This function searches through the sockets and attempts to match one with
-    a given TCP header.
+    This function searches the demux buckets for the packet hash and
+    destination port and attempts to match a socket with a given TCP header.
     If a socket is found, a valid socket pointer it is returned. 
     Otherwise, a 0 pointer is returned.
     
@@ -4319,7 +4532,6 @@ static _TCP_SEND_RES _TcpSend(TCB_STUB* pSkt, uint8_t vTCPFlags, uint8_t vSendFl
   ***************************************************************************/
 static TCB_STUB* _TcpFindMatchingSocket(TCPIP_MAC_PACKET* pRxPkt, const void * remoteIP, const void * localIP, IP_ADDRESS_TYPE addressType)
 {
-    TCP_SOCKET hTCP;
     uint16_t hash;
     TCB_STUB* pSkt, *partialSkt;
     TCPIP_NET_IF* pPktIf;
@@ -4353,73 +4565,65 @@ static TCB_STUB* _TcpFindMatchingSocket(TCPIP_MAC_PACKET* pRxPkt, const void * r
             return 0;  // shouldn't happen
     }
 
-    // Loop through all sockets looking for a socket that is expecting this 
-    // packet or can handle it.
-    for(hTCP = 0; hTCP < TcpSockets; hTCP++)
+    // Look for a connected socket expecting this packet,
+    // then for a listening socket that can handle it.
+    // Only the buckets of this hash/port are searched, not all TCBStubs.
+    OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    for(pSkt = tcpConnBkts[_TcpHashBkt(hash)]; pSkt != 0; pSkt = pSkt->pHashNext)
     {
-        pSkt = TCBStubs[hTCP];
-
-        if(pSkt == 0 || pSkt->smState == TCPIP_TCP_STATE_CLIENT_WAIT_CONNECT)
-        {
+        if(pSkt->remoteHash != hash || h->DestPort != pSkt->localPort || h->SourcePort != pSkt->remotePort)
+        {   // Ignore if the hash or the ports don't match
             continue;
         }
 
-        if( (pSkt->addType == IP_ADDRESS_TYPE_ANY || pSkt->addType == addressType) &&
-                (pSkt->pSktNet == 0 || pSkt->pSktNet == pPktIf) )
-        {   // both network interface and address type match
-
-            bool found = false;
+        if( (pSkt->addType != IP_ADDRESS_TYPE_ANY && pSkt->addType != addressType) ||
+                (pSkt->pSktNet != 0 && pSkt->pSktNet != pPktIf) )
+        {   // network interface or address type mismatch
+            continue;
+        }
 
-            if(pSkt->smState == TCPIP_TCP_STATE_LISTEN)
+#if defined (TCPIP_STACK_USE_IPV6)
+        if (addressType == IP_ADDRESS_TYPE_IPV6)
+        {
+            if (!memcmp (TCPIP_IPV6_DestAddressGet(pSkt->pV6Pkt), remoteIP, sizeof (IPV6_ADDR)))
             {
-                // For listening ports, check if this is the correct port
-                if(pSkt->remoteHash == h->DestPort && partialSkt == 0)
-                {
-                    partialSkt = pSkt;
-                }
-                continue;
-            }
-            else if(pSkt->remoteHash != hash)
-            {// Ignore if the hash doesn't match
-                continue;
+                break;
             }
-
-            while(  h->DestPort == pSkt->localPort && h->SourcePort == pSkt->remotePort )  
-            {
-
-#if defined (TCPIP_STACK_USE_IPV6)
-                if (addressType == IP_ADDRESS_TYPE_IPV6)
-                {
-                    if (!memcmp (TCPIP_IPV6_DestAddressGet(pSkt->pV6Pkt), remoteIP, sizeof (IPV6_ADDR)))
-                    {
-                        found = true;
-                    }
-                    break;
-                }
+        }
 #endif  // defined (TCPIP_STACK_USE_IPV6)
 
 #if defined (TCPIP_STACK_USE_IPV4)
-                if (addressType == IP_ADDRESS_TYPE_IPV4)
-                {
-                    if (pSkt->destAddress.Val == ((IPV4_ADDR *)remoteIP)->Val)
-                    {
-                        found = true;
-                    }
-                    break;
-                }
-#endif  // defined (TCPIP_STACK_USE_IPV4)
-
+        if (addressType == IP_ADDRESS_TYPE_IPV4)
+        {
+            if (pSkt->destAddress.Val == ((IPV4_ADDR *)remoteIP)->Val)
+            {
                 break;
             }
+        }
+#endif  // defined (TCPIP_STACK_USE_IPV4)
+    }
 
-            if(found)
-            { 
-                pSkt->addType = addressType;
-                _TcpSocketBind(pSkt, pPktIf, (IP_MULTI_ADDRESS*)localIP);
-                return pSkt;    // bind to the correct interface
+    if(pSkt == 0)
+    {
+        // For listening ports, check if this is the correct port
+        for(partialSkt = tcpListenBkts[_TcpHashBkt(h->DestPort)]; partialSkt != 0; partialSkt = partialSkt->pHashNext)
+        {
+            if(partialSkt->remoteHash == h->DestPort &&
+                    (partialSkt->addType == IP_ADDRESS_TYPE_ANY || partialSkt->addType == addressType) &&
+                    (partialSkt->pSktNet == 0 || partialSkt->pSktNet == pPktIf))
+            {
+                break;
             }
         }
     }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+    if(pSkt != 0)
+    { 
+        pSkt->addType = addressType;
+        _TcpSocketBind(pSkt, pPktIf, (IP_MULTI_ADDRESS*)localIP);
+        return pSkt;    // bind to the correct interface
+    }
 
 
     // If there is a partial match, then a listening socket is currently 
@@ -4468,6 +4672,7 @@ static TCB_STUB* _TcpFindMatchingSocket(TCPIP_MAC_PACKET* pRxPkt, const void * r
         pSkt->remoteHash = hash;
         pSkt->remotePort = h->SourcePort;
         pSkt->localPort = h->DestPort;
+        _TcpSocketHashSet(pSkt);
         pSkt->txUnackedTail = pSkt->txStart;
 
         // All done, and we have a match
@@ -4537,6 +4742,7 @@ static void _TcpSocketSetIdleState(TCB_STUB* pSkt)
 {
 
     pSkt->remoteHash = pSkt->localPort;
+    _TcpSocketHashSet(pSkt);
     pSkt->txHead = pSkt->txStart;
     pSkt->txTail = pSkt->txStart;
     pSkt->txUnackedTail = pSkt->txStart;
@@ -5789,7 +5995,7 @@ bool TCPIP_TCP_FifoSizeAdjust(TCP_SOCKET hTCP, uint16_t wMinRXSize, uint16_t wMi
 
     if(diffChange >= TCP_MIN_BUFF_CHANGE)
     {
-        newTxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, wMinTXSize + 1);
+        newTxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, _TCP_TX_BUFF_ALLOC_SIZE(wMinTXSize));
         if(newTxBuff == 0)
         {    // fail, out of memory
             return false;
@@ -5957,6 +6163,7 @@ bool TCPIP_TCP_FifoSizeAdjust(TCP_SOCKET hTCP, uint16_t wMinRXSize, uint16_t wMi
         pSkt->txTail = pSkt->txStart;
         pSkt->txHead = pSkt->txStart + (pendTxEnd + pendTxBeg);
         pSkt->txUnackedTail = pSkt->txTail + txUnackOffs;
+        _TcpTxPut(pSkt, pSkt->txStart, 0, pendTxEnd + pendTxBeg);    // new block checksums for the pending data
         _TCPSetHalfFlushFlag(pSkt);
     }
 
@@ -6240,6 +6447,7 @@ bool TCPIP_TCP_Bind(TCP_SOCKET hTCP, IP_ADDRESS_TYPE addType, TCP_PORT localPort
     {   // client socket
         pSkt->remoteHash = _TCP_ClientIPV4RemoteHash(&pSkt->destAddress, pSkt);
     }
+    _TcpSocketHashSet(pSkt);
 
     return true;
 }
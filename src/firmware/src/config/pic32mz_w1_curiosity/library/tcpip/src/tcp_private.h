@@ -88,6 +88,14 @@ Microchip or any third party.
 // the minimum MTU value that needs to be supported
 #define TCP_MIN_DEFAULT_MTU     (536)
 
+// size of the TX buffer checksum blocks, power of 2
+// the payload checksum is calculated as the data is copied into the TX buffer,
+// one partial checksum per block, and is reused when the data is transmitted
+// 0 disables it: the payload is checksummed at transmission time
+#if !defined(TCPIP_TCP_TX_CHKSUM_BLOCK)
+#define TCPIP_TCP_TX_CHKSUM_BLOCK   (64)
+#endif
+
 // the min value of the data offset field, in 32 bit words
 #define TCP_DATA_OFFSET_VAL_MIN    5       // 20 bytes
 
@@ -120,7 +128,7 @@ typedef struct
   ***************************************************************************/
 
 // TCP Control Block (TCB) stub data storage. 
-typedef struct
+typedef struct _tag_TCB_STUB
 {
     uint8_t*            txStart;                    // First byte of skt TX buffer
     uint8_t*            txEnd;                      // Last byte of skt TX buffer
@@ -136,6 +144,7 @@ typedef struct
                                                     //      - can send data = txHead - txUnackedTail
                                                     //      - init: txBuff = alloc txBuffSize + 1)
                                                     //              txStart = txBuff; txEnd = txBuff + txBuffSize + 1;
+                                                    //      - the checksum blocks, if any, are allocated after txEnd
                                                     //
     uint8_t*            rxStart;                    // First byte of the socket RX buffer.
     uint8_t*            rxEnd;                      // Last byte of the socket RX buffer
@@ -239,6 +248,8 @@ typedef struct
             uint8_t reserved        : 3;            // padding; not used
         };
     }dbgFlags;
+    struct _tag_TCB_STUB*   pHashNext;              // next socket in the same demux bucket
+    struct _tag_TCB_STUB**  pHashBkt;               // demux bucket the socket is linked in; 0 if none
 
     uint8_t pad[];                  // padding; not used
 } TCB_STUB;
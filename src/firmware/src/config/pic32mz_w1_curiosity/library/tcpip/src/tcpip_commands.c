@@ -3244,6 +3244,17 @@ static void _Command_HeapInfo(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv
 
     }
 
+    // display the packet pools
+    int poolIx;
+    TCPIP_PKT_POOL_STAT poolStat;
+    for(poolIx = 0; poolIx < TCPIP_PKT_PoolGetEntriesNo(); poolIx++)
+    {
+        if(TCPIP_PKT_PoolGetEntry(poolIx, &poolStat))
+        {
+            (*pCmdIO->pCmdApi->print)(cmdIoParam, "Packet pool: %d Bytes, blocks: %d, used: %d, high watermark: %d, misses: %d\r\n", poolStat.blockSize, poolStat.nBlocks, poolStat.nUsed, poolStat.highWater, poolStat.nMisses);
+        }
+    }
+
 }
 
 static void _Command_MacInfo(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv)
@@ -1039,7 +1039,6 @@ uint16_t TCPIP_Helper_PacketChecksum(TCPIP_MAC_PACKET* pPkt, uint8_t* startAdd,
     TCPIP_MAC_DATA_SEGMENT  *pSeg;
     uint8_t* pChkBuff;
     uint16_t checkLength, chkBytes, nBytes;
-    uint16_t segChkSum;
     uint32_t calcChkSum;
 
     if(len == 0)
@@ -1069,15 +1068,9 @@ uint16_t TCPIP_Helper_PacketChecksum(TCPIP_MAC_PACKET* pPkt, uint8_t* startAdd,
 
         if(chkBytes)
         {
-            segChkSum = ~TCPIP_Helper_CalcIPChecksum(pChkBuff, chkBytes, 0);
-            if((nBytes & 0x1) != 0)
-            {
-                segChkSum = TCPIP_Helper_htons(segChkSum);
-            }
-
+            calcChkSum = TCPIP_Helper_ChecksumAdd(calcChkSum, pChkBuff, chkBytes, nBytes);
             checkLength -= chkBytes;
             nBytes += chkBytes;
-            calcChkSum += segChkSum;
         }
         if((pSeg = pSeg->next) != 0)
         {
@@ -1095,6 +1088,116 @@ uint16_t TCPIP_Helper_PacketChecksum(TCPIP_MAC_PACKET* pPkt, uint8_t* startAdd,
     return ~TCPIP_Helper_ChecksumFold(calcChkSum);
 }
 
+// adds the sum of a buffer to a running, not folded, checksum
+// offset is the position of the buffer within the checksummed data:
+// a buffer starting at an odd offset has its bytes swapped in the sum
+uint32_t TCPIP_Helper_ChecksumAdd(uint32_t rawChksum, const uint8_t* buffer, uint16_t len, uint32_t offset)
+{
+    uint16_t chkSum = ~TCPIP_Helper_CalcIPChecksum(buffer, len, 0);
+
+    if((offset & 0x1) != 0)
+    {
+        chkSum = TCPIP_Helper_htons(chkSum);
+    }
+
+    rawChksum += chkSum;
+    if(rawChksum < chkSum)
+    {   // end-around carry
+        rawChksum++;
+    }
+
+    return rawChksum;
+}
+
+// copies len bytes and returns their not complemented checksum,
+// the same as ~TCPIP_Helper_CalcIPChecksum(dst, len, 0)
+// the stores follow the dst alignment, src can have any alignment
+uint16_t TCPIP_Helper_MemcpyChecksum(uint8_t* dst, const uint8_t* src, uint16_t len)
+{
+    uint64_t sum = 0;
+    uint32_t w0, w1, w2, w3;
+    uint16_t hw;
+    uint16_t res;
+    bool swap;
+
+    // odd start: sum as if the buffer started one byte earlier, swap the result
+    swap = ((uintptr_t)dst & 0x1) != 0;
+    if(swap && len != 0)
+    {
+        *dst = *src++;
+        sum += (uint32_t)*dst++ << 8;
+        len--;
+    }
+
+    if(((uintptr_t)dst & 0x2) != 0 && len >= 2)
+    {
+        memcpy(&hw, src, sizeof(hw));
+        *(uint16_t*)dst = hw;
+        sum += hw;
+        dst += 2;
+        src += 2;
+        len -= 2;
+    }
+
+    // aligned 32-bit stores, 4 per pass
+    while(len >= 16)
+    {
+        uint32_t* pW = (uint32_t*)dst;
+        memcpy(&w0, src, sizeof(w0));
+        memcpy(&w1, src + 4, sizeof(w1));
+        memcpy(&w2, src + 8, sizeof(w2));
+        memcpy(&w3, src + 12, sizeof(w3));
+        pW[0] = w0;
+        pW[1] = w1;
+        pW[2] = w2;
+        pW[3] = w3;
+        sum += (uint64_t)w0 + w1 + w2 + w3;
+        dst += 16;
+        src += 16;
+        len -= 16;
+    }
+
+    while(len >= 4)
+    {
+        memcpy(&w0, src, sizeof(w0));
+        *(uint32_t*)dst = w0;
+        sum += w0;
+        dst += 4;
+        src += 4;
+        len -= 4;
+    }
+
+    if(len >= 2)
+    {
+        memcpy(&hw, src, sizeof(hw));
+        *(uint16_t*)dst = hw;
+        sum += hw;
+        dst += 2;
+        src += 2;
+        len -= 2;
+    }
+
+    if(len != 0)
+    {
+        *dst = *src;
+        sum += *dst;
+    }
+
+    // end-around carries, down to 16 bits
+    sum = (sum & 0xffffffffU) + (sum >> 32);
+    sum = (sum & 0xffffffffU) + (sum >> 32);
+    sum = (sum & 0xffffU) + (sum >> 16);
+    sum = (sum & 0xffffU) + (sum >> 16);
+    res = (uint16_t)sum;
+
+    if(swap)
+    {
+        res = (uint16_t)((res << 8) | (res >> 8));
+    }
+
+    return res;
+}
+
 uint16_t TCPIP_Helper_ChecksumFold(uint32_t rawChksum)
 {
     TCPIP_UINT32_VAL checksum;
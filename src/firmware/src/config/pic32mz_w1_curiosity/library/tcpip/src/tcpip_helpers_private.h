@@ -65,6 +65,14 @@ uint16_t        TCPIP_Helper_PacketChecksum(TCPIP_MAC_PACKET* pPkt, uint8_t* sta
 
 uint16_t        TCPIP_Helper_ChecksumFold(uint32_t checksum);
 
+// adds a buffer to a partial checksum, to be folded with TCPIP_Helper_ChecksumFold
+// offset: position of the buffer within the checksummed data
+uint32_t        TCPIP_Helper_ChecksumAdd(uint32_t rawChksum, const uint8_t* buffer, uint16_t len, uint32_t offset);
+
+// copies a buffer and sums it in the same pass
+// returns ~TCPIP_Helper_CalcIPChecksum(dst, len, 0)
+uint16_t        TCPIP_Helper_MemcpyChecksum(uint8_t* dst, const uint8_t* src, uint16_t len);
+
 uint16_t        TCPIP_Helper_PacketCopy(TCPIP_MAC_PACKET* pSrcPkt, uint8_t* pDest, uint8_t** pStartAdd, uint16_t len, bool srchTransport);
 
 
@@ -769,7 +769,7 @@ static bool _TCPIP_DoInitialize(const TCPIP_STACK_INIT * init)
             break;
         }
 
-        if(TCPIP_PKT_Initialize(heapH, pUsrConfig, nNets) == false)
+        if(TCPIP_PKT_Initialize(heapH, heapData->heapUsage, pUsrConfig, nNets) == false)
         {
             SYS_ERROR_PRINT(SYS_ERROR_ERROR, TCPIP_STACK_HDR_MESSAGE "Packet initialization failed: 0x%x\r\n", (uint32_t)heapH);
             initFail = 3;
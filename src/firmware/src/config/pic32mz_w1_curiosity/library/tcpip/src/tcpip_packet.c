@@ -75,6 +75,201 @@ Microchip or any third party.
 
 static TCPIP_STACK_HEAP_HANDLE    pktMemH = 0;
 
+// packet pools
+// selected by the TCPIP_STACK_HEAP_USE_PACKET heap usage flag
+// a pool with 0 blocks is not created
+#if !defined(TCPIP_PKT_POOL_BLOCKS_SMALL)
+#define TCPIP_PKT_POOL_BLOCKS_SMALL     0
+#endif
+#if !defined(TCPIP_PKT_POOL_SIZE_SMALL)
+#define TCPIP_PKT_POOL_SIZE_SMALL       384
+#endif
+#if !defined(TCPIP_PKT_POOL_BLOCKS_MEDIUM)
+#define TCPIP_PKT_POOL_BLOCKS_MEDIUM    0
+#endif
+#if !defined(TCPIP_PKT_POOL_SIZE_MEDIUM)
+#define TCPIP_PKT_POOL_SIZE_MEDIUM      896
+#endif
+#if !defined(TCPIP_PKT_POOL_BLOCKS_LARGE)
+#define TCPIP_PKT_POOL_BLOCKS_LARGE     0
+#endif
+#if !defined(TCPIP_PKT_POOL_SIZE_LARGE)
+#define TCPIP_PKT_POOL_SIZE_LARGE       1728
+#endif
+
+#define _TCPIP_PKT_POOLS    ((TCPIP_PKT_POOL_BLOCKS_SMALL + TCPIP_PKT_POOL_BLOCKS_MEDIUM + TCPIP_PKT_POOL_BLOCKS_LARGE) != 0)
+
+#if (_TCPIP_PKT_POOLS)
+// a pool of fixed size blocks, kept in a LIFO free list
+// the list is lock free, so blocks can be taken and returned from any context, ISR included:
+// the freeHead low 16 bits are the index of the 1st free block + 1 (0 if the pool is empty)
+// and the high 16 bits a modification count, so that the compare and swap of a pop that was
+// interrupted while the same block was taken and returned fails instead of corrupting the list
+// a free block stores the index + 1 of the next free block in its 1st word 
+typedef struct
+{
+    uint8_t*            base;       // pool blocks; 0 if the pool is not created
+    uint8_t*            end;        // end of the pool blocks
+    uint16_t            blockSize;  // multiple of TCPIP_SEGMENT_CACHE_ALIGN_SIZE
+    uint16_t            nBlocks;
+    volatile uint32_t   freeHead;   // free list head
+    volatile uint32_t   nUsed;      // blocks currently allocated
+    volatile uint32_t   highWater;  // max blocks allocated at the same time
+    volatile uint32_t   nMisses;    // allocations that found the pool empty
+}TCPIP_PKT_POOL;
+
+// ascending block sizes: an allocation uses the 1st pool it fits in
+static const struct
+{
+    uint16_t    blockSize;
+    uint16_t    nBlocks;
+}pktPoolConfig[] = 
+{
+    {TCPIP_PKT_POOL_SIZE_SMALL,     TCPIP_PKT_POOL_BLOCKS_SMALL},
+    {TCPIP_PKT_POOL_SIZE_MEDIUM,    TCPIP_PKT_POOL_BLOCKS_MEDIUM},
+    {TCPIP_PKT_POOL_SIZE_LARGE,     TCPIP_PKT_POOL_BLOCKS_LARGE},
+};
+
+static TCPIP_PKT_POOL   pktPools[sizeof(pktPoolConfig) / sizeof(*pktPoolConfig)];
+static int              pktPoolsNo;     // number of created pools; 0 if not in use
+
+static void _TCPIP_PKT_PoolsDelete(void)
+{
+    int ix;
+    TCPIP_PKT_POOL* pPool = pktPools;
+
+    for(ix = 0; ix < pktPoolsNo; ix++, pPool++)
+    {
+        if(pPool->base != 0)
+        {
+            TCPIP_HEAP_Free(pktMemH, pPool->base);
+        }
+    }
+    memset(pktPools, 0, sizeof(pktPools));
+    pktPoolsNo = 0;
+}
+
+// the pool memory is allocated from the packet heap
+// so the blocks have the same alignment and caching attributes as the heap allocated packets
+static bool _TCPIP_PKT_PoolsCreate(void)
+{
+    int ix, blkIx;
+    uint16_t blockSize;
+    TCPIP_PKT_POOL* pPool = pktPools;
+
+    memset(pktPools, 0, sizeof(pktPools));
+    pktPoolsNo = sizeof(pktPools) / sizeof(*pktPools);
+
+    for(ix = 0; ix < pktPoolsNo; ix++, pPool++)
+    {
+        if(pktPoolConfig[ix].nBlocks == 0)
+        {
+            continue;
+        }
+
+        blockSize = ((pktPoolConfig[ix].blockSize + TCPIP_SEGMENT_CACHE_ALIGN_SIZE - 1) / TCPIP_SEGMENT_CACHE_ALIGN_SIZE) * TCPIP_SEGMENT_CACHE_ALIGN_SIZE;
+        pPool->base = (uint8_t*)TCPIP_HEAP_Malloc(pktMemH, (size_t)blockSize * pktPoolConfig[ix].nBlocks);
+        if(pPool->base == 0)
+        {
+            _TCPIP_PKT_PoolsDelete();
+            return false;
+        }
+        pPool->blockSize = blockSize;
+        pPool->nBlocks = pktPoolConfig[ix].nBlocks;
+        pPool->end = pPool->base + (size_t)blockSize * pPool->nBlocks;
+
+        // chain all blocks
+        for(blkIx = 0; blkIx < pPool->nBlocks; blkIx++)
+        {
+            *(uint32_t*)(pPool->base + (size_t)blkIx * blockSize) = blkIx + 1 < pPool->nBlocks ? blkIx + 2 : 0;
+        }
+        pPool->freeHead = 1;
+    }
+
+    return true;
+}
+
+// returns a block of at least allocLen bytes
+// 0 if no pool or the pool that fits is empty; the heap should be used
+static void* _TCPIP_PKT_PoolAlloc(uint16_t allocLen)
+{
+    int ix;
+    uint32_t head, newHead, blkIx, nUsed, highWater;
+    uint8_t* pBlk;
+    TCPIP_PKT_POOL* pPool = pktPools;
+
+    for(ix = 0; ix < pktPoolsNo; ix++, pPool++)
+    {
+        if(pPool->base != 0 && allocLen <= pPool->blockSize)
+        {
+            break;
+        }
+    }
+
+    if(ix == pktPoolsNo)
+    {   // too large for any pool
+        return 0;
+    }
+
+    head = __atomic_load_n(&pPool->freeHead, __ATOMIC_ACQUIRE);
+    do
+    {
+        if((blkIx = head & 0xffff) == 0)
+        {   // empty
+            __atomic_add_fetch(&pPool->nMisses, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        pBlk = pPool->base + (blkIx - 1) * pPool->blockSize;
+        // if the block was taken meanwhile the next index is garbage but the swap fails
+        newHead = ((head + 0x10000) & 0xffff0000) | (*(volatile uint32_t*)pBlk & 0xffff);
+    }while(!__atomic_compare_exchange_n(&pPool->freeHead, &head, newHead, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    nUsed = __atomic_add_fetch(&pPool->nUsed, 1, __ATOMIC_RELAXED);
+    highWater = __atomic_load_n(&pPool->highWater, __ATOMIC_RELAXED);
+    while(nUsed > highWater && !__atomic_compare_exchange_n(&pPool->highWater, &highWater, nUsed, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return pBlk;
+}
+
+// returns true if ptr is a pool block and was released
+// false if it's a heap allocation
+static bool _TCPIP_PKT_PoolFree(void* ptr)
+{
+    int ix;
+    uint32_t head, newHead, blkIx;
+    TCPIP_PKT_POOL* pPool = pktPools;
+
+    for(ix = 0; ix < pktPoolsNo; ix++, pPool++)
+    {
+        if(pPool->base <= (uint8_t*)ptr && (uint8_t*)ptr < pPool->end)
+        {
+            break;
+        }
+    }
+
+    if(ix == pktPoolsNo)
+    {
+        return false;
+    }
+
+    // count it before the block can be taken again, so nUsed never exceeds nBlocks
+    __atomic_sub_fetch(&pPool->nUsed, 1, __ATOMIC_RELAXED);
+
+    blkIx = ((uint8_t*)ptr - pPool->base) / pPool->blockSize + 1;
+    head = __atomic_load_n(&pPool->freeHead, __ATOMIC_RELAXED);
+    do
+    {
+        *(volatile uint32_t*)ptr = head & 0xffff;
+        newHead = ((head + 0x10000) & 0xffff0000) | blkIx;
+    }while(!__atomic_compare_exchange_n(&pPool->freeHead, &head, newHead, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    return true;
+}
+#else
+#define _TCPIP_PKT_PoolAlloc(allocLen)  0
+#define _TCPIP_PKT_PoolFree(ptr)        false
+#endif  // (_TCPIP_PKT_POOLS)
+
 #if defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
 static TCPIP_PKT_TRACE_ENTRY    _pktTraceTbl[TCPIP_PKT_TRACE_SIZE];
 
@@ -120,7 +315,7 @@ static void                 _TCPIP_PKT_LogInit(bool resetAll);
 
 // API
 
-bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CONFIG* pNetConf, int nNets)
+bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, TCPIP_STACK_HEAP_USAGE heapUsage, const TCPIP_NETWORK_CONFIG* pNetConf, int nNets)
 {
     pktMemH = 0;
 
@@ -139,6 +334,17 @@ bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CON
         // success
         pktMemH = heapH;
 
+#if (_TCPIP_PKT_POOLS)
+        if((heapUsage & TCPIP_STACK_HEAP_USE_PACKET) != 0)
+        {
+            if(!_TCPIP_PKT_PoolsCreate())
+            {
+                pktMemH = 0;
+                break;
+            }
+        }
+#endif  // (_TCPIP_PKT_POOLS)
+
 #if defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
         memset(_pktTraceTbl, 0, sizeof(_pktTraceTbl));
         memset(&_pktTraceInfo, 0, sizeof(_pktTraceInfo));
@@ -169,9 +375,42 @@ bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CON
 
 void TCPIP_PKT_Deinitialize(void)
 {
+#if (_TCPIP_PKT_POOLS)
+    _TCPIP_PKT_PoolsDelete();
+#endif  // (_TCPIP_PKT_POOLS)
     pktMemH = 0;
 }
 
+int TCPIP_PKT_PoolGetEntriesNo(void)
+{
+#if (_TCPIP_PKT_POOLS)
+    return pktPoolsNo;
+#else
+    return 0;
+#endif  // (_TCPIP_PKT_POOLS)
+}
+
+bool TCPIP_PKT_PoolGetEntry(int poolIx, TCPIP_PKT_POOL_STAT* pStat)
+{
+#if (_TCPIP_PKT_POOLS)
+    if(0 <= poolIx && poolIx < pktPoolsNo && pktPools[poolIx].base != 0)
+    {
+        TCPIP_PKT_POOL* pPool = pktPools + poolIx;
+        if(pStat)
+        {
+            pStat->blockSize = pPool->blockSize;
+            pStat->nBlocks = pPool->nBlocks;
+            pStat->nUsed = (uint16_t)pPool->nUsed;
+            pStat->highWater = (uint16_t)pPool->highWater;
+            pStat->nMisses = pPool->nMisses;
+        }
+        return true;
+    }
+#endif  // (_TCPIP_PKT_POOLS)
+
+    return false;
+}
+
 
 // acknowledges a packet
 void _TCPIP_PKT_PacketAcknowledge(TCPIP_MAC_PACKET* pPkt, TCPIP_MAC_PKT_ACK_RES ackRes, TCPIP_STACK_MODULE moduleId)
@@ -330,11 +569,15 @@ static __inline__ TCPIP_MAC_PACKET* __attribute__((always_inline)) _TCPIP_PKT_Pa
     // total allocation size
     allocLen = pktUpLen + sizeof(*pSeg) + segAllocSize;
 
+    pPkt = (TCPIP_MAC_PACKET*)_TCPIP_PKT_PoolAlloc(allocLen);
+    if(pPkt == 0)
+    {
 #if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
+        pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
 #else
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+        pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
 #endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+    }
 
     if(pPkt)
     {   
@@ -377,7 +620,7 @@ static __inline__ void __attribute__((always_inline)) _TCPIP_PKT_PacketFreeInt(T
         for(pSeg = pPkt->pDSeg; pSeg != 0; pSeg = pNSeg)
         {
             pNSeg = pSeg->next;
-            if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
+            if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0 && !_TCPIP_PKT_PoolFree(pSeg))
             {
 #if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
                 TCPIP_HEAP_FreeDebug(pktMemH, pSeg, moduleId);
@@ -387,11 +630,14 @@ static __inline__ void __attribute__((always_inline)) _TCPIP_PKT_PacketFreeInt(T
             }
         }
 
+        if(!_TCPIP_PKT_PoolFree(pPkt))
+        {
 #if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-        TCPIP_HEAP_FreeDebug(pktMemH, pPkt, moduleId);
+            TCPIP_HEAP_FreeDebug(pktMemH, pPkt, moduleId);
 #else
-        TCPIP_HEAP_Free(pktMemH, pPkt);
+            TCPIP_HEAP_Free(pktMemH, pPkt);
 #endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+        }
     }
 }
 
@@ -441,11 +687,15 @@ static __inline__ TCPIP_MAC_DATA_SEGMENT* __attribute__((always_inline)) _TCPIP_
     allocLen = sizeof(*pSeg) + segAllocSize;
 
 
+    pSeg = (TCPIP_MAC_DATA_SEGMENT*)_TCPIP_PKT_PoolAlloc(allocLen);
+    if(pSeg == 0)
+    {
 #if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
+        pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
 #else
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+        pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
 #endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+    }
 
 
     if(pSeg)
@@ -466,7 +716,7 @@ static __inline__ TCPIP_MAC_DATA_SEGMENT* __attribute__((always_inline)) _TCPIP_
 
 static __inline__ void __attribute__((always_inline)) _TCPIP_PKT_SegmentFreeInt(TCPIP_MAC_DATA_SEGMENT* pSeg, int moduleId)
 {
-    if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
+    if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0 && !_TCPIP_PKT_PoolFree(pSeg))
     {
 #if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
         TCPIP_HEAP_FreeDebug(pktMemH, pSeg, moduleId);
@@ -688,7 +938,11 @@ TCPIP_MAC_PACKET* _TCPIP_PKT_PacketAlloc(uint16_t pktLen, uint16_t segLoadLen, T
     // total allocation size
     allocLen = pktUpLen + sizeof(*pSeg) + segAllocSize;
 
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    pPkt = (TCPIP_MAC_PACKET*)_TCPIP_PKT_PoolAlloc(allocLen);
+    if(pPkt == 0)
+    {
+        pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    }
 
     if(pPkt)
     {   
@@ -763,13 +1017,16 @@ void _TCPIP_PKT_PacketFree(TCPIP_MAC_PACKET* pPkt)
         for( pSeg = pPkt->pDSeg; pSeg != 0; pSeg = pNSeg )
         {
             pNSeg = pSeg->next;
-            if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
+            if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0 && !_TCPIP_PKT_PoolFree(pSeg))
             {
                 TCPIP_HEAP_Free(pktMemH, pSeg);
             }
         }
 
-        TCPIP_HEAP_Free(pktMemH, pPkt);
+        if(!_TCPIP_PKT_PoolFree(pPkt))
+        {
+            TCPIP_HEAP_Free(pktMemH, pPkt);
+        }
     }
 }
 
@@ -788,7 +1045,11 @@ TCPIP_MAC_DATA_SEGMENT* _TCPIP_PKT_SegmentAlloc(uint16_t loadLen, TCPIP_MAC_SEGM
     // total allocation size
     allocLen = sizeof(*pSeg) + segAllocSize;
 
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    pSeg = (TCPIP_MAC_DATA_SEGMENT*)_TCPIP_PKT_PoolAlloc(allocLen);
+    if(pSeg == 0)
+    {
+        pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    }
 
     if(pSeg)
     {
@@ -808,7 +1069,7 @@ TCPIP_MAC_DATA_SEGMENT* _TCPIP_PKT_SegmentAlloc(uint16_t loadLen, TCPIP_MAC_SEGM
 
 void _TCPIP_PKT_SegmentFree(TCPIP_MAC_DATA_SEGMENT* pSeg)
 {
-    if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
+    if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0 && !_TCPIP_PKT_PoolFree(pSeg))
     {
         TCPIP_HEAP_Free(pktMemH, pSeg);
     }
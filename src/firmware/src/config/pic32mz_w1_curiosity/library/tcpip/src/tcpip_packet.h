@@ -214,10 +214,29 @@ typedef struct
 // initialization API
 
 // sets the heap handle to be used for packet allocations
-bool            TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CONFIG* pNetConf, int nNets);
+// if heapUsage has TCPIP_STACK_HEAP_USE_PACKET set, the packet pools are created from this heap
+bool            TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, TCPIP_STACK_HEAP_USAGE heapUsage, const TCPIP_NETWORK_CONFIG* pNetConf, int nNets);
 
 void            TCPIP_PKT_Deinitialize(void);
 
+// packet pools statistics
+typedef struct
+{
+    uint16_t    blockSize;      // size of a pool block, bytes
+    uint16_t    nBlocks;        // number of blocks in the pool
+    uint16_t    nUsed;          // blocks currently allocated
+    uint16_t    highWater;      // max number of blocks allocated at the same time
+    uint32_t    nMisses;        // allocations that found the pool empty and went to the heap
+}TCPIP_PKT_POOL_STAT;
+
+// returns the number of packet pool entries
+// 0 if the packets are allocated from the heap only
+int             TCPIP_PKT_PoolGetEntriesNo(void);
+
+// populates the statistics of a pool entry
+// returns true if the entry is a created pool
+bool            TCPIP_PKT_PoolGetEntry(int poolIx, TCPIP_PKT_POOL_STAT* pStat);
+
 
 // packet allocation API
 
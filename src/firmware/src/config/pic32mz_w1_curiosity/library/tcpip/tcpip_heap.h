@@ -172,6 +172,9 @@ typedef enum
     TCPIP_STACK_HEAP_USE_GENERIC    = 0x01,      
                                           
     /* Heap for packet allocations */
+    /* The packets and data segments are allocated from fixed size pools */
+    /* created from the stack heap, see the TCPIP_PKT_POOL_ settings */
+    /* Allocations that do not fit a pool use the heap */
     TCPIP_STACK_HEAP_USE_PACKET     = 0x02, 
                           
     /* Heap for TCP sockets */
@@ -322,7 +325,7 @@ typedef enum
   Remarks:
     The TCPIP_STACK_HEAP_FLAG_ALLOC_UNCACHED heap flag will be internally set as needed 
 
-    The heapUsage field is currently not used but it's reserved for further development.
+    Of the heapUsage flags only TCPIP_STACK_HEAP_USE_PACKET is currently used.
 
     The malloc_fnc/calloc_fnc/free_fnc are used to allocate the heap objects themselves
     plus the actual heap space (for internal and pool heap types).
@@ -406,6 +409,14 @@ typedef struct
 
 }TCPIP_STACK_HEAP_EXTERNAL_CONFIG;
 
+// the external heap functions selected in the configuration;
+// they need not be the C library ones
+#if defined(TCPIP_STACK_MALLOC_FUNC) && defined(TCPIP_STACK_CALLOC_FUNC) && defined(TCPIP_STACK_FREE_FUNC)
+extern void*    TCPIP_STACK_MALLOC_FUNC(size_t bytes);
+extern void*    TCPIP_STACK_CALLOC_FUNC(size_t nElems, size_t elemSize);
+extern void     TCPIP_STACK_FREE_FUNC(void* ptr);
+#endif
+
 
 //*******************************************************************************
 /* Internal Pool Configuration Data
@@ -44,6 +44,7 @@ Microchip or any third party.
 
 extern  int CheckAvailableSize(WOLFSSL *ssl, int size);
 #include "wolfssl/wolfcrypt/port/atmel/atmel.h"
+#include "system/time/sys_time.h"
 
 
 typedef struct 
@@ -77,6 +78,24 @@ NET_PRES_EncProviderObject net_pres_EncProviderStreamClient0 =
 };
 	
 net_pres_wolfsslInfo net_pres_wolfSSLInfoStreamClient0;
+
+// Session of the last completed handshake, offered on the next connect so that
+// the server can resume it (TLS 1.2 session ID/ticket, TLS 1.3 PSK) and skip
+// the certificate exchange and the ECDH/ECDSA operations.
+// Kept in RAM only: it holds the master secret and the flash is exposed over USB MSD.
+static WOLFSSL_SESSION* net_pres_sessionCacheClient0 = NULL;
+static NET_PRES_EncProviderSessionStats net_pres_sessionStatsClient0;
+static uint32_t net_pres_handshakeStartClient0 = 0;
+static volatile bool net_pres_sessionFlushClient0 = false;
+
+static void _NET_PRES_EncProviderSessionDrop0(void)
+{
+    if (net_pres_sessionCacheClient0 != NULL)
+    {
+        wolfSSL_SESSION_free(net_pres_sessionCacheClient0);
+        net_pres_sessionCacheClient0 = NULL;
+    }
+}
 	
 int NET_PRES_EncGlue_StreamClientReceiveCb0(void *sslin, char *buf, int sz, void *ctx)
 {
@@ -152,6 +171,7 @@ bool NET_PRES_EncProviderStreamClientDeinit0(void)
     atmel_finish();
     wolfSSL_CTX_free(net_pres_wolfSSLInfoStreamClient0.context);
     net_pres_wolfSSLInfoStreamClient0.isInited = false;
+    _NET_PRES_EncProviderSessionDrop0();
     _net_pres_wolfsslUsers--;
     if (_net_pres_wolfsslUsers == 0)
     {
@@ -179,6 +199,24 @@ bool NET_PRES_EncProviderStreamClientOpen0(uintptr_t transHandle, void * provide
         {
             return false;
         }
+#ifdef HAVE_SESSION_TICKET
+        // TLS 1.2 session tickets; TLS 1.3 tickets do not need to be asked for
+        wolfSSL_UseSessionTicket(ssl);
+#endif
+        if (net_pres_sessionFlushClient0)
+        {
+            net_pres_sessionFlushClient0 = false;
+            _NET_PRES_EncProviderSessionDrop0();
+        }
+        if (net_pres_sessionCacheClient0 != NULL)
+        {
+            if (wolfSSL_set_session(ssl, net_pres_sessionCacheClient0) != WOLFSSL_SUCCESS)
+            {
+                // Expired, do a full handshake
+                _NET_PRES_EncProviderSessionDrop0();
+            }
+        }
+        net_pres_handshakeStartClient0 = SYS_TIME_CounterGet();
         memcpy(providerData, &ssl, sizeof(WOLFSSL*));
         return true;
 }
@@ -194,7 +232,20 @@ NET_PRES_EncSessionStatus NET_PRES_EncProviderClientConnect0(void * providerData
     switch (result)
     {
         case SSL_SUCCESS:
+        {
+            uint32_t ms = SYS_TIME_CountToMS(SYS_TIME_CounterGet() - net_pres_handshakeStartClient0);
+            net_pres_sessionStatsClient0.handshakes++;
+            if (wolfSSL_session_reused(ssl))
+            {
+                net_pres_sessionStatsClient0.resumed++;
+                net_pres_sessionStatsClient0.resumedHandshakeMs = ms;
+            }
+            else
+            {
+                net_pres_sessionStatsClient0.fullHandshakeMs = ms;
+            }
             return NET_PRES_ENC_SS_OPEN;
+        }
         default:
         {
             int error = wolfSSL_get_error(ssl, result);
@@ -204,6 +255,9 @@ NET_PRES_EncSessionStatus NET_PRES_EncProviderClientConnect0(void * providerData
                 case SSL_ERROR_WANT_WRITE:
                     return NET_PRES_ENC_SS_CLIENT_NEGOTIATING;
                 default:
+                    // Do not offer the same session again if it was the cause
+                    net_pres_sessionStatsClient0.failed++;
+                    _NET_PRES_EncProviderSessionDrop0();
                     return NET_PRES_ENC_SS_FAILED;
             }
         }
@@ -213,9 +267,30 @@ NET_PRES_EncSessionStatus NET_PRES_EncProviderConnectionClose0(void * providerDa
 {
     WOLFSSL* ssl;
     memcpy(&ssl, providerData, sizeof(WOLFSSL*));
+    // Keep the session for the next connect. Taken at close so that a TLS 1.3
+    // ticket received after the handshake is included.
+    if (wolfSSL_is_init_finished(ssl))
+    {
+        WOLFSSL_SESSION* session = wolfSSL_get1_session(ssl);
+        if (session != NULL)
+        {
+            _NET_PRES_EncProviderSessionDrop0();
+            net_pres_sessionCacheClient0 = session;
+        }
+    }
     wolfSSL_free(ssl);
     return NET_PRES_ENC_SS_CLOSED;
 }
+// May be called from any task, the session is dropped by the next open
+void NET_PRES_EncProviderSessionFlush0(void)
+{
+    net_pres_sessionFlushClient0 = true;
+}
+void NET_PRES_EncProviderSessionStatsGet0(NET_PRES_EncProviderSessionStats * stats)
+{
+    *stats = net_pres_sessionStatsClient0;
+    stats->sessionCached = (net_pres_sessionCacheClient0 != NULL);
+}
 int32_t NET_PRES_EncProviderWrite0(void * providerData, const uint8_t * buffer, uint16_t size)
 {
     WOLFSSL* ssl;
@@ -43,6 +43,15 @@ Microchip or any third party.
 extern "C" {
 #endif
 extern NET_PRES_EncProviderObject net_pres_EncProviderStreamClient0;
+typedef struct
+{
+    uint32_t handshakes;            // completed handshakes
+    uint32_t resumed;               // ... of them resuming the cached session
+    uint32_t failed;
+    uint32_t fullHandshakeMs;       // duration of the last full handshake
+    uint32_t resumedHandshakeMs;    // duration of the last resumed handshake
+    bool sessionCached;
+} NET_PRES_EncProviderSessionStats;
 bool NET_PRES_EncProviderStreamClientInit0(struct _NET_PRES_TransportObject * transObject);
 bool NET_PRES_EncProviderStreamClientDeinit0(void);
 bool NET_PRES_EncProviderStreamClientOpen0(uintptr_t transHandle, void * providerData);
@@ -56,6 +65,8 @@ int32_t NET_PRES_EncProviderReadReady0(void * providerData);
 int32_t NET_PRES_EncProviderPeek0(void * providerData, uint8_t * buffer, uint16_t size);
 int32_t NET_PRES_EncProviderOutputSize0(void * providerData, int32_t inSize);
 int32_t NET_PRES_EncProviderMaxOutputSize0(void * providerData);
+void NET_PRES_EncProviderSessionFlush0(void);
+void NET_PRES_EncProviderSessionStatsGet0(NET_PRES_EncProviderSessionStats * stats);
 #define NET_PRES_SNI_HOST_NAME		"a1gqt8sttiign3-ats.iot.us-east-2.amazonaws.com"
 #define NET_PRES_ALPN_PROTOCOL_NAME_LIST		"x-amzn-mqtt-ca"
 #ifdef __CPLUSPLUS
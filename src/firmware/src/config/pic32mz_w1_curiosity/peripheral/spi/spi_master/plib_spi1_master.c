@@ -60,6 +60,10 @@ volatile static SPI_OBJECT spi1Obj;
 #define SPI1_CON_MSSEN                      (0UL << _SPI1CON_MSSEN_POSITION)
 #define SPI1_CON_SMP                        (0UL << _SPI1CON_SMP_POSITION)
 
+/* In 8-bit mode up to this many bytes are kept in the 16-byte FIFOs, so that
+ * an interrupt moves a burst of bytes instead of a single one */
+#define SPI1_FIFO_BURST                     (8U)
+
 void SPI1_Initialize ( void )
 {
     uint32_t rdata = 0U;
@@ -365,6 +369,13 @@ void __attribute__((used)) SPI1_RX_InterruptHandler (void)
             {
                 ((uint8_t*)spi1Obj.rxBuffer)[rxCount] = (uint8_t)receivedData;
                 rxCount++;
+
+                /* Drain the rest of the burst */
+                while ((rxCount < spi1Obj.rxSize) && ((SPI1STAT & _SPI1STAT_SPIRBE_MASK) == 0U))
+                {
+                    ((uint8_t*)spi1Obj.rxBuffer)[rxCount] = (uint8_t)SPI1BUF;
+                    rxCount++;
+                }
             }
 
             spi1Obj.rxCount = rxCount;
@@ -429,19 +440,30 @@ void __attribute__((used)) SPI1_RX_InterruptHandler (void)
             }
             else
             {
-                if (txCount < spi1Obj.txSize)
+                size_t txSz = spi1Obj.txSize;
+                size_t rxSz = spi1Obj.rxSize;
+                size_t dummyTotal = (rxSz > txSz) ? (rxSz - txSz) : 0U;
+                size_t sent = txCount + (dummyTotal - spi1Obj.dummySize);
+
+                /* Refill the burst. Bytes past rxSize are clocked out by the
+                 * transmit interrupt, which waits for the shift register. */
+                while (((sent - rxCount) < SPI1_FIFO_BURST) && (sent < rxSz))
                 {
-                    SPI1BUF = ((uint8_t*)spi1Obj.txBuffer)[txCount];
-                    txCount++;
-                }
-                else if (spi1Obj.dummySize > 0U)
-                {
-                    SPI1BUF = (uint8_t)(0xffU);
-                    spi1Obj.dummySize--;
-                }
-                else
-                {
-                    /* Do Nothing */
+                    if (txCount < txSz)
+                    {
+                        SPI1BUF = ((uint8_t*)spi1Obj.txBuffer)[txCount];
+                        txCount++;
+                    }
+                    else if (spi1Obj.dummySize > 0U)
+                    {
+                        SPI1BUF = (uint8_t)(0xffU);
+                        spi1Obj.dummySize--;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                    sent++;
                 }
             }
             spi1Obj.txCount = txCount;
@@ -496,8 +518,12 @@ void __attribute__((used)) SPI1_TX_InterruptHandler (void)
             }
             else
             {
-                SPI1BUF = ((uint8_t*)spi1Obj.txBuffer)[txCount];
-                txCount++;
+                /* The buffer is empty, fill it */
+                do
+                {
+                    SPI1BUF = ((uint8_t*)spi1Obj.txBuffer)[txCount];
+                    txCount++;
+                } while ((txCount < spi1Obj.txSize) && ((SPI1STAT & _SPI1STAT_SPITBF_MASK) == 0U));
             }
 
             spi1Obj.txCount = txCount;
@@ -77,5 +77,62 @@ extern TaskHandle_t xMQTT_APP_Tasks;
 extern TaskHandle_t xSYS_CMD_Tasks;
 
 
+// *****************************************************************************
+// *****************************************************************************
+// Section: Application task wakeup control
+// *****************************************************************************
+// *****************************************************************************
+/* Tasks serviced by the loops in tasks.c */
+typedef enum
+{
+    APP_RTOS_TASK_APP = 0,
+    APP_RTOS_TASK_APP_WIFI,
+    APP_RTOS_TASK_MSD_APP,
+    APP_RTOS_TASK_APP_CONTROL,
+    APP_RTOS_TASK_MQTT_APP,
+    /* System tasks, polled in both configurations: only counted, so that the
+       total wakeup rate can be compared */
+    APP_RTOS_TASK_NET_PRES,
+    APP_RTOS_TASK_TCPIP,
+    APP_RTOS_TASK_SYS_WIFI,
+    APP_RTOS_TASK_SYS_FS,
+    APP_RTOS_TASK_SYS_CMD,
+    APP_RTOS_TASK_USB_DEVICE,
+    APP_RTOS_TASK_DRV_MEMORY,
+    APP_RTOS_TASK_COUNT
+} APP_RTOS_TASK_ID;
+
+/* Wakeup accounting for one task. "notified" counts the wakeups caused by an
+   event, the remainder of "wakeups" are period/timeout expiries. */
+typedef struct
+{
+    const char *name;
+    uint32_t wakeups;
+    uint32_t notified;
+} APP_RTOS_TASK_STATS;
+
+extern APP_RTOS_TASK_STATS appRtosTaskStats[APP_RTOS_TASK_COUNT];
+
+#ifdef APP_RTOS_EVENT_DRIVEN
+/* Wake an application task from task context */
+void APP_RTOS_Notify(TaskHandle_t xTask);
+
+/* Wake an application task from an interrupt or SYS_TIME callback */
+void APP_RTOS_NotifyFromISR(TaskHandle_t xTask);
+
+/* Called by a task that still has polled work pending (connecting, mounting,
+   etc). Its next wait uses the regular polling period instead of blocking
+   for APP_RTOS_EVENT_TIMEOUT. */
+void APP_RTOS_PollRequest(APP_RTOS_TASK_ID id);
+#else
+#define APP_RTOS_Notify(xTask)
+#define APP_RTOS_NotifyFromISR(xTask)
+#define APP_RTOS_PollRequest(id)
+#endif
+
+/* Wakes the USB device task, DRV_MEMORY_TRANSFER_COMPLETE_HOOK */
+void APP_RTOS_UsbDeviceWake(void);
+
+
 
 #endif //SYS_TASKS_H
\ No newline at end of file
@@ -15,15 +15,184 @@
 
 #define CACHE_ALIGN_CHECK  (CACHE_LINE_SIZE - 1)
 
+#ifndef SYS_FS_FAT_SECTOR_CACHE_ENTRIES
+#define SYS_FS_FAT_SECTOR_CACHE_ENTRIES 0
+#endif
+
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+/* Single sector reads are FAT, directory and partial file data accesses.
+ * They are kept here on a LRU basis, writes from FatFs update the copies. */
+typedef struct
+{
+    uint8_t data[SYS_FS_FAT_MAX_SS] __ALIGNED(CACHE_LINE_SIZE);
+    uint32_t sector;
+    uint32_t lastUse;
+    bool valid;
+} SYS_FS_DISK_CACHE_ENTRY;
+#endif
+
 typedef struct
 {
     uint8_t alignedBuffer[SYS_FS_FAT_ALIGNED_BUFFER_LEN] __ALIGNED(CACHE_LINE_SIZE);
     SYS_FS_MEDIA_COMMAND_STATUS commandStatus;
     SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE commandHandle;
+    /* A CTRL_SYNC was postponed by disk_sync_hold() */
+    bool syncPending;
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+    SYS_FS_DISK_CACHE_ENTRY cache[SYS_FS_FAT_SECTOR_CACHE_ENTRIES];
+    uint32_t cacheUse;
+    /* Value of gSysFsDiskMediaWrites the cache contents are valid for */
+    uint32_t cacheMediaWrites;
+#endif
 } SYS_FS_DISK_DATA;
 
 static SYS_FS_DISK_DATA CACHE_ALIGN gSysFsDiskData[SYS_FS_MEDIA_NUMBER];
 
+/* Writes to the media that did not go through FatFs, e.g. from the USB host */
+static volatile uint32_t gSysFsDiskMediaWrites = 0;
+
+/* Writes from FatFs */
+static uint32_t gSysFsDiskWrites = 0;
+
+static bool gSysFsDiskSyncHeld = false;
+
+void disk_media_written(void)
+{
+    gSysFsDiskMediaWrites++;
+}
+
+uint32_t disk_write_count(void)
+{
+    return (gSysFsDiskWrites + gSysFsDiskMediaWrites);
+}
+
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+static void disk_cache_invalidate(uint8_t pdrv)
+{
+    uint32_t i;
+
+    for (i = 0; i < SYS_FS_FAT_SECTOR_CACHE_ENTRIES; i++)
+    {
+        gSysFsDiskData[pdrv].cache[i].valid = false;
+    }
+}
+
+static SYS_FS_DISK_CACHE_ENTRY *disk_cache_find(uint8_t pdrv, uint32_t sector)
+{
+    SYS_FS_DISK_DATA *disk = &gSysFsDiskData[pdrv];
+    uint32_t mediaWrites = gSysFsDiskMediaWrites;
+    uint32_t i;
+
+    if (disk->cacheMediaWrites != mediaWrites)
+    {
+        disk_cache_invalidate(pdrv);
+        disk->cacheMediaWrites = mediaWrites;
+        return NULL;
+    }
+
+    for (i = 0; i < SYS_FS_FAT_SECTOR_CACHE_ENTRIES; i++)
+    {
+        if ((disk->cache[i].valid == true) && (disk->cache[i].sector == sector))
+        {
+            return &disk->cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static SYS_FS_DISK_CACHE_ENTRY *disk_cache_victim(uint8_t pdrv)
+{
+    SYS_FS_DISK_DATA *disk = &gSysFsDiskData[pdrv];
+    SYS_FS_DISK_CACHE_ENTRY *victim = &disk->cache[0];
+    uint32_t i;
+
+    for (i = 0; i < SYS_FS_FAT_SECTOR_CACHE_ENTRIES; i++)
+    {
+        if (disk->cache[i].valid == false)
+        {
+            return &disk->cache[i];
+        }
+
+        /* Wrap safe, the oldest entry is the furthest behind cacheUse */
+        if ((disk->cacheUse - disk->cache[i].lastUse) > (disk->cacheUse - victim->lastUse))
+        {
+            victim = &disk->cache[i];
+        }
+    }
+
+    return victim;
+}
+
+static void disk_cache_update(uint8_t pdrv, const uint8_t *buff, uint32_t sector, uint32_t count, bool written)
+{
+    SYS_FS_DISK_CACHE_ENTRY *entry;
+    uint32_t i;
+
+    for (i = 0; i < SYS_FS_FAT_SECTOR_CACHE_ENTRIES; i++)
+    {
+        entry = &gSysFsDiskData[pdrv].cache[i];
+
+        if ((entry->valid == true) && (entry->sector >= sector) && ((entry->sector - sector) < count))
+        {
+            if (written == true)
+            {
+                memcpy(entry->data, &buff[(entry->sector - sector) * SYS_FS_FAT_MAX_SS], SYS_FS_FAT_MAX_SS);
+            }
+            else
+            {
+                /* The media contents are unknown after a failed write */
+                entry->valid = false;
+            }
+        }
+    }
+}
+
+static DRESULT disk_read_aligned(uint8_t pdrv, uint8_t *buff, uint32_t sector, uint32_t sector_count);
+
+static DRESULT disk_read_cached
+(
+    uint8_t pdrv,
+    uint8_t *buff,
+    uint32_t sector
+)
+{
+    SYS_FS_DISK_DATA *disk = &gSysFsDiskData[pdrv];
+    SYS_FS_DISK_CACHE_ENTRY *entry;
+    uint32_t mediaWrites = gSysFsDiskMediaWrites;
+    DRESULT result;
+
+    entry = disk_cache_find(pdrv, sector);
+
+    if (entry == NULL)
+    {
+        entry = disk_cache_victim(pdrv);
+        entry->valid = false;
+
+        result = disk_read_aligned(pdrv, entry->data, sector, 1);
+
+        if (result != RES_OK)
+        {
+            return result;
+        }
+
+        /* Do not keep the sector if the media was written meanwhile */
+        if (mediaWrites == disk->cacheMediaWrites)
+        {
+            entry->sector = sector;
+            entry->valid = true;
+        }
+    }
+
+    disk->cacheUse++;
+    entry->lastUse = disk->cacheUse;
+
+    memcpy(buff, entry->data, SYS_FS_FAT_MAX_SS);
+
+    return RES_OK;
+}
+#endif
+
 void diskEventHandler
 (
     SYS_FS_MEDIA_BLOCK_EVENT event,
@@ -109,6 +278,12 @@ DSTATUS disk_initialize (
     }
 
     SYS_FS_MEDIA_MANAGER_RegisterTransferHandler( (void *) diskEventHandler );
+
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+    /* The media may have been changed while unmounted */
+    disk_cache_invalidate(pdrv);
+    gSysFsDiskData[pdrv].cacheMediaWrites = gSysFsDiskMediaWrites;
+#endif
     return 0;
 }
 
@@ -154,6 +329,13 @@ DRESULT disk_read
     uint32_t sector_aligned_index = 0;
     uint8_t (*sector_ptr)[SYS_FS_FAT_MAX_SS] = (uint8_t (*)[])buff;
 
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+    if (count == 1U)
+    {
+        return disk_read_cached(pdrv, buff, sector);
+    }
+#endif
+
     /* Use Aligned Buffer if input buffer is in Cacheable address space and
      * is not aligned to cache line size */
     if ((IS_KVA0((uint8_t *)buff) == true) && (((uint32_t)buff & CACHE_ALIGN_CHECK) != 0))
@@ -231,6 +413,12 @@ DRESULT disk_write
     uint32_t bytesToTransfer    = 0;
     uint32_t currentXferLen     = 0;
     uint32_t sectorXferCntr     = 0;
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+    const uint8_t *cacheBuff    = buff;
+    uint32_t cacheSector        = sector;
+#endif
+
+    gSysFsDiskWrites++;
 
     /* Use Aligned Buffer if input buffer is in Cacheable address space and
      * is not aligned to cache line size */
@@ -298,6 +486,10 @@ DRESULT disk_write
         result = disk_checkCommandStatus(pdrv);
     }
 
+#if (SYS_FS_FAT_SECTOR_CACHE_ENTRIES > 0)
+    disk_cache_update(pdrv, cacheBuff, cacheSector, count, (result == RES_OK));
+#endif
+
     return result;
 }
 #endif
@@ -338,9 +530,53 @@ DRESULT disk_ioctl (
 
         *(uint32_t *)buff = numSectors;
     }
+    else if (cmd == CTRL_SYNC)
+    {
+        if (gSysFsDiskSyncHeld == true)
+        {
+            gSysFsDiskData[pdrv].syncPending = true;
+            return RES_OK;
+        }
+
+        /* Write back the data held by the media driver, if any */
+        gSysFsDiskData[pdrv].commandStatus = SYS_FS_MEDIA_COMMAND_IN_PROGRESS;
+
+        if (SYS_FS_MEDIA_MANAGER_CacheFlush(pdrv, &gSysFsDiskData[pdrv].commandHandle) == true)
+        {
+            return disk_checkCommandStatus(pdrv);
+        }
+    }
 
     return RES_OK;
 }
+
+void disk_sync_hold(void)
+{
+    gSysFsDiskSyncHeld = true;
+}
+
+DRESULT disk_sync_release(void)
+{
+    DRESULT result = RES_OK;
+    uint8_t pdrv;
+
+    gSysFsDiskSyncHeld = false;
+
+    for (pdrv = 0; pdrv < SYS_FS_MEDIA_NUMBER; pdrv++)
+    {
+        if (gSysFsDiskData[pdrv].syncPending == true)
+        {
+            gSysFsDiskData[pdrv].syncPending = false;
+
+            if (disk_ioctl(pdrv, CTRL_SYNC, NULL) != RES_OK)
+            {
+                result = RES_ERROR;
+            }
+        }
+    }
+
+    return result;
+}
 #endif
 
 /****************************************************************************
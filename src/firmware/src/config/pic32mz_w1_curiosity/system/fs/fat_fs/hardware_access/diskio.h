@@ -37,6 +37,15 @@ DRESULT disk_read (uint8_t pdrv, uint8_t* buff, uint32_t sector, uint32_t count)
 DRESULT disk_write (uint8_t pdrv, const uint8_t* buff, uint32_t sector, uint32_t count);
 DRESULT disk_ioctl (uint8_t pdrv, uint8_t cmd, void* buff);
 
+/* Count of media writes, including those reported by disk_media_written() */
+uint32_t disk_write_count (void);
+/* Report a write to the media made outside of FatFs (e.g. by a USB host) */
+void disk_media_written (void);
+/* Postpone CTRL_SYNC write backs until disk_sync_release(), to group the
+   updates of several files into one media flush */
+void disk_sync_hold (void);
+DRESULT disk_sync_release (void);
+
 
 /* Disk Status Bits (DSTATUS) */
 
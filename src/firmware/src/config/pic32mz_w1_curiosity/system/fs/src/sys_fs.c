@@ -40,6 +40,8 @@
 //DOM-IGNORE-END
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "system/fs/src/sys_fs_local.h"
@@ -121,6 +123,21 @@ static OSAL_MUTEX_DECLARE(gSysFsMutex);
 /* Variable to hold the error value */
 static SYS_FS_ERROR errorValue;
 
+/* Atomic write instance mutex */
+static OSAL_MUTEX_DECLARE(gSysFsAtomicMutex);
+/* Journal record and paths of the atomic write in progress */
+static SYS_FS_ATOMIC_JOURNAL gSysFsJournal;
+static SYS_FS_FSTAT gSysFsAtomicStat;
+static char gSysFsAtomicTarget[SYS_FS_FILE_NAME_LEN + 1U];
+static char gSysFsAtomicTemp[SYS_FS_FILE_NAME_LEN + 1U];
+static char gSysFsAtomicJournalPath[SYS_FS_FILE_NAME_LEN + 1U];
+
+#ifdef SYS_FS_ATOMIC_FAULT_HOOK
+extern bool SYS_FS_ATOMIC_FAULT_HOOK(SYS_FS_ATOMIC_STEP step);
+#endif
+
+static void SYS_FS_AtomicRecover(SYS_FS_MOUNT_POINT *disk);
+
 //******************************************************************************
 /*Function:
     static bool SYS_FS_GetDisk
@@ -377,6 +394,11 @@ SYS_FS_RESULT SYS_FS_Initialize
         }
     }
 
+    if (OSAL_MUTEX_Create(&gSysFsAtomicMutex) != OSAL_RESULT_SUCCESS)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
     return SYS_FS_RES_SUCCESS;
 }
 /* MISRAC 2012 deviation block end */
@@ -498,7 +520,6 @@ SYS_FS_RESULT SYS_FS_Mount
 
     const char *ptr = NULL;
 
-    (void)mountflags;
     (void)data;
 
     /* Validate the parameters. */
@@ -646,6 +667,13 @@ SYS_FS_RESULT SYS_FS_Mount
     /* Release the acquired mutex. */
     (void) OSAL_MUTEX_Unlock (&gSysFsMutex);
 
+    /* Complete an atomic write interrupted by a power loss */
+    if ((fileStatus == 0) && (errorValue == SYS_FS_ERROR_OK) &&
+            ((mountflags & SYS_FS_MOUNT_NO_RECOVERY) == 0U))
+    {
+        SYS_FS_AtomicRecover(disk);
+    }
+
     return (fileStatus == 0) ? SYS_FS_RES_SUCCESS : SYS_FS_RES_FAILURE;
 }
 
@@ -3223,6 +3251,437 @@ SYS_FS_RESULT SYS_FS_FileDirectoryRenameMove
     return (fileStatus == 0) ? SYS_FS_RES_SUCCESS : SYS_FS_RES_FAILURE;
 }
 
+//******************************************************************************
+/*Function:
+    static bool SYS_FS_AtomicFault
+    (
+        SYS_FS_ATOMIC_STEP step
+    )
+
+  Summary:
+    Fault injection point of the atomic write.
+
+  Description:
+    Returns true if SYS_FS_ATOMIC_FAULT_HOOK asks to stop before the step.
+
+  Remarks:
+    None
+***************************************************************************/
+static bool SYS_FS_AtomicFault
+(
+    SYS_FS_ATOMIC_STEP step
+)
+{
+#ifdef SYS_FS_ATOMIC_FAULT_HOOK
+    return SYS_FS_ATOMIC_FAULT_HOOK(step);
+#else
+    (void)step;
+    return false;
+#endif
+}
+
+//******************************************************************************
+/*Function:
+    static uint32_t SYS_FS_AtomicCrc
+    (
+        const void *data,
+        size_t len
+    )
+
+  Summary:
+    CRC-32 of the journal record.
+
+  Description:
+    Bitwise CRC-32 (IEEE 802.3). The record is only computed on an atomic write
+    and at mount, a table is not worth the flash.
+
+  Remarks:
+    None
+***************************************************************************/
+static uint32_t SYS_FS_AtomicCrc
+(
+    const void *data,
+    size_t len
+)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFUL;
+    uint8_t bit = 0;
+
+    while (len != 0U)
+    {
+        crc ^= *ptr;
+        for (bit = 0; bit != 8U; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+        }
+        ptr++;
+        len--;
+    }
+
+    return ~crc;
+}
+
+//******************************************************************************
+/*Function:
+    static bool SYS_FS_AtomicPathsGet
+    (
+        SYS_FS_MOUNT_POINT *disk
+    )
+
+  Summary:
+    Builds the paths used by the atomic write.
+
+  Description:
+    Builds the journal path of the volume and, if the journal record holds a
+    target, the absolute target and temporary file paths.
+
+  Remarks:
+    Called with gSysFsAtomicMutex held.
+***************************************************************************/
+static bool SYS_FS_AtomicPathsGet
+(
+    SYS_FS_MOUNT_POINT *disk
+)
+{
+    int len = 0;
+    int nameLength = (int)disk->mountNameLength;
+
+    len = snprintf(gSysFsAtomicJournalPath, sizeof(gSysFsAtomicJournalPath), "/mnt/%.*s/%s",
+            nameLength, disk->mountName, SYS_FS_ATOMIC_JOURNAL_NAME);
+    if ((len < 0) || ((size_t)len >= sizeof(gSysFsAtomicJournalPath)))
+    {
+        errorValue = SYS_FS_ERROR_INVALID_NAME;
+        return false;
+    }
+
+    if (gSysFsJournal.path[0] == '\0')
+    {
+        return true;
+    }
+
+    len = snprintf(gSysFsAtomicTarget, sizeof(gSysFsAtomicTarget), "/mnt/%.*s/%s",
+            nameLength, disk->mountName, gSysFsJournal.path);
+    if ((len < 0) || ((size_t)len >= sizeof(gSysFsAtomicTarget)))
+    {
+        errorValue = SYS_FS_ERROR_INVALID_NAME;
+        return false;
+    }
+
+    len = snprintf(gSysFsAtomicTemp, sizeof(gSysFsAtomicTemp), "%s%s",
+            gSysFsAtomicTarget, SYS_FS_ATOMIC_TEMP_SUFFIX);
+    if ((len < 0) || ((size_t)len >= sizeof(gSysFsAtomicTemp)))
+    {
+        errorValue = SYS_FS_ERROR_INVALID_NAME;
+        return false;
+    }
+
+    return true;
+}
+
+//******************************************************************************
+/*Function:
+    static bool SYS_FS_AtomicJournalWrite
+    (
+        bool commit,
+        uint32_t size
+    )
+
+  Summary:
+    Writes the journal record.
+
+  Description:
+    The record is overwritten in place, the journal file is only created, and
+    hidden, the first time. Closing the file syncs it to the media.
+
+  Remarks:
+    Called with gSysFsAtomicMutex held.
+***************************************************************************/
+static bool SYS_FS_AtomicJournalWrite
+(
+    bool commit,
+    uint32_t size
+)
+{
+    SYS_FS_HANDLE handle = SYS_FS_HANDLE_INVALID;
+    size_t nbyte = 0;
+    bool created = false;
+
+    gSysFsJournal.magic = SYS_FS_ATOMIC_JOURNAL_MAGIC;
+    gSysFsJournal.commit = (commit == true) ? 1UL : 0UL;
+    gSysFsJournal.size = size;
+    gSysFsJournal.crc = SYS_FS_AtomicCrc(&gSysFsJournal, offsetof(SYS_FS_ATOMIC_JOURNAL, crc));
+
+    handle = SYS_FS_FileOpen(gSysFsAtomicJournalPath, SYS_FS_FILE_OPEN_READ_PLUS);
+    if (handle == SYS_FS_HANDLE_INVALID)
+    {
+        handle = SYS_FS_FileOpen(gSysFsAtomicJournalPath, SYS_FS_FILE_OPEN_WRITE);
+        created = true;
+    }
+
+    if (handle == SYS_FS_HANDLE_INVALID)
+    {
+        return false;
+    }
+
+    nbyte = SYS_FS_FileWrite(handle, &gSysFsJournal, sizeof(gSysFsJournal));
+    if (SYS_FS_FileClose(handle) != SYS_FS_RES_SUCCESS)
+    {
+        nbyte = 0;
+    }
+
+    if (created == true)
+    {
+        (void) SYS_FS_FileDirectoryModeSet(gSysFsAtomicJournalPath,
+                (SYS_FS_FILE_DIR_ATTR)((uint32_t)SYS_FS_ATTR_HID | (uint32_t)SYS_FS_ATTR_SYS),
+                (SYS_FS_FILE_DIR_ATTR)((uint32_t)SYS_FS_ATTR_HID | (uint32_t)SYS_FS_ATTR_SYS));
+    }
+
+    if (nbyte != sizeof(gSysFsJournal))
+    {
+        errorValue = SYS_FS_ERROR_DISK_ERR;
+        return false;
+    }
+
+    return true;
+}
+
+//******************************************************************************
+/*Function:
+    static SYS_FS_RESULT SYS_FS_AtomicCommit
+    (
+        void
+    )
+
+  Summary:
+    Replaces the target by the temporary file and clears the journal.
+
+  Description:
+    Runs once the journal holds the intent, from SYS_FS_FileWriteAtomic and
+    again from the recovery at mount if it was interrupted. Every step can be
+    repeated: a target that is already gone is not an error.
+
+  Remarks:
+    Called with gSysFsAtomicMutex held.
+***************************************************************************/
+static SYS_FS_RESULT SYS_FS_AtomicCommit
+(
+    void
+)
+{
+    if (SYS_FS_AtomicFault(SYS_FS_ATOMIC_STEP_TARGET_REMOVE) == true)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if ((SYS_FS_FileDirectoryRemove(gSysFsAtomicTarget) != SYS_FS_RES_SUCCESS) &&
+            (errorValue != SYS_FS_ERROR_NO_FILE))
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if (SYS_FS_AtomicFault(SYS_FS_ATOMIC_STEP_RENAME) == true)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if (SYS_FS_FileDirectoryRenameMove(gSysFsAtomicTemp, gSysFsAtomicTarget) != SYS_FS_RES_SUCCESS)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if (SYS_FS_AtomicFault(SYS_FS_ATOMIC_STEP_JOURNAL_CLEAR) == true)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if (SYS_FS_AtomicJournalWrite(false, 0U) == false)
+    {
+        return SYS_FS_RES_FAILURE;
+    }
+
+    return SYS_FS_RES_SUCCESS;
+}
+
+//******************************************************************************
+/*Function:
+    static void SYS_FS_AtomicRecover
+    (
+        SYS_FS_MOUNT_POINT *disk
+    )
+
+  Summary:
+    Completes an atomic write interrupted by a power loss.
+
+  Description:
+    Reads the journal of the volume. Without a committed intent, which is the
+    normal case, nothing else is read. Otherwise the rename is completed if
+    the temporary file is still there, and the journal is cleared.
+
+  Remarks:
+    Called by SYS_FS_Mount. The error value of the mount is preserved.
+***************************************************************************/
+static void SYS_FS_AtomicRecover
+(
+    SYS_FS_MOUNT_POINT *disk
+)
+{
+    SYS_FS_HANDLE handle = SYS_FS_HANDLE_INVALID;
+    SYS_FS_ERROR mountError = errorValue;
+    size_t nbyte = 0;
+
+    if (OSAL_MUTEX_Lock(&gSysFsAtomicMutex, OSAL_WAIT_FOREVER) != OSAL_RESULT_SUCCESS)
+    {
+        return;
+    }
+
+    gSysFsJournal.path[0] = '\0';
+    if (SYS_FS_AtomicPathsGet(disk) == true)
+    {
+        handle = SYS_FS_FileOpen(gSysFsAtomicJournalPath, SYS_FS_FILE_OPEN_READ);
+    }
+
+    if (handle != SYS_FS_HANDLE_INVALID)
+    {
+        nbyte = SYS_FS_FileRead(handle, &gSysFsJournal, sizeof(gSysFsJournal));
+        (void) SYS_FS_FileClose(handle);
+
+        if ((nbyte == sizeof(gSysFsJournal)) &&
+                (gSysFsJournal.magic == SYS_FS_ATOMIC_JOURNAL_MAGIC) &&
+                (gSysFsJournal.commit == 1UL) &&
+                (gSysFsJournal.path[SYS_FS_FILE_NAME_LEN] == '\0') &&
+                (gSysFsJournal.crc == SYS_FS_AtomicCrc(&gSysFsJournal, offsetof(SYS_FS_ATOMIC_JOURNAL, crc))) &&
+                (SYS_FS_AtomicPathsGet(disk) == true))
+        {
+            if (SYS_FS_FileStat(gSysFsAtomicTemp, &gSysFsAtomicStat) != SYS_FS_RES_SUCCESS)
+            {
+                /* Renamed already, only the journal was not cleared */
+                (void) SYS_FS_AtomicJournalWrite(false, 0U);
+            }
+            else if (gSysFsAtomicStat.fsize == gSysFsJournal.size)
+            {
+                (void) SYS_FS_AtomicCommit();
+            }
+            else
+            {
+                /* Not the file the journal was written for, keep the target */
+                (void) SYS_FS_FileDirectoryRemove(gSysFsAtomicTemp);
+                (void) SYS_FS_AtomicJournalWrite(false, 0U);
+            }
+        }
+    }
+
+    (void) OSAL_MUTEX_Unlock(&gSysFsAtomicMutex);
+
+    errorValue = mountError;
+}
+
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileWriteAtomic
+    (
+        const char *fname,
+        const void *buffer,
+        size_t nbyte
+    );
+
+  Summary:
+    Replaces the content of a file so that it survives a power loss.
+
+  Description:
+    Writes a temporary file, records the intent in the journal, then renames
+    the temporary file over the target.
+
+  Remarks:
+    See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileWriteAtomic
+(
+    const char *fname,
+    const void *buffer,
+    size_t nbyte
+)
+{
+    SYS_FS_MOUNT_POINT *disk = (SYS_FS_MOUNT_POINT *) NULL;
+    SYS_FS_HANDLE handle = SYS_FS_HANDLE_INVALID;
+    SYS_FS_RESULT result = SYS_FS_RES_FAILURE;
+    const char *path = fname;
+    size_t written = 0;
+    bool closed = false;
+
+    if ((fname == NULL) || ((buffer == NULL) && (nbyte != 0U)))
+    {
+        errorValue = SYS_FS_ERROR_INVALID_PARAMETER;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    /* Get disk number */
+    if (SYS_FS_GetDisk(fname, &disk, NULL) == false)
+    {
+        /* "errorValue" contains the reason for failure. */
+        return SYS_FS_RES_FAILURE;
+    }
+
+    /* The journal holds the path relative to the root of the volume */
+    if (strncmp(fname, "/mnt/", 5) == 0)
+    {
+        path = fname + 5 + disk->mountNameLength;
+    }
+    while (*path == '/')
+    {
+        path++;
+    }
+
+    if ((*path == '\0') || (strlen(path) > SYS_FS_FILE_NAME_LEN))
+    {
+        errorValue = SYS_FS_ERROR_INVALID_NAME;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if (OSAL_MUTEX_Lock(&gSysFsAtomicMutex, OSAL_WAIT_FOREVER) != OSAL_RESULT_SUCCESS)
+    {
+        errorValue = SYS_FS_ERROR_DENIED;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    /* Zero padded, the CRC covers the whole path */
+    (void) memset(&gSysFsJournal, 0, sizeof(gSysFsJournal));
+    (void) strncpy(gSysFsJournal.path, path, SYS_FS_FILE_NAME_LEN);
+
+    if ((SYS_FS_AtomicPathsGet(disk) == true) &&
+            (SYS_FS_AtomicFault(SYS_FS_ATOMIC_STEP_TEMP_WRITE) == false))
+    {
+        handle = SYS_FS_FileOpen(gSysFsAtomicTemp, SYS_FS_FILE_OPEN_WRITE);
+    }
+
+    if (handle != SYS_FS_HANDLE_INVALID)
+    {
+        written = SYS_FS_FileWrite(handle, buffer, nbyte);
+        closed = (SYS_FS_FileClose(handle) == SYS_FS_RES_SUCCESS);
+
+        if ((written != nbyte) || (closed == false))
+        {
+            /* The target is untouched */
+            (void) SYS_FS_FileDirectoryRemove(gSysFsAtomicTemp);
+            errorValue = SYS_FS_ERROR_DISK_ERR;
+        }
+        else if ((SYS_FS_AtomicFault(SYS_FS_ATOMIC_STEP_JOURNAL_COMMIT) == false) &&
+                (SYS_FS_AtomicJournalWrite(true, (uint32_t)nbyte) == true))
+        {
+            /* From here on, the next mount completes the write if this does not */
+            result = SYS_FS_AtomicCommit();
+        }
+        else
+        {
+            /* Nothing to do, a torn journal record holds no intent */
+        }
+    }
+
+    (void) OSAL_MUTEX_Unlock(&gSysFsAtomicMutex);
+
+    return result;
+}
+
 //******************************************************************************
 /*Function:
     SYS_FS_RESULT SYS_FS_CurrentDriveSet
@@ -21,8 +21,10 @@
 * THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
  *******************************************************************************/
 
+#include <string.h>
 #include "system/fs/sys_fs_fat_interface.h"
 #include "system/fs/sys_fs.h"
+#include "system/fs/fat_fs/hardware_access/diskio.h"
 
 typedef struct
 {
@@ -47,6 +49,98 @@ static FATFS_FILE_OBJECT CACHE_ALIGN FATFSFileObject[SYS_FS_MAX_FILES];
 static FATFS_DIR_OBJECT CACHE_ALIGN FATFSDirObject[SYS_FS_MAX_FILES];
 static uint8_t startupflag = 0;
 
+#ifndef SYS_FS_FAT_STAT_CACHE_ENTRIES
+#define SYS_FS_FAT_STAT_CACHE_ENTRIES 0
+#endif
+
+#if (SYS_FS_FAT_STAT_CACHE_ENTRIES > 0)
+/* Results of FATFS_stat() indexed by a hash of the path. Entries are valid
+ * until the next write to the media, by FatFs or the USB host. */
+typedef struct
+{
+    bool valid;
+    FRESULT res;
+    uint32_t hash;
+    uint32_t writeCount;
+    FSIZE_t fsize;
+    WORD fdate;
+    WORD ftime;
+    BYTE fattrib;
+    TCHAR altname[FF_SFN_BUF + 1];
+    TCHAR fname[SYS_FS_FAT_STAT_CACHE_PATH_LEN];
+    char path[SYS_FS_FAT_STAT_CACHE_PATH_LEN];
+} FATFS_STAT_CACHE_ENTRY;
+
+static FATFS_STAT_CACHE_ENTRY FATFSStatCache[SYS_FS_FAT_STAT_CACHE_ENTRIES];
+
+static uint32_t FATFS_StatCacheHash(const char *path)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261UL;
+
+    while (*path != '\0')
+    {
+        hash = (hash ^ (uint8_t)*path) * 16777619UL;
+        path++;
+    }
+
+    return hash;
+}
+
+/* Two slots per path: the home slot and the next one */
+static FATFS_STAT_CACHE_ENTRY *FATFS_StatCacheFind(const char *path, uint32_t hash, uint32_t writeCount)
+{
+    FATFS_STAT_CACHE_ENTRY *entry;
+    uint32_t i;
+
+    for (i = 0; i < 2U; i++)
+    {
+        entry = &FATFSStatCache[(hash + i) % SYS_FS_FAT_STAT_CACHE_ENTRIES];
+
+        if ((entry->valid == true) && (entry->hash == hash) &&
+            (entry->writeCount == writeCount) && (strcmp(entry->path, path) == 0))
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void FATFS_StatCacheStore(const char *path, uint32_t hash, uint32_t writeCount, FRESULT res, const FILINFO *finfo)
+{
+    FATFS_STAT_CACHE_ENTRY *entry = &FATFSStatCache[hash % SYS_FS_FAT_STAT_CACHE_ENTRIES];
+    FATFS_STAT_CACHE_ENTRY *next = &FATFSStatCache[(hash + 1U) % SYS_FS_FAT_STAT_CACHE_ENTRIES];
+
+    if ((res == FR_OK) && (strlen(finfo->fname) >= SYS_FS_FAT_STAT_CACHE_PATH_LEN))
+    {
+        return;
+    }
+
+    /* Prefer a slot that is free or outdated */
+    if ((entry->valid == true) && (entry->writeCount == writeCount))
+    {
+        entry = next;
+    }
+
+    entry->valid = true;
+    entry->res = res;
+    entry->hash = hash;
+    entry->writeCount = writeCount;
+    (void) strcpy(entry->path, path);
+
+    if (res == FR_OK)
+    {
+        entry->fsize = finfo->fsize;
+        entry->fdate = finfo->fdate;
+        entry->ftime = finfo->ftime;
+        entry->fattrib = finfo->fattrib;
+        (void) strcpy(entry->altname, finfo->altname);
+        (void) strcpy(entry->fname, finfo->fname);
+    }
+}
+#endif
+
 int FATFS_mount ( uint8_t vol )
 {
     FATFS *fs = NULL;
@@ -295,8 +389,45 @@ int FATFS_stat (
 {
     FRESULT res;
     FILINFO *finfo = (FILINFO *)fileInfo;
+#if (SYS_FS_FAT_STAT_CACHE_ENTRIES > 0)
+    FATFS_STAT_CACHE_ENTRY *entry = NULL;
+    uint32_t writeCount = disk_write_count();
+    uint32_t hash = 0;
+    bool cacheable = ((finfo != NULL) && (strlen(path) < SYS_FS_FAT_STAT_CACHE_PATH_LEN));
 
+    if (cacheable == true)
+    {
+        hash = FATFS_StatCacheHash(path);
+        entry = FATFS_StatCacheFind(path, hash, writeCount);
+    }
+
+    if (entry != NULL)
+    {
+        res = entry->res;
+
+        if (res == FR_OK)
+        {
+            finfo->fsize = entry->fsize;
+            finfo->fdate = entry->fdate;
+            finfo->ftime = entry->ftime;
+            finfo->fattrib = entry->fattrib;
+            (void) strcpy(finfo->altname, entry->altname);
+            (void) strcpy(finfo->fname, entry->fname);
+        }
+    }
+    else
+    {
+        res = f_stat((const TCHAR *)path, finfo);
+
+        /* A missing file is looked up as often as an existing one */
+        if ((cacheable == true) && ((res == FR_OK) || (res == FR_NO_FILE)))
+        {
+            FATFS_StatCacheStore(path, hash, writeCount, res, finfo);
+        }
+    }
+#else
     res = f_stat((const TCHAR *)path, finfo);
+#endif
 
     if (finfo != NULL)
     {
@@ -55,6 +55,13 @@
 #ifndef SYS_FS_CWD_STRING_LEN
 #define SYS_FS_CWD_STRING_LEN (1024)
 #endif
+#ifndef SYS_FS_ATOMIC_JOURNAL_NAME
+#define SYS_FS_ATOMIC_JOURNAL_NAME "FSJOURNL.SYS"
+#endif
+#ifndef SYS_FS_ATOMIC_TEMP_SUFFIX
+#define SYS_FS_ATOMIC_TEMP_SUFFIX "~"
+#endif
+#define SYS_FS_ATOMIC_JOURNAL_MAGIC (0x4C4E524AUL)
 
 // *****************************************************************************
 /* Mount point
@@ -168,6 +175,36 @@ typedef struct
 }
 SYS_FS_CURRENT_MOUNT_POINT;
 
+// *****************************************************************************
+/* Atomic write journal
+
+  Summary:
+    Intent record of SYS_FS_FileWriteAtomic.
+
+  Description:
+    The journal file holds a single record, written in place so that it stays
+    within the first sector of the file. A record whose magic or CRC does not
+    match, from a write torn by a power loss, is the same as no intent: the
+    temporary file was complete before the record was written, but the old
+    file has not been touched yet.
+
+  Remarks:
+    None.
+*/
+typedef struct
+{
+    uint32_t magic;
+    /* 1 while the rename is pending */
+    uint32_t commit;
+    /* Size of the temporary file */
+    uint32_t size;
+    /* Target file, relative to the root of the volume */
+    char path[SYS_FS_FILE_NAME_LEN + 1U];
+    /* CRC-32 of the members above */
+    uint32_t crc;
+}
+SYS_FS_ATOMIC_JOURNAL;
+
 //******************************************************************************
 
 #endif // SYS_FS_PRIVATE_H
@@ -1030,6 +1030,60 @@ SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE SYS_FS_MEDIA_MANAGER_SectorWrite
     return (mediaObj->commandHandle);
 }
 
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_CacheFlush
+    (
+        uint16_t diskNo,
+        SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE *commandHandle
+    );
+
+  Summary:
+    Writes back the data cached by the specified media.
+
+  Description:
+    This function calls the cache flush function of the media driver, if it
+    has one.
+
+  Remarks:
+    See sys_fs_media_manager.h for usage information.
+***************************************************************************/
+bool SYS_FS_MEDIA_MANAGER_CacheFlush
+(
+    uint16_t diskNum,
+    SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE *commandHandle
+)
+{
+    SYS_FS_MEDIA *mediaObj = NULL;
+
+    *commandHandle = SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID;
+
+    if(diskNum >= SYS_FS_MEDIA_NUMBER)
+    {
+        SYS_ASSERT(false, "Invalid Disk");
+        return true;
+    }
+
+    mediaObj = &gSYSFSMediaManagerObj.mediaObj[diskNum];
+
+    if (mediaObj->driverHandle == DRV_HANDLE_INVALID)
+    {
+        return true;
+    }
+
+    if (mediaObj->driverFunctions->cacheFlush == NULL)
+    {
+        return false;
+    }
+
+    mediaObj->commandStatus = SYS_FS_MEDIA_COMMAND_IN_PROGRESS;
+    mediaObj->driverFunctions->cacheFlush (mediaObj->driverHandle, &(mediaObj->commandHandle));
+
+    *commandHandle = mediaObj->commandHandle;
+
+    return true;
+}
+
 //*****************************************************************************
 /* Function:
     uintptr_t SYS_FS_MEDIA_MANAGER_AddressGet
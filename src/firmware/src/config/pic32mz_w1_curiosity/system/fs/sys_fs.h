@@ -737,6 +737,55 @@ typedef union
 } SYS_FS_TIME;
 
 /* MISRAC 2012 deviation block end */
+
+// *****************************************************************************
+/* Mount flags
+
+  Summary:
+    Flags for the mountflags parameter of SYS_FS_Mount.
+
+  Description:
+    With SYS_FS_MOUNT_NO_RECOVERY, SYS_FS_Mount does not complete an
+    interrupted SYS_FS_FileWriteAtomic and writes nothing to the volume. Use
+    it to remount a volume which is also exposed to a USB host.
+
+  Remarks:
+    None.
+*/
+
+#define SYS_FS_MOUNT_NO_RECOVERY        (0x1UL)
+
+// *****************************************************************************
+/* Atomic write steps
+
+  Summary:
+    Identifies the steps of SYS_FS_FileWriteAtomic.
+
+  Description:
+    When SYS_FS_ATOMIC_FAULT_HOOK is defined, it is called with each of these
+    steps before the step is carried out. If the hook returns true the write
+    stops there, as if the power had been lost, and returns
+    SYS_FS_RES_FAILURE. The recovery done by the next SYS_FS_Mount can be
+    exercised this way on any media, including a RAM disk on a host.
+
+  Remarks:
+    None.
+*/
+
+typedef enum
+{
+    /* Temporary file is created and written */
+    SYS_FS_ATOMIC_STEP_TEMP_WRITE,
+    /* Intent is recorded in the journal */
+    SYS_FS_ATOMIC_STEP_JOURNAL_COMMIT,
+    /* Old file is removed */
+    SYS_FS_ATOMIC_STEP_TARGET_REMOVE,
+    /* Temporary file is renamed to the file name */
+    SYS_FS_ATOMIC_STEP_RENAME,
+    /* Journal is cleared */
+    SYS_FS_ATOMIC_STEP_JOURNAL_CLEAR
+} SYS_FS_ATOMIC_STEP;
+
 // ****************************************************************************
 // ****************************************************************************
 // Section: File System Abstraction Layer Interface Routines
@@ -944,8 +993,8 @@ void SYS_FS_Tasks
                        the mountName is used to refer the path for file. The
                        mount name has to be preceded by the string "/mnt/"
       filesystemtype - Native file system of SYS_FS_FILE_SYSTEM_TYPE type.
-      mountflags     - Mounting control flags. This parameter is reserved for
-                       future enhancements. Therefore, always pass zero.
+      mountflags     - Mounting control flags, zero or
+                       SYS_FS_MOUNT_NO_RECOVERY.
       data           - The data argument is interpreted by the different file
                        systems. This parameter is reserved for future
                        enhancements. Therefore, always pass NULL.
@@ -3323,6 +3372,68 @@ SYS_FS_RESULT SYS_FS_FileDirectoryRenameMove
     const char *newPath
 );
 
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileWriteAtomic
+    (
+        const char *fname,
+        const void *buffer,
+        size_t nbyte
+    );
+
+    Summary:
+      Replaces the content of a file so that it survives a power loss.
+
+    Description:
+      This function writes the buffer to a temporary file next to fname,
+      records the intent in a journal file at the root of the volume, then
+      removes fname and renames the temporary file to fname. After a power
+      loss, the file holds either its old or its new content: if the journal
+      still holds an intent when the volume is mounted, SYS_FS_Mount completes
+      the rename. Recovery reads the journal only, one sector.
+
+      The temporary file name is fname followed by
+      SYS_FS_ATOMIC_TEMP_SUFFIX. The journal, SYS_FS_ATOMIC_JOURNAL_NAME, is
+      a hidden system file.
+
+    Precondition:
+      The volume must be mounted. A relative fname is resolved from the root
+      of the volume during recovery, do not combine this function with
+      SYS_FS_DirectoryChange.
+
+    Parameters:
+      fname       - Name of the file to be written.
+      buffer      - New content of the file.
+      nbyte       - Size of the new content in bytes.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - The file holds the new content.
+      SYS_FS_RES_FAILURE - The file could not be written. It holds its old
+                           content, or the new one if the failure happened
+                           after the journal was written. The reason for the
+                           failure can be retrieved with SYS_FS_Error.
+
+    Example:
+      <code>
+        const char cfg[] = "{\"broker\":\"example.com\"}";
+
+        if (SYS_FS_FileWriteAtomic("cloud.json", cfg, strlen(cfg)) != SYS_FS_RES_SUCCESS)
+        {
+            
+        }
+      </code>
+
+    Remarks:
+      Writes are serialized. One file handle is used at a time.
+*/
+
+SYS_FS_RESULT SYS_FS_FileWriteAtomic
+(
+    const char *fname,
+    const void *buffer,
+    size_t nbyte
+);
+
 //******************************************************************************
 /* Function:
     SYS_FS_RESULT SYS_FS_DriveLabelSet
@@ -460,6 +460,8 @@ typedef struct
     void (*close)(DRV_HANDLE client);
     /* Task function of the media */
     void (*tasks)(SYS_MODULE_OBJ obj);
+    /* Function to write back data cached by the media, NULL if it has none */
+    void (*cacheFlush)(const DRV_HANDLE handle, SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE *commandHandle);
 
 } SYS_FS_MEDIA_FUNCTIONS;
 
@@ -683,6 +685,39 @@ SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE SYS_FS_MEDIA_MANAGER_SectorWrite
     uint32_t numSectors
 );
 
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_CacheFlush
+    (
+        uint16_t diskNo,
+        SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE *commandHandle
+    );
+
+    Summary:
+      Writes back the data cached by the specified media.
+
+    Description:
+      This function calls the cache flush function of the media driver, if
+      it has one. The request completes like a sector write.
+
+    Precondition:
+      None.
+
+    Parameters:
+      diskNo         - media number
+      commandHandle  - gets the buffer handle of the flush request
+
+    Returns:
+      false if the media does not cache writes, there is nothing to wait for.
+      true if a flush was requested, *commandHandle is then either a valid
+      handle or SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID on failure.
+*/
+bool SYS_FS_MEDIA_MANAGER_CacheFlush
+(
+    uint16_t diskNum,
+    SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE *commandHandle
+);
+
 //*****************************************************************************
 /* Function:
     bool SYS_FS_MEDIA_MANAGER_VolumePropertyGet
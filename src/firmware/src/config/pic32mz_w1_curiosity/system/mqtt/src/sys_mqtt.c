@@ -283,6 +283,14 @@ static void SysMqtt_Command_Process(int argc, char *argv[])
                 SYS_CONSOLE_PRINT("\n\rAutoReconnect: %d", g_asSysMqttHandle[instCnt].sCfgInfo.sBrokerConfig.autoConnect);
                 SYS_CONSOLE_PRINT("\n\rUsername: %s", g_asSysMqttHandle[instCnt].sCfgInfo.sBrokerConfig.username);
                 SYS_CONSOLE_PRINT("\n\rPassword: %s", g_asSysMqttHandle[instCnt].sCfgInfo.sBrokerConfig.password);
+#ifdef SYS_MQTT_PAHO
+                SYS_CONSOLE_PRINT("\n\rPubQueue: %d/%d (Sent: %d, InFlight: %d/%d)",
+                                  g_asSysMqttHandle[instCnt].uVendorInfo.sPahoInfo.sPubQueue.count,
+                                  SYS_MQTT_PAHO_PUB_QUEUE_LEN,
+                                  g_asSysMqttHandle[instCnt].uVendorInfo.sPahoInfo.sPubQueue.sent,
+                                  g_asSysMqttHandle[instCnt].uVendorInfo.sPahoInfo.sPubQueue.inFlight,
+                                  SYS_MQTT_PAHO_PUB_INFLIGHT_MAX);
+#endif
 
                 for (subCnt = 0; subCnt < SYS_MQTT_SUB_MAX_TOPICS; subCnt++)
                 {
@@ -719,3 +727,19 @@ int32_t SYS_MQTT_Publish(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *pubConfig
     return SYS_MQTT_FAILURE;
 }
 
+char *SYS_MQTT_PublishReserve(SYS_MODULE_OBJ obj, uint16_t *maxLen)
+{
+#ifdef SYS_MQTT_PAHO
+    return SYS_MQTT_Paho_PubReserve(obj, maxLen);
+#endif    
+    return NULL;
+}
+
+int32_t SYS_MQTT_PublishCommit(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *pubConfig, uint16_t message_len, uint16_t *msgId)
+{
+#ifdef SYS_MQTT_PAHO
+    return SYS_MQTT_Paho_PubCommit(obj, pubConfig, message_len, msgId);
+#endif    
+    return SYS_MQTT_FAILURE;
+}
+
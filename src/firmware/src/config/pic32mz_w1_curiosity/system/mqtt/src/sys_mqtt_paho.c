@@ -34,7 +34,6 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 #define SYS_MQTT_MAX_NUM_OF_INSTANCES  1
 extern SYS_MQTT_Handle g_asSysMqttHandle[SYS_MQTT_MAX_NUM_OF_INSTANCES];
-MQTTMessage g_sMqttMsg;
 
 extern uint8_t g_OmitPacketType;
 #define SYS_MQTT_DBG_OMIT_PKT_TYPE_KEEPALIVE    1
@@ -180,6 +179,205 @@ void SYS_MQTT_messageCallback(MessageData* data)
     }
 }
 
+static inline SYS_MQTT_PahoPubEntry *SYS_MQTT_PubQueueEntry(SYS_MQTT_PahoPubQueue *q, uint8_t offset)
+{
+    return &q->entry[(q->tail + offset) % SYS_MQTT_PAHO_PUB_QUEUE_LEN];
+}
+
+/* Callback registered with Paho SW to get the PUBACK/ PUBCOMP of the published messages */
+void SYS_MQTT_pubAckCallback(MQTTClient *c, unsigned short packetId)
+{
+    int32_t i = 0;
+
+    if (g_OmitPacketType == SYS_MQTT_DBG_OMIT_PKT_TYPE_PUBACK)
+    {
+        return; //This is test stub 
+    }
+
+    for (i = 0; i < SYS_MQTT_MAX_NUM_OF_INSTANCES; i++)
+    {
+        SYS_MQTT_Handle *hdl = &g_asSysMqttHandle[i];
+        SYS_MQTT_PahoPubQueue *q = &hdl->uVendorInfo.sPahoInfo.sPubQueue;
+        uint8_t j = 0;
+
+        if (c != &hdl->uVendorInfo.sPahoInfo.sPahoClient)
+        {
+            continue;
+        }
+
+        /* Match the Ack against the messages on the wire */
+        for (j = 0; j < q->sent; j++)
+        {
+            SYS_MQTT_PahoPubEntry *e = SYS_MQTT_PubQueueEntry(q, j);
+
+            if ((e->qos != 0) && (e->acked == 0) && (e->packetId == packetId))
+            {
+                e->acked = 1;
+
+                q->inFlight--;
+
+                SYS_MQTTDEBUG_DBG_PRINT(g_AppDebugHdl, MQTT_DATA, "Puback received (%d)\r\n", packetId);
+
+                /* Tell the Application that we have received the PUBACK */
+                if (hdl->callback_fn)
+                {
+                    hdl->callback_fn(SYS_MQTT_EVENT_MSG_PUBLISHED,
+                                     &e->msgId,
+                                     sizeof (e->msgId),
+                                     hdl->vCookie);
+                }
+
+                return;
+            }
+        }
+    }
+
+    SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Puback for unknown Packet Id (%d)\r\n", packetId);
+}
+
+/* Rewind the Publish Queue so that the messages not acked get sent again */
+static void SYS_MQTT_Paho_RewindPubQueue(SYS_MQTT_Handle *hdl)
+{
+    SYS_MQTT_PahoPubQueue *q = &hdl->uVendorInfo.sPahoInfo.sPubQueue;
+
+    q->sent = 0;
+
+    q->inFlight = 0;
+}
+
+/* Retire the acked messages, check for PUBACK timeout and send the queued 
+ * messages as long as the in-flight window allows */
+static void SYS_MQTT_Paho_ServicePubQueue(SYS_MQTT_Handle *hdl)
+{
+    SYS_MQTT_PahoPubQueue *q = &hdl->uVendorInfo.sPahoInfo.sPubQueue;
+    SYS_MQTT_PahoPubEntry *e = NULL;
+    uint8_t i = 0;
+    int rc = 0;
+
+    /* Free the entries at the tail which have been acked */
+    OSAL_SEM_Pend(&hdl->InstSemaphore, OSAL_WAIT_FOREVER);
+
+    while ((q->sent != 0) && (SYS_MQTT_PubQueueEntry(q, 0)->acked))
+    {
+        q->tail = (q->tail + 1) % SYS_MQTT_PAHO_PUB_QUEUE_LEN;
+
+        q->count--;
+
+        q->sent--;
+    }
+
+    OSAL_SEM_Post(&hdl->InstSemaphore);
+
+    /* The oldest message not acked decides the PUBACK timeout */
+    for (i = 0; i < q->sent; i++)
+    {
+        e = SYS_MQTT_PubQueueEntry(q, i);
+
+        if (e->acked)
+        {
+            continue;
+        }
+
+        if (SYS_TMR_TickCountGet() - e->sentTime > SYS_MQTT_TIMEOUT_CONST)
+        {
+            SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Puback Timed out (%d)\r\n", e->packetId);
+
+            if (hdl->callback_fn)
+            {
+                hdl->callback_fn(SYS_MQTT_EVENT_MSG_PUBACK_TO,
+                                 NULL,
+                                 0,
+                                 hdl->vCookie);
+            }
+
+            if ((rc = SYS_NET_CtrlMsg(hdl->netSrvcHdl,
+                                      SYS_NET_CTRL_MSG_DISCONNECT,
+                                      NULL, 0)) != SYS_NET_SUCCESS)
+            {
+                SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "SYS_NET_CtrlMsg() Failed (%d)\r\n", rc);
+
+                return;
+            }
+
+            SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_MQTT_DISCONNECTING);
+
+            return;
+        }
+
+        break;
+    }
+
+    /* Send the queued messages */
+    while (q->sent < q->count)
+    {
+        MQTTMessage sMqttMsg;
+
+        e = SYS_MQTT_PubQueueEntry(q, q->sent);
+
+        /* Already acked before a reconnect - nothing to resend */
+        if (e->acked)
+        {
+            q->sent++;
+
+            continue;
+        }
+
+        if ((e->qos != 0) && (q->inFlight >= SYS_MQTT_PAHO_PUB_INFLIGHT_MAX))
+        {
+            break;
+        }
+
+        memset(&sMqttMsg, 0, sizeof (sMqttMsg));
+
+        sMqttMsg.payload = e->message;
+
+        sMqttMsg.payloadlen = e->messageLength;
+
+        sMqttMsg.qos = (enum QoS)e->qos;
+
+        sMqttMsg.retained = e->retain;
+
+        rc = MQTTPublish(&(hdl->uVendorInfo.sPahoInfo.sPahoClient),
+                         e->topicName,
+                         &sMqttMsg);
+        if (rc != 0)
+        {
+            SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "MQTTPublish() Failed (%d)\r\n", rc);
+
+            if ((rc = SYS_NET_CtrlMsg(hdl->netSrvcHdl,
+                                      SYS_NET_CTRL_MSG_DISCONNECT,
+                                      NULL, 0)) != SYS_NET_SUCCESS)
+            {
+                SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "SYS_NET_CtrlMsg() Failed (%d)\r\n", rc);
+
+                return;
+            }
+
+            SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_MQTT_DISCONNECTING);
+
+            return;
+        }
+
+        /* Paho assigned the Packet Id for QoS1/2 */
+        e->packetId = sMqttMsg.id;
+
+        e->sentTime = SYS_TMR_TickCountGet();
+
+        if (e->qos == 0)
+        {
+            e->acked = 1;
+        }
+        else
+        {
+            q->inFlight++;
+        }
+
+        q->sent++;
+
+        SYS_MQTTDEBUG_DBG_PRINT(g_AppDebugHdl, MQTT_DATA, "Publish to Topic (%s) Id (%d)\r\n", e->topicName, e->packetId);
+    }
+}
+
 SYS_MODULE_OBJ SYS_MQTT_PAHO_Open(SYS_MQTT_Config *cfg,
                                   SYS_MQTT_CALLBACK fn,
                                   void *cookie)
@@ -245,6 +443,8 @@ SYS_MODULE_OBJ SYS_MQTT_PAHO_Open(SYS_MQTT_Config *cfg,
 
     hdl->netSrvcHdl = SYS_MODULE_OBJ_INVALID;
 
+    memset(&hdl->uVendorInfo.sPahoInfo.sPubQueue, 0, sizeof (hdl->uVendorInfo.sPahoInfo.sPubQueue));
+
     SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_LOWER_LAYER_DOWN);
 
     SYS_MQTTDEBUG_FN_EXIT_PRINT(g_AppDebugHdl, MQTT_CFG);
@@ -336,6 +536,8 @@ void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj)
                            hdl->uVendorInfo.sPahoInfo.recvbuf,
                            SYS_MQTT_PAHO_MAX_RX_BUFF_LEN);
 
+            hdl->uVendorInfo.sPahoInfo.sPahoClient.pubAckHandler = SYS_MQTT_pubAckCallback;
+
             firstConnect++;
         }
 
@@ -585,42 +787,6 @@ void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj)
     }
         break;
 
-        /* Waiting for Pub Ack */
-    case SYS_MQTT_STATUS_WAIT_FOR_MQTT_PUBACK:
-    {
-        /* Wait for the MQTT Publish Ack */
-        int rc = MQTTWaitForPublishAck(&(hdl->uVendorInfo.sPahoInfo.sPahoClient),
-                                       &g_sMqttMsg);
-
-        if (g_OmitPacketType == SYS_MQTT_DBG_OMIT_PKT_TYPE_PUBACK)
-        {
-            rc = FAILURE; //This is test stub 
-        }
-
-        if (rc == SUCCESS)
-        {
-            SYS_MQTT_ResetTimer(hdl);
-
-            SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_MQTT_CONNECTED);
-
-            SYS_MQTTDEBUG_DBG_PRINT(g_AppDebugHdl, MQTT_DATA, "Puback received\r\n", g_sMqttMsg.payload);
-
-            /* Tell the Application that we have received the PUBACK */
-            if (hdl->callback_fn)
-            {
-                hdl->callback_fn(SYS_MQTT_EVENT_MSG_PUBLISHED,
-                                 NULL,
-                                 0,
-                                 hdl->vCookie);
-            }
-        }
-        else
-        {
-            SYS_MQTT_ProcessTimeout(hdl, SYS_MQTT_EVENT_MSG_PUBACK_TO, SYS_MQTT_STATUS_MQTT_DISCONNECTING);
-        }
-    }
-        break;
-
         /* MQTT Connection Up */
     case SYS_MQTT_STATUS_MQTT_CONNECTED:
     {
@@ -629,6 +795,12 @@ void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj)
         if (rc == SUCCESS)
         {
         }
+
+        /* PUBACKs are matched while reading above; send what is queued */
+        if (hdl->eStatus == SYS_MQTT_STATUS_MQTT_CONNECTED)
+        {
+            SYS_MQTT_Paho_ServicePubQueue(hdl);
+        }
     }
         break;
 
@@ -654,6 +826,9 @@ void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj)
             hdl->sCfgInfo.sSubscribeConfig[i].entryValid = 0;
         }
 
+        /* Messages not acked are sent again once reconnected */
+        SYS_MQTT_Paho_RewindPubQueue(hdl);
+
         SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_MQTT_DISCONNECTED);
 
         /* Call the Application CB to give 'Disconnected' event */
@@ -685,6 +860,8 @@ void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj)
     case SYS_MQTT_STATUS_IDLE:
     case SYS_MQTT_STATUS_SOCK_CLIENT_CONNECTING:
     case SYS_MQTT_STATUS_SOCK_OPEN_FAILED:
+    /* Publishes are pipelined from the Connected state, see SYS_MQTT_Paho_ServicePubQueue() */
+    case SYS_MQTT_STATUS_WAIT_FOR_MQTT_PUBACK:
     {
     }
         break;
@@ -942,67 +1119,154 @@ int32_t SYS_MQTT_Paho_CtrlMsg(SYS_MODULE_OBJ obj, SYS_MQTT_CtrlMsgType eCtrlMsgT
     return SYS_MQTT_SUCCESS;
 }
 
-int32_t SYS_MQTT_Paho_SendMsg(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *psTopicCfg, char *message, uint16_t message_len)
+/* Hands out the message buffer of the next free queue entry. The entry is
+ * marked reserved until SYS_MQTT_Paho_PubCommit() so that it cannot be taken
+ * by another publisher meanwhile; one reservation at a time */
+char *SYS_MQTT_Paho_PubReserve(SYS_MODULE_OBJ obj, uint16_t *maxLen)
 {
     SYS_MQTT_Handle *hdl = (SYS_MQTT_Handle *) obj;
-    int rc = 0;
+    SYS_MQTT_PahoPubQueue *q = NULL;
 
     SYS_MQTTDEBUG_FN_ENTER_PRINT(g_AppDebugHdl, MQTT_DATA);
 
-    if (hdl->eStatus != SYS_MQTT_STATUS_MQTT_CONNECTED)
+    if ((hdl->eStatus == SYS_MQTT_STATUS_IDLE) ||
+            (hdl->eStatus == SYS_MQTT_STATUS_MQTT_DISCONNECTED))
     {
-        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Instance not in CONNECTED State (%d)\r\n", hdl->eStatus);
+        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Instance not Open/ Connecting (%d)\r\n", hdl->eStatus);
 
-        return SYS_MQTT_FAILURE;
+        return NULL;
+    }
+
+    /* Queue the message; SYS_MQTT_Paho_Task() sends it once connected */
+    q = &hdl->uVendorInfo.sPahoInfo.sPubQueue;
+
+    OSAL_SEM_Pend(&hdl->InstSemaphore, OSAL_WAIT_FOREVER);
+
+    if (q->count == SYS_MQTT_PAHO_PUB_QUEUE_LEN)
+    {
+        OSAL_SEM_Post(&hdl->InstSemaphore);
+
+        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Publish Queue Full\r\n");
+
+        return NULL;
     }
 
-    memset(&g_sMqttMsg, 0, sizeof (g_sMqttMsg));
+    if (q->reserved)
+    {
+        OSAL_SEM_Post(&hdl->InstSemaphore);
 
-    g_sMqttMsg.dup = 0;
+        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Publish Entry already Reserved\r\n");
 
-    g_sMqttMsg.id = 1;
+        return NULL;
+    }
 
-    g_sMqttMsg.payload = message;
+    q->reserved = 1;
+
+    OSAL_SEM_Post(&hdl->InstSemaphore);
+
+    if (maxLen != NULL)
+    {
+        *maxLen = SYS_MQTT_PAHO_PUB_MSG_MAX_LEN;
+    }
 
-    g_sMqttMsg.payloadlen = message_len;
+    /* The task only moves 'tail' and 'count' together: the entry stays put */
+    return SYS_MQTT_PubQueueEntry(q, q->count)->message;
+}
 
-    g_sMqttMsg.qos = psTopicCfg->qos;
+/* Queues the entry filled in after SYS_MQTT_Paho_PubReserve() and ends the 
+ * reservation. A message_len of 0 releases the entry without queuing it.
+ * The message Id is not the Packet Id: Paho picks a new one on every send */
+int32_t SYS_MQTT_Paho_PubCommit(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *psTopicCfg, uint16_t message_len, uint16_t *msgId)
+{
+    SYS_MQTT_Handle *hdl = (SYS_MQTT_Handle *) obj;
+    SYS_MQTT_PahoPubQueue *q = &hdl->uVendorInfo.sPahoInfo.sPubQueue;
+    SYS_MQTT_PahoPubEntry *e = NULL;
 
-    g_sMqttMsg.retained = psTopicCfg->retain;
+    OSAL_SEM_Pend(&hdl->InstSemaphore, OSAL_WAIT_FOREVER);
 
-    rc = MQTTPublish(&(hdl->uVendorInfo.sPahoInfo.sPahoClient),
-                     psTopicCfg->topicName,
-                     &g_sMqttMsg);
-    if (rc != 0)
+    if (!q->reserved)
     {
-        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "MQTTPublish() Failed (%d)\r\n", rc);
+        OSAL_SEM_Post(&hdl->InstSemaphore);
 
-        if ((rc = SYS_NET_CtrlMsg(hdl->netSrvcHdl,
-                                  SYS_NET_CTRL_MSG_DISCONNECT,
-                                  NULL, 0)) != SYS_NET_SUCCESS)
-        {
-            SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "SYS_NET_CtrlMsg() Failed (%d)\r\n", rc);
+        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Commit without a Reserve\r\n");
 
-            return SYS_MQTT_FAILURE;
-        }
+        return SYS_MQTT_FAILURE;
+    }
+
+    q->reserved = 0;
 
-        SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_MQTT_DISCONNECTING);
+    if ((message_len == 0) ||
+            (message_len > SYS_MQTT_PAHO_PUB_MSG_MAX_LEN) ||
+            (strlen(psTopicCfg->topicName) >= SYS_MQTT_TOPIC_NAME_MAX_LEN))
+    {
+        OSAL_SEM_Post(&hdl->InstSemaphore);
+
+        if (message_len != 0)
+        {
+            SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Message too long (%d)\r\n", message_len);
+        }
 
         return SYS_MQTT_FAILURE;
     }
 
-    SYS_MQTT_StartTimer(hdl, SYS_MQTT_TIMEOUT_CONST);
+    e = SYS_MQTT_PubQueueEntry(q, q->count);
+
+    strcpy(e->topicName, psTopicCfg->topicName);
+
+    e->messageLength = message_len;
+
+    e->qos = psTopicCfg->qos;
 
-    if (psTopicCfg->qos != 0)
+    e->retain = psTopicCfg->retain;
+
+    e->acked = 0;
+
+    e->packetId = 0;
+
+    /* 0 is never handed out */
+    if (++q->lastMsgId == 0)
+    {
+        q->lastMsgId = 1;
+    }
+
+    e->msgId = q->lastMsgId;
+
+    if (msgId != NULL)
     {
-        SYS_MQTT_SetInstStatus(hdl, SYS_MQTT_STATUS_WAIT_FOR_MQTT_PUBACK);
+        *msgId = e->msgId;
     }
 
-    SYS_MQTTDEBUG_DBG_PRINT(g_AppDebugHdl, MQTT_DATA, "Publish to Topic (%s)\r\n", psTopicCfg->topicName);
+    q->count++;
+
+    OSAL_SEM_Post(&hdl->InstSemaphore);
+
+    SYS_MQTTDEBUG_DBG_PRINT(g_AppDebugHdl, MQTT_DATA, "Queued for Topic (%s)\r\n", psTopicCfg->topicName);
 
     return SYS_MQTT_SUCCESS;
 }
 
+int32_t SYS_MQTT_Paho_SendMsg(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *psTopicCfg, char *message, uint16_t message_len)
+{
+    char *buf = NULL;
+
+    if (message_len > SYS_MQTT_PAHO_PUB_MSG_MAX_LEN)
+    {
+        SYS_MQTTDEBUG_ERR_PRINT(g_AppDebugHdl, MQTT_DATA, "Message too long (%d)\r\n", message_len);
+
+        return SYS_MQTT_FAILURE;
+    }
+
+    buf = SYS_MQTT_Paho_PubReserve(obj, NULL);
+    if (buf == NULL)
+    {
+        return SYS_MQTT_FAILURE;
+    }
+
+    memcpy(buf, message, message_len);
+
+    return SYS_MQTT_Paho_PubCommit(obj, psTopicCfg, message_len, NULL);
+}
+
 SYS_MODULE_OBJ SYS_MQTT_Paho_GetNetHdlFromNw(Network* n)
 {
     int32_t i = 0;
@@ -1031,6 +1295,12 @@ void SYS_MQTT_Paho_Close(SYS_MODULE_OBJ obj)
 #endif    
     SYS_NET_Close(hdl->netSrvcHdl);
 
+    hdl->netSrvcHdl = SYS_MODULE_OBJ_INVALID;
+
+    /* Release the instance, SYS_MQTT_Connect() may be called again */
+    OSAL_SEM_Delete(&hdl->InstSemaphore);
+
+    SYS_MQTT_FreeHandle(hdl);
 }
 
 #endif //SYS_MQTT_PAHO
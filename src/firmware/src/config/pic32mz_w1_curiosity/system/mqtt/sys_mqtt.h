@@ -334,7 +334,8 @@ typedef enum
     //MQTT Client UnSubscribed from a Grp
     SYS_MQTT_EVENT_MSG_UNSUBSCRIBED,
 
-    //MQTT Client Published to a Grp	
+    //MQTT Client Published to a Grp, PUBACK received. data points to the 
+    //uint16_t message Id returned by SYS_MQTT_PublishCommit()
     SYS_MQTT_EVENT_MSG_PUBLISHED,
 
     //MQTT Client ConnAck TimeOut
@@ -527,6 +528,83 @@ SYS_MQTT_STATUS SYS_MQTT_GetStatus(SYS_MODULE_OBJ obj);
  */
 int32_t SYS_MQTT_Publish(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *psPubCfg, char *message, uint16_t message_len);
 
+// *****************************************************************************
+/* Function:
+    char *SYS_MQTT_PublishReserve(SYS_MODULE_OBJ obj, uint16_t *maxLen);
+
+  Summary:
+      Returns a buffer in the publish queue for the message to be built in.
+
+   Description:
+                This function lets the user serialize a message straight into
+                the publish queue of the service instead of passing a copy to
+                SYS_MQTT_Publish(). The queue entry stays reserved until
+                SYS_MQTT_PublishCommit() is called; only one entry can be 
+                reserved at a time. The message is still copied into the MQTT 
+                packet when it is sent.
+  
+  Precondition:
+       SYS_MQTT_Connect should have been called before calling this function
+
+  Parameters:
+       obj  - SYS MQTT object handle, returned from SYS_MQTT_Connect <br>
+           maxLen		- if not NULL, receives the size of the buffer <br>
+	   	     
+   Returns:
+                Pointer to the message buffer, NULL if the instance is not 
+                connecting/ connected, the publish queue is full or an entry 
+                is already reserved. 
+                SYS_MQTT_PublishCommit() must not be called when NULL is returned.
+
+   Example:
+       <code>
+           uint16_t maxLen;
+           char *msg = SYS_MQTT_PublishReserve(objSysMqtt, &maxLen);
+           
+           if (msg != NULL)
+           {
+               memcpy(msg, "80.17", 5);
+               SYS_MQTT_PublishCommit(objSysMqtt, &sTopicCfg, 5, NULL);
+           }
+                </code>
+
+ */
+char *SYS_MQTT_PublishReserve(SYS_MODULE_OBJ obj, uint16_t *maxLen);
+
+// *****************************************************************************
+/* Function:
+    int32_t SYS_MQTT_PublishCommit(SYS_MODULE_OBJ obj, 
+                        SYS_MQTT_PublishTopicCfg  *psPubCfg, uint16_t message_len,
+                        uint16_t *msgId);
+
+  Summary:
+      Queues the message built in the buffer from SYS_MQTT_PublishReserve().
+
+   Description:
+                This function completes a SYS_MQTT_PublishReserve() and 
+                releases the instance. A message_len of 0 releases the buffer 
+                without publishing anything.
+  
+  Precondition:
+       SYS_MQTT_PublishReserve should have returned a buffer
+
+  Parameters:
+       obj  - SYS MQTT object handle, returned from SYS_MQTT_Connect <br>
+           psPubCfg		- valid pointer to the Topic details on which to Publish <br>
+           message_len  - Length of the message written to the buffer <br>
+           msgId        - if not NULL, receives the Id the PUBACK of the message 
+                          is reported with in SYS_MQTT_EVENT_MSG_PUBLISHED. It 
+                          stays the same when the message is resent after a 
+                          reconnect. <br>
+	   	     
+   Returns:
+                SYS_MQTT_SUCCESS - Indicates that the message was queued
+                SYS_MQTT_FAILURE - Indicates that the Request failed or was cancelled,
+                                   or that no entry was reserved
+
+ */
+int32_t SYS_MQTT_PublishCommit(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg *psPubCfg, uint16_t message_len, uint16_t *msgId);
+
 
 // *****************************************************************************
 /* Function:
@@ -686,7 +764,8 @@ SYS_MODULE_OBJ SYS_MQTT_Connect(SYS_MQTT_Config *cfg, SYS_MQTT_CALLBACK fn, void
                 </code>
 
   Remarks:
-       None.
+       The handle is released and must not be used afterwards. A new
+       connection, e.g. to another broker, is opened with SYS_MQTT_Connect.
  */
 void SYS_MQTT_Disconnect(SYS_MODULE_OBJ obj);
 
@@ -33,6 +33,47 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 #define SYS_MQTT_PAHO_MAX_TX_BUFF_LEN  1500
 #define SYS_MQTT_PAHO_MAX_RX_BUFF_LEN  1500
+
+/* Number of messages SYS_MQTT_Paho_SendMsg() can queue before it fails */
+#ifndef SYS_MQTT_PAHO_PUB_QUEUE_LEN
+#define SYS_MQTT_PAHO_PUB_QUEUE_LEN     8
+#endif
+
+/* Number of QoS1/2 PUBLISHes allowed on the wire without a PUBACK */
+#ifndef SYS_MQTT_PAHO_PUB_INFLIGHT_MAX
+#define SYS_MQTT_PAHO_PUB_INFLIGHT_MAX  4
+#endif
+
+/* Largest message payload that can be queued */
+#ifndef SYS_MQTT_PAHO_PUB_MSG_MAX_LEN
+#define SYS_MQTT_PAHO_PUB_MSG_MAX_LEN   256
+#endif
+
+typedef struct {
+    char            topicName[SYS_MQTT_TOPIC_NAME_MAX_LEN];
+    char            message[SYS_MQTT_PAHO_PUB_MSG_MAX_LEN];
+    uint16_t        messageLength;
+    uint8_t         qos;
+    uint8_t         retain;
+    uint8_t         acked;      /* PUBACK received (or QoS0 sent) */
+    uint16_t        msgId;      /* Id given by SYS_MQTT_PublishCommit(), kept when resent */
+    unsigned short  packetId;   /* Id used on the wire, valid once sent */
+    uint32_t        sentTime;   /* Tick count when the PUBLISH was sent */
+} SYS_MQTT_PahoPubEntry;
+
+/* Ring of messages waiting to be sent or acknowledged. Entries from 'tail'
+ * onwards: the first 'sent' are on the wire, the rest up to 'count' are
+ * still waiting to be sent */
+typedef struct {
+    SYS_MQTT_PahoPubEntry   entry[SYS_MQTT_PAHO_PUB_QUEUE_LEN];
+    uint8_t                 tail;
+    uint8_t                 count;
+    uint8_t                 sent;
+    uint8_t                 inFlight;   /* sent QoS1/2 entries not yet acked */
+    uint16_t                lastMsgId;
+    uint8_t                 reserved;   /* entry at 'count' handed out by SYS_MQTT_PublishReserve() */
+} SYS_MQTT_PahoPubQueue;
+
 typedef struct {
     Network sPahoNetwork;
     MQTTClient sPahoClient;
@@ -40,6 +81,7 @@ typedef struct {
  	SYS_MQTT_PublishConfig   sPubSubCfgInProgress;
 	unsigned char   sendbuf[SYS_MQTT_PAHO_MAX_TX_BUFF_LEN];
     unsigned char   recvbuf[SYS_MQTT_PAHO_MAX_RX_BUFF_LEN];
+    SYS_MQTT_PahoPubQueue   sPubQueue;
 } SYS_MQTT_PahoInfo;
 
 typedef struct {
@@ -146,6 +188,8 @@ SYS_MODULE_OBJ SYS_MQTT_PAHO_Open(SYS_MQTT_Config *cfg,
 void SYS_MQTT_Paho_Task(SYS_MODULE_OBJ obj);
 int32_t	SYS_MQTT_Paho_CtrlMsg(SYS_MODULE_OBJ obj, SYS_MQTT_CtrlMsgType eCtrlMsgType, void *data, uint16_t len);
 int32_t	SYS_MQTT_Paho_SendMsg(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg  *psTopicCfg, char *message, uint16_t message_len);
+char *SYS_MQTT_Paho_PubReserve(SYS_MODULE_OBJ obj, uint16_t *maxLen);
+int32_t	SYS_MQTT_Paho_PubCommit(SYS_MODULE_OBJ obj, SYS_MQTT_PublishTopicCfg  *psTopicCfg, uint16_t message_len, uint16_t *msgId);
 SYS_MODULE_OBJ SYS_MQTT_Paho_GetNetHdlFromNw(Network* n);
 void SYS_MQTT_Paho_Close(SYS_MODULE_OBJ obj);
 SYS_MODULE_OBJ SYS_MQTT_GetHandleFromPaho(Network* n);
@@ -52,6 +52,9 @@ typedef struct
     NET_PRES_SKT_T sock_type;
     IP_ADDRESS_TYPE addr_type;
     SYS_NET_TimerInfo timerInfo;
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+    uint8_t dnsCache; /* SYS_NET_DNS_CACHE_xxx; use of the last known good server address */
+#endif
 } SYS_NET_Handle;
 
 static SYS_NET_Handle g_asSysNetHandle[SYS_NET_MAX_NUM_OF_SOCKETS];
@@ -63,6 +66,31 @@ bool SYS_NET_IsLinkIpv6AddrAvailable(SYS_NET_Handle *hdl);
 bool g_bIpv6DnsResolve = true;
 #endif
 
+#ifdef SYS_NET_RX_SIGNAL_HOOK
+/* Configuration supplied hook, invoked from the TCP/IP task context whenever
+   a SYS_NET socket has data available, so that the task reading it does not
+   have to poll */
+extern void SYS_NET_RX_SIGNAL_HOOK(void);
+#endif
+
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+/* Configuration supplied store for the last known good IPv4 address of the
+   server: LOAD returns false if there is none for host_name, STORE is given
+   the address and its DNS TTL (seconds) once the name is resolved, INVALIDATE
+   is called when the connection to the loaded address failed. The hooks run
+   in the SYS_NET task context and must not block. */
+extern bool SYS_NET_DNS_CACHE_LOAD_HOOK(const char *host_name, IPV4_ADDR *addr);
+extern void SYS_NET_DNS_CACHE_STORE_HOOK(const char *host_name, IPV4_ADDR addr, uint32_t ttl);
+extern void SYS_NET_DNS_CACHE_INVALIDATE_HOOK(const char *host_name);
+
+#define SYS_NET_DNS_CACHE_IDLE      0 /* next resolution may use the cached address */
+#define SYS_NET_DNS_CACHE_IN_USE    1 /* connecting to the cached address, name resolution pending */
+#define SYS_NET_DNS_CACHE_SKIP      2 /* cached address failed; use DNS until connected */
+
+/* Time allowed to connect to a cached address before falling back to DNS */
+#define SYS_NET_DNS_CACHE_CONNECT_TIMEOUT 5 //Sec
+#endif
+
 #ifdef SYS_NET_ENABLE_DEBUG_PRINT
 SYS_APPDEBUG_CONFIG g_sNetAppDbgCfg;
 #endif
@@ -652,6 +680,90 @@ static bool SYS_NET_Ll_Link_Status(SYS_NET_Handle *hdl)
     return true;
 }
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+static uint32_t SYS_NET_DNS_TtlGet(const char *host_name)
+{
+    char name[SYS_NET_MAX_HOSTNAME_LEN];
+    TCPIP_DNS_ENTRY_QUERY query;
+    int i;
+
+    memset(&query, 0, sizeof (query));
+    query.hostName = name;
+    query.nameLen = sizeof (name);
+    for (i = 0; i < TCPIP_DNS_CLIENT_CACHE_ENTRIES; i++)
+    {
+        if ((TCPIP_DNS_EntryQuery(&query, i) == TCPIP_DNS_RES_OK) &&
+            (strcmp(name, host_name) == 0))
+        {
+            return query.ttlTime;
+        }
+    }
+
+    return 0;
+}
+
+static void SYS_NET_DNS_CacheStore(SYS_NET_Handle *hdl, IPV4_ADDR addr)
+{
+    SYS_NET_DNS_CACHE_STORE_HOOK(hdl->cfg_info.host_name, addr, SYS_NET_DNS_TtlGet(hdl->cfg_info.host_name));
+}
+
+/* Collects the result of the name resolution started in the background while
+   connecting to the cached address */
+static void SYS_NET_DNS_CachePoll(SYS_NET_Handle *hdl)
+{
+    IPV4_ADDR hostIPv4;
+    TCPIP_DNS_RESULT result;
+
+    if (hdl->dnsCache == SYS_NET_DNS_CACHE_SKIP)
+    {
+        if (hdl->status == SYS_NET_STATUS_CONNECTED)
+        {
+            hdl->dnsCache = SYS_NET_DNS_CACHE_IDLE;
+        }
+        return;
+    }
+
+    if (hdl->dnsCache != SYS_NET_DNS_CACHE_IN_USE)
+    {
+        return;
+    }
+
+    hostIPv4.Val = 0;
+    result = TCPIP_DNS_IsNameResolved(hdl->cfg_info.host_name, &hostIPv4, NULL);
+    if (result == TCPIP_DNS_RES_PENDING)
+    {
+        return;
+    }
+
+    if ((result == TCPIP_DNS_RES_OK) && (hostIPv4.Val != 0))
+    {
+        SYS_NETDEBUG_DBG_PRINT(g_NetAppDbgHdl, NET_CFG, "Background DNS Resolved\r\n");
+
+        SYS_NET_DNS_CacheStore(hdl, hostIPv4);
+    }
+
+    hdl->dnsCache = SYS_NET_DNS_CACHE_IDLE;
+}
+
+/* Returns true if the failed connection used the cached address; the caller
+   then resolves the name again instead of reporting the failure */
+static bool SYS_NET_DNS_CacheFailed(SYS_NET_Handle *hdl)
+{
+    if (hdl->dnsCache != SYS_NET_DNS_CACHE_IN_USE)
+    {
+        return false;
+    }
+
+    SYS_NETDEBUG_ERR_PRINT(g_NetAppDbgHdl, NET_CFG, "Cached Server Address failed; Resolving DNS\r\n");
+
+    SYS_NET_DNS_CACHE_INVALIDATE_HOOK(hdl->cfg_info.host_name);
+
+    hdl->dnsCache = SYS_NET_DNS_CACHE_SKIP;
+
+    return true;
+}
+#endif
+
 TCPIP_DNS_RESULT SYS_NET_DNS_Resolve(SYS_NET_Handle *hdl)
 {
 #ifdef TCPIP_STACK_USE_IPV6
@@ -694,6 +806,23 @@ TCPIP_DNS_RESULT SYS_NET_DNS_Resolve(SYS_NET_Handle *hdl)
         return result;
     }
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+    /* Connect to the last known good address right away; the name resolution
+       started above goes on in the background and refreshes the cache */
+    if ((hdl->dnsCache == SYS_NET_DNS_CACHE_IDLE) &&
+        SYS_NET_DNS_CACHE_LOAD_HOOK(hdl->cfg_info.host_name, &hdl->server_ip.v4Add))
+    {
+        hdl->addr_type = IP_ADDRESS_TYPE_IPV4;
+        hdl->dnsCache = (result < 0) ? SYS_NET_DNS_CACHE_SKIP : SYS_NET_DNS_CACHE_IN_USE;
+
+        SYS_NETDEBUG_INFO_PRINT(g_NetAppDbgHdl, NET_CFG, "Using Cached Server Address for %s\r\n", hdl->cfg_info.host_name);
+
+        SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_DNS_RESOLVED);
+
+        return result;
+    }
+#endif
+
     /* If Host name could not be resolved */
     if (result < 0)
     {
@@ -776,6 +905,13 @@ TCPIP_DNS_RESULT SYS_NET_IPV6_DNS_Resolve(SYS_NET_Handle *hdl)
 void SYS_NET_NetPres_Signal(NET_PRES_SKT_HANDLE_T handle, NET_PRES_SIGNAL_HANDLE hNet,
                             uint16_t sigType, const void* param)
 {
+#ifdef SYS_NET_RX_SIGNAL_HOOK
+    if (sigType & TCPIP_TCP_SIGNAL_RX_DATA)
+    {
+        SYS_NET_RX_SIGNAL_HOOK();
+    }
+#endif
+
     /* Peer sent a FIN to close the connection */
     if (sigType & TCPIP_TCP_SIGNAL_RX_FIN)
     {
@@ -894,6 +1030,10 @@ SYS_MODULE_OBJ SYS_NET_Open(SYS_NET_Config *cfg, SYS_NET_CALLBACK net_cb, void *
 
     hdl->callback_fn = net_cb;
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+    hdl->dnsCache = SYS_NET_DNS_CACHE_IDLE;
+#endif
+
 #ifdef SYS_NET_SUPP_INTF_WIFI
     /* Validate for Interface */
     if (hdl->cfg_info.intf != SYS_NET_INTF_WIFI)
@@ -983,6 +1123,10 @@ static void SYS_NET_Client_Task(SYS_NET_Handle *hdl)
         return;
     }
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+    SYS_NET_DNS_CachePoll(hdl);
+#endif
+
     switch (hdl->status)
     {
         /* Lower Layer is Down */
@@ -1030,6 +1174,9 @@ static void SYS_NET_Client_Task(SYS_NET_Handle *hdl)
             {
                 hdl->addr_type = IP_ADDRESS_TYPE_IPV4;
                 hdl->server_ip.v4Add.Val = hostIPv4.Val;
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+                SYS_NET_DNS_CacheStore(hdl, hostIPv4);
+#endif
                 SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_DNS_RESOLVED);
             }
 #ifdef TCPIP_STACK_USE_IPV6
@@ -1120,6 +1267,13 @@ static void SYS_NET_Client_Task(SYS_NET_Handle *hdl)
             SYS_NETDEBUG_ERR_PRINT(g_NetAppDbgHdl, NET_CFG, "Handler Registration failed!\r\n");
         }
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+        if (hdl->dnsCache == SYS_NET_DNS_CACHE_IN_USE)
+        {
+            SYS_NET_StartTimer(hdl, SYS_NET_DNS_CACHE_CONNECT_TIMEOUT * SYS_TMR_TickCounterFrequencyGet());
+        }
+#endif
+
         SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_CLIENT_CONNECTING);
     }
         break;
@@ -1155,9 +1309,26 @@ static void SYS_NET_Client_Task(SYS_NET_Handle *hdl)
     {
         if ((!NET_PRES_SocketIsConnected(hdl->socket)) || (!SYS_NET_Ll_Link_Status(hdl)))
         {
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+            /* The cached address may be stale; give up on it and resolve */
+            if ((hdl->dnsCache == SYS_NET_DNS_CACHE_IN_USE) && (SYS_NET_TimerExpired(hdl) == true))
+            {
+                SYS_NET_ResetTimer(hdl);
+
+                NET_PRES_SocketClose(hdl->socket);
+
+                SYS_NET_DNS_CacheFailed(hdl);
+
+                SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_LOWER_LAYER_DOWN);
+            }
+#endif
             break;
         }
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+        SYS_NET_ResetTimer(hdl);
+#endif
+
 #ifdef SYS_NET_TLS_ENABLED
         /* Check if it is a secured connection */
         if (hdl->cfg_info.enable_tls)
@@ -1352,6 +1523,17 @@ static void SYS_NET_Client_Task(SYS_NET_Handle *hdl)
         /* Close socket */
         NET_PRES_SocketClose(hdl->socket);
 
+#ifdef SYS_NET_DNS_CACHE_LOAD_HOOK
+        /* A stale address may now belong to another server; retry with DNS
+           before reporting the failure */
+        if (SYS_NET_DNS_CacheFailed(hdl))
+        {
+            SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_LOWER_LAYER_DOWN);
+
+            break;
+        }
+#endif
+
         SYS_NET_SetInstStatus(hdl, SYS_NET_STATUS_DISCONNECTED);
 
         /* Call the Application CB to give 'SSL Negotiation Failed' event */
@@ -55,6 +55,89 @@
 #include "sys_tasks.h"
 
 
+// *****************************************************************************
+// *****************************************************************************
+// Section: Application task wakeup control
+// *****************************************************************************
+// *****************************************************************************
+APP_RTOS_TASK_STATS appRtosTaskStats[APP_RTOS_TASK_COUNT] =
+{
+    [APP_RTOS_TASK_APP]         = { "APP_Tasks", 0, 0 },
+    [APP_RTOS_TASK_APP_WIFI]    = { "APP_WIFI_Tasks", 0, 0 },
+    [APP_RTOS_TASK_MSD_APP]     = { "MSD_APP_Tasks", 0, 0 },
+    [APP_RTOS_TASK_APP_CONTROL] = { "APP_CONTROL_Tasks", 0, 0 },
+    [APP_RTOS_TASK_MQTT_APP]    = { "MQTT_APP_Tasks", 0, 0 },
+    [APP_RTOS_TASK_NET_PRES]    = { "NET_PRES_Tasks", 0, 0 },
+    [APP_RTOS_TASK_TCPIP]       = { "TCPIP_STACK_Task", 0, 0 },
+    [APP_RTOS_TASK_SYS_WIFI]    = { "SYS_WIFI_Tasks", 0, 0 },
+    [APP_RTOS_TASK_SYS_FS]      = { "SYS_FS_Tasks", 0, 0 },
+    [APP_RTOS_TASK_SYS_CMD]     = { "SYS_CMD_Tasks", 0, 0 },
+    [APP_RTOS_TASK_USB_DEVICE]  = { "USB_DEVICE_Tasks", 0, 0 },
+    [APP_RTOS_TASK_DRV_MEMORY]  = { "DRV_MEMORY_Tasks", 0, 0 },
+};
+
+/* Wakeup of a system task, see APP_RTOS_TASK_ID */
+#define APP_RTOS_TaskWoken(id)      (appRtosTaskStats[(id)].wakeups++)
+
+#ifdef APP_RTOS_EVENT_DRIVEN
+static volatile bool appRtosPollRequest[APP_RTOS_TASK_COUNT];
+
+void APP_RTOS_Notify(TaskHandle_t xTask)
+{
+    if (xTask != NULL)
+    {
+        xTaskNotifyGive(xTask);
+    }
+}
+
+void APP_RTOS_NotifyFromISR(TaskHandle_t xTask)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (xTask != NULL)
+    {
+        vTaskNotifyGiveFromISR(xTask, &xHigherPriorityTaskWoken);
+        portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+    }
+}
+
+void APP_RTOS_PollRequest(APP_RTOS_TASK_ID id)
+{
+    appRtosPollRequest[id] = true;
+}
+
+void APP_RTOS_NetRxSignal(void)
+{
+    /* The only SYS_NET client is the MQTT service owned by MQTT_APP */
+    APP_RTOS_Notify(xMQTT_APP_Tasks);
+}
+#endif
+
+/* Block an application task until its next service slot. In the polled
+   configuration this is the fixed period; in the event driven configuration
+   the task sleeps until notified, falling back to the period while it has
+   polled work pending and to APP_RTOS_EVENT_TIMEOUT otherwise. */
+static void APP_RTOS_TaskWait(APP_RTOS_TASK_ID id, uint32_t delayMs)
+{
+#ifdef APP_RTOS_EVENT_DRIVEN
+    uint32_t timeoutMs = APP_RTOS_EVENT_TIMEOUT;
+
+    if (appRtosPollRequest[id])
+    {
+        appRtosPollRequest[id] = false;
+        timeoutMs = delayMs;
+    }
+
+    if (ulTaskNotifyTake(pdTRUE, timeoutMs / portTICK_PERIOD_MS) != 0U)
+    {
+        appRtosTaskStats[id].notified++;
+    }
+#else
+    vTaskDelay(delayMs / portTICK_PERIOD_MS);
+#endif
+    appRtosTaskStats[id].wakeups++;
+}
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: RTOS "Tasks" Routine
@@ -68,7 +151,7 @@ static void lAPP_Tasks(  void *pvParameters  )
     while(true)
     {
         APP_Tasks();
-        vTaskDelay(100U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWait(APP_RTOS_TASK_APP, APP_RTOS_DELAY);
     }
 }
 /* Handle for the APP_WIFI_Tasks. */
@@ -79,7 +162,7 @@ static void lAPP_WIFI_Tasks(  void *pvParameters  )
     while(true)
     {
         APP_WIFI_Tasks();
-        vTaskDelay(50U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWait(APP_RTOS_TASK_APP_WIFI, APP_WIFI_RTOS_DELAY);
     }
 }
 /* Handle for the MSD_APP_Tasks. */
@@ -90,7 +173,7 @@ static void lMSD_APP_Tasks(  void *pvParameters  )
     while(true)
     {
         MSD_APP_Tasks();
-        vTaskDelay(50U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWait(APP_RTOS_TASK_MSD_APP, MSD_APP_RTOS_DELAY);
     }
 }
 /* Handle for the APP_CONTROL_Tasks. */
@@ -101,7 +184,7 @@ static void lAPP_CONTROL_Tasks(  void *pvParameters  )
     while(true)
     {
         APP_CONTROL_Tasks();
-        vTaskDelay(100U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWait(APP_RTOS_TASK_APP_CONTROL, APP_CONTROL_RTOS_DELAY);
     }
 }
 /* Handle for the MQTT_APP_Tasks. */
@@ -112,7 +195,7 @@ static void lMQTT_APP_Tasks(  void *pvParameters  )
     while(true)
     {
         MQTT_APP_Tasks();
-        vTaskDelay(50U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWait(APP_RTOS_TASK_MQTT_APP, MQTT_APP_RTOS_DELAY);
     }
 }
 
@@ -122,7 +205,10 @@ void _NET_PRES_Tasks(  void *pvParameters  )
     while(1)
     {
         NET_PRES_Tasks(sysObj.netPres);
+        /* Polled in the event driven configuration too: it drives the TLS
+           handshakes, which have no completion event to block on */
         vTaskDelay(1 / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_NET_PRES);
     }
 }
 
@@ -133,6 +219,7 @@ static void lSYS_FS_Tasks(  void *pvParameters  )
     {
         SYS_FS_Tasks();
         vTaskDelay(10U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_SYS_FS);
     }
 }
 
@@ -146,13 +233,25 @@ void _DRV_BA414E_Tasks(  void *pvParameters  )
     }
 }
 
+static TaskHandle_t xUSB_DEVICE_Tasks;
+
+void APP_RTOS_UsbDeviceWake(void)
+{
+    if (xUSB_DEVICE_Tasks != NULL)
+    {
+        xTaskNotifyGive(xUSB_DEVICE_Tasks);
+    }
+}
+
 static void F_USB_DEVICE_Tasks(  void *pvParameters  )
 {
     while(true)
     {
                 /* USB Device layer tasks routine */
         USB_DEVICE_Tasks(sysObj.usbDevObject0);
-        vTaskDelay(10U / portTICK_PERIOD_MS);
+        /* Woken up early when a media transfer of the MSD function completes */
+        (void) ulTaskNotifyTake(pdTRUE, 10U / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_USB_DEVICE);
     }
 }
 
@@ -161,7 +260,8 @@ static void lDRV_MEMORY_0_Tasks(  void *pvParameters  )
     while(true)
     {
         DRV_MEMORY_Tasks(sysObj.drvMemory0);
-        vTaskDelay(DRV_MEMORY_RTOS_DELAY_IDX0 / portTICK_PERIOD_MS);
+        DRV_MEMORY_TasksWait(sysObj.drvMemory0, DRV_MEMORY_RTOS_DELAY_IDX0);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_DRV_MEMORY);
     }
 }
 
@@ -173,6 +273,7 @@ void _TCPIP_STACK_Task(  void *pvParameters  )
     {
         TCPIP_STACK_Task(sysObj.tcpip);
         vTaskDelay(4 / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_TCPIP);
     }
 }
 
@@ -183,6 +284,7 @@ void lSYS_CMD_Tasks(  void *pvParameters  )
     {
         SYS_CMD_Tasks();
         vTaskDelay(10 / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_SYS_CMD);
     }
 }
 
@@ -211,6 +313,7 @@ void _SYS_WIFI_Task(  void *pvParameters  )
     {
         SYS_WIFI_Tasks(sysObj.syswifi);
         vTaskDelay(4 / portTICK_PERIOD_MS);
+        APP_RTOS_TaskWoken(APP_RTOS_TASK_SYS_WIFI);
     }
 }
 
@@ -302,7 +405,7 @@ void SYS_Tasks ( void )
         1024,
         (void*)NULL,
         1,
-        (TaskHandle_t*)NULL
+        &xUSB_DEVICE_Tasks
     );
 
 
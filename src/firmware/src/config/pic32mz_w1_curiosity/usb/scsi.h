@@ -93,7 +93,8 @@ typedef enum
     SCSI_READ_10        = 0x28,
     SCSI_WRITE_10       = 0x2A,
     SCSI_STOP_START     = 0x1B,
-    SCSI_VERIFY         = 0x2F
+    SCSI_VERIFY         = 0x2F,
+    SCSI_SYNCHRONIZE_CACHE = 0x35
 
 } SCSI_BLOCK_COMMAND;
 
@@ -56,6 +56,26 @@ static USB_DEVICE_MSD_INSTANCE gUSBDeviceMSDInstance [USB_DEVICE_INSTANCES_NUMBE
 
 static SCSI_SENSE_DATA gUSBDeviceMSDSenseData[USB_DEVICE_MSD_LUNS_NUMBER] USB_ALIGN;
 
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_HOOK
+/* Configuration supplied hook, invoked when a WRITE(10) is submitted to the
+ * media and again when it completed, so that anything caching the media
+ * contents on the device side drops its copy */
+extern void USB_DEVICE_MSD_MEDIA_WRITE_HOOK(void);
+#endif
+
+#ifdef USB_DEVICE_MSD_MEDIA_EJECT_HOOK
+/* Configuration supplied hook, invoked when the host ejects the media with a
+ * START STOP UNIT command. The host no longer uses the media from then on. */
+extern void USB_DEVICE_MSD_MEDIA_EJECT_HOOK(void);
+#endif
+
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_COUNT
+/* Configuration supplied counter of the writes to the media, from the host
+ * or the device. Blocks read ahead past the end of a READ(10) are only used
+ * by the next one if it did not change. */
+extern uint32_t USB_DEVICE_MSD_MEDIA_WRITE_COUNT(void);
+#endif
+
 /****************************************
  * MSD Device function driver structure
  ****************************************/
@@ -217,6 +237,10 @@ void F_USB_DEVICE_MSD_InitializeInterface
     /* The Host may set an alternate inteface on this instance. Intialize the
      * alternate setting to zero */
     msdDeviceObj->alternateSetting = 0;
+
+    /* No read buffered or in progress */
+    msdDeviceObj->readFetchPending = false;
+    F_USB_DEVICE_MSD_ReadBufferInvalidate(msdDeviceObj);
 }
 
 // ******************************************************************************
@@ -591,6 +615,13 @@ void F_USB_DEVICE_MSD_Tasks
                 if (( (msdObj->irpRx.status == USB_DEVICE_IRP_STATUS_COMPLETED) || (msdObj->irpRx.status == USB_DEVICE_IRP_STATUS_COMPLETED_SHORT))
                         && (!USB_DEVICE_EndpointIsStalled(msdObj->hUsbDevHandle, msdObj->bulkEndpointRx)))
                 {
+                    /* The read ahead of the last READ(10) must complete before
+                     * the sector buffer and the media state are used again */
+                    if (!F_USB_DEVICE_MSD_ReadFetchDone(msdObj))
+                    {
+                        break;
+                    }
+
                     /* Received the CBW from the HOST. Check whether the CBW is valid and meaningful. */
                     msdObj->msdMainState = F_USB_DEVICE_MSD_VerifyCommand (iMSD, &commandStatus);
 
@@ -656,11 +687,41 @@ void F_USB_DEVICE_MSD_Tasks
                 break;
             }
 
+            case USB_DEVICE_MSD_STATE_SYNC_CACHE:
+            {
+                /* SYNCHRONIZE CACHE completes once the flush queued by
+                 * F_USB_DEVICE_MSD_ProcessNonRWCommand() is done */
+                USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA * mediaDynamicData = &msdObj->mediaDynamicData[msdObj->msdCBW->bCBWLUN];
+
+                if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_COMPLETE)
+                {
+                    msdObj->msdMainState = USB_DEVICE_MSD_STATE_CSW;
+                }
+                else if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_ERROR)
+                {
+                    msdObj->msdCSW->bCSWStatus = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
+                    msdObj->msdMainState = USB_DEVICE_MSD_STATE_CSW;
+                }
+                else
+                {
+                    /* Do Nothing */
+                }
+                break;
+            }
+
             case USB_DEVICE_MSD_STATE_CSW:
             {
                 if (msdObj->irpTx.status <= USB_DEVICE_IRP_STATUS_COMPLETED_SHORT)
                 {
                     (void) F_USB_DEVICE_MSD_PostDataStageRoutine(iMSD);
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_HOOK
+                    /* Reads started while the write was in progress may
+                     * have returned the old contents */
+                    if (msdObj->msdCBW->CBWCB[0] == (uint8_t)SCSI_WRITE_10)
+                    {
+                        USB_DEVICE_MSD_MEDIA_WRITE_HOOK();
+                    }
+#endif
                     msdObj->msdMainState = USB_DEVICE_MSD_STATE_SEND_CSW;
                 }
                 else
@@ -900,6 +961,13 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_VerifyCommand
         return USB_DEVICE_MSD_STATE_STALL_IN_OUT;
     }
 
+    /* The other commands use the sector buffer or may change the media.
+     * Blocks read ahead are kept for a READ(10) following a READ(10). */
+    if ((lCBW->CBWCB[0] != (uint8_t)SCSI_READ_10) && (lCBW->CBWCB[0] != (uint8_t)SCSI_TEST_UNIT_READY))
+    {
+        F_USB_DEVICE_MSD_ReadBufferInvalidate(msdInstance);
+    }
+
     /* Check and update the media state */
     F_USB_DEVICE_MSD_CheckAndUpdateMediaState(iMSD, lCBW->bCBWLUN);
 
@@ -949,6 +1017,7 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_VerifyCommand
                 *commandStatus = (uint8_t)USB_MSD_CSW_COMMAND_FAILED; 
                 return USB_DEVICE_MSD_STATE_CSW;
             }
+            F_USB_DEVICE_MSD_ReadAheadMatch(iMSD);
             return USB_DEVICE_MSD_STATE_DATA_IN;
         }
         else
@@ -1060,6 +1129,245 @@ void  F_USB_DEVICE_MSD_SaveBlockAddressAndLength
 
 }    
 
+// ******************************************************************************
+/* Function:
+    void F_USB_DEVICE_MSD_ReadBufferInvalidate
+    (
+        USB_DEVICE_MSD_INSTANCE * msdInstance
+    )
+
+  Summary:
+    Drops the blocks held in the read buffers.
+
+  Description:
+    Drops the blocks held in the read buffers. A media read still in progress
+    completes into a buffer that is no longer used.
+
+  Remarks:
+    This is a local function and should not be called directly by an
+    application.
+*/
+
+void F_USB_DEVICE_MSD_ReadBufferInvalidate
+(
+    USB_DEVICE_MSD_INSTANCE * msdInstance
+)
+{
+    uint8_t index;
+
+    for (index = 0; index < M_DRV_MSD_NUM_READ_BUFFERS; index++)
+    {
+        msdInstance->readBuffer[index].count = 0;
+        msdInstance->readBuffer[index].sent = 0;
+        msdInstance->readBuffer[index].ready = false;
+    }
+    msdInstance->readBufferActive = 0;
+    msdInstance->readBufferNext = 0;
+}
+
+// ******************************************************************************
+/* Function:
+    bool F_USB_DEVICE_MSD_ReadFetchDone
+    (
+        USB_DEVICE_MSD_INSTANCE * msdInstance
+    )
+
+  Summary:
+    Checks for the completion of the media read into the read buffers.
+
+  Description:
+    Returns false while a media read started by F_USB_DEVICE_MSD_ReadFetch is
+    in progress. Once it completed the buffer is marked ready, or dropped if
+    the read failed, and the media state is back to idle.
+
+  Remarks:
+    This is a local function and should not be called directly by an
+    application.
+*/
+
+bool F_USB_DEVICE_MSD_ReadFetchDone
+(
+    USB_DEVICE_MSD_INSTANCE * msdInstance
+)
+{
+    USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA * mediaDynamicData;
+    USB_DEVICE_MSD_READ_BUFFER * readBuffer;
+
+    if (msdInstance->readFetchPending == false)
+    {
+        return true;
+    }
+
+    mediaDynamicData = &msdInstance->mediaDynamicData[msdInstance->readFetchLun];
+    if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_PENDING)
+    {
+        return false;
+    }
+
+    readBuffer = &msdInstance->readBuffer[msdInstance->readFetchBuffer];
+    if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_COMPLETE)
+    {
+        readBuffer->ready = (readBuffer->count != 0U);
+    }
+    else
+    {
+        readBuffer->count = 0;
+    }
+
+    msdInstance->readFetchPending = false;
+    mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_IDLE;
+    return true;
+}
+
+// ******************************************************************************
+/* Function:
+    bool F_USB_DEVICE_MSD_ReadFetch
+    (
+        SYS_MODULE_INDEX iMSD,
+        uint8_t logicalUnit,
+        uint32_t lba,
+        uint8_t count
+    )
+
+  Summary:
+    Starts reading blocks from the media into the next read buffer.
+
+  Description:
+    Starts reading count blocks at lba into readBuffer[readBufferNext], which
+    must be free. Only one media read is in progress at a time. Returns false
+    if the media did not accept the request.
+
+  Remarks:
+    This is a local function and should not be called directly by an
+    application.
+*/
+
+bool F_USB_DEVICE_MSD_ReadFetch
+(
+    SYS_MODULE_INDEX iMSD,
+    uint8_t logicalUnit,
+    uint32_t lba,
+    uint8_t count
+)
+{
+    USB_DEVICE_MSD_INSTANCE * msdInstance = &gUSBDeviceMSDInstance[iMSD];
+    USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA * mediaDynamicData = &msdInstance->mediaDynamicData[logicalUnit];
+    USB_DEVICE_MSD_MEDIA_FUNCTIONS * mediaFunctions = &msdInstance->mediaData[logicalUnit].mediaFunctions;
+    SYS_MEDIA_BLOCK_COMMAND_HANDLE mediaReadWriteHandle = SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID;
+    uint8_t index = msdInstance->readBufferNext;
+    USB_DEVICE_MSD_READ_BUFFER * readBuffer = &msdInstance->readBuffer[index];
+    uint32_t mediaBlocksPerSector;
+
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_COUNT
+    uint8_t i;
+    bool empty = true;
+
+    /* The buffered blocks are valid as long as nothing was written since the
+     * oldest of them was read */
+    for (i = 0; i < M_DRV_MSD_NUM_READ_BUFFERS; i++)
+    {
+        if (msdInstance->readBuffer[i].count != 0U)
+        {
+            empty = false;
+        }
+    }
+    if (empty)
+    {
+        msdInstance->readWriteCount = USB_DEVICE_MSD_MEDIA_WRITE_COUNT();
+    }
+#endif
+
+    /* Find the media read block size */
+    mediaBlocksPerSector = mediaDynamicData->sectorSize / mediaDynamicData->mediaGeometry->geometryTable[0].blockSize;
+
+    readBuffer->lba = lba;
+    readBuffer->count = count;
+    readBuffer->sent = 0;
+    readBuffer->ready = false;
+
+    msdInstance->readFetchPending = true;
+    msdInstance->readFetchBuffer = index;
+    msdInstance->readFetchLun = logicalUnit;
+    mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_PENDING;
+
+    mediaFunctions->blockRead (mediaDynamicData->mediaHandle,
+                    &mediaReadWriteHandle,
+                    &msdInstance->mediaData[logicalUnit].sectorBuffer[(uint32_t)index * M_DRV_MSD_READ_BUFFER_SECTORS * 512U],
+                    lba * mediaBlocksPerSector,
+                    (uint32_t)count * mediaBlocksPerSector);
+
+    if (mediaReadWriteHandle == SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID)
+    {
+        readBuffer->count = 0;
+        msdInstance->readFetchPending = false;
+        mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_IDLE;
+        return false;
+    }
+
+    msdInstance->readBufferNext = (uint8_t)((index + 1U) % M_DRV_MSD_NUM_READ_BUFFERS);
+    msdInstance->readFetchLba = lba + count;
+    return true;
+}
+
+// ******************************************************************************
+/* Function:
+    void F_USB_DEVICE_MSD_ReadAheadMatch
+    (
+        SYS_MODULE_INDEX iMSD
+    )
+
+  Summary:
+    Uses the blocks read ahead for a new READ(10).
+
+  Description:
+    If the READ(10) in the CBW starts with the blocks held in the read buffers,
+    and the media was not written since they were read, the CBW block address
+    and length are advanced past them so that only the missing blocks are read
+    from the media. Otherwise the read buffers are dropped.
+
+  Remarks:
+    This is a local function and should not be called directly by an
+    application.
+*/
+
+void F_USB_DEVICE_MSD_ReadAheadMatch
+(
+    SYS_MODULE_INDEX iMSD
+)
+{
+    USB_DEVICE_MSD_INSTANCE * msdInstance = &gUSBDeviceMSDInstance[iMSD];
+
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_COUNT
+    USB_MSD_CBW * lCBW = msdInstance->msdCBW;
+    USB_DEVICE_MSD_READ_BUFFER * readBuffer = &msdInstance->readBuffer[msdInstance->readBufferActive];
+    USB_DEVICE_MSD_DWORD_VAL logicalBlockLength;
+    USB_DEVICE_MSD_DWORD_VAL logicalBlockAddress;
+    uint32_t buffered;
+
+    logicalBlockAddress.Val = 0;
+    logicalBlockLength.Val = 0;
+    F_USB_DEVICE_MSD_GetBlockAddressAndLength(lCBW, &logicalBlockAddress, &logicalBlockLength);
+
+    if ((readBuffer->count != 0U) && (lCBW->bCBWLUN == msdInstance->readFetchLun)
+            && ((readBuffer->lba + readBuffer->sent) == logicalBlockAddress.Val)
+            && (USB_DEVICE_MSD_MEDIA_WRITE_COUNT() == msdInstance->readWriteCount))
+    {
+        /* The buffers hold contiguous blocks up to readFetchLba */
+        buffered = msdInstance->readFetchLba - logicalBlockAddress.Val;
+        if (buffered > logicalBlockLength.Val)
+        {
+            buffered = logicalBlockLength.Val;
+        }
+        logicalBlockAddress.Val += buffered;
+        logicalBlockLength.Val -= buffered;
+        F_USB_DEVICE_MSD_SaveBlockAddressAndLength(lCBW, &logicalBlockAddress, &logicalBlockLength);
+        return;
+    }
+#endif
+
+    F_USB_DEVICE_MSD_ReadBufferInvalidate(msdInstance);
+}
+
 USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessRead
 (
     SYS_MODULE_INDEX iMSD,
@@ -1068,19 +1376,16 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessRead
 {
     USB_MSD_CBW *lCBW;
     uint8_t *msdBuffer;
-    size_t mediaReadBlockSize = 0;
     uint8_t logicalUnit;
+    uint32_t blocks;
 
-    SYS_MEDIA_BLOCK_COMMAND_HANDLE mediaReadWriteHandle = SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID;
-    USB_DEVICE_MSD_MEDIA_FUNCTIONS * mediaFunctions;
     USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA * mediaDynamicData;
+    USB_DEVICE_MSD_READ_BUFFER * readBuffer;
 
     USB_DEVICE_MSD_INSTANCE * msdInstance = &gUSBDeviceMSDInstance[iMSD];
     USB_DEVICE_MSD_DWORD_VAL logicalBlockLength;
     USB_DEVICE_MSD_DWORD_VAL logicalBlockAddress;
 
-    DRV_HANDLE drvHandle;
-
     /* Pointer to the CBW */ 
     lCBW = (USB_MSD_CBW *)msdInstance->msdCBW; // Pointer to CBW
 
@@ -1090,74 +1395,50 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessRead
     /* Get the media dynamic data */
     mediaDynamicData = &msdInstance->mediaDynamicData[logicalUnit];
 
-    /* Pointer to the media functions for this LUN */
-    mediaFunctions = &msdInstance->mediaData[logicalUnit].mediaFunctions;
-
     /* Pointer to the working buffer for this LUN */
     msdBuffer = msdInstance->mediaData[logicalUnit].sectorBuffer;
-    drvHandle = mediaDynamicData->mediaHandle;
 
     *commandStatus = (uint8_t)USB_MSD_CSW_COMMAND_PASSED;
     logicalBlockAddress.Val = 0;
     logicalBlockLength.Val = 0;
 
+    /* The CBW block address and length are those of the blocks not read from
+     * the media yet */
     F_USB_DEVICE_MSD_GetBlockAddressAndLength(lCBW, &logicalBlockAddress, &logicalBlockLength);
 
-    if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_COMPLETE)
+    if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_ERROR)
     {
-        /* Keep queuing IRPs as long as there is buffered data available with the MSD. */
-        if (msdInstance->numPendingIrps != msdInstance->bufferOffset)
-        {
-            msdInstance->rxTxTotalDataByteCount += mediaDynamicData->sectorSize;
-            msdInstance->irpTx.size = mediaDynamicData->sectorSize;
-            msdInstance->irpTx.data = (void *)&msdBuffer[msdInstance->numPendingIrps * 512U];
-            msdInstance->irpTx.flags = USB_DEVICE_IRP_FLAG_DATA_PENDING;
-
-            /* Submit the endpoint */
-            (void) USB_DEVICE_IRPSubmit( msdInstance->hUsbDevHandle, msdInstance->bulkEndpointTx, &msdInstance->irpTx);
-            msdInstance->numPendingIrps ++;
-
-            /* There is still data to be transferred. Continue to be in the IN state. */
-            return USB_DEVICE_MSD_STATE_DATA_IN;
-        }
-
-        /* Reset the counters */
-        msdInstance->numPendingIrps = 0;
-        msdInstance->bufferOffset = 0;
-
+        /* Media Read Failed. */
+        msdInstance->readFetchPending = false;
         mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_IDLE;
-        if (logicalBlockLength.Val == 0U)
-        {
-            /* End the data stage and move to CSW state */
-            return USB_DEVICE_MSD_STATE_CSW;
-        }
+        F_USB_DEVICE_MSD_ReadBufferInvalidate(msdInstance);
+        *commandStatus = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
+        return USB_DEVICE_MSD_STATE_CSW;
     }
+    (void) F_USB_DEVICE_MSD_ReadFetchDone(msdInstance);
 
-    if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_IDLE)
+    /* Move on to the next buffer once the host has all the blocks of this one */
+    readBuffer = &msdInstance->readBuffer[msdInstance->readBufferActive];
+    if ((readBuffer->count != 0U) && (readBuffer->sent == readBuffer->count))
     {
-        mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_PENDING;
+        readBuffer->count = 0;
+        readBuffer->ready = false;
+        msdInstance->readBufferActive = (uint8_t)((msdInstance->readBufferActive + 1U) % M_DRV_MSD_NUM_READ_BUFFERS);
+        readBuffer = &msdInstance->readBuffer[msdInstance->readBufferActive];
+    }
 
-        /* Find the amount of buffering available with the MSD driver. */
-        if (logicalBlockLength.Val > (uint32_t)M_DRV_MSD_NUM_SECTORS_BUFFERING)
-        {
-            msdInstance->bufferOffset = M_DRV_MSD_NUM_SECTORS_BUFFERING;
-        }
-        else
+    /* Read the next blocks from the media while the host reads the active
+     * buffer. */
+    if ((logicalBlockLength.Val != 0U) && (msdInstance->readFetchPending == false)
+            && (msdInstance->readBuffer[msdInstance->readBufferNext].count == 0U))
+    {
+        blocks = logicalBlockLength.Val;
+        if (blocks > M_DRV_MSD_READ_BUFFER_SECTORS)
         {
-            msdInstance->bufferOffset = (uint8_t)logicalBlockLength.Val;
+            blocks = M_DRV_MSD_READ_BUFFER_SECTORS;
         }
 
-        /* Find the media read block size */
-        mediaReadBlockSize = mediaDynamicData->mediaGeometry->geometryTable[0].blockSize;
-
-        /* Read bufferOffset number of sectors data from the media. */
-        mediaFunctions->blockRead (drvHandle, 
-                        &mediaReadWriteHandle, 
-                        (uint8_t*)&msdBuffer[0],
-                        (logicalBlockAddress.Val * (mediaDynamicData->sectorSize/mediaReadBlockSize)),
-                        msdInstance->bufferOffset * (mediaDynamicData->sectorSize/mediaReadBlockSize));
-
-        if (mediaReadWriteHandle == SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID)
+        if (F_USB_DEVICE_MSD_ReadFetch(iMSD, logicalUnit, logicalBlockAddress.Val, (uint8_t)blocks) == false)
         {
             /* Media Read Failed. */
             *commandStatus = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
@@ -1166,21 +1447,62 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessRead
 
         /* Update the amount of data read and the sector address
          * read. */
-        logicalBlockLength.Val -= msdInstance->bufferOffset;
-        logicalBlockAddress.Val += msdInstance->bufferOffset;
+        logicalBlockLength.Val -= blocks;
+        logicalBlockAddress.Val += blocks;
 
         F_USB_DEVICE_MSD_SaveBlockAddressAndLength(lCBW, &logicalBlockAddress, &logicalBlockLength);
-
-        msdInstance->numPendingIrps = 0;
     }
-    else if (mediaDynamicData->mediaState == USB_DEVICE_MSD_MEDIA_OPERATION_ERROR)
+
+    /* Keep queuing IRPs as long as the active buffer has blocks for this
+     * command. */
+    if (readBuffer->ready && (readBuffer->sent < readBuffer->count)
+            && (msdInstance->rxTxTotalDataByteCount < lCBW->dCBWDataTransferLength))
     {
-        *commandStatus = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
-        return USB_DEVICE_MSD_STATE_CSW;
+        msdInstance->rxTxTotalDataByteCount += mediaDynamicData->sectorSize;
+        msdInstance->irpTx.size = mediaDynamicData->sectorSize;
+        msdInstance->irpTx.data = (void *)&msdBuffer[(((uint32_t)msdInstance->readBufferActive * M_DRV_MSD_READ_BUFFER_SECTORS) + readBuffer->sent) * 512U];
+        msdInstance->irpTx.flags = USB_DEVICE_IRP_FLAG_DATA_PENDING;
+
+        /* Submit the endpoint */
+        (void) USB_DEVICE_IRPSubmit( msdInstance->hUsbDevHandle, msdInstance->bulkEndpointTx, &msdInstance->irpTx);
+        readBuffer->sent ++;
+
+        /* There is still data to be transferred. Continue to be in the IN state. */
+        return USB_DEVICE_MSD_STATE_DATA_IN;
     }
-    else
+
+    if (msdInstance->rxTxTotalDataByteCount >= lCBW->dCBWDataTransferLength)
     {
-        /* Do nothing */
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_COUNT
+        SYS_MEDIA_GEOMETRY * mediaGeometry = mediaDynamicData->mediaGeometry;
+        uint32_t numSectors;
+
+        /* Hosts read files sequentially. Read the blocks following this
+         * command while the CSW and the next CBW are on the bus. */
+        if (mediaGeometry->geometryTable[0].numBlocks > mediaDynamicData->sectorSize)
+        {
+            numSectors = (mediaGeometry->geometryTable[0].numBlocks / mediaDynamicData->sectorSize) *
+                    mediaGeometry->geometryTable[0].blockSize;
+        }
+        else
+        {
+            numSectors = (mediaGeometry->geometryTable[0].numBlocks * mediaGeometry->geometryTable[0].blockSize) /
+                    mediaDynamicData->sectorSize;
+        }
+
+        if ((msdInstance->readFetchPending == false) && (msdInstance->readFetchLba < numSectors)
+                && (msdInstance->readBuffer[msdInstance->readBufferNext].count == 0U))
+        {
+            blocks = numSectors - msdInstance->readFetchLba;
+            if (blocks > M_DRV_MSD_READ_BUFFER_SECTORS)
+            {
+                blocks = M_DRV_MSD_READ_BUFFER_SECTORS;
+            }
+            (void) F_USB_DEVICE_MSD_ReadFetch(iMSD, logicalUnit, msdInstance->readFetchLba, (uint8_t)blocks);
+        }
+#endif
+        /* End the data stage and move to CSW state */
+        return USB_DEVICE_MSD_STATE_CSW;
     }
 
     return USB_DEVICE_MSD_STATE_DATA_IN;
@@ -1444,6 +1766,10 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessWrite
 
         mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_PENDING;
 
+#ifdef USB_DEVICE_MSD_MEDIA_WRITE_HOOK
+        USB_DEVICE_MSD_MEDIA_WRITE_HOOK();
+#endif
+
         /* number of sectors to be written in this block != 0 */
         /* Write data to the media */
         mediaFunctions->blockWrite (drvHandle, &mediaReadWriteHandle, 
@@ -1514,6 +1840,7 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessNonRWCommand
 
     DRV_HANDLE              drvHandle;
     SYS_MEDIA_GEOMETRY * mediaGeometry;
+    SYS_MEDIA_BLOCK_COMMAND_HANDLE flushHandle = SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID;
 
     /* Pointer to the CBW */ 
     lCBW = (USB_MSD_CBW *)msdInstance->msdCBW; // Pointer to CBW
@@ -1783,11 +2110,55 @@ USB_DEVICE_MSD_STATE F_USB_DEVICE_MSD_ProcessNonRWCommand
             break;
 
         case (uint8_t)SCSI_VERIFY:
+            if(mediaDynamicData->mediaPresent == false)
+            {
+                (*commandStatus) = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
+            }
+            break;
+
         case (uint8_t)SCSI_STOP_START:
             if(mediaDynamicData->mediaPresent == false)
             {
                 (*commandStatus) = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
             }
+#ifdef USB_DEVICE_MSD_MEDIA_EJECT_HOOK
+            /* LOEJ set and START clear: eject */
+            else if((lCBW->CBWCB[4] & 0x03U) == 0x02U)
+            {
+                USB_DEVICE_MSD_MEDIA_EJECT_HOOK();
+            }
+#endif
+            else
+            {
+                /* Nothing to do */
+            }
+            break;
+
+        case (uint8_t)SCSI_SYNCHRONIZE_CACHE:
+            if(mediaDynamicData->mediaPresent == false)
+            {
+                (*commandStatus) = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
+            }
+            else if(mediaFunctions->cacheFlush != NULL)
+            {
+                /* The CSW is held until the cached data is on the media */
+                mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_PENDING;
+                mediaFunctions->cacheFlush(drvHandle, &flushHandle);
+
+                if(flushHandle == SYS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID)
+                {
+                    mediaDynamicData->mediaState = USB_DEVICE_MSD_MEDIA_OPERATION_IDLE;
+                    (*commandStatus) = (uint8_t)USB_MSD_CSW_COMMAND_FAILED;
+                }
+                else
+                {
+                    msdNextState = USB_DEVICE_MSD_STATE_SYNC_CACHE;
+                }
+            }
+            else
+            {
+                /* Nothing is cached */
+            }
             break;
 
         case (uint8_t)SCSI_PREVENT_ALLOW_MEDIUM_REMOVAL:
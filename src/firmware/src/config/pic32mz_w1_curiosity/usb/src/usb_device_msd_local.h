@@ -52,6 +52,15 @@
 
 #define M_DRV_MSD_NUM_SECTORS_BUFFERING (USB_DEVICE_MSD_NUM_SECTOR_BUFFERS)
 
+/* READ(10) splits the sector buffer: the host reads one part while the next
+ * blocks are read from the media into the other one. */
+#define M_DRV_MSD_NUM_READ_BUFFERS      2U
+#define M_DRV_MSD_READ_BUFFER_SECTORS   (M_DRV_MSD_NUM_SECTORS_BUFFERING / M_DRV_MSD_NUM_READ_BUFFERS)
+
+#if (USB_DEVICE_MSD_NUM_SECTOR_BUFFERS < 2)
+    #error "USB_DEVICE_MSD_NUM_SECTOR_BUFFERS must be at least 2"
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Local data types.
@@ -79,6 +88,7 @@ typedef enum
     USB_DEVICE_MSD_STATE_STALL_IN_OUT,
     USB_DEVICE_MSD_STATE_DATA_IN,
     USB_DEVICE_MSD_STATE_DATA_OUT,
+    USB_DEVICE_MSD_STATE_SYNC_CACHE,
     USB_DEVICE_MSD_STATE_CSW,
     USB_DEVICE_MSD_STATE_SEND_CSW,
     USB_DEVICE_MSD_STATE_IDLE
@@ -148,6 +158,30 @@ typedef struct
     SYS_MEDIA_GEOMETRY * mediaGeometry;
 } USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA;
 
+// *****************************************************************************
+/* USB MSD device read buffer.
+
+  Summary:
+    Part of the sector buffer holding blocks read for the host.
+
+  Description:
+    Blocks lba + sent up to lba + count - 1 are still to be sent to the host.
+    The buffer is in use as long as count is not zero, the data is valid once
+    ready is set.
+
+  Remarks:
+    This is a private structure of USB MSD device.
+ */
+
+typedef struct
+{
+    uint32_t lba;
+    uint8_t count;
+    uint8_t sent;
+    bool ready;
+
+} USB_DEVICE_MSD_READ_BUFFER;
+
 // *****************************************************************************
 /* USB MSD device instance structure.
 
@@ -186,6 +220,24 @@ typedef struct
     uint8_t numSectorsToWrite;
     uint8_t numPendingIrps;
 
+    /* READ(10) buffers, sent to the host in order starting at readBufferActive */
+    USB_DEVICE_MSD_READ_BUFFER readBuffer[M_DRV_MSD_NUM_READ_BUFFERS];
+    uint8_t readBufferActive;
+
+    /* Buffer the next media read goes to */
+    uint8_t readBufferNext;
+
+    /* A media read is in progress into readBuffer[readFetchBuffer] */
+    bool readFetchPending;
+    uint8_t readFetchBuffer;
+    uint8_t readFetchLun;
+
+    /* Block following the last one read into the buffers */
+    uint32_t readFetchLba;
+
+    /* USB_DEVICE_MSD_MEDIA_WRITE_COUNT() when the buffers were first filled */
+    uint32_t readWriteCount;
+
     /* Dynamic media information */
     USB_DEVICE_MSD_MEDIA_DYNAMIC_DATA mediaDynamicData[USB_DEVICE_MSD_LUNS_NUMBER]; 
 
@@ -672,5 +724,28 @@ void  F_USB_DEVICE_MSD_SaveBlockAddressAndLength
     USB_DEVICE_MSD_DWORD_VAL * logicalBlockLength
 );
 
+void F_USB_DEVICE_MSD_ReadBufferInvalidate
+(
+    USB_DEVICE_MSD_INSTANCE * msdInstance
+);
+
+bool F_USB_DEVICE_MSD_ReadFetchDone
+(
+    USB_DEVICE_MSD_INSTANCE * msdInstance
+);
+
+bool F_USB_DEVICE_MSD_ReadFetch
+(
+    SYS_MODULE_INDEX iMSD,
+    uint8_t logicalUnit,
+    uint32_t lba,
+    uint8_t count
+);
+
+void F_USB_DEVICE_MSD_ReadAheadMatch
+(
+    SYS_MODULE_INDEX iMSD
+);
+
 #endif
 
@@ -189,6 +189,17 @@ typedef struct USB_DEVICE_MSD_MEDIA_FUNCTIONS
         const void * addressOfStartBlock
     );
 
+    /* Optional. Called on a SCSI SYNCHRONIZE CACHE command for media drivers
+       which hold back writes. The function queues the write of the cached
+       data as a block operation and returns its handle. The CSW is sent
+       once the block event handler reports the operation complete. */
+
+    void (*cacheFlush)
+    (
+        const DRV_HANDLE drvHandle,
+        uintptr_t * blockOperationHandle
+    );
+
 } USB_DEVICE_MSD_MEDIA_FUNCTIONS;
 
 // *****************************************************************************
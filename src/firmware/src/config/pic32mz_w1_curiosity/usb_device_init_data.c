@@ -106,7 +106,8 @@ static USB_DEVICE_MSD_MEDIA_INIT_DATA USB_ALIGN  msdMediaInit0[1] =
             DRV_MEMORY_AsyncEraseWrite,
             DRV_MEMORY_IsWriteProtected,
             DRV_MEMORY_TransferHandlerSet,
-            NULL
+            NULL,
+            DRV_MEMORY_AsyncCacheFlush
         }
     },
 };
@@ -32,11 +32,26 @@
 #include "mqtt_app.h"
 #include "system/command/sys_command.h"
 #include "app_control.h"
-#include "cJSON.h"
+#include "app_json.h"
 #include "system/mqtt/sys_mqtt.h"
 #include "bsp/bsp.h"
+#include "sys_tasks.h"
+#include "app_spool.h"
+#include "app_nvrec.h"
+#include "app_dnscache.h"
+#include "app_heapstat.h"
+#include "tcpip/tcpip.h"
+#include "wdrv_pic32mzw_common.h"
+#include "wdrv_pic32mzw_assoc.h"
 
 MQTT_APP_DATA mqtt_appData;
+/*Publish topics, built once the clientId is known. Not in MQTT_APP_DATA:
+  sys_mqtt.h includes definitions.h, and so mqtt_app.h, before its types.*/
+static SYS_MQTT_PublishTopicCfg sensorsTopic;
+static SYS_MQTT_PublishTopicCfg shadowTopic;
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+static SYS_MQTT_PublishTopicCfg heapStatTopic;
+#endif
 
 int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, void* cookie) {
     static int errorCount = 0;
@@ -49,31 +64,24 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
             //SYS_CONSOLE_PRINT("\nMqttCallback(): Msg received on Topic: %s ; Msg: %s\r\n",psMsg->topicName, psMsg->message);
 
             if (NULL != strstr((char*) psMsg->topicName, "/shadow/update/delta")) {
-                cJSON *messageJson = cJSON_Parse((char*) psMsg->message);
-                if (messageJson == NULL) {
-                    const char *error_ptr = cJSON_GetErrorPtr();
-                    if (error_ptr != NULL) {
-                        SYS_CONSOLE_PRINT(TERM_RED"Message JSON parse Error. Error before: %s\n"TERM_RESET, error_ptr);
-                    }
-                    cJSON_Delete(messageJson);
-                    break;
-                }
-
-                //Get the desired state
-                cJSON *state = cJSON_GetObjectItem(messageJson, "state");
-                if (!state) {
-                    cJSON_Delete(messageJson);
+                int32_t toggle = -1;
+                size_t errPos = 0;
+                APP_JSON_HANDLER handlers[] = {
+                    {"/state/toggle", APP_JSON_GetInt, &toggle},
+                };
+
+                if (APP_JSON_OK != APP_JSON_Parse((char*) psMsg->message, psMsg->messageLength,
+                        handlers, sizeof (handlers) / sizeof (handlers[0]), &errPos)) {
+                    SYS_CONSOLE_PRINT(TERM_RED"Message JSON parse Error at offset %d\n"TERM_RESET, (int) errPos);
                     break;
                 }
 
-                //Get the toggle state
-                cJSON *toggle = cJSON_GetObjectItem(state, "toggle");
-                if (!toggle) {
-                    cJSON_Delete(messageJson);
+                //No desired toggle state in the delta
+                if (toggle < 0) {
                     break;
                 }
 
-                bool desiredState = (bool) toggle->valueint;
+                bool desiredState = (bool) toggle;
                 if (desiredState) {
                     LED_GREEN_On();
                     SYS_CONSOLE_PRINT(TERM_GREEN"LED ON\r\n"TERM_RESET);
@@ -81,7 +89,6 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
                     LED_GREEN_Off();
                     SYS_CONSOLE_PRINT(TERM_YELLOW"LED OFF\r\n"TERM_RESET);
                 }
-                cJSON_Delete(messageJson);
 #if 0
                 if (NULL != strstr((char*) psMsg->message, "\"state\":{\"toggle\":1}")) {
                     LED_GREEN_On();
@@ -93,6 +100,8 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
 #endif
                 mqtt_appData.shadowUpdate = true;
                 mqtt_appData.pubFlag = true;
+                /*report the new state on the next pass instead of waiting for the timer*/
+                APP_RTOS_Notify(xMQTT_APP_Tasks);
             }
         }
             break;
@@ -102,7 +111,7 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
             SYS_CONSOLE_PRINT("\nMqttCallback(): MQTT Disconnected\r\n");
             mqtt_appData.MQTTConnected = false;
             app_controlData.mqttCtrl.conStat = false;
-            mqtt_appData.MQTTPubQueued = false;
+            APP_RTOS_Notify(xAPP_CONTROL_Tasks);
         }
             break;
 
@@ -111,6 +120,8 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
             SYS_CONSOLE_PRINT("\nMqttCallback(): MQTT Connected\r\n");
             mqtt_appData.MQTTConnected = true;
             app_controlData.mqttCtrl.conStat = true;
+            APP_SPOOL_DrainStart();
+            APP_RTOS_Notify(xAPP_CONTROL_Tasks);
         }
             break;
 
@@ -131,8 +142,11 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
         case SYS_MQTT_EVENT_MSG_PUBLISHED:
         {
             //SYS_CONSOLE_PRINT("\nMqttCallback(): Published Sensor Data\r\n");
-            mqtt_appData.MQTTPubQueued = false;
             errorCount = 0;
+            /*the other publishes are acked meanwhile, only the spooled batch is waited for*/
+            if ((mqtt_appData.spoolBatch != 0) && (*(uint16_t *) data == mqtt_appData.spoolMsgId)) {
+                mqtt_appData.spoolAcked = true;
+            }
         }
             break;
         case SYS_MQTT_EVENT_MSG_CONNACK_TO:
@@ -149,13 +163,10 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
             break;
         case SYS_MQTT_EVENT_MSG_PUBACK_TO:
         {
-            SYS_CONSOLE_PRINT("\nMqttCallback(): PUBACK Timed out. non-Fatal error.\r\n");
-            mqtt_appData.MQTTPubQueued = false;
+            /*raised once per stall, the service then reconnects and resends the queue; the
+              readings which do not fit meanwhile go to the spool*/
             errorCount++;
-            if (errorCount > 5) {
-                SYS_CONSOLE_PRINT(TERM_RED"\nMqttCallback(): Too many failed events. Forcing a reset\r\n"TERM_RESET);
-                while (1); //force a WDT reset
-            }            
+            SYS_CONSOLE_PRINT("\nMqttCallback(): PUBACK Timed out (%d in a row). non-Fatal error.\r\n", errorCount);
         }
             break;
         case SYS_MQTT_EVENT_MSG_UNSUBACK_TO:
@@ -171,46 +182,345 @@ int32_t MqttCallback(SYS_MQTT_EVENT_TYPE eEventType, void *data, uint16_t len, v
 static void timerCallback(uintptr_t context) {
     //SYS_CONSOLE_PRINT("Timer : Publishing data\r\n");
     mqtt_appData.pubFlag = true;
+    APP_RTOS_NotifyFromISR(xMQTT_APP_Tasks);
+}
+
+/*Formatters for the publish path. They do not NUL terminate and return the
+  position after the text written.*/
+static char *putBytes(char *p, const char *s, size_t n) {
+    memcpy(p, s, n);
+    return p + n;
+}
+
+#define putLiteral(p, lit) putBytes((p), (lit), sizeof (lit) - 1)
+
+static char *putUint(char *p, uint32_t v) {
+    char digits[10];
+    uint8_t n = 0;
+
+    do {
+        digits[n++] = '0' + (v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n != 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+static char *putInt(char *p, int32_t v) {
+    if (v < 0) {
+        *p++ = '-';
+        return putUint(p, 0U - (uint32_t) v);
+    }
+    return putUint(p, (uint32_t) v);
+}
+
+/*The telemetry is serialized straight into the SYS_MQTT publish queue: get
+  the buffer with SYS_MQTT_PublishReserve(), then publishTelemetry() it. The
+  queue entry is reserved in between, the other publishes fail meanwhile.*/
+static int32_t publishTelemetry(size_t len, uint16_t *msgId) {
+    return SYS_MQTT_PublishCommit(mqtt_appData.SysMqttHandle, &sensorsTopic, len, msgId);
+}
+
+static void sampleTelemetry(APP_SPOOL_RECORD *rec) {
+    int8_t rssi = 0;
+
+    if (app_controlData.wifiCtrl.wifiConnected) {
+        /*no callback: returns the last RSSI known to the driver*/
+        WDRV_PIC32MZW_AssocRSSIGet((WDRV_PIC32MZW_ASSOC_HANDLE) app_controlData.rssiData.assocHandle, &rssi, NULL);
+    }
+    rec->temp = (int16_t) app_controlData.adcData.temp;
+    rec->switchStatus = app_controlData.switchData.switchStatus;
+    rec->rssi = rssi;
+    rec->timestamp = TCPIP_SNTP_UTCSecondsGet();
+}
+
+/*Encodes the samples as compact JSON, see MQTT_APP_TELEMETRY_BATCH_TS. The
+  message length (NUL included) goes to *msgLen. Returns the number of samples
+  which fit in len.*/
+static uint8_t encodeBatch(char *buf, size_t len, const APP_SPOOL_RECORD *recs, uint8_t nRecs, bool withSeq, size_t *msgLen) {
+    char row[MQTT_APP_TELEMETRY_BATCH_ROW_MAX_LEN];
+    char *p = buf;
+    uint8_t i;
+
+    p = putLiteral(p, MQTT_APP_TELEMETRY_BATCH_TS);
+    p = putUint(p, recs[0].timestamp);
+    if (withSeq) {
+        p = putLiteral(p, MQTT_APP_TELEMETRY_BATCH_SEQ);
+        p = putUint(p, recs[0].seq);
+    }
+    p = putLiteral(p, MQTT_APP_TELEMETRY_BATCH_ROWS);
+    for (i = 0; i < nRecs; i++) {
+        uint32_t dt = (recs[i].timestamp >= recs[0].timestamp) ? (recs[i].timestamp - recs[0].timestamp) : 0;
+        char *r = row;
+
+        if (i != 0) {
+            *r++ = ',';
+        }
+        *r++ = '[';
+        r = putUint(r, dt);
+        *r++ = ',';
+        r = putInt(r, recs[i].temp);
+        *r++ = ',';
+        r = putUint(r, recs[i].switchStatus);
+        *r++ = ',';
+        r = putInt(r, recs[i].rssi);
+        *r++ = ']';
+        /*leave room for the closing "]}" and the NUL*/
+        if ((p - buf) + (r - row) + 3 > len) {
+            break;
+        }
+        p = putBytes(p, row, r - row);
+    }
+    p = putBytes(p, MQTT_APP_TELEMETRY_BATCH_END, sizeof (MQTT_APP_TELEMETRY_BATCH_END));
+    *msgLen = p - buf;
+    return i;
+}
+
+/*Publish the collected samples. Whatever does not fit or fails to queue stays
+  for the next flush.*/
+static void flushBatch() {
+    int32_t retVal;
+    uint8_t nRecs;
+    size_t len;
+    uint16_t maxLen;
+    char *msg;
+
+    if (mqtt_appData.batchCount == 0) {
+        return;
+    }
+    msg = SYS_MQTT_PublishReserve(mqtt_appData.SysMqttHandle, &maxLen);
+    if (msg == NULL) {
+        SYS_CONSOLE_PRINT("\nMQTT_APP: publish queue full, telemetry kept for the next round\r\n");
+        return;
+    }
+    if (MQTT_APP_TELEMETRY_BATCH == 1U) {
+        char *p = msg;
+
+        p = putLiteral(p, MQTT_APP_TELEMETRY_MSG_PREFIX);
+        p = putInt(p, mqtt_appData.batch[0].temp);
+        /*Graduation step to include an additional sensor data. Uncomment the two lines below.*/
+        //p = putLiteral(p, MQTT_APP_TELEMETRY_MSG_GRAD_SWITCH);
+        //p = putUint(p, mqtt_appData.batch[0].switchStatus);
+        p = putBytes(p, MQTT_APP_TELEMETRY_MSG_SUFFIX, sizeof (MQTT_APP_TELEMETRY_MSG_SUFFIX));
+        len = p - msg;
+        nRecs = 1;
+    } else {
+        nRecs = encodeBatch(msg, maxLen, mqtt_appData.batch, mqtt_appData.batchCount, false, &len);
+    }
+
+    retVal = publishTelemetry(len, NULL);
+    if (retVal != SYS_MQTT_SUCCESS) {
+        SYS_CONSOLE_PRINT("\nMQTT_APP: publishMessage() Failed (%d)\r\n", retVal);
+        return;
+    }
+    mqtt_appData.batchCount -= nRecs;
+    memmove(&mqtt_appData.batch[0], &mqtt_appData.batch[nRecs], mqtt_appData.batchCount * sizeof (APP_SPOOL_RECORD));
+    mqtt_appData.batchStartTick = xTaskGetTickCount();
+}
+
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+/*Heap diagnostics, every MQTT_APP_HEAPSTAT_PERIOD ms. The message is encoded
+  before the queue entry is reserved, the probe suspends the scheduler.*/
+static void publishHeapStat() {
+    char buf[MQTT_APP_HEAPSTAT_MSG_MAX_LEN];
+    APP_HEAPSTAT_STATS stats;
+    TickType_t now = xTaskGetTickCount();
+    char *p = buf;
+    uint16_t maxLen;
+    uint8_t i;
+    char *msg;
+
+    if ((now - mqtt_appData.lastHeapStatTick) * portTICK_PERIOD_MS < MQTT_APP_HEAPSTAT_PERIOD) {
+        return;
+    }
+    APP_HEAPSTAT_Get(&stats, true);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_SIZE);
+    p = putUint(p, stats.heapSize);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_LFB);
+    p = putUint(p, stats.largestFree);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_LFB_MIN);
+    p = putUint(p, stats.largestFreeMin);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_CUR);
+    p = putUint(p, stats.current);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_PEAK);
+    p = putUint(p, stats.peak);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_RTOS_FAILS);
+    p = putUint(p, stats.rtosFails);
+    p = putLiteral(p, MQTT_APP_HEAPSTAT_MSG_TAGS);
+    for (i = 0; i < APP_HEAPSTAT_COUNT; i++) {
+        const char *name = APP_HEAPSTAT_TagName((APP_HEAPSTAT_TAG) i);
+
+        if (i != 0) {
+            *p++ = ',';
+        }
+        *p++ = '"';
+        p = putBytes(p, name, strlen(name));
+        p = putLiteral(p, "\":[");
+        p = putUint(p, stats.tag[i].current);
+        *p++ = ',';
+        p = putUint(p, stats.tag[i].peak);
+        *p++ = ',';
+        p = putUint(p, stats.tag[i].fails);
+        *p++ = ']';
+    }
+    p = putBytes(p, MQTT_APP_HEAPSTAT_MSG_END, sizeof (MQTT_APP_HEAPSTAT_MSG_END));
+
+    msg = SYS_MQTT_PublishReserve(mqtt_appData.SysMqttHandle, &maxLen);
+    if (msg == NULL) {
+        /*queue full, try again next round*/
+        return;
+    }
+    if ((size_t) (p - buf) > maxLen) {
+        SYS_MQTT_PublishCommit(mqtt_appData.SysMqttHandle, &heapStatTopic, 0, NULL);
+        SYS_CONSOLE_PRINT("\nMQTT_APP: heap diagnostics exceed SYS_MQTT_PAHO_PUB_MSG_MAX_LEN\r\n");
+    } else {
+        memcpy(msg, buf, p - buf);
+        SYS_MQTT_PublishCommit(mqtt_appData.SysMqttHandle, &heapStatTopic, p - buf, NULL);
+    }
+    mqtt_appData.lastHeapStatTick = now;
+}
+#endif
+
+/*Move the samples not published yet to the spool. The ones the spool does
+  not take stay in the batch, oldest first.*/
+static void spillBatch() {
+    uint8_t i;
+
+    for (i = 0; i < mqtt_appData.batchCount; i++) {
+        if (!APP_SPOOL_IsReady() || !APP_SPOOL_Write(&mqtt_appData.batch[i])) {
+            break;
+        }
+    }
+    mqtt_appData.batchCount -= i;
+    memmove(&mqtt_appData.batch[0], &mqtt_appData.batch[i], mqtt_appData.batchCount * sizeof (APP_SPOOL_RECORD));
+}
+
+/*Append a sample to the batch, making room if it is full*/
+static void batchSample(const APP_SPOOL_RECORD *sample, TickType_t now) {
+    if (mqtt_appData.batchCount == MQTT_APP_TELEMETRY_BATCH) {
+        /*earlier flushes failed, make room*/
+        spillBatch();
+    }
+    if (mqtt_appData.batchCount == MQTT_APP_TELEMETRY_BATCH) {
+        /*the spool is full or not available either: drop the oldest sample*/
+        mqtt_appData.batchCount--;
+        memmove(&mqtt_appData.batch[0], &mqtt_appData.batch[1], mqtt_appData.batchCount * sizeof (APP_SPOOL_RECORD));
+        SYS_CONSOLE_PRINT("\nMQTT_APP: telemetry batch full, oldest sample dropped\r\n");
+    }
+    if (mqtt_appData.batchCount == 0) {
+        mqtt_appData.batchStartTick = now;
+    }
+    mqtt_appData.batch[mqtt_appData.batchCount++] = *sample;
 }
 
 static void publishMessage() {
-    /*MQTT service does not queue messages*/
-    
-    if (mqtt_appData.MQTTConnected && !mqtt_appData.MQTTPubQueued) {
-        SYS_MQTT_PublishTopicCfg sMqttTopicCfg;
+    APP_SPOOL_RECORD sample;
+    TickType_t now = xTaskGetTickCount();
+    /*keep the samples in order: while anything is spooled, new samples go to the spool too*/
+    bool spooled = false;
+
+    sampleTelemetry(&sample);
+    if (!mqtt_appData.MQTTConnected || (mqtt_appData.spoolBatch != 0) || (APP_SPOOL_PendingCount() != 0)) {
+        spillBatch();
+        /*behind samples the spool did not take, the new one waits in the batch too*/
+        spooled = (mqtt_appData.batchCount == 0) && APP_SPOOL_IsReady() && APP_SPOOL_Write(&sample);
+    }
+    if (!mqtt_appData.MQTTConnected) {
+        if (!spooled) {
+            batchSample(&sample, now);
+        }
+        return;
+    }
+
+    /*MQTT service queues the message and pipelines the QoS1 PUBACKs*/
+    if (mqtt_appData.shadowUpdate) { /*if a shadow update is requested, do it in this round*/
         int32_t retVal = SYS_MQTT_FAILURE;
-        /* All Params other than the message are initialized by the config provided in MHC*/
-        char pubTopic[MQTT_APP_TOPIC_NAME_MAX_LEN] = {'\0'};
-        char message[MQTT_APP_MAX_MSG_LLENGTH] = {'\0'};
-
-        if (!mqtt_appData.shadowUpdate) { /*if a shadow update is requested, do it in this round*/
-            snprintf(pubTopic, MQTT_APP_TOPIC_NAME_MAX_LEN, "%s/sensors", app_controlData.mqttCtrl.clientId);
-            sprintf(message, MQTT_APP_TELEMETRY_MSG_TEMPLATE, (int) app_controlData.adcData.temp);
-            /*Graduation step to include an additional sensor data. Comment out the above line and uncomment the one below.*/
-            //sprintf(message, MQTT_APP_TELEMETRY_MSG_GRAD_TEMPLATE, (int) app_controlData.adcData.temp,app_controlData.switchData.switchStatus);
+        char *message = SYS_MQTT_PublishReserve(mqtt_appData.SysMqttHandle, NULL);
+
+        if (message != NULL) {
+            char *p = message;
+
+            p = putLiteral(p, MQTT_APP_SHADOW_MSG_PREFIX);
+            p = putUint(p, LED_GREEN_Get());
+            p = putBytes(p, MQTT_APP_SHADOW_MSG_SUFFIX, sizeof (MQTT_APP_SHADOW_MSG_SUFFIX));
+
+            //SYS_CONSOLE_PRINT("Publishing:\r\n    Topic: %s\r\n    Message: %s\r\n",shadowTopic.topicName,message);
+
+            retVal = SYS_MQTT_PublishCommit(mqtt_appData.SysMqttHandle, &shadowTopic, p - message, NULL);
+            if (retVal != SYS_MQTT_SUCCESS) {
+                SYS_CONSOLE_PRINT("\nMQTT_APP: publishMessage() Failed (%d)\r\n", retVal);
+            }
         } else {
-            snprintf(pubTopic, MQTT_APP_TOPIC_NAME_MAX_LEN, MQTT_APP_SHADOW_UPDATE_TOPIC_TEMPLATE, app_controlData.mqttCtrl.clientId);
-            sprintf(message, MQTT_APP_SHADOW_MSG_TEMPLATE, LED_GREEN_Get());
-            mqtt_appData.shadowUpdate = false; /*TODO: Parse puback topic and make this false in the CB*/
+            SYS_CONSOLE_PRINT("\nMQTT_APP: publish queue full, shadow update kept for the next round\r\n");
         }
-        strcpy(sMqttTopicCfg.topicName, pubTopic);
-        sMqttTopicCfg.topicLength = strlen(pubTopic);
-        sMqttTopicCfg.retain = 0;
-        sMqttTopicCfg.qos = 1;
-
-        //SYS_CONSOLE_PRINT("Publishing:\r\n    Topic: %s\r\n    Message: %s\r\n",pubTopic,message);
-
-        mqtt_appData.MQTTPubQueued = true;
-        retVal = SYS_MQTT_Publish(mqtt_appData.SysMqttHandle,
-                &sMqttTopicCfg,
-                message,
-                strlen(message) + 1);
-        if (retVal != SYS_MQTT_SUCCESS) {
-            SYS_CONSOLE_PRINT("\nMQTT_APP: publishMessage() Failed (%d)\r\n", retVal);
+        /*on a failure the shadow update stays pending for the next round*/
+        if (retVal == SYS_MQTT_SUCCESS) {
+            mqtt_appData.shadowUpdate = false;
+        }
+    }
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+    publishHeapStat();
+#endif
+
+    if (!spooled) {
+        batchSample(&sample, now);
+        if ((mqtt_appData.batchCount >= MQTT_APP_TELEMETRY_BATCH) ||
+                ((now - mqtt_appData.batchStartTick) * portTICK_PERIOD_MS >= MQTT_APP_TELEMETRY_BATCH_AGE)) {
+            flushBatch();
+        }
+    }
+}
+
+/*Publish the spooled samples, APP_SPOOL_DRAIN_BATCH of them per message. A
+  batch is marked consumed on the flash only once its message has been acked,
+  so a reset re-sends it rather than losing it.*/
+static void drainSpool() {
+    APP_SPOOL_RECORD recs[APP_SPOOL_DRAIN_BATCH];
+    TickType_t now = xTaskGetTickCount();
+    uint8_t nRecs;
+    size_t len;
+    uint16_t maxLen;
+    char *msg;
+
+    if (mqtt_appData.spoolBatch != 0) {
+        if (mqtt_appData.spoolAcked) {
+            APP_SPOOL_Commit(mqtt_appData.spoolBatch);
+            mqtt_appData.spoolBatch = 0;
         }
-    } else {
         return;
     }
+    if ((APP_SPOOL_PendingCount() == 0) ||
+            ((now - mqtt_appData.lastDrainTick) * portTICK_PERIOD_MS < APP_SPOOL_DRAIN_PERIOD)) {
+        return;
+    }
+    mqtt_appData.lastDrainTick = now;
+
+    /*read the flash before reserving the queue entry*/
+    nRecs = APP_SPOOL_ReadBatch(recs, APP_SPOOL_DRAIN_BATCH);
+    if (nRecs == 0) {
+        return;
+    }
+    msg = SYS_MQTT_PublishReserve(mqtt_appData.SysMqttHandle, &maxLen);
+    if (msg == NULL) {
+        return;
+    }
+    /*the records not fitting the payload are read again with the next batch*/
+    nRecs = encodeBatch(msg, maxLen, recs, nRecs, true, &len);
+    if (publishTelemetry(len, &mqtt_appData.spoolMsgId) == SYS_MQTT_SUCCESS) {
+        mqtt_appData.spoolBatch = nRecs;
+        mqtt_appData.spoolAcked = false;
+    }
+}
+
+/*The publish topics only depend on the clientId, build them once*/
+static void MQTT_APP_TopicCfgInit(SYS_MQTT_PublishTopicCfg *cfg, const char *fmt) {
+    int len = snprintf(cfg->topicName, SYS_MQTT_TOPIC_NAME_MAX_LEN, fmt, app_controlData.mqttCtrl.clientId);
+
+    cfg->topicLength = (len < SYS_MQTT_TOPIC_NAME_MAX_LEN) ? len : (SYS_MQTT_TOPIC_NAME_MAX_LEN - 1);
+    cfg->retain = 0;
+    cfg->qos = 1;
 }
 
 static void MQTT_APP_SysMQTT_init() {
@@ -223,6 +533,12 @@ static void MQTT_APP_SysMQTT_init() {
     char subTopic[MQTT_APP_TOPIC_NAME_MAX_LEN];
     snprintf(subTopic, MQTT_APP_TOPIC_NAME_MAX_LEN, MQTT_APP_SHADOW_DELTA_TOPIC_TEMPLATE, app_controlData.mqttCtrl.clientId);
 
+    MQTT_APP_TopicCfgInit(&sensorsTopic, MQTT_APP_SENSORS_TOPIC_TEMPLATE);
+    MQTT_APP_TopicCfgInit(&shadowTopic, MQTT_APP_SHADOW_UPDATE_TOPIC_TEMPLATE);
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+    MQTT_APP_TopicCfgInit(&heapStatTopic, MQTT_APP_HEAPSTAT_TOPIC_TEMPLATE);
+#endif
+
     cloudConfig.subscribeCount = 1;
     memcpy(cloudConfig.sSubscribeConfig[0].topicName, subTopic, strlen(subTopic)+1);
     cloudConfig.sSubscribeConfig[0].qos = 1;
@@ -233,9 +549,19 @@ void MQTT_APP_Initialize(void) {
     mqtt_appData.state = MQTT_APP_STATE_INIT;
     mqtt_appData.SysMqttHandle = SYS_MODULE_OBJ_INVALID;
     mqtt_appData.pubFlag = true;
-    mqtt_appData.MQTTPubQueued = false;
     mqtt_appData.MQTTConnected = false;
     mqtt_appData.shadowUpdate = true; /*so that we send the boot status update*/
+    mqtt_appData.spoolBatch = 0;
+    mqtt_appData.spoolAcked = false;
+    mqtt_appData.lastDrainTick = 0;
+    mqtt_appData.batchCount = 0;
+    mqtt_appData.batchStartTick = 0;
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+    mqtt_appData.lastHeapStatTick = 0;
+#endif
+    APP_SPOOL_Initialize();
+    APP_NVREC_Initialize();
+    APP_DNSCACHE_Initialize();
     mqtt_appData.state = MQTT_APP_STATE_INIT;
 }
 
@@ -244,6 +570,7 @@ void MQTT_APP_Tasks(void) {
         case MQTT_APP_STATE_INIT:
         {
             if (app_controlData.serialNumValid && app_controlData.mqttCtrl.mqttConfigValid) {
+                app_controlData.mqttCtrl.mqttConfigChanged = false;
                 SYS_CONSOLE_PRINT("Found valid MQTT config\r\n");
                 SYS_CONSOLE_PRINT("Device SerialNumber is : "TERM_GREEN"%s\r\n"TERM_RESET, app_controlData.devSerialStr);
                 MQTT_APP_SysMQTT_init();
@@ -258,11 +585,35 @@ void MQTT_APP_Tasks(void) {
         case MQTT_APP_STATE_SERVICE_TASKS:
         {
             //APP_MQTT_Task();
+            if (!APP_SPOOL_IsReady()) {
+                APP_SPOOL_Mount();
+            }
+            if (app_controlData.mqttCtrl.mqttConfigChanged) {
+                /*cloud.json edited over USB: connect to the new broker without a reboot*/
+                app_controlData.mqttCtrl.mqttConfigChanged = false;
+                SYS_CONSOLE_PRINT("MQTT_APP: Applying the new cloud config\r\n");
+                SYS_MQTT_Disconnect(mqtt_appData.SysMqttHandle);
+                mqtt_appData.MQTTConnected = false;
+                app_controlData.mqttCtrl.conStat = false;
+                /*the new instance starts with an empty publish queue*/
+                mqtt_appData.spoolBatch = 0;
+                MQTT_APP_SysMQTT_init();
+            }
+            /*before SYS_MQTT_Task(): SYS_NET may look up the broker address*/
+            APP_DNSCACHE_Tasks();
             if (mqtt_appData.pubFlag) {/*This flag will be set in timerCallback()*/
                 mqtt_appData.pubFlag = false;
                 publishMessage();
             }
             SYS_MQTT_Task(mqtt_appData.SysMqttHandle);
+            if (!mqtt_appData.MQTTConnected) {
+                /*SYS_NET/SYS_MQTT connection state machine needs to be polled*/
+                APP_RTOS_PollRequest(APP_RTOS_TASK_MQTT_APP);
+            } else if ((mqtt_appData.spoolBatch != 0) || (APP_SPOOL_PendingCount() != 0)) {
+                drainSpool();
+                /*keep draining at the task period*/
+                APP_RTOS_PollRequest(APP_RTOS_TASK_MQTT_APP);
+            }
             break;
         }
         default:
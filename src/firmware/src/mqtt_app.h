@@ -35,6 +35,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "config/pic32mz_w1_curiosity/system/system_module.h"
+#include "app_spool.h"
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
@@ -45,11 +46,39 @@ extern "C" {
 // DOM-IGNORE-END
 
 #define MQTT_APP_TOPIC_NAME_MAX_LEN 161
-#define MQTT_APP_TELEMETRY_MSG_TEMPLATE "{\"Temperature (C)\": %d}"
-#define MQTT_APP_TELEMETRY_MSG_GRAD_TEMPLATE "{\"Temperature (C)\": %d,\"switch\":%d}"
-#define MQTT_APP_SHADOW_MSG_TEMPLATE "{\"state\":{\"reported\":{\"toggle\": %d}}}"
+/*The messages are assembled from these fragments and the field values by
+  mqtt_app.c, without going through printf*/
+/*{"Temperature (C)": <temp>}*/
+#define MQTT_APP_TELEMETRY_MSG_PREFIX "{\"Temperature (C)\": "
+#define MQTT_APP_TELEMETRY_MSG_GRAD_SWITCH ",\"switch\":"
+#define MQTT_APP_TELEMETRY_MSG_SUFFIX "}"
+/*{"state":{"reported":{"toggle": <led>}}}*/
+#define MQTT_APP_SHADOW_MSG_PREFIX "{\"state\":{\"reported\":{\"toggle\": "
+#define MQTT_APP_SHADOW_MSG_SUFFIX "}}}"
+/*Batched telemetry: time of the first sample, then one [dt,temp,switch,rssi] row per sample.
+  Spooled batches also carry the number of the first sample so that duplicates can be dropped.
+  {"ts":<ts>,"seq":<seq>,"s":[[dt,temp,switch,rssi],...]}*/
+#define MQTT_APP_TELEMETRY_BATCH_TS "{\"ts\":"
+#define MQTT_APP_TELEMETRY_BATCH_SEQ ",\"seq\":"
+#define MQTT_APP_TELEMETRY_BATCH_ROWS ",\"s\":["
+#define MQTT_APP_TELEMETRY_BATCH_END "]}"
+#define MQTT_APP_TELEMETRY_BATCH_ROW_MAX_LEN 32
 #define MQTT_APP_MAX_MSG_LLENGTH 64
+#define MQTT_APP_SENSORS_TOPIC_TEMPLATE "%s/sensors"
 #define MQTT_APP_SHADOW_UPDATE_TOPIC_TEMPLATE "$aws/things/%s/shadow/update"
+#define MQTT_APP_HEAPSTAT_TOPIC_TEMPLATE "%s/diag/heap"
+/*Heap diagnostics, the "heap" command output. A [current,peak,fails] row per tag:
+  {"size":<heap>,"lfb":<largest free>,"lfbMin":<lowest>,"cur":<total>,"peak":<total>,"rtosFails":<n>,"tags":{"tcpip":[cur,peak,fails],...}}*/
+#define MQTT_APP_HEAPSTAT_MSG_SIZE "{\"size\":"
+#define MQTT_APP_HEAPSTAT_MSG_LFB ",\"lfb\":"
+#define MQTT_APP_HEAPSTAT_MSG_LFB_MIN ",\"lfbMin\":"
+#define MQTT_APP_HEAPSTAT_MSG_CUR ",\"cur\":"
+#define MQTT_APP_HEAPSTAT_MSG_PEAK ",\"peak\":"
+#define MQTT_APP_HEAPSTAT_MSG_RTOS_FAILS ",\"rtosFails\":"
+#define MQTT_APP_HEAPSTAT_MSG_TAGS ",\"tags\":{"
+#define MQTT_APP_HEAPSTAT_MSG_END "}}"
+/*numbers of up to 10 digits*/
+#define MQTT_APP_HEAPSTAT_MSG_MAX_LEN (128 + (APP_HEAPSTAT_COUNT * 48))
 /*Subscribe to wildcard topic (update/#) to enable AWS qualification log collection*/
 #define MQTT_APP_SHADOW_DELTA_TOPIC_TEMPLATE "$aws/things/%s/shadow/update/delta" 
 
@@ -65,8 +94,17 @@ typedef struct
     SYS_MODULE_OBJ      SysMqttHandle;
     bool pubFlag;
     bool MQTTConnected;
-    bool MQTTPubQueued; /*MQTT service does not queue messages*/
     bool shadowUpdate;
+    uint8_t spoolBatch;     /*spooled records published, committed once their message is acked*/
+    uint16_t spoolMsgId;    /*SYS_MQTT message Id of the spooled batch*/
+    bool spoolAcked;
+    TickType_t lastDrainTick;
+    APP_SPOOL_RECORD batch[MQTT_APP_TELEMETRY_BATCH];
+    uint8_t batchCount;
+    TickType_t batchStartTick;
+#if defined(APP_HEAPSTAT_ENABLE) && defined(MQTT_APP_HEAPSTAT_PERIOD)
+    TickType_t lastHeapStatTick;
+#endif
 } MQTT_APP_DATA;
 
 void MQTT_APP_Initialize ( void );
@@ -39,7 +39,10 @@
 #include "ssl.h"
 #include "wolfcrypt/asn.h"
 #include "wolfcrypt/sha256.h"
-#include "cJSON.h"
+#include "app_json.h"
+#include "sys_tasks.h"
+#include "system/fs/fat_fs/hardware_access/diskio.h"
+#include <ctype.h>
 
 MSD_APP_DATA msd_appData;
 
@@ -54,11 +57,16 @@ void APP_USBDeviceEventHandler(USB_DEVICE_EVENT event, void * pEventData, uintpt
         case USB_DEVICE_EVENT_DECONFIGURED:
 
             /* Device was reset or de-configured. Update LED status */
+            appData->hostAttached = false;
+            /*look at the files the host may have edited*/
+            appData->checkHash = true;
+            APP_RTOS_Notify(xMSD_APP_Tasks);
             break;
 
         case USB_DEVICE_EVENT_CONFIGURED:
 
             /* Device is configured. Update LED status */
+            appData->hostAttached = true;
             break;
 
         case USB_DEVICE_EVENT_SUSPENDED:
@@ -74,6 +82,9 @@ void APP_USBDeviceEventHandler(USB_DEVICE_EVENT event, void * pEventData, uintpt
 
             /* VBUS is not detected. Detach the device */
             USB_DEVICE_Detach(appData->usbDeviceHandle);
+            appData->hostAttached = false;
+            appData->checkHash = true;
+            APP_RTOS_Notify(xMSD_APP_Tasks);
             break;
 
             /* These events are not used in this demo */
@@ -108,6 +119,15 @@ void MSD_APP_Initialize(void) {
     msd_appData.fsMounted = false;
 
     msd_appData.checkHash = true;
+    msd_appData.remountPending = false;
+    msd_appData.watchRetry = false;
+    msd_appData.hostAttached = false;
+}
+
+void MSD_APP_MediaEjected(void) {
+    msd_appData.hostAttached = false;
+    msd_appData.checkHash = true;
+    APP_RTOS_Notify(xMSD_APP_Tasks);
 }
 
 static int MSD_APP_Write_errInfo(char* errorString) {
@@ -136,37 +156,39 @@ static int MSD_APP_Write_errInfo(char* errorString) {
 
 static uint8_t sernum[ATCA_SERIAL_NUM_SIZE];
 
+/*A brownout while writing leaves the old or the new file, never a truncated one*/
 static int write_file(const char* fileName, const void *buffer, size_t nbyte) {
-    SYS_FS_HANDLE fd = 0;
-    size_t size;
     SYS_CONSOLE_PRINT("Creating %s\r\n", fileName);
-    fd = SYS_FS_FileOpen(fileName, SYS_FS_FILE_OPEN_WRITE);
-    if (SYS_FS_HANDLE_INVALID != fd) {
-
-        size = SYS_FS_FileWrite(fd, buffer, nbyte);
-        SYS_FS_FileSync(fd);
-        SYS_FS_FileClose(fd);
-
-        if ((nbyte) != size) {
-            SYS_CONSOLE_PRINT("error writing %s . Size mismatch (got %d on fd %x. FSError = %d) \r\n", fileName, (int) size, (int) fd, SYS_FS_Error());
-            return -1;
-        }
-    } else {
-        SYS_CONSOLE_PRINT("Error creating new %s (fsError=%d)\r\n", fileName, SYS_FS_Error());
-        return -2;
+    if (SYS_FS_RES_SUCCESS != SYS_FS_FileWriteAtomic(fileName, buffer, nbyte)) {
+        SYS_CONSOLE_PRINT("Error writing %s (fsError=%d)\r\n", fileName, SYS_FS_Error());
+        return -1;
     }
     return 0;
 }
 
+/*Config file contents. A file larger than this is rejected instead of being read on the stack.*/
+static char msdAppConfigBuf[MSD_APP_CONFIG_FILE_MAX_SIZE + 1];
+
 static int MSD_APP_Write_Config(void) {
     SYS_FS_RESULT fsResult = SYS_FS_RES_FAILURE;
 
 #ifdef MSD_APP_TXT_CONFIG
     fsResult = SYS_FS_FileStat(MSD_APP_TXT_CONFIG_FILE_NAME, &msd_appData.fileStatus);
     if (SYS_FS_RES_FAILURE == fsResult) {
-        /*No config file found . Create one. */
-        SYS_CONSOLE_PRINT("No TXT config file found. Creating default at "MSD_APP_TXT_CONFIG_FILE_NAME"\r\n");
-        if (0 != write_file(MSD_APP_TXT_CONFIG_FILE_NAME, MSD_APP_TXT_CONFIG_DATA, strlen(MSD_APP_TXT_CONFIG_DATA))) {
+        const char *config = MSD_APP_TXT_CONFIG_DATA;
+
+        /*No config file found . Create one, from the stored config if there is one. */
+        if (app_controlData.wifiCtrl.wifiCtrlValid) {
+            bool open = (WIFI_OPEN == app_controlData.wifiCtrl.authmode);
+
+            snprintf(msdAppConfigBuf, sizeof (msdAppConfigBuf), MSD_APP_TXT_CONFIG_DATA_TEMPLATE,
+                    app_controlData.wifiCtrl.SSID, open ? "" : app_controlData.wifiCtrl.pass, open ? 1 : 2);
+            config = msdAppConfigBuf;
+            SYS_CONSOLE_PRINT("No TXT config file found. Exporting the stored config to "MSD_APP_TXT_CONFIG_FILE_NAME"\r\n");
+        } else {
+            SYS_CONSOLE_PRINT("No TXT config file found. Creating default at "MSD_APP_TXT_CONFIG_FILE_NAME"\r\n");
+        }
+        if (0 != write_file(MSD_APP_TXT_CONFIG_FILE_NAME, config, strlen(config))) {
             return -3;
         }
 
@@ -178,169 +200,331 @@ static int MSD_APP_Write_Config(void) {
     return 0;
 }
 
-static int MSD_APP_Read_cloud_config() {
-    /*Read the MQTT config now*/
+/*Reads a config file into msdAppConfigBuf and NUL terminates it. Returns its size, < 0 on error.*/
+static int MSD_APP_Read_config_file(const char *fileName) {
+    SYS_FS_HANDLE fd;
+    int32_t size;
+    size_t rSize;
 
-    SYS_FS_RESULT fsResult = SYS_FS_RES_FAILURE;
-    SYS_FS_HANDLE fd = 0;
-    size_t size, rSize;
-    fsResult = SYS_FS_FileStat(MSD_APP_CLOUD_CONFIG_FILE_NAME, &msd_appData.fileStatus);
-    if (SYS_FS_RES_FAILURE != fsResult) {
-        fd = SYS_FS_FileOpen(MSD_APP_CLOUD_CONFIG_FILE_NAME, SYS_FS_FILE_OPEN_READ);
-        if (SYS_FS_HANDLE_INVALID != fd) {
-            /*get size of file*/
-            SYS_FS_FileSeek(fd, 0L, SYS_FS_SEEK_END);
-            size = SYS_FS_FileTell(fd);
-            SYS_FS_FileSeek(fd, 0L, SYS_FS_SEEK_SET);
-            char configString[size + 1];
-            
-            rSize = SYS_FS_FileRead(fd, configString, size);
-            SYS_FS_FileClose(fd);
-
-            if (rSize != size) {
-                SYS_CONSOLE_PRINT("error reading Cloud config file . Size mismatch (got %d. Expected %d. FSError = %d) \r\n", (int) rSize, (int) size, SYS_FS_Error());
-                return -1;
-            }
+    fd = SYS_FS_FileOpen(fileName, SYS_FS_FILE_OPEN_READ);
+    if (SYS_FS_HANDLE_INVALID == fd) {
+        SYS_CONSOLE_PRINT("Error opening %s (fsError=%d)\r\n", fileName, SYS_FS_Error());
+        return -1;
+    }
+    size = SYS_FS_FileSize(fd);
+    if ((size < 0) || (size > MSD_APP_CONFIG_FILE_MAX_SIZE)) {
+        SYS_CONSOLE_PRINT("error reading %s . Too large (got %d. Expected maximum %d) \r\n", fileName, (int) size, MSD_APP_CONFIG_FILE_MAX_SIZE);
+        SYS_FS_FileClose(fd);
+        return -2;
+    }
+    rSize = SYS_FS_FileRead(fd, msdAppConfigBuf, (size_t) size);
+    SYS_FS_FileClose(fd);
 
-            const cJSON *broker = NULL;
-            const cJSON *clientID = NULL;
+    if (rSize != (size_t) size) {
+        SYS_CONSOLE_PRINT("error reading %s . Size mismatch (got %d. Expected %d. FSError = %d) \r\n", fileName, (int) rSize, (int) size, SYS_FS_Error());
+        return -3;
+    }
+    msdAppConfigBuf[size] = '\0';
+    return (int) size;
+}
 
-            cJSON *config_json = cJSON_Parse(configString);
-            if (config_json == NULL) {
-                const char *error_ptr = cJSON_GetErrorPtr();
-                if (error_ptr != NULL) {
-                    SYS_CONSOLE_PRINT("Cloud config parse Error. Error before: %s\n", error_ptr);
-                }
-                cJSON_Delete(config_json);
-                return -2;
-            }
+static int MSD_APP_Read_cloud_config() {
+    /*Read the MQTT config now*/
+    int size = MSD_APP_Read_config_file(MSD_APP_CLOUD_CONFIG_FILE_NAME);
 
-            bool err = false;
-            broker = cJSON_GetObjectItemCaseSensitive(config_json, "broker");
-            if (cJSON_IsString(broker) && (broker->valuestring != NULL)) {
-                SYS_CONSOLE_PRINT("    Cloud config broker \"%s\"\r\n", broker->valuestring);
-            } else {
-                SYS_CONSOLE_PRINT("Error parsing broker from cloud config\r\n");
-                err = true;
-            }
+    if (size < 0) {
+        return -1;
+    }
 
-            clientID = cJSON_GetObjectItemCaseSensitive(config_json, "clientID");
-            if (cJSON_IsString(clientID) && (clientID->valuestring != NULL)) {
-                SYS_CONSOLE_PRINT("    Cloud config clientID \"%s\"\r\n", clientID->valuestring);
-            } else {
-                SYS_CONSOLE_PRINT("Error parsing clientID from Cloud config\r\n");
-                err = true;
-            }
+    char broker[APP_CTRL_MAX_BROKER_NAME_LEN];
+    char clientID[APP_CTRL_MAX_CLIENT_ID_LEN];
+    APP_JSON_STRING_BUF brokerBuf = {broker, sizeof (broker), false};
+    APP_JSON_STRING_BUF clientIDBuf = {clientID, sizeof (clientID), false};
+    APP_JSON_HANDLER handlers[] = {
+        {"/broker", APP_JSON_GetString, &brokerBuf},
+        {"/clientID", APP_JSON_GetString, &clientIDBuf},
+    };
+    size_t errPos = 0;
+
+    if (APP_JSON_OK != APP_JSON_Parse(msdAppConfigBuf, (size_t) size, handlers, sizeof (handlers) / sizeof (handlers[0]), &errPos)) {
+        SYS_CONSOLE_PRINT("Cloud config parse Error at offset %d\n", (int) errPos);
+        return -2;
+    }
 
-            if (true == err) return -3;
+    bool err = false;
+    if (brokerBuf.found) {
+        SYS_CONSOLE_PRINT("    Cloud config broker \"%s\"\r\n", broker);
+    } else {
+        SYS_CONSOLE_PRINT("Error parsing broker from cloud config\r\n");
+        err = true;
+    }
 
-            /*set read config into app control structure.*/
-            app_controlData.mqttCtrl.mqttConfigValid = false;
-            strncpy(app_controlData.mqttCtrl.mqttBroker, broker->valuestring, APP_CTRL_MAX_BROKER_NAME_LEN - 1);
-            strncpy(app_controlData.mqttCtrl.clientId, clientID->valuestring, APP_CTRL_MAX_CLIENT_ID_LEN - 1);
-            app_controlData.mqttCtrl.mqttConfigValid = true;
-            cJSON_Delete(config_json);
-        }
+    if (clientIDBuf.found) {
+        SYS_CONSOLE_PRINT("    Cloud config clientID \"%s\"\r\n", clientID);
     } else {
-        SYS_CONSOLE_PRINT("Error opening Cloud config file (fsError=%d)\r\n", SYS_FS_Error());
-        return -1;
+        SYS_CONSOLE_PRINT("Error parsing clientID from Cloud config\r\n");
+        err = true;
     }
 
+    if (true == err) return -3;
+
+    /*set read config into app control structure.*/
+    app_controlData.mqttCtrl.mqttConfigValid = false;
+    strncpy(app_controlData.mqttCtrl.mqttBroker, broker, APP_CTRL_MAX_BROKER_NAME_LEN - 1);
+    strncpy(app_controlData.mqttCtrl.clientId, clientID, APP_CTRL_MAX_CLIENT_ID_LEN - 1);
+    app_controlData.mqttCtrl.mqttConfigValid = true;
+
     return 0;
 }
 
-static int MSD_APP_Read_Config(void) {
+#ifdef MSD_APP_TXT_CONFIG
+/*Splits the next comma separated field off *cursor. strtok() is not used, its state is shared by all the tasks.*/
+static char *MSD_APP_Next_field(char **cursor) {
+    char *field = *cursor;
+    char *end;
+
+    if (NULL == field) {
+        return NULL;
+    }
+    end = strchr(field, ',');
+    if (NULL != end) {
+        *end = '\0';
+        *cursor = end + 1;
+    } else {
+        *cursor = NULL;
+    }
+    return field;
+}
+#endif
+
+static int MSD_APP_Read_wifi_config(void) {
 
 #ifdef MSD_APP_TXT_CONFIG
     {
-        SYS_FS_RESULT fsResult = SYS_FS_RES_FAILURE;
-        SYS_FS_HANDLE fd = 0;
-        size_t size, rSize;
-        fsResult = SYS_FS_FileStat(MSD_APP_TXT_CONFIG_FILE_NAME, &msd_appData.fileStatus);
-        if (SYS_FS_RES_FAILURE != fsResult) {
-            fd = SYS_FS_FileOpen(MSD_APP_TXT_CONFIG_FILE_NAME, SYS_FS_FILE_OPEN_READ);
-            if (SYS_FS_HANDLE_INVALID != fd) {
-                /*get size of file*/
-                SYS_FS_FileSeek(fd, 0L, SYS_FS_SEEK_END);
-                size = SYS_FS_FileTell(fd);
-                SYS_FS_FileSeek(fd, 0L, SYS_FS_SEEK_SET);
-
-                char configString[size + 1];
-
-                //SYS_CONSOLE_PRINT("Config file size : %d bytes \r\n", (int) size);
-
-                rSize = SYS_FS_FileRead(fd, configString, size);
-                SYS_FS_FileClose(fd);
-
-                if (rSize != size) {
-                    SYS_CONSOLE_PRINT("error reading TXT config file . Size mismatch (got %d. Expected %d. FSError = %d) \r\n", (int) rSize, (int) size, SYS_FS_Error());
-                    return -3;
-                } else {
+        char *cursor, *ssid, *password, *authMode;
+        int size = MSD_APP_Read_config_file(MSD_APP_TXT_CONFIG_FILE_NAME);
 
-                    char *ssid, *password, *authMode;
-
-                    if(rSize < MSD_APP_TXT_CONFIG_FILE_MIN_SIZE)
-                    {
-                        SYS_CONSOLE_PRINT("error reading TXT config file . Size mismatch (got %d. Expected minimum %d. FSError = %d) \r\n", (int) rSize, MSD_APP_TXT_CONFIG_FILE_MIN_SIZE, SYS_FS_Error());
-                        return -3;                        
-                    }
-                    
-                    taskENTER_CRITICAL();
-                    ssid = strtok(&configString[19], ",");
-                    password = strtok(NULL, ",");
-                    authMode = strtok(NULL, ",");
-                    taskEXIT_CRITICAL();
-
-                    //no SSID is passed when the auth mode is open
-                    if (NULL == authMode) {
-                        authMode = password;
-                        password = NULL;
-                    }
-
-                    uint32_t mode = (uint32_t) atoi(authMode);
-                    /*Validate the input*/
-                    if ((NULL == ssid) || (mode > 3) || (mode <= 0)) {
-                        SYS_CONSOLE_PRINT("error parsing TXT config. (ssid=%s, pass=%s, mode=%d\r\n)", ssid, password, mode);
-                        return -4;
-                    }
-
-                    SYS_CONSOLE_PRINT("Applying TXT config. (ssid=%s, pass=%s, mode=%d)\r\n", ssid, password, mode);
-
-                    /*set read config into app control structure.*/
-                    strncpy(app_controlData.wifiCtrl.SSID, ssid, APP_CTRL_MAX_SSID_LEN - 1);
-                    if(password)
-                        strncpy(app_controlData.wifiCtrl.pass, password, APP_CTRL_MAX_WIFI_PASS_LEN - 1);
-                    
-                    app_controlData.wifiCtrl.wifiCtrlValid = false;
-                    switch (mode) {
-                        case 1:
-                            app_controlData.wifiCtrl.authmode = WIFI_OPEN;
-                            break;
-                        case 2:
-                        case 3:
-                            app_controlData.wifiCtrl.authmode = WIFI_WPAWPA2MIXED;
-                            break;
-                        default:
-                            app_controlData.wifiCtrl.authmode = WIFI_WPAWPA2MIXED;
-                            SYS_CONSOLE_PRINT("Invalid auth mode in TXT config. Using SYS_WIFI_WPA2WPA3MIXED");
-                    }
-                    app_controlData.wifiCtrl.wifiCtrlValid = true;
-                    //return 0;
-                }
-            }
-        } else {
-            SYS_CONSOLE_PRINT("Error opening TXT config file (fsError=%d)\r\n", SYS_FS_Error());
+        if (size < 0) {
             return -2;
         }
+        if ((size < MSD_APP_TXT_CONFIG_FILE_MIN_SIZE) ||
+                (0 != strncmp(msdAppConfigBuf, MSD_APP_TXT_CONFIG_PREFIX, strlen(MSD_APP_TXT_CONFIG_PREFIX)))) {
+            SYS_CONSOLE_PRINT("error reading TXT config file . Expected \""MSD_APP_TXT_CONFIG_PREFIX"\" and minimum %d bytes (got %d) \r\n", MSD_APP_TXT_CONFIG_FILE_MIN_SIZE, size);
+            return -3;
+        }
+
+        cursor = &msdAppConfigBuf[strlen(MSD_APP_TXT_CONFIG_PREFIX)];
+        ssid = MSD_APP_Next_field(&cursor);
+        password = MSD_APP_Next_field(&cursor);
+        authMode = MSD_APP_Next_field(&cursor);
+
+        //no SSID is passed when the auth mode is open
+        if (NULL == authMode) {
+            authMode = password;
+            password = NULL;
+        }
+
+        uint32_t mode = (NULL != authMode) ? (uint32_t) atoi(authMode) : 0;
+        /*Validate the input*/
+        if ((NULL == ssid) || ('\0' == ssid[0]) || (mode > 3) || (mode <= 0)) {
+            SYS_CONSOLE_PRINT("error parsing TXT config. (ssid=%s, pass=%s, mode=%d\r\n)", ssid ? ssid : "", password ? password : "", mode);
+            return -4;
+        }
+
+        SYS_CONSOLE_PRINT("Applying TXT config. (ssid=%s, pass=%s, mode=%d)\r\n", ssid, password ? password : "", mode);
+
+        /*set read config into app control structure.*/
+        app_controlData.wifiCtrl.wifiCtrlValid = false;
+        strncpy(app_controlData.wifiCtrl.SSID, ssid, APP_CTRL_MAX_SSID_LEN - 1);
+        if (password)
+            strncpy(app_controlData.wifiCtrl.pass, password, APP_CTRL_MAX_WIFI_PASS_LEN - 1);
+
+        switch (mode) {
+            case 1:
+                app_controlData.wifiCtrl.authmode = WIFI_OPEN;
+                break;
+            case 2:
+            case 3:
+                app_controlData.wifiCtrl.authmode = WIFI_WPAWPA2MIXED;
+                break;
+            default:
+                app_controlData.wifiCtrl.authmode = WIFI_WPAWPA2MIXED;
+                SYS_CONSOLE_PRINT("Invalid auth mode in TXT config. Using SYS_WIFI_WPA2WPA3MIXED");
+        }
+        app_controlData.wifiCtrl.wifiCtrlValid = true;
     }
 #endif // MSD_APP_TXT_CONFIG
-    /*all good so far. Now read MQTT config*/
-    return MSD_APP_Read_cloud_config();
+    return 0;
+}
+
+/*The Wi-Fi config is only required with MSD_APP_TXT_CONFIG*/
+static bool MSD_APP_Config_valid(void) {
+#ifdef MSD_APP_TXT_CONFIG
+    if (!app_controlData.wifiCtrl.wifiCtrlValid) {
+        return false;
+    }
+#endif
+    return app_controlData.mqttCtrl.mqttConfigValid;
+}
+
+static const char * const msdAppWatchName[MSD_APP_WATCH_COUNT] = {
+#ifdef MSD_APP_TXT_CONFIG
+    MSD_APP_TXT_CONFIG_FILE_NAME,
+#else
+    NULL,
+#endif
+    MSD_APP_CLOUD_CONFIG_FILE_NAME,
+};
+
+/*Record a watched file is imported into*/
+static const APP_CFGSTORE_REC msdAppWatchRec[MSD_APP_WATCH_COUNT] = {
+    APP_CFGSTORE_WIFI,
+    APP_CFGSTORE_CLOUD,
+};
+
+/*SHA-256 of the file content, on the crypto engine with WOLFSSL_PIC32MZ_HASH*/
+static int MSD_APP_Hash_file(const char *fileName, unsigned char *hash) {
+    SYS_FS_HANDLE fd;
+    wc_Sha256 sha;
+    uint8_t buf[128];
+    size_t nBytes;
+    int ret;
+
+    fd = SYS_FS_FileOpen(fileName, SYS_FS_FILE_OPEN_READ);
+    if (SYS_FS_HANDLE_INVALID == fd) {
+        return -1;
+    }
+    ret = wc_InitSha256(&sha);
+    while ((0 == ret) && ((nBytes = SYS_FS_FileRead(fd, buf, sizeof (buf))) != 0)) {
+        ret = (nBytes != (size_t) - 1) ? wc_Sha256Update(&sha, buf, nBytes) : -1;
+    }
+    if (0 == ret) {
+        ret = wc_Sha256Final(&sha, hash);
+    }
+    wc_Sha256Free(&sha);
+    SYS_FS_FileClose(fd);
+    return ret;
+}
+
+/*Returns true if the content of the watched file changed since the last call*/
+static bool MSD_APP_Watch_file(MSD_APP_WATCH_FILE file) {
+    MSD_APP_WATCH_STATE *w = &msd_appData.watch[file];
+    SYS_FS_FSTAT *stat = &msd_appData.fileStatus;
+    unsigned char hash[sizeof (w->src.hash)];
+    bool exists;
+
+    if (NULL == msdAppWatchName[file]) {
+        return false;
+    }
+    exists = (SYS_FS_RES_SUCCESS == SYS_FS_FileStat(msdAppWatchName[file], stat));
+    if (!exists) {
+        w->exists = false;
+        return false;
+    }
+    if (w->exists && (w->src.fsize == stat->fsize) && (w->src.fdate == stat->fdate) && (w->src.ftime == stat->ftime)) {
+        return false;
+    }
+    if (0 != MSD_APP_Hash_file(msdAppWatchName[file], hash)) {
+        /*the old stat stays: the file is looked at again on the next check*/
+        SYS_CONSOLE_PRINT(TERM_RED"MSD_APP: Failed reading %s\r\n"TERM_RESET, msdAppWatchName[file]);
+        msd_appData.watchRetry = true;
+        return false;
+    }
+    w->exists = true;
+    w->src.fsize = stat->fsize;
+    w->src.fdate = stat->fdate;
+    w->src.ftime = stat->ftime;
+    /*the host may rewrite a file with the same content, e.g. on save without changes*/
+    if (0 == memcmp(hash, w->src.hash, sizeof (hash))) {
+        return false;
+    }
+    memcpy(w->src.hash, hash, sizeof (hash));
+    return true;
+}
+
+/*Running config from the record store. The watch starts from the files the records were imported from: only the
+ files edited since then are parsed.*/
+static void MSD_APP_Load_config(bool fromRecords) {
+    int i;
+
+    memset(msd_appData.watch, 0, sizeof (msd_appData.watch));
+    for (i = 0; fromRecords && (i < MSD_APP_WATCH_COUNT); i++) {
+        msd_appData.watch[i].exists = APP_CFGSTORE_Load(msdAppWatchRec[i], &msd_appData.watch[i].src);
+    }
+}
+
+/*Parses the config files changed since the last look and stores them. Returns the MSD_APP_WATCH_FILE bits of the
+ imported ones.*/
+static uint32_t MSD_APP_Import_config(void) {
+    uint32_t imported = 0;
+    int i, ret;
+
+    msd_appData.watchRetry = false;
+    for (i = 0; i < MSD_APP_WATCH_COUNT; i++) {
+        if (!MSD_APP_Watch_file(i)) {
+            continue;
+        }
+        SYS_CONSOLE_PRINT(TERM_CYAN"MSD_APP: Importing %s\r\n"TERM_RESET, msdAppWatchName[i]);
+        ret = (MSD_APP_WATCH_WIFI_CONFIG == i) ? MSD_APP_Read_wifi_config() : MSD_APP_Read_cloud_config();
+        if (0 != ret) {
+            /*the running config stays, the file is looked at again once it changes*/
+            continue;
+        }
+#ifdef APP_FLASH_RESERVED_ENABLE
+        if (!APP_CFGSTORE_Save(msdAppWatchRec[i], &msd_appData.watch[i].src)) {
+            SYS_CONSOLE_PRINT(TERM_RED"MSD_APP: Failed storing %s, it is parsed again on the next boot\r\n"TERM_RESET, msdAppWatchName[i]);
+        }
+#endif
+        imported |= 1UL << i;
+    }
+    return imported;
+}
+
+static bool checkFSMount(unsigned long mountflags);
+
+/*Hot-apply config files edited from the USB host*/
+static void MSD_APP_Check_config(void) {
+    uint32_t writeCount = disk_write_count();
+    uint32_t imported;
+
+    if (!msd_appData.remountPending) {
+        /*nothing at all was written to the media: no need to look at it*/
+        if ((writeCount == msd_appData.watchWriteCount) && !msd_appData.watchRetry) {
+            return;
+        }
+        /*the device side FAT state would race the host writes: the files are looked at once the host
+         ejects the drive or detaches*/
+        if (msd_appData.hostAttached) {
+            return;
+        }
+        /*FatFs keeps a sector of the FAT/directory in its window, remount so that the host changes are seen*/
+        SYS_FS_Unmount(SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0);
+        msd_appData.remountPending = true;
+        if (!checkFSMount(SYS_FS_MOUNT_NO_RECOVERY)) {
+            /*retried on the next polls, as the boot mount*/
+            SYS_CONSOLE_PRINT(TERM_RED"MSD_APP: Failed remounting the FS, retrying\r\n"TERM_RESET);
+            return;
+        }
+    } else if (!checkFSMount(SYS_FS_MOUNT_NO_RECOVERY)) {
+        return;
+    }
+    /*the write count moves on only once the volume is back*/
+    msd_appData.remountPending = false;
+    msd_appData.watchWriteCount = writeCount;
+    SYS_FS_CurrentDriveSet(SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0);
+
+    imported = MSD_APP_Import_config();
+    if (imported & (1UL << MSD_APP_WATCH_WIFI_CONFIG)) {
+        app_controlData.wifiCtrl.wifiCtrlChanged = true;
+        APP_RTOS_Notify(xAPP_WIFI_Tasks);
+    }
+    if (imported & (1UL << MSD_APP_WATCH_CLOUD_CONFIG)) {
+        app_controlData.mqttCtrl.mqttConfigChanged = true;
+        APP_RTOS_Notify(xMQTT_APP_Tasks);
+    }
 }
 
 static int MSD_APP_Write_Serial(void) {
-    SYS_FS_HANDLE fd = 0;
-    size_t size;
     SYS_FS_RESULT fsResult = SYS_FS_RES_FAILURE;
 
     /*Initialize device serial number into the controlData structure.*/
@@ -355,19 +539,8 @@ static int MSD_APP_Write_Serial(void) {
 
     fsResult = SYS_FS_FileStat(MSD_APP_SERIAL_FILE_NAME, &msd_appData.fileStatus);
     if (SYS_FS_RES_FAILURE == fsResult) {
-        SYS_CONSOLE_PRINT("Creating serial file at "MSD_APP_SERIAL_FILE_NAME"\r\n");
-        fd = SYS_FS_FileOpen(MSD_APP_SERIAL_FILE_NAME, SYS_FS_FILE_OPEN_WRITE);
-        if (SYS_FS_HANDLE_INVALID != fd) {
-            size = SYS_FS_FileWrite(fd, packedDisplayStr, packedDispLen);
-            SYS_FS_FileClose(fd);
-
-            if ((packedDispLen) != size) {
-                SYS_CONSOLE_PRINT("error writing serial file . Size mismatch (got %d on fd %x. FSError = %d) \r\n", (int) size, (int) fd, SYS_FS_Error());
-                return -1;
-            }
-        } else {
-            SYS_CONSOLE_PRINT("Error creating new serial file (fsError=%d)\r\n", SYS_FS_Error());
-            return -2;
+        if (0 != write_file(MSD_APP_SERIAL_FILE_NAME, packedDisplayStr, packedDispLen)) {
+            return -1;
         }
     } else {
         //SYS_CONSOLE_PRINT("Serial file already exists \r\n");
@@ -399,70 +572,172 @@ static int getSubjectKeyID(uint8_t* derCert, size_t derCertSz, char* keyID) {
     return ret;
 }
 
-/*Pull device, signer and root certificates from the ECC608 device and write them to the MSD. Also re-create the cloud config file*/
-static int MSD_APP_Write_certs(void) {
-    ATCA_STATUS status;
+/*Security artifacts pulled from the ECC608/TNG into the MSD. Provisioning scans the root and sec/ directories once
+ and writes only the files that are missing.*/
+typedef enum {
+    MSD_APP_ARTIFACT_ROOT_CERT = 0,
+    MSD_APP_ARTIFACT_SIGNER_CERT,
+    MSD_APP_ARTIFACT_DEVICE_CERT,
+    MSD_APP_ARTIFACT_DEVICE_PEM,
+    MSD_APP_ARTIFACT_CLICKME,
+    MSD_APP_ARTIFACT_VOICE_CLICKME,
+    MSD_APP_ARTIFACT_CLOUD_CONFIG,
+    MSD_APP_ARTIFACT_SLOT_0_KEY,
+    MSD_APP_ARTIFACT_SLOT_1_KEY,
+    MSD_APP_ARTIFACT_SLOT_2_KEY,
+    MSD_APP_ARTIFACT_SLOT_3_KEY,
+    MSD_APP_ARTIFACT_SLOT_4_KEY,
+    MSD_APP_ARTIFACT_ROOT_KEY,
+    MSD_APP_ARTIFACT_SIGNER_KEY,
+    MSD_APP_ARTIFACT_DEVICE_KEY,
+    MSD_APP_ARTIFACT_COUNT
+} MSD_APP_ARTIFACT;
+
+#define MSD_APP_ARTIFACT_BIT(a) (1UL << (a))
+#define MSD_APP_ARTIFACTS_ALL (MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_COUNT) - 1UL)
+/*Files generated from the key ID of the device certificate*/
+#define MSD_APP_ARTIFACTS_KEY_ID (MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_CLICKME) | \
+        MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_VOICE_CLICKME) | MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_CLOUD_CONFIG))
+/*The device certificate can only be read along with the signer certificate*/
+#define MSD_APP_ARTIFACTS_DEVICE_CERT (MSD_APP_ARTIFACTS_KEY_ID | \
+        MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_DEVICE_CERT) | MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_DEVICE_PEM))
+#define MSD_APP_ARTIFACTS_SIGNER_CERT (MSD_APP_ARTIFACTS_DEVICE_CERT | MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_SIGNER_CERT))
+
+/*<serial>.cer*/
+static char devPemFileName[APP_SERIAL_NUM_STR_LEN + 5];
+
+static const char * const msdAppArtifactName[MSD_APP_ARTIFACT_COUNT] = {
+    MSD_APP_ROOTCERT_FILE_NAME,
+    MSD_APP_SIGNER_FILE_NAME,
+    MSD_APP_DEVCERT_FILE_NAME,
+    devPemFileName,
+    MSD_APP_CLICKME_FILE_NAME,
+    MSD_APP_VOICE_CLICKME_FILE_NAME,
+    MSD_APP_CLOUD_CONFIG_FILE_NAME,
+    MSD_APP_SLOT_0_PUBKEY_FILE_NAME,
+    MSD_APP_SLOT_1_PUBKEY_FILE_NAME,
+    MSD_APP_SLOT_2_PUBKEY_FILE_NAME,
+    MSD_APP_SLOT_3_PUBKEY_FILE_NAME,
+    MSD_APP_SLOT_4_PUBKEY_FILE_NAME,
+    MSD_APP_ROOT_PUBKEY_FILE_NAME,
+    MSD_APP_SIGNER_PUBKEY_FILE_NAME,
+    MSD_APP_DEVICE_PUBKEY_FILE_NAME,
+};
+
+/*FAT names are case insensitive*/
+static bool MSD_APP_Name_equals(const char *a, const char *b) {
+    while ((*a != '\0') && (tolower((unsigned char) *a) == tolower((unsigned char) *b))) {
+        a++;
+        b++;
+    }
+    return (tolower((unsigned char) *a) == tolower((unsigned char) *b));
+}
+
+/*Add the artifacts found in dirName ("" for the root directory) to the present mask*/
+static uint32_t MSD_APP_Scan_dir(const char *dirName, uint32_t present) {
+    SYS_FS_HANDLE dir;
+    size_t dirLen = strlen(dirName);
+    char path[sizeof (SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0) + dirLen + 1];
+    SYS_FS_FSTAT *stat = &msd_appData.fileStatus;
+    int i;
+
+    /*The root directory has to be opened with a trailing '/'*/
+    sprintf(path, SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0"/%s", dirName);
+    dir = SYS_FS_DirOpen(path);
+    if (SYS_FS_HANDLE_INVALID == dir) {
+        return present;
+    }
+
+    stat->lfname = NULL;
+    stat->lfsize = 0;
+    while ((SYS_FS_RES_SUCCESS == SYS_FS_DirRead(dir, stat)) && ('\0' != stat->fname[0])) {
+        if (0 != (stat->fattrib & SYS_FS_ATTR_DIR)) {
+            continue;
+        }
+        for (i = 0; i < MSD_APP_ARTIFACT_COUNT; i++) {
+            const char *name = msdAppArtifactName[i];
 
-    SYS_FS_RESULT fsResultRoot = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultSigner = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultDevice = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultClickme = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultCloudConfig = SYS_FS_RES_FAILURE;
+            if (0 != dirLen) {
+                if ((0 != strncmp(name, dirName, dirLen)) || ('/' != name[dirLen])) {
+                    continue;
+                }
+                name += dirLen + 1;
+            } else if (NULL != strchr(name, '/')) {
+                continue;
+            }
+            if (MSD_APP_Name_equals(name, stat->fname)) {
+                present |= MSD_APP_ARTIFACT_BIT(i);
+            }
+        }
+    }
+    SYS_FS_DirClose(dir);
 
-    /*Not implementing a loop to make the code more readable*/
-    fsResultSigner = SYS_FS_FileStat(MSD_APP_SIGNER_FILE_NAME, &msd_appData.fileStatus);
-    fsResultDevice = SYS_FS_FileStat(MSD_APP_DEVCERT_FILE_NAME, &msd_appData.fileStatus);
-    fsResultRoot = SYS_FS_FileStat(MSD_APP_ROOTCERT_FILE_NAME, &msd_appData.fileStatus);
-    fsResultClickme = SYS_FS_FileStat(MSD_APP_CLICKME_FILE_NAME, &msd_appData.fileStatus);
-    fsResultCloudConfig = SYS_FS_FileStat(MSD_APP_CLOUD_CONFIG_FILE_NAME, &msd_appData.fileStatus);
+    return present;
+}
 
+static int MSD_APP_Write_keyID_files(uint32_t missing, uint8_t *deviceCert, size_t deviceCertSize) {
+    char keyID[APP_CTRL_CLIENTID_SIZE];
 
-    if ((SYS_FS_RES_FAILURE == fsResultSigner) || (SYS_FS_RES_FAILURE == fsResultDevice) ||
-            (SYS_FS_RES_FAILURE == fsResultRoot) || (SYS_FS_RES_FAILURE == fsResultClickme) ||
-            (SYS_FS_RES_FAILURE == fsResultCloudConfig)) {
+    memset(keyID, '\0', APP_CTRL_CLIENTID_SIZE);
+    if (0 != getSubjectKeyID(deviceCert, deviceCertSize, keyID)) {
+        return -5;
+    }
 
-        /*Read root Certificate*/
-        size_t rootCertSize = 0;
-        status = tng_atcacert_root_cert_size(&rootCertSize);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_root_cert_size Failed \r\n");
-            return status;
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_CLICKME)) {
+        char clickmeString[strlen(MSD_APP_CLICKME_DATA_TEMPLATE) + strlen(keyID)];
+        sprintf(clickmeString, MSD_APP_CLICKME_DATA_TEMPLATE, keyID);
+        if (0 != write_file(MSD_APP_CLICKME_FILE_NAME, clickmeString, strlen(clickmeString))) {
+            return -6;
         }
-        uint8_t rootCert[rootCertSize];
-        status = tng_atcacert_root_cert((uint8_t*) & rootCert, &rootCertSize);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_root_cert Failed \r\n");
-            return status;
+    }
+
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_VOICE_CLICKME)) {
+        char voiceClickmeString[strlen(MSD_APP_VOICE_CLICKME_DATA_TEMPLATE) + strlen(keyID)];
+        sprintf(voiceClickmeString, MSD_APP_VOICE_CLICKME_DATA_TEMPLATE, keyID);
+        if (0 != write_file(MSD_APP_VOICE_CLICKME_FILE_NAME, voiceClickmeString, strlen(voiceClickmeString))) {
+            return -7;
         }
-        /*Read signer cert*/
-        size_t signerCertSize = 0;
-        status = tng_atcacert_max_signer_cert_size(&signerCertSize);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_max_signer_cert_size Failed \r\n");
-            return status;
+    }
+
+    /*A cloud config edited by the user is never overwritten, only created*/
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_CLOUD_CONFIG)) {
+        const char *broker = SYS_MQTT_INDEX0_BROKER_NAME;
+        const char *clientID = keyID;
+
+        /*exported from the stored config if there is one*/
+        if (app_controlData.mqttCtrl.mqttConfigValid) {
+            broker = app_controlData.mqttCtrl.mqttBroker;
+            clientID = app_controlData.mqttCtrl.clientId;
         }
-        uint8_t signerCert[signerCertSize];
-        status = tng_atcacert_read_signer_cert((uint8_t*) & signerCert, &signerCertSize);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_read_signer_cert Failed \r\n");
-            return status;
+        char cloudConfigString[strlen(MSD_APP_CLOUD_CONFIG_DATA_TEMPLATE) + APP_CTRL_MAX_CLIENT_ID_LEN + APP_CTRL_MAX_BROKER_NAME_LEN];
+        sprintf(cloudConfigString, MSD_APP_CLOUD_CONFIG_DATA_TEMPLATE, broker, clientID);
+        if (0 != write_file(MSD_APP_CLOUD_CONFIG_FILE_NAME, cloudConfigString, strlen(cloudConfigString))) {
+            return -8;
         }
+    }
+    return 0;
+}
 
-        /*Read device cert signer by the signer above*/
-        size_t deviceCertSize = 0;
-        status = tng_atcacert_max_device_cert_size(&deviceCertSize);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_max_signer_cert_size Failed \r\n");
-            return status;
-        }
+static int MSD_APP_Write_device_cert(uint32_t missing, uint8_t *signerCert) {
+    ATCA_STATUS status;
+    int ret;
 
-        uint8_t deviceCert[deviceCertSize];
-        status = tng_atcacert_read_device_cert((uint8_t*) & deviceCert, &deviceCertSize, (uint8_t*) & signerCert);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_read_device_cert Failed (%x) \r\n", status);
-            return status;
-        }
+    /*Read device cert signer by the signer above*/
+    size_t deviceCertSize = 0;
+    status = tng_atcacert_max_device_cert_size(&deviceCertSize);
+    if (ATCA_SUCCESS != status) {
+        SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_max_signer_cert_size Failed \r\n");
+        return status;
+    }
 
+    uint8_t deviceCert[deviceCertSize];
+    status = tng_atcacert_read_device_cert((uint8_t*) & deviceCert, &deviceCertSize, signerCert);
+    if (ATCA_SUCCESS != status) {
+        SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_read_device_cert Failed (%x) \r\n", status);
+        return status;
+    }
+
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_DEVICE_PEM)) {
         /*Generate a PEM device certificate.*/
         byte devPem[1024];
         XMEMSET(devPem, 0, 1024);
@@ -475,188 +750,161 @@ static int MSD_APP_Write_certs(void) {
         }
 
         /*Write PEM format device certificate to root folder*/
-        char devPemFileName[strlen(app_controlData.devSerialStr) + 5];
-        sprintf(devPemFileName, "%s.cer", app_controlData.devSerialStr);
-
         if (0 != write_file(devPemFileName, devPem, devPemSz)) {
             return -1;
         }
+    }
 
-        /*Write files to FS*/
-        if (0 != write_file(MSD_APP_ROOTCERT_FILE_NAME, rootCert, rootCertSize)) {
-            return -2;
-        }
-
-        if (0 != write_file(MSD_APP_SIGNER_FILE_NAME, signerCert, signerCertSize)) {
-            return -3;
-        }
-
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_DEVICE_CERT)) {
         if (0 != write_file(MSD_APP_DEVCERT_FILE_NAME, deviceCert, deviceCertSize)) {
             return -4;
         }
+    }
 
-        char keyID[APP_CTRL_CLIENTID_SIZE];
-        memset(keyID, '\0', APP_CTRL_CLIENTID_SIZE);
-        if (0 != getSubjectKeyID(deviceCert, deviceCertSize, keyID)) {
-            return -5;
-        } else {
-            char clickmeString[strlen(MSD_APP_CLICKME_DATA_TEMPLATE) + strlen(keyID)];
-            sprintf(clickmeString, MSD_APP_CLICKME_DATA_TEMPLATE, keyID);
-            if (0 != write_file(MSD_APP_CLICKME_FILE_NAME, clickmeString, strlen(clickmeString))) {
-                return -6;
-            }
-
-            char voiceClickmeString[strlen(MSD_APP_VOICE_CLICKME_DATA_TEMPLATE) + strlen(keyID)];
-            sprintf(voiceClickmeString, MSD_APP_VOICE_CLICKME_DATA_TEMPLATE, keyID);
-            if (0 != write_file(MSD_APP_VOICE_CLICKME_FILE_NAME, voiceClickmeString, strlen(voiceClickmeString))) {
-                return -7;
-            }
+    if (missing & MSD_APP_ARTIFACTS_KEY_ID) {
+        ret = MSD_APP_Write_keyID_files(missing, deviceCert, deviceCertSize);
+        if (0 != ret) {
+            return ret;
         }
-        /*Write cloud config if it does not exist. Writing with certs to avoid reading KeyID again*/
-        if (SYS_FS_RES_FAILURE == fsResultCloudConfig) {
-            char cloudConfigString[strlen(MSD_APP_CLOUD_CONFIG_DATA_TEMPLATE) + strlen(keyID) + APP_CTRL_MAX_BROKER_NAME_LEN];
-            sprintf(cloudConfigString, MSD_APP_CLOUD_CONFIG_DATA_TEMPLATE, SYS_MQTT_INDEX0_BROKER_NAME, keyID);
-            if (0 != write_file(MSD_APP_CLOUD_CONFIG_FILE_NAME, cloudConfigString, strlen(cloudConfigString))) {
-                return -8;
-            }
-        }
-    } else {
-        //SYS_CONSOLE_PRINT("Cert files already exists \r\n");
     }
     return 0;
 }
 
-static int MSD_APP_Write_keys(void) {
-
+/*Pull the missing device, signer and root certificates from the ECC608 device and write them to the MSD, along with
+ the files generated from the device certificate*/
+static int MSD_APP_Write_certs(uint32_t missing) {
     ATCA_STATUS status;
-    SYS_FS_RESULT fsResultkey0 = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultkey1 = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultkey2 = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultkey3 = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultkey4 = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultRootKey = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultSigKey = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultDevKey = SYS_FS_RES_FAILURE;
-    SYS_FS_RESULT fsResultClickme = SYS_FS_RES_FAILURE;
-
-    fsResultkey0 = SYS_FS_FileStat(MSD_APP_SLOT_0_PUBKEY_FILE_NAME, &msd_appData.fileStatus);
-    fsResultkey1 = SYS_FS_FileStat(MSD_APP_SLOT_1_PUBKEY_FILE_NAME, &msd_appData.fileStatus);
-    fsResultkey2 = SYS_FS_FileStat(MSD_APP_SLOT_2_PUBKEY_FILE_NAME, &msd_appData.fileStatus);
-    fsResultkey3 = SYS_FS_FileStat(MSD_APP_SLOT_3_PUBKEY_FILE_NAME, &msd_appData.fileStatus);
-    fsResultkey4 = SYS_FS_FileStat(MSD_APP_SLOT_4_PUBKEY_FILE_NAME, &msd_appData.fileStatus);
-    fsResultRootKey = SYS_FS_FileStat(MSD_APP_ROOTCERT_FILE_NAME, &msd_appData.fileStatus);
-    fsResultSigKey = SYS_FS_FileStat(MSD_APP_SIGNER_FILE_NAME, &msd_appData.fileStatus);
-    fsResultDevKey = SYS_FS_FileStat(MSD_APP_DEVCERT_FILE_NAME, &msd_appData.fileStatus);
-    fsResultClickme = SYS_FS_FileStat(MSD_APP_CLICKME_FILE_NAME, &msd_appData.fileStatus);
-
-
-
-    if ((SYS_FS_RES_FAILURE == fsResultkey0) || (SYS_FS_RES_FAILURE == fsResultkey1) ||
-            (SYS_FS_RES_FAILURE == fsResultkey2) || (SYS_FS_RES_FAILURE == fsResultkey3) ||
-            (SYS_FS_RES_FAILURE == fsResultkey4) || (SYS_FS_RES_FAILURE == fsResultRootKey) ||
-            (SYS_FS_RES_FAILURE == fsResultSigKey) || (SYS_FS_RES_FAILURE == fsResultDevKey) ||
-            (SYS_FS_RES_FAILURE == fsResultClickme)) {
-
-        uint8_t public_key[ATCA_PUB_KEY_SIZE];
-        status = atcab_get_pubkey(0, public_key);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Slot0 Public Key");
-            return status;
-        }
-        if (0 != write_file(MSD_APP_SLOT_0_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Slot0 Public Key");
-            return -1;
-        }
 
-        status = atcab_get_pubkey(1, public_key);
+    if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_ROOT_CERT)) {
+        /*Read root Certificate*/
+        size_t rootCertSize = 0;
+        status = tng_atcacert_root_cert_size(&rootCertSize);
         if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Slot1 Public Key");
+            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_root_cert_size Failed \r\n");
             return status;
         }
-        if (0 != write_file(MSD_APP_SLOT_1_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Slot1 Public Key");
-            return -1;
-        }
-
-        status = atcab_get_pubkey(2, public_key);
+        uint8_t rootCert[rootCertSize];
+        status = tng_atcacert_root_cert((uint8_t*) & rootCert, &rootCertSize);
         if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Slot2 Public Key");
+            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_root_cert Failed \r\n");
             return status;
         }
-        if (0 != write_file(MSD_APP_SLOT_2_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Slot2 Public Key");
-            return -1;
+        if (0 != write_file(MSD_APP_ROOTCERT_FILE_NAME, rootCert, rootCertSize)) {
+            return -2;
         }
+    }
 
-        status = atcab_get_pubkey(3, public_key);
+    if (missing & MSD_APP_ARTIFACTS_SIGNER_CERT) {
+        /*Read signer cert*/
+        size_t signerCertSize = 0;
+        status = tng_atcacert_max_signer_cert_size(&signerCertSize);
         if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Slot3 Public Key");
+            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_max_signer_cert_size Failed \r\n");
             return status;
         }
-        if (0 != write_file(MSD_APP_SLOT_3_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Slot3 Public Key");
-            return -1;
-        }
-
-        status = atcab_get_pubkey(4, public_key);
+        uint8_t signerCert[signerCertSize];
+        status = tng_atcacert_read_signer_cert((uint8_t*) & signerCert, &signerCertSize);
         if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Slot4 Public Key");
+            SYS_CONSOLE_PRINT("    MSD_APP_Write_certs: tng_atcacert_read_signer_cert Failed \r\n");
             return status;
         }
-        if (0 != write_file(MSD_APP_SLOT_4_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Slot4 Public Key");
-            return -1;
-        }
 
-        status = tng_atcacert_root_public_key(public_key);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading root Public Key");
-            return status;
+        if (missing & MSD_APP_ARTIFACT_BIT(MSD_APP_ARTIFACT_SIGNER_CERT)) {
+            if (0 != write_file(MSD_APP_SIGNER_FILE_NAME, signerCert, signerCertSize)) {
+                return -3;
+            }
         }
-        if (0 != write_file(MSD_APP_ROOT_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing root Public Key");
-            return -1;
+
+        if (missing & MSD_APP_ARTIFACTS_DEVICE_CERT) {
+            return MSD_APP_Write_device_cert(missing, signerCert);
         }
+    }
+    return 0;
+}
 
-        status = tng_atcacert_signer_public_key(public_key, NULL);
-        if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading Signer Public Key");
-            return status;
+static int MSD_APP_Write_keys(uint32_t missing) {
+    ATCA_STATUS status;
+    uint8_t public_key[ATCA_PUB_KEY_SIZE];
+    int i;
+
+    for (i = MSD_APP_ARTIFACT_SLOT_0_KEY; i <= MSD_APP_ARTIFACT_DEVICE_KEY; i++) {
+        if (0 == (missing & MSD_APP_ARTIFACT_BIT(i))) {
+            continue;
         }
-        if (0 != write_file(MSD_APP_SIGNER_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing Signer Public Key");
-            return -1;
+        switch (i) {
+            case MSD_APP_ARTIFACT_ROOT_KEY:
+                status = tng_atcacert_root_public_key(public_key);
+                break;
+            case MSD_APP_ARTIFACT_SIGNER_KEY:
+                status = tng_atcacert_signer_public_key(public_key, NULL);
+                break;
+            case MSD_APP_ARTIFACT_DEVICE_KEY:
+                status = tng_atcacert_device_public_key(public_key, NULL);
+                break;
+            default:
+                status = atcab_get_pubkey(i - MSD_APP_ARTIFACT_SLOT_0_KEY, public_key);
+                break;
         }
-
-        status = tng_atcacert_device_public_key(public_key, NULL);
         if (ATCA_SUCCESS != status) {
-            SYS_CONSOLE_PRINT("Failed reading device Public Key");
+            SYS_CONSOLE_PRINT("Failed reading public key for %s\r\n", msdAppArtifactName[i]);
             return status;
         }
-        if (0 != write_file(MSD_APP_DEVICE_PUBKEY_FILE_NAME, public_key, ATCA_PUB_KEY_SIZE)) {
-            SYS_CONSOLE_PRINT("Failed writing device Public Key");
+        if (0 != write_file(msdAppArtifactName[i], public_key, ATCA_PUB_KEY_SIZE)) {
+            SYS_CONSOLE_PRINT("Failed writing %s\r\n", msdAppArtifactName[i]);
             return -1;
         }
-
-    } else {
-        //SYS_CONSOLE_PRINT("Slot Key files already exists \r\n");
     }
     return ATCA_SUCCESS;
 }
 
+/*Write the missing security artifacts in a single pass. Called with the ECC608 session open. The files are flushed
+ to flash together, by the last close.*/
+static int MSD_APP_Provision(void) {
+    uint32_t startCount = SYS_TIME_CounterGet();
+    uint32_t present;
+    uint32_t missing;
+    int ret;
+
+    snprintf(devPemFileName, sizeof (devPemFileName), "%s.cer", app_controlData.devSerialStr);
+
+    present = MSD_APP_Scan_dir("", 0);
+    present = MSD_APP_Scan_dir(MSD_APP_SEC_DIR_NAME, present);
+    missing = ~present & MSD_APP_ARTIFACTS_ALL;
+    if (0 == missing) {
+        //SYS_CONSOLE_PRINT("Security files already exist \r\n");
+        return 0;
+    }
+
+    disk_sync_hold();
+    ret = MSD_APP_Write_certs(missing);
+    if (0 == ret) {
+        ret = MSD_APP_Write_keys(missing);
+    }
+    if ((RES_OK != disk_sync_release()) && (0 == ret)) {
+        SYS_CONSOLE_PRINT("Error flushing security files\r\n");
+        ret = -9;
+    }
+
+    SYS_CONSOLE_PRINT("MSD_APP: Provisioned security files (mask %x) in %d ms\r\n", (unsigned) missing,
+            (int) SYS_TIME_CountToMS(SYS_TIME_CounterGet() - startCount));
+    return ret;
+}
+
 static void timerCallback(uintptr_t context) {
     //SYS_CONSOLE_PRINT("checking for file changes\r\n");
     msd_appData.checkHash = true;
+    APP_RTOS_NotifyFromISR(xMSD_APP_Tasks);
 }
 
 
 uint8_t CACHE_ALIGN work[SYS_FS_FAT_MAX_SS];
 
-static bool checkFSMount() {
+static bool checkFSMount(unsigned long mountflags) {
 #if SYS_FS_AUTOMOUNT_ENABLE
+    (void) mountflags;
     return msd_appData.fsMounted;
 #else
-    if (SYS_FS_Mount(SYS_FS_MEDIA_IDX0_DEVICE_NAME_VOLUME_IDX0, SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0, FAT, 0, NULL) != SYS_FS_RES_SUCCESS) {
+    if (SYS_FS_Mount(SYS_FS_MEDIA_IDX0_DEVICE_NAME_VOLUME_IDX0, SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0, FAT, mountflags, NULL) != SYS_FS_RES_SUCCESS) {
         return false;
     } else {
         return true;
@@ -677,24 +925,14 @@ static int updateVerFile(void) {
         char versionString[nbytes];
         size = SYS_FS_FileRead(fd, versionString, nbytes);
         SYS_FS_FileClose(fd);
-        if (0==strncmp(versionString,APP_VERSION,nbytes)){
+        if ((nbytes == size) && (0==strncmp(versionString,APP_VERSION,nbytes))){
             return 0;
         }
     }
     
     /*write a version file in case of 1)file not found 2)version mismatch */
-    fd = SYS_FS_FileOpen(MSD_APP_VERSION_FILE_NAME, SYS_FS_FILE_OPEN_WRITE);
-    if (SYS_FS_HANDLE_INVALID != fd) {
-        size = SYS_FS_FileWrite(fd, APP_VERSION, nbytes);
-        SYS_FS_FileSync(fd);
-        SYS_FS_FileClose(fd);
-        if (nbytes != size) {
-            SYS_CONSOLE_PRINT("error writing version . Size mismatch (got %d on fd %x. FSError = %d) \r\n", (int) size, (int) fd, SYS_FS_Error());
-            return -2;
-        }
-    } else {
-        SYS_CONSOLE_PRINT("Error creating new version file (fsError=%d)\r\n", SYS_FS_Error());
-        return -3;
+    if (0 != write_file(MSD_APP_VERSION_FILE_NAME, APP_VERSION, nbytes)) {
+        return -2;
     }
     return 0;
 }
@@ -716,7 +954,7 @@ void MSD_APP_Tasks(void) {
             }
             break;
         case MSD_APP_STATE_WAIT_FS_MOUNT:
-            if (checkFSMount()) {
+            if (checkFSMount(0)) {
                 SYS_CONSOLE_PRINT("MSD_APP: FS Mounted\r\n");
                 if (app_controlData.switchData.bootSwitch) {
                     SYS_CONSOLE_PRINT(TERM_CYAN"MSD_APP: Factory config reset requested\r\n"TERM_RESET);
@@ -753,6 +991,9 @@ void MSD_APP_Tasks(void) {
             break;
         case MSD_APP_STATE_TOUCH_FILE:
             SYS_FS_CurrentDriveSet(SYS_FS_MEDIA_IDX0_MOUNT_NAME_VOLUME_IDX0);
+            /*The stored config is exported to the config files missing from the drive. A factory config reset drops
+             it along with the files.*/
+            MSD_APP_Load_config(!app_controlData.switchData.bootSwitch);
             extern ATCAIfaceCfg atecc608_0_init_data;
             ATCA_STATUS atcaStat;
             /*Write an version file*/
@@ -766,14 +1007,8 @@ void MSD_APP_Tasks(void) {
                     break;
                 }
 
-                if (0 != MSD_APP_Write_certs()) {
-                    MSD_APP_Write_errInfo("Error creating certificates");
-                    msd_appData.state = MSD_APP_CONNECT_USB;
-                    atcab_release();
-                    break;
-                }
-                if (0 != MSD_APP_Write_keys()) {
-                    MSD_APP_Write_errInfo("Error creating keys");
+                if (0 != MSD_APP_Provision()) {
+                    MSD_APP_Write_errInfo("Error creating certificates and keys");
                     msd_appData.state = MSD_APP_CONNECT_USB;
                     atcab_release();
                     break;
@@ -787,12 +1022,18 @@ void MSD_APP_Tasks(void) {
                 msd_appData.state = MSD_APP_CONNECT_USB;
                 break;
             }
-            /*Read data from active config*/
-            if (0 != MSD_APP_Read_Config()) {
+            /*Import the config files edited since they were stored*/
+            (void) MSD_APP_Import_config();
+            /*USB is not connected yet, all the writes so far were ours*/
+            msd_appData.watchWriteCount = disk_write_count();
+            if (!MSD_APP_Config_valid()) {
                 MSD_APP_Write_errInfo("invalid wifi or cloud Config File");
                 msd_appData.state = MSD_APP_CONNECT_USB;
                 break;
             }
+            /*Wi-Fi and MQTT apps are waiting on this config*/
+            APP_RTOS_Notify(xAPP_WIFI_Tasks);
+            APP_RTOS_Notify(xMQTT_APP_Tasks);
 
             msd_appData.state = MSD_APP_CONNECT_USB;
             break;
@@ -818,12 +1059,21 @@ void MSD_APP_Tasks(void) {
                 break;
             }
         case MSD_APP_STATE_RUNNING:
+            if (msd_appData.checkHash || msd_appData.remountPending) {
+                msd_appData.checkHash = false;
+                MSD_APP_Check_config();
+            }
             break;
         case MSD_APP_STATE_ERROR:
             break;
         default:
             break;
     }
+
+    if (((MSD_APP_STATE_RUNNING != msd_appData.state) && (MSD_APP_STATE_ERROR != msd_appData.state)) ||
+            msd_appData.remountPending) {
+        APP_RTOS_PollRequest(APP_RTOS_TASK_MSD_APP);
+    }
 }
 /*******************************************************************************
  End of File
@@ -30,6 +30,7 @@
 #include "usb/usb_device.h"
 #include "system/fs/sys_fs.h"
 #include "app_wifi.h"
+#include "app_cfgstore.h"
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
@@ -41,6 +42,8 @@ extern "C" {
 #define MSD_APP_FS_FORMA_BUFFER_SIZE 512
     
 #define MSD_APP_TXT_CONFIG
+/*larger config files are rejected, they are read into a static buffer*/
+#define MSD_APP_CONFIG_FILE_MAX_SIZE 512
     
 #define MSD_APP_VERSION_FILE_NAME "version.txt"    
 #define MSD_APP_SEC_DIR_NAME "sec"
@@ -71,7 +74,9 @@ extern "C" {
 #ifdef MSD_APP_TXT_CONFIG
 #define MSD_APP_TXT_CONFIG_FILE_NAME "WIFI.CFG"
 #define MSD_APP_TXT_CONFIG_FILE_MIN_SIZE    23    
-#define MSD_APP_TXT_CONFIG_DATA "CMD:SEND_UART=wifi "DEFAULT_SSID","DEFAULT_SSID_PSK","DEFAULT_AUTH_MODE_NUM
+#define MSD_APP_TXT_CONFIG_PREFIX "CMD:SEND_UART=wifi "
+#define MSD_APP_TXT_CONFIG_DATA MSD_APP_TXT_CONFIG_PREFIX DEFAULT_SSID","DEFAULT_SSID_PSK","DEFAULT_AUTH_MODE_NUM
+#define MSD_APP_TXT_CONFIG_DATA_TEMPLATE MSD_APP_TXT_CONFIG_PREFIX"%s,%s,%d"
 #endif
     
 #define MSD_APP_CLICKME_DATA_TEMPLATE "<html><body><script type=\"text/javascript\">window.location.href =\"\
@@ -93,6 +98,20 @@ extern "C" {
         MSD_APP_STATE_ERROR,
     } MSD_APP_STATES;
 
+    /*Config files watched for edits from the USB host*/
+    typedef enum {
+        MSD_APP_WATCH_WIFI_CONFIG = 0,
+        MSD_APP_WATCH_CLOUD_CONFIG,
+        MSD_APP_WATCH_COUNT
+    } MSD_APP_WATCH_FILE;
+
+    typedef struct {
+        /*directory entry of the last look, the content is hashed only when it changes. Seeded from the source of the
+         stored config at boot.*/
+        APP_CFGSTORE_SOURCE src;
+        bool exists;
+    } MSD_APP_WATCH_STATE;
+
     typedef struct {
         /* The application's current state */
         MSD_APP_STATES state;
@@ -104,15 +123,25 @@ extern "C" {
         SYS_FS_HANDLE fileHandle;
         SYS_FS_FSTAT fileStatus;
         volatile bool fsMounted;
-        SYS_FS_TIME fileTime_old, fileTime_new;
         bool checkHash;
-        unsigned char configHash[32];
+        /*disk_write_count() when the config files were last checked*/
+        uint32_t watchWriteCount;
+        /*unmounted to see the host changes, mount retried on every poll*/
+        bool remountPending;
+        /*a watched file could not be read, checked again even without new writes*/
+        bool watchRetry;
+        /*configured by a USB host which has not ejected the drive: the host owns the volume*/
+        volatile bool hostAttached;
+        MSD_APP_WATCH_STATE watch[MSD_APP_WATCH_COUNT];
     } MSD_APP_DATA;
 
     void MSD_APP_Initialize(void);
 
     void MSD_APP_Tasks(void);
 
+    /*USB_DEVICE_MSD_MEDIA_EJECT_HOOK*/
+    void MSD_APP_MediaEjected(void);
+
 #endif /* _MSD_APP_H */
 
     //DOM-IGNORE-BEGIN
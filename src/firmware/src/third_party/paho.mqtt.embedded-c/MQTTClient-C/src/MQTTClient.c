@@ -74,6 +74,7 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->cleansession = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
+    c->pubAckHandler = NULL;
 	  c->next_packetid = 1;
     TimerInit(&c->last_sent);
     TimerInit(&c->last_received);
@@ -286,9 +287,18 @@ int cycle(MQTTClient* c, Timer* timer)
         case 0: /* timed out reading packet */
             break;
         case CONNACK:
-        case PUBACK:
         case SUBACK:
             break;
+        case PUBACK:
+        case PUBCOMP:
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            if (c->pubAckHandler != NULL &&
+                MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) == 1)
+                c->pubAckHandler(c, mypacketid);
+            break;
+        }
         case PUBLISH:
         {
             MQTTString topicName;
@@ -332,8 +342,6 @@ int cycle(MQTTClient* c, Timer* timer)
             break;
         }
 
-        case PUBCOMP:
-            break;
         case PINGRESP:
             c->ping_outstanding = 0;
             break;
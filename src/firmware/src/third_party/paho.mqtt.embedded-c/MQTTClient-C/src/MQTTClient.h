@@ -131,6 +131,10 @@ typedef struct MQTTClient
 
     void (*defaultMessageHandler) (MessageData*);
 
+    /* Called from cycle() for every PUBACK/PUBCOMP, so that a caller pipelining several
+     * QoS1 publishes can match the acknowledgements by packet id */
+    void (*pubAckHandler) (struct MQTTClient*, unsigned short);
+
     Network* ipstack;
     Timer last_sent, last_received;
 #if defined(MQTT_TASK)